@@ -61,6 +61,7 @@
 #include "../version.h"
 
 #include "../far/subdivisionTables.h"
+#include "../far/kernelInstrumentation.h"
 
 #include <cassert>
 #include <vector>
@@ -85,6 +86,10 @@ public:
     /// Compute the positions of refined vertices using the specified kernels
     virtual void Apply( int level, FarDispatcher<U> const *dispatch, void * data=0 ) const;
 
+    /// Compute the positions of the refined vertices of a level that are
+    /// listed in 'dirty' using the specified kernels
+    virtual void ApplyDirty( int level, FarDirtyVertices const * dirty, FarDispatcher<U> const *dispatch, void * data=0 ) const;
+
     /// Face-vertices indexing table accessor
     FarTable<unsigned int> const & Get_F_IT( ) const { return _F_IT; }
 
@@ -97,6 +102,8 @@ public:
 
 private:
     template <class X, class Y> friend class FarBilinearSubdivisionTablesFactory;
+    template <class X> friend class FarMeshSerializer;
+    template <class X> friend class FarTopologyMeshFactory;
     friend class FarDispatcher<U>;
 
     FarBilinearSubdivisionTables( FarMesh<U> * mesh, int maxlevel );
@@ -118,7 +125,7 @@ private:
 
 template <class U>
 FarBilinearSubdivisionTables<U>::FarBilinearSubdivisionTables( FarMesh<U> * mesh, int maxlevel ) :
-    FarSubdivisionTables<U>(mesh, maxlevel),
+    FarSubdivisionTables<U>(mesh, maxlevel, FarSubdivisionTables<U>::k_Bilinear),
     _F_ITa(maxlevel+1),
     _F_IT(maxlevel+1)
 { }
@@ -138,16 +145,44 @@ FarBilinearSubdivisionTables<U>::Apply( int level, FarDispatcher<U> const *dispa
     typename FarSubdivisionTables<U>::VertexKernelBatch const * batch = & (this->_batches[level-1]);
 
     int offset = this->GetFirstVertexOffset(level);
-    if (batch->kernelF>0)
+    if (batch->kernelF>0) {
+        FarKernelScope<U> scope(dispatch, clientdata, this, FarKernelLaunch::k_FaceVertices, level, offset, 0, batch->kernelF);
         dispatch->ApplyBilinearFaceVerticesKernel(this->_mesh, offset, level, 0, batch->kernelF, clientdata);
+    }
 
     offset += this->GetNumFaceVertices(level);
-    if (batch->kernelE>0)
+    if (batch->kernelE>0) {
+        FarKernelScope<U> scope(dispatch, clientdata, this, FarKernelLaunch::k_EdgeVertices, level, offset, 0, batch->kernelE);
         dispatch->ApplyBilinearEdgeVerticesKernel(this->_mesh, offset, level, 0, batch->kernelE, clientdata);
+    }
 
     offset += this->GetNumEdgeVertices(level);
-    if (batch->kernelB.first < batch->kernelB.second)
+    if (batch->kernelB.first < batch->kernelB.second) {
+        FarKernelScope<U> scope(dispatch, clientdata, this, FarKernelLaunch::k_VertexVertices, level, offset, batch->kernelB.first, batch->kernelB.second);
         dispatch->ApplyBilinearVertexVerticesKernel(this->_mesh, offset, level, batch->kernelB.first, batch->kernelB.second, clientdata);
+    }
+}
+
+template <class U> void
+FarBilinearSubdivisionTables<U>::ApplyDirty( int level, FarDirtyVertices const * dirty, FarDispatcher<U> const *dispatch, void * clientdata ) const {
+
+    assert(this->_mesh and level>0 and dirty);
+
+    std::vector<FarDirtyVertices::Range> const & faceRanges = dirty->GetFaceVertexRanges(level);
+    std::vector<FarDirtyVertices::Range> const & edgeRanges = dirty->GetEdgeVertexRanges(level);
+    std::vector<FarDirtyVertices::Range> const & vertexRanges = dirty->GetVertexVertexRanges(level);
+
+    int offset = this->GetFirstVertexOffset(level);
+    for (int i=0; i<(int)faceRanges.size(); ++i)
+        dispatch->ApplyBilinearFaceVerticesKernel(this->_mesh, offset, level, faceRanges[i].first, faceRanges[i].second, clientdata);
+
+    offset += this->GetNumFaceVertices(level);
+    for (int i=0; i<(int)edgeRanges.size(); ++i)
+        dispatch->ApplyBilinearEdgeVerticesKernel(this->_mesh, offset, level, edgeRanges[i].first, edgeRanges[i].second, clientdata);
+
+    offset += this->GetNumEdgeVertices(level);
+    for (int i=0; i<(int)vertexRanges.size(); ++i)
+        dispatch->ApplyBilinearVertexVerticesKernel(this->_mesh, offset, level, vertexRanges[i].first, vertexRanges[i].second, clientdata);
 }
 
 //
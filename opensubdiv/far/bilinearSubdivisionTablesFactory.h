@@ -96,7 +96,8 @@ FarBilinearSubdivisionTablesFactory<T,U>::Create( FarMeshFactory<T,U> * meshFact
     
     std::vector<int> & remap = meshFactory->getRemappingTable();
     
-    FarSubdivisionTablesFactory<T,U> tablesFactory( meshFactory->GetHbrMesh(),  maxlevel, remap );
+    FarSubdivisionTablesFactory<T,U> tablesFactory( meshFactory->GetHbrMesh(), maxlevel, remap,
+                                                    meshFactory->_vertexOrdering );
 
     FarBilinearSubdivisionTables<U> * result = new FarBilinearSubdivisionTables<U>(farMesh, maxlevel);
 
@@ -135,8 +136,18 @@ FarBilinearSubdivisionTablesFactory<T,U>::Create( FarMeshFactory<T,U> * meshFact
             F_ITa[2*i+0] = offset;
             F_ITa[2*i+1] = valence;
 
-            for (int j=0; j<valence; ++j)
-                F_IT[offset++] = remap[f->GetVertex(j)->GetID()];
+            offset += valence;
+        }
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(meshFactory->getThreadCount()) if(meshFactory->getThreadCount()>1)
+#endif
+        for (int i=0; i < batch->kernelF; ++i) {
+
+            HbrFace<T> * f=tablesFactory._faceVertsList[level][i]->GetParentFace();
+
+            for (int j=0; j<F_ITa[2*i+1]; ++j)
+                F_IT[F_ITa[2*i]+j] = remap[f->GetVertex(j)->GetID()];
         }
         result->_F_ITa.SetMarker(level, &F_ITa[2*batch->kernelF]);
         result->_F_IT.SetMarker(level, &F_IT[offset]);
@@ -146,6 +157,9 @@ FarBilinearSubdivisionTablesFactory<T,U>::Create( FarMeshFactory<T,U> * meshFact
         // "Average the end-points of the parent edge"
         int * E_IT = result->_E_IT[level-1];
         batch->kernelE = (int)tablesFactory._edgeVertsList[level].size();
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(meshFactory->getThreadCount()) if(meshFactory->getThreadCount()>1)
+#endif
         for (int i=0; i < batch->kernelE; ++i) {
 
             HbrVertex<T> * v = tablesFactory._edgeVertsList[level][i];
@@ -167,6 +181,9 @@ FarBilinearSubdivisionTablesFactory<T,U>::Create( FarMeshFactory<T,U> * meshFact
         int * V_ITa = result->_V_ITa[level-1];
         batch->kernelB.first = 0;
         batch->kernelB.second = (int)tablesFactory._vertVertsList[level].size();
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(meshFactory->getThreadCount()) if(meshFactory->getThreadCount()>1)
+#endif
         for (int i=0; i < batch->kernelB.second; ++i) {
 
             HbrVertex<T> * v = tablesFactory._vertVertsList[level][i],
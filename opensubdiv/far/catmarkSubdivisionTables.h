@@ -61,6 +61,7 @@
 #include "../version.h"
 
 #include "../far/subdivisionTables.h"
+#include "../far/kernelInstrumentation.h"
 
 #include <cassert>
 #include <vector>
@@ -85,6 +86,10 @@ public:
     /// Compute the positions of refined vertices using the specified kernels
     virtual void Apply( int level, FarDispatcher<U> const *dispatch, void * data=0 ) const;
 
+    /// Compute the positions of the refined vertices of a level that are
+    /// listed in 'dirty' using the specified kernels
+    virtual void ApplyDirty( int level, FarDirtyVertices const * dirty, FarDispatcher<U> const *dispatch, void * data=0 ) const;
+
     /// Face-vertices indexing table accessor
     FarTable<unsigned int> const & Get_F_IT( ) const { return _F_IT; }
 
@@ -97,6 +102,8 @@ public:
 
 private:
     template <class X, class Y> friend class FarCatmarkSubdivisionTablesFactory;
+    template <class X> friend class FarMeshSerializer;
+    template <class X> friend class FarTopologyMeshFactory;
     friend class FarDispatcher<U>;
 
     // Private constructor called by factory
@@ -108,6 +115,10 @@ private:
     // Compute-kernel applied to vertices resulting from the refinement of an edge.
     void computeEdgePoints(int offset, int level, int start, int end, void * clientdata) const;
 
+    // Compute-kernel applied to vertices resulting from the refinement of a vertex
+    // Fused kernel applying the rule of each vertex in a single pass
+    void computeVertexPoints(int offset, int level, int start, int end, void * clientdata) const;
+
     // Compute-kernel applied to vertices resulting from the refinement of a vertex
     // Kernel "A" Handles the k_Smooth and k_Dart rules
     void computeVertexPointsA(int offset, bool pass, int level, int start, int end, void * clientdata) const;
@@ -124,7 +135,7 @@ private:
 
 template <class U>
 FarCatmarkSubdivisionTables<U>::FarCatmarkSubdivisionTables( FarMesh<U> * mesh, int maxlevel ) :
-    FarSubdivisionTables<U>(mesh, maxlevel),
+    FarSubdivisionTables<U>(mesh, maxlevel, FarSubdivisionTables<U>::k_Catmark),
     _F_ITa(maxlevel+1),
     _F_IT(maxlevel+1)
 { }
@@ -144,20 +155,45 @@ FarCatmarkSubdivisionTables<U>::Apply( int level, FarDispatcher<U> const *dispat
     typename FarSubdivisionTables<U>::VertexKernelBatch const * batch = & (this->_batches[level-1]);
 
     int offset = this->GetFirstVertexOffset(level);
-    if (batch->kernelF>0)
+    if (batch->kernelF>0) {
+        FarKernelScope<U> scope(dispatch, clientdata, this, FarKernelLaunch::k_FaceVertices, level, offset, 0, batch->kernelF);
         dispatch->ApplyCatmarkFaceVerticesKernel(this->_mesh, offset, level, 0, batch->kernelF, clientdata);
+    }
 
     offset += this->GetNumFaceVertices(level);
-    if (batch->kernelE>0)
+    if (batch->kernelE>0) {
+        FarKernelScope<U> scope(dispatch, clientdata, this, FarKernelLaunch::k_EdgeVertices, level, offset, 0, batch->kernelE);
         dispatch->ApplyCatmarkEdgeVerticesKernel(this->_mesh, offset, level, 0, batch->kernelE, clientdata);
+    }
+
+    offset += this->GetNumEdgeVertices(level);
+    int nverts = this->GetNumVertexVertices(level);
+    if (nverts>0) {
+        FarKernelScope<U> scope(dispatch, clientdata, this, FarKernelLaunch::k_VertexVertices, level, offset, 0, nverts);
+        dispatch->ApplyCatmarkVertexVerticesKernel(this->_mesh, offset, level, 0, nverts, clientdata);
+    }
+}
+
+template <class U> void
+FarCatmarkSubdivisionTables<U>::ApplyDirty( int level, FarDirtyVertices const * dirty, FarDispatcher<U> const *dispatch, void * clientdata ) const {
+
+    assert(this->_mesh and level>0 and dirty);
+
+    std::vector<FarDirtyVertices::Range> const & faceRanges = dirty->GetFaceVertexRanges(level);
+    std::vector<FarDirtyVertices::Range> const & edgeRanges = dirty->GetEdgeVertexRanges(level);
+    std::vector<FarDirtyVertices::Range> const & vertexRanges = dirty->GetVertexVertexRanges(level);
+
+    int offset = this->GetFirstVertexOffset(level);
+    for (int i=0; i<(int)faceRanges.size(); ++i)
+        dispatch->ApplyCatmarkFaceVerticesKernel(this->_mesh, offset, level, faceRanges[i].first, faceRanges[i].second, clientdata);
+
+    offset += this->GetNumFaceVertices(level);
+    for (int i=0; i<(int)edgeRanges.size(); ++i)
+        dispatch->ApplyCatmarkEdgeVerticesKernel(this->_mesh, offset, level, edgeRanges[i].first, edgeRanges[i].second, clientdata);
 
     offset += this->GetNumEdgeVertices(level);
-    if (batch->kernelB.first < batch->kernelB.second)
-        dispatch->ApplyCatmarkVertexVerticesKernelB(this->_mesh, offset, level, batch->kernelB.first, batch->kernelB.second, clientdata);
-    if (batch->kernelA1.first < batch->kernelA1.second)
-        dispatch->ApplyCatmarkVertexVerticesKernelA(this->_mesh, offset, false, level, batch->kernelA1.first, batch->kernelA1.second, clientdata);
-    if (batch->kernelA2.first < batch->kernelA2.second)
-        dispatch->ApplyCatmarkVertexVerticesKernelA(this->_mesh, offset, true, level, batch->kernelA2.first, batch->kernelA2.second, clientdata);
+    for (int i=0; i<(int)vertexRanges.size(); ++i)
+        dispatch->ApplyCatmarkVertexVerticesKernel(this->_mesh, offset, level, vertexRanges[i].first, vertexRanges[i].second, clientdata);
 }
 
 //
@@ -233,6 +269,81 @@ FarCatmarkSubdivisionTables<U>::computeEdgePoints( int offset,  int level, int s
     }
 }
 
+//
+// Vertex-vertices compute Kernel - completely re-entrant
+//
+
+// single-pass kernel applying the rule of each vertex (see VertexRule)
+template <class U> void
+FarCatmarkSubdivisionTables<U>::computeVertexPoints( int offset, int level, int start, int end, void * clientdata ) const {
+
+    assert(this->_mesh);
+
+    U * vsrc = &this->_mesh->GetVertices().at(0),
+      * vdst = vsrc + offset + start;
+
+    const int * V_ITa = this->_V_ITa[level-1];
+    const unsigned int * V_IT = this->_V_IT[level-1];
+    const float * V_W = this->_V_W[level-1];
+    const unsigned char * V_R = this->_V_R[level-1];
+
+    for (int i=start; i<end; ++i, ++vdst ) {
+
+        vdst->Clear(clientdata);
+
+        int     h=V_ITa[5*i  ],   // offset of the vertices in the _V0_IT array
+                n=V_ITa[5*i+1],   // number of vertices in the _VO_IT array (valence)
+                p=V_ITa[5*i+2],   // index of the parent vertex
+            eidx0=V_ITa[5*i+3],   // index of the first crease rule edge
+            eidx1=V_ITa[5*i+4];   // index of the second crease rule edge
+
+        unsigned char rule = V_R[i];
+
+        float weight = V_W[i];
+
+        if (rule<=FarSubdivisionTables<U>::k_RuleSmoothCrease) {
+            // k_Smooth / k_Dart rule
+            float wp = 1.0f/(n*n),
+                  wv = (n-2.0f)*n*wp;
+
+            vdst->AddWithWeight( vsrc[p], weight * wv, clientdata );
+
+            for (int j=0; j<n; ++j) {
+                vdst->AddWithWeight( vsrc[V_IT[h+j*2  ]], weight * wp, clientdata );
+                vdst->AddWithWeight( vsrc[V_IT[h+j*2+1]], weight * wp, clientdata );
+            }
+        }
+
+        switch (rule) {
+            case FarSubdivisionTables<U>::k_RuleSmoothCorner :
+                vdst->AddWithWeight( vsrc[p], 1.0f - weight, clientdata );
+                break;
+            case FarSubdivisionTables<U>::k_RuleSmoothCrease : {
+                float w = 1.0f - weight;
+                vdst->AddWithWeight( vsrc[p], w * 0.75f, clientdata );
+                vdst->AddWithWeight( vsrc[eidx0], w * 0.125f, clientdata );
+                vdst->AddWithWeight( vsrc[eidx1], w * 0.125f, clientdata );
+            } break;
+            case FarSubdivisionTables<U>::k_RuleCreaseCorner :
+                vdst->AddWithWeight( vsrc[p], 1.0f - weight, clientdata );
+                vdst->AddWithWeight( vsrc[p], weight * 0.75f, clientdata );
+                vdst->AddWithWeight( vsrc[eidx0], weight * 0.125f, clientdata );
+                vdst->AddWithWeight( vsrc[eidx1], weight * 0.125f, clientdata );
+                break;
+            case FarSubdivisionTables<U>::k_RuleCorner :
+                vdst->AddWithWeight( vsrc[p], 1.0f, clientdata );
+                break;
+            case FarSubdivisionTables<U>::k_RuleCrease :
+                vdst->AddWithWeight( vsrc[p], 0.75f, clientdata );
+                vdst->AddWithWeight( vsrc[eidx0], 0.125f, clientdata );
+                vdst->AddWithWeight( vsrc[eidx1], 0.125f, clientdata );
+                break;
+            default : break;
+        }
+        vdst->AddVaryingWithWeight( vsrc[p], 1.0f, clientdata );
+    }
+}
+
 //
 // Vertex-vertices compute Kernels "A" and "B" - completely re-entrant
 //
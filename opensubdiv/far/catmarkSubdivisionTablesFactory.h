@@ -96,10 +96,14 @@ FarCatmarkSubdivisionTablesFactory<T,U>::Create( FarMeshFactory<T,U> * meshFacto
     
     std::vector<int> & remap = meshFactory->getRemappingTable();
     
-    FarSubdivisionTablesFactory<T,U> tablesFactory( meshFactory->GetHbrMesh(), maxlevel, remap );
+    FarSubdivisionTablesFactory<T,U> tablesFactory( meshFactory->GetHbrMesh(), maxlevel, remap,
+                                                    meshFactory->_vertexOrdering );
 
     FarCatmarkSubdivisionTables<U> * result = new FarCatmarkSubdivisionTables<U>(farMesh, maxlevel);
 
+    // threads filling the indexing tables (see FarMeshFactory::SetNumThreads)
+    int nthreads = meshFactory->getThreadCount();
+
     // Allocate memory for the indexing tables
     result->_F_ITa.Resize(tablesFactory.GetNumFaceVerticesTotal(maxlevel)*2);
     result->_F_IT.Resize(tablesFactory.GetFaceVertsValenceSum());
@@ -110,6 +114,7 @@ FarCatmarkSubdivisionTablesFactory<T,U>::Create( FarMeshFactory<T,U> * meshFacto
     result->_V_ITa.Resize(tablesFactory.GetNumVertexVerticesTotal(maxlevel)*5);
     result->_V_IT.Resize(tablesFactory.GetVertVertsValenceSum()*2);
     result->_V_W.Resize(tablesFactory.GetNumVertexVerticesTotal(maxlevel));
+    result->_V_R.Resize(tablesFactory.GetNumVertexVerticesTotal(maxlevel));
 
     for (int level=1; level<=maxlevel; ++level) {
 
@@ -137,8 +142,18 @@ FarCatmarkSubdivisionTablesFactory<T,U>::Create( FarMeshFactory<T,U> * meshFacto
             F_ITa[2*i+0] = offset;
             F_ITa[2*i+1] = valence;
 
-            for (int j=0; j<valence; ++j)
-                F_IT[offset++] = remap[f->GetVertex(j)->GetID()];
+            offset += valence;
+        }
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if(nthreads>1)
+#endif
+        for (int i=0; i < batch->kernelF; ++i) {
+
+            HbrFace<T> * f=tablesFactory._faceVertsList[level][i]->GetParentFace();
+
+            for (int j=0; j<F_ITa[2*i+1]; ++j)
+                F_IT[F_ITa[2*i]+j] = remap[f->GetVertex(j)->GetID()];
         }
         result->_F_ITa.SetMarker(level, &F_ITa[2*batch->kernelF]);
         result->_F_IT.SetMarker(level, &F_IT[offset]);
@@ -156,6 +171,9 @@ FarCatmarkSubdivisionTablesFactory<T,U>::Create( FarMeshFactory<T,U> * meshFacto
         int * E_IT = result->_E_IT[level-1];
         float * E_W = result->_E_W[level-1];
         batch->kernelE = (int)tablesFactory._edgeVertsList[level].size();
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if(nthreads>1)
+#endif
         for (int i=0; i < batch->kernelE; ++i) {
 
             HbrVertex<T> * v = tablesFactory._edgeVertsList[level][i];
@@ -204,11 +222,18 @@ FarCatmarkSubdivisionTablesFactory<T,U>::Create( FarMeshFactory<T,U> * meshFacto
 
         batch->InitVertexKernels( (int)tablesFactory._vertVertsList[level].size(), 0 );
 
-        offset = 0;
         int * V_ITa = result->_V_ITa[level-1];
         unsigned int * V_IT = result->_V_IT[level-1];
         float * V_W = result->_V_W[level-1];
+        unsigned char * V_R = result->_V_R[level-1];
         int nverts = (int)tablesFactory._vertVertsList[level].size();
+
+        std::vector<int> offsets, ranks(nverts);
+        tablesFactory.computeVertVertsOffsets(level, 2, nthreads, offsets);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if(nthreads>1)
+#endif
         for (int i=0; i < nverts; ++i) {
 
             HbrVertex<T> * v = tablesFactory._vertVertsList[level][i],
@@ -239,7 +264,9 @@ FarCatmarkSubdivisionTablesFactory<T,U>::Create( FarMeshFactory<T,U> * meshFacto
                 npasses = 1;
             }
 
-            int rank = FarSubdivisionTablesFactory<T,U>::GetMaskRanking(masks[0], masks[1]);
+            int rank = FarSubdivisionTables<U>::GetMaskRanking(masks[0], masks[1]);
+
+            int offset = offsets[i];
 
             V_ITa[5*i+0] = offset;
             V_ITa[5*i+1] = 0;
@@ -310,11 +337,18 @@ FarCatmarkSubdivisionTablesFactory<T,U>::Create( FarMeshFactory<T,U> * meshFacto
             else
                 V_W[i] = weights[0];
 
-            batch->AddVertex( i, rank );
+            V_R[i] = FarSubdivisionTables<U>::GetVertexRule(rank);
+
+            ranks[i] = rank;
         }
+
+        for (int i=0; i < nverts; ++i)
+            batch->AddVertex( i, ranks[i] );
+
         result->_V_ITa.SetMarker(level, &V_ITa[5*nverts]);
-        result->_V_IT.SetMarker(level, &V_IT[offset]);
+        result->_V_IT.SetMarker(level, &V_IT[offsets[nverts]]);
         result->_V_W.SetMarker(level, &V_W[nverts]);
+        result->_V_R.SetMarker(level, &V_R[nverts]);
 
         if (nverts>0) {
             batch->kernelB.second++;
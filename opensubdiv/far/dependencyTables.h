@@ -0,0 +1,321 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef FAR_DEPENDENCY_TABLES_H
+#define FAR_DEPENDENCY_TABLES_H
+
+#include "../version.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Refined vertices affected by a set of modified coarse vertices.
+///
+/// The dirty vertices are grouped by level of subdivision and by compute
+/// kernel, as ranges of consecutive vertices. The ranges use the same indices
+/// as the 'start' and 'end' arguments of the FarDispatcher kernels, so that
+/// each range can be passed as-is to a kernel.
+///
+/// FarDirtyVertices are computed by FarDependencyTables::GetDirtyVertices().
+///
+class FarDirtyVertices {
+
+public:
+    /// First / last (excluded) kernel index of a range of vertices
+    typedef std::pair<int,int> Range;
+
+    FarDirtyVertices() : _numVertices(0) { }
+
+    /// Returns the number of levels of subdivision (levels 1 to N)
+    int GetNumLevels() const { return (int)_faceRanges.size(); }
+
+    /// Returns the ranges of dirty face-vertices of a level
+    std::vector<Range> const & GetFaceVertexRanges( int level ) const;
+
+    /// Returns the ranges of dirty edge-vertices of a level
+    std::vector<Range> const & GetEdgeVertexRanges( int level ) const;
+
+    /// Returns the ranges of dirty vertex-vertices of a level
+    std::vector<Range> const & GetVertexVertexRanges( int level ) const;
+
+    /// Returns the total number of dirty refined vertices
+    int GetNumVertices() const { return _numVertices; }
+
+private:
+    friend class FarDependencyTables;
+
+    std::vector< std::vector<Range> > _faceRanges,   // ranges of each level
+                                      _edgeRanges,
+                                      _vertexRanges;
+
+    int _numVertices;
+
+    // scratch buffers kept from one update to the next
+    std::vector<int>  _vertices;
+    std::vector<char> _marked;
+};
+
+inline std::vector<FarDirtyVertices::Range> const &
+FarDirtyVertices::GetFaceVertexRanges( int level ) const {
+    assert(level>0 and level<=GetNumLevels());
+    return _faceRanges[level-1];
+}
+
+inline std::vector<FarDirtyVertices::Range> const &
+FarDirtyVertices::GetEdgeVertexRanges( int level ) const {
+    assert(level>0 and level<=GetNumLevels());
+    return _edgeRanges[level-1];
+}
+
+inline std::vector<FarDirtyVertices::Range> const &
+FarDirtyVertices::GetVertexVertexRanges( int level ) const {
+    assert(level>0 and level<=GetNumLevels());
+    return _vertexRanges[level-1];
+}
+
+/// \brief Reverse dependencies of the subdivision tables.
+///
+/// The subdivision tables list, for each refined vertex, the vertices it is
+/// interpolated from. The dependency tables store the reverse relation : for
+/// each vertex of the mesh, the refined vertices that read it. Walking these
+/// tables from a set of modified coarse vertices yields the refined vertices
+/// that need to be recomputed, in time proportional to the size of the
+/// modified region of the mesh rather than to the size of the mesh.
+///
+/// Note that some refined vertices read vertices of their own level (ex.
+/// Catmark edge-vertices read the face-vertices of the adjacent faces) : the
+/// kernels of a level must still be applied in the order of the subdivision
+/// tables.
+///
+/// Dependency tables are created with a FarDependencyTablesFactory.
+///
+class FarDependencyTables {
+
+public:
+    /// Returns the number of coarse vertices
+    int GetNumControlVertices() const { return _numControlVertices; }
+
+    /// Returns the number of vertices of the mesh
+    int GetNumVertices() const { return (int)_offsets.size()-1; }
+
+    /// Returns the number of levels of subdivision (levels 1 to N)
+    int GetNumLevels() const { return (int)_levels.size(); }
+
+    /// Computes the refined vertices that depend on a set of coarse vertices
+    ///
+    /// @param coarseVertices  indices of the modified coarse vertices
+    ///
+    /// @param numVertices     number of indices in coarseVertices
+    ///
+    /// @param dirty           receives the dirty refined vertices
+    ///
+    void GetDirtyVertices( int const * coarseVertices, int numVertices,
+                           FarDirtyVertices * dirty ) const;
+
+    /// Allocates the memory GetDirtyVertices() needs to update 'dirty' for
+    /// any set of coarse vertices, so that it does not allocate afterwards
+    void ReserveDirtyVertices( FarDirtyVertices * dirty ) const;
+
+    /// Memory required to store the dependencies
+    int GetMemoryUsed() const;
+
+private:
+    template <class U> friend class FarDependencyTablesFactory;
+
+    FarDependencyTables() : _numControlVertices(0) { }
+
+    struct Level {
+        int firstVertex,
+            numFaceVertices,
+            numEdgeVertices,
+            numVertexVertices;
+    };
+
+    std::vector<Level> _levels;      // kernel layout of the levels 1 to N
+
+    std::vector<int>   _offsets,     // offset to the dependents of each vertex
+                       _dependents;  // refined vertices reading each vertex
+
+    int _numControlVertices;
+};
+
+inline void
+FarDependencyTables::GetDirtyVertices( int const * coarseVertices, int numVertices,
+                                       FarDirtyVertices * dirty ) const {
+    assert(dirty);
+
+    int nlevels = GetNumLevels();
+
+    dirty->_faceRanges.resize(nlevels);
+    dirty->_edgeRanges.resize(nlevels);
+    dirty->_vertexRanges.resize(nlevels);
+    dirty->_numVertices = 0;
+
+    std::vector<int> & vertices = dirty->_vertices;
+    std::vector<char> & marked = dirty->_marked;
+
+    vertices.clear();
+    marked.resize(GetNumVertices(), 0);
+
+    // gather the dependents of the coarse vertices, then the dependents of
+    // the dependents until the list is closed (coarse vertices do not depend
+    // on any other vertex, so they never need to be marked)
+    for (int i=0; i<numVertices; ++i) {
+        int v = coarseVertices[i];
+        assert(v>=0 and v<_numControlVertices);
+        for (int j=_offsets[v]; j<_offsets[v+1]; ++j) {
+            int d = _dependents[j];
+            if (not marked[d]) {
+                marked[d] = 1;
+                vertices.push_back(d);
+            }
+        }
+    }
+
+    for (int i=0; i<(int)vertices.size(); ++i) {
+        int v = vertices[i];
+        for (int j=_offsets[v]; j<_offsets[v+1]; ++j) {
+            int d = _dependents[j];
+            if (not marked[d]) {
+                marked[d] = 1;
+                vertices.push_back(d);
+            }
+        }
+    }
+
+    std::sort(vertices.begin(), vertices.end());
+
+    // the levels are stored in increasing order, as well as the face / edge /
+    // vertex-vertices of each level : split the sorted list into ranges of
+    // consecutive kernel indices
+    for (int i=0; i<nlevels; ++i) {
+        dirty->_faceRanges[i].clear();
+        dirty->_edgeRanges[i].clear();
+        dirty->_vertexRanges[i].clear();
+    }
+
+    for (int i=0, level=0; i<(int)vertices.size(); ++i) {
+
+        int v = vertices[i];
+        marked[v] = 0;
+
+        Level const * l = &_levels[level];
+        while (v >= l->firstVertex+l->numFaceVertices+l->numEdgeVertices+l->numVertexVertices) {
+            assert(level+1<nlevels);
+            l = &_levels[++level];
+        }
+
+        int index = v - l->firstVertex;
+        assert(index>=0);
+
+        std::vector<FarDirtyVertices::Range> * ranges;
+        if (index < l->numFaceVertices) {
+            ranges = &dirty->_faceRanges[level];
+        } else if ((index-=l->numFaceVertices) < l->numEdgeVertices) {
+            ranges = &dirty->_edgeRanges[level];
+        } else {
+            index -= l->numEdgeVertices;
+            ranges = &dirty->_vertexRanges[level];
+        }
+
+        if ((not ranges->empty()) and ranges->back().second==index)
+            ++ranges->back().second;
+        else
+            ranges->push_back( FarDirtyVertices::Range(index, index+1) );
+    }
+
+    dirty->_numVertices = (int)vertices.size();
+}
+
+inline void
+FarDependencyTables::ReserveDirtyVertices( FarDirtyVertices * dirty ) const {
+    assert(dirty);
+
+    int nlevels = GetNumLevels();
+
+    dirty->_faceRanges.resize(nlevels);
+    dirty->_edgeRanges.resize(nlevels);
+    dirty->_vertexRanges.resize(nlevels);
+
+    // the ranges are separated by a vertex at least
+    for (int i=0; i<nlevels; ++i) {
+        dirty->_faceRanges[i].reserve((_levels[i].numFaceVertices+1)/2);
+        dirty->_edgeRanges[i].reserve((_levels[i].numEdgeVertices+1)/2);
+        dirty->_vertexRanges[i].reserve((_levels[i].numVertexVertices+1)/2);
+    }
+
+    dirty->_vertices.reserve(GetNumVertices());
+    dirty->_marked.resize(GetNumVertices(), 0);
+}
+
+inline int
+FarDependencyTables::GetMemoryUsed() const {
+    return (int)(_levels.size()*sizeof(Level)+
+                 _offsets.size()*sizeof(int)+
+                 _dependents.size()*sizeof(int));
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_DEPENDENCY_TABLES_H */
@@ -0,0 +1,302 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef FAR_DEPENDENCY_TABLES_FACTORY_H
+#define FAR_DEPENDENCY_TABLES_FACTORY_H
+
+#include "../version.h"
+
+#include "../far/dispatcher.h"
+#include "../far/mesh.h"
+#include "../far/dependencyTables.h"
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief A specialized factory for FarDependencyTables
+///
+/// The factory applies the subdivision tables of a FarMesh with kernels that
+/// record the vertices read by each refined vertex, instead of interpolating
+/// vertex data.
+///
+template <class U> class FarDependencyTablesFactory {
+
+public:
+    /// Creates the dependency tables of the refined vertices of a mesh.
+    ///
+    /// @param mesh  the mesh to generate the dependencies from
+    ///
+    /// Returns 0 if the mesh has hierarchical vertex edits, since these are
+    /// applied to all the vertices of a level at once.
+    ///
+    static FarDependencyTables * Create( FarMesh<U> const * mesh );
+
+private:
+    // list of (vertex, dependent vertex) pairs
+    typedef std::vector< std::pair<int, int> > DependencyList;
+
+    // Dispatcher applying the compute kernels to a DependencyList
+    class DependencyDispatcher : public FarDispatcher<U> {
+    protected:
+        virtual void ApplyBilinearFaceVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
+
+        virtual void ApplyBilinearEdgeVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
+
+        virtual void ApplyBilinearVertexVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
+
+
+        virtual void ApplyCatmarkFaceVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
+
+        virtual void ApplyCatmarkEdgeVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
+
+        virtual void ApplyCatmarkVertexVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
+
+
+        virtual void ApplyLoopEdgeVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
+
+        virtual void ApplyLoopVertexVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
+
+    private:
+        static void addFaceDependencies( FarTable<unsigned int> const & F_IT, FarTable<int> const & F_ITa,
+                                         int offset, int level, int start, int end, DependencyList * list );
+
+        static void addEdgeDependencies( FarSubdivisionTables<U> const * tables, int stride,
+                                         int offset, int level, int start, int end, DependencyList * list );
+
+        static void addVertexDependencies( FarSubdivisionTables<U> const * tables, int stride,
+                                           int offset, int level, int start, int end, DependencyList * list );
+    };
+};
+
+template <class U> FarDependencyTables *
+FarDependencyTablesFactory<U>::Create( FarMesh<U> const * mesh ) {
+
+    assert( mesh );
+
+    if (mesh->GetVertexEdit())
+        return 0;
+
+    FarSubdivisionTables<U> const * tables = mesh->GetSubdivisionTables();
+    assert( tables );
+
+    int maxlevel = tables->GetMaxLevel()-1,
+        nverts = mesh->GetNumVertices();
+
+    DependencyList list;
+
+    DependencyDispatcher dispatcher;
+
+    FarDependencyTables * result = new FarDependencyTables;
+
+    result->_numControlVertices = tables->GetNumVertices(0);
+    result->_levels.resize(maxlevel);
+
+    for (int level=1; level<=maxlevel; ++level) {
+
+        tables->Apply( level, &dispatcher, &list );
+
+        FarDependencyTables::Level & l = result->_levels[level-1];
+        l.firstVertex = tables->GetFirstVertexOffset(level);
+        l.numFaceVertices = tables->GetNumFaceVertices(level);
+        l.numEdgeVertices = tables->GetNumEdgeVertices(level);
+        l.numVertexVertices = tables->GetNumVertexVertices(level);
+    }
+
+    // sort the dependents by vertex in a compressed row format
+    std::vector<int> & offsets = result->_offsets;
+    offsets.assign(nverts+1, 0);
+    for (int i=0; i<(int)list.size(); ++i) {
+        assert(list[i].first>=0 and list[i].first<nverts);
+        ++offsets[list[i].first+1];
+    }
+    for (int i=0; i<nverts; ++i)
+        offsets[i+1] += offsets[i];
+
+    std::vector<int> cursors(offsets.begin(), offsets.end()-1);
+
+    result->_dependents.resize(list.size());
+    for (int i=0; i<(int)list.size(); ++i)
+        result->_dependents[cursors[list[i].first]++] = list[i].second;
+
+    return result;
+}
+
+//
+// Symbolic compute kernels : these record every vertex read by the
+// FarSubdivisionTables kernels (vertex and varying interpolation).
+//
+
+template <class U> void
+FarDependencyTablesFactory<U>::DependencyDispatcher::addFaceDependencies( FarTable<unsigned int> const & F_IT, FarTable<int> const & F_ITa,
+                                                                          int offset, int level, int start, int end, DependencyList * list ) {
+
+    const int * ITa = F_ITa[level-1];
+    const unsigned int * IT = F_IT[level-1];
+
+    for (int i=start; i<end; ++i) {
+
+        int h = ITa[2*i  ],
+            n = ITa[2*i+1];
+
+        for (int j=0; j<n; ++j)
+            list->push_back( std::make_pair((int)IT[h+j], offset+i) );
+    }
+}
+
+template <class U> void
+FarDependencyTablesFactory<U>::DependencyDispatcher::addEdgeDependencies( FarSubdivisionTables<U> const * tables, int stride,
+                                                                          int offset, int level, int start, int end, DependencyList * list ) {
+
+    const int * E_IT = tables->Get_E_IT()[level-1];
+
+    for (int i=start; i<end; ++i) {
+        // boundary edges have no face vertices (-1)
+        for (int j=0; j<stride; ++j)
+            if (E_IT[stride*i+j]!=-1)
+                list->push_back( std::make_pair(E_IT[stride*i+j], offset+i) );
+    }
+}
+
+template <class U> void
+FarDependencyTablesFactory<U>::DependencyDispatcher::addVertexDependencies( FarSubdivisionTables<U> const * tables, int stride,
+                                                                            int offset, int level, int start, int end, DependencyList * list ) {
+
+    const int * V_ITa = tables->Get_V_ITa()[level-1];
+    const unsigned int * V_IT = tables->Get_V_IT()[level-1];
+
+    for (int i=start; i<end; ++i) {
+
+        int     h=V_ITa[5*i  ],
+                n=V_ITa[5*i+1],
+                p=V_ITa[5*i+2],
+            eidx0=V_ITa[5*i+3],
+            eidx1=V_ITa[5*i+4];
+
+        list->push_back( std::make_pair(p, offset+i) );
+
+        for (int j=0; j<n*stride; ++j)
+            list->push_back( std::make_pair((int)V_IT[h+j], offset+i) );
+
+        if (eidx0!=-1)
+            list->push_back( std::make_pair(eidx0, offset+i) );
+        if (eidx1!=-1)
+            list->push_back( std::make_pair(eidx1, offset+i) );
+    }
+}
+
+template <class U> void
+FarDependencyTablesFactory<U>::DependencyDispatcher::ApplyBilinearFaceVerticesKernel( FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata ) const {
+    FarBilinearSubdivisionTables<U> const * subdivision =
+        dynamic_cast<FarBilinearSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(subdivision);
+    addFaceDependencies( subdivision->Get_F_IT(), subdivision->Get_F_ITa(), offset, level, start, end, static_cast<DependencyList *>(clientdata) );
+}
+
+template <class U> void
+FarDependencyTablesFactory<U>::DependencyDispatcher::ApplyBilinearEdgeVerticesKernel( FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata ) const {
+    addEdgeDependencies( mesh->GetSubdivisionTables(), 2, offset, level, start, end, static_cast<DependencyList *>(clientdata) );
+}
+
+template <class U> void
+FarDependencyTablesFactory<U>::DependencyDispatcher::ApplyBilinearVertexVerticesKernel( FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata ) const {
+
+    DependencyList * list = static_cast<DependencyList *>(clientdata);
+
+    const int * V_ITa = mesh->GetSubdivisionTables()->Get_V_ITa()[level-1];
+
+    for (int i=start; i<end; ++i)
+        list->push_back( std::make_pair(V_ITa[i], offset+i) );
+}
+
+template <class U> void
+FarDependencyTablesFactory<U>::DependencyDispatcher::ApplyCatmarkFaceVerticesKernel( FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata ) const {
+    FarCatmarkSubdivisionTables<U> const * subdivision =
+        dynamic_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(subdivision);
+    addFaceDependencies( subdivision->Get_F_IT(), subdivision->Get_F_ITa(), offset, level, start, end, static_cast<DependencyList *>(clientdata) );
+}
+
+template <class U> void
+FarDependencyTablesFactory<U>::DependencyDispatcher::ApplyCatmarkEdgeVerticesKernel( FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata ) const {
+    addEdgeDependencies( mesh->GetSubdivisionTables(), 4, offset, level, start, end, static_cast<DependencyList *>(clientdata) );
+}
+
+template <class U> void
+FarDependencyTablesFactory<U>::DependencyDispatcher::ApplyCatmarkVertexVerticesKernel( FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata ) const {
+    // Catmark vertex-vertices read an edge-vertex and a face-vertex per valence
+    addVertexDependencies( mesh->GetSubdivisionTables(), 2, offset, level, start, end, static_cast<DependencyList *>(clientdata) );
+}
+
+template <class U> void
+FarDependencyTablesFactory<U>::DependencyDispatcher::ApplyLoopEdgeVerticesKernel( FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata ) const {
+    addEdgeDependencies( mesh->GetSubdivisionTables(), 4, offset, level, start, end, static_cast<DependencyList *>(clientdata) );
+}
+
+template <class U> void
+FarDependencyTablesFactory<U>::DependencyDispatcher::ApplyLoopVertexVerticesKernel( FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata ) const {
+    addVertexDependencies( mesh->GetSubdivisionTables(), 1, offset, level, start, end, static_cast<DependencyList *>(clientdata) );
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_DEPENDENCY_TABLES_FACTORY_H */
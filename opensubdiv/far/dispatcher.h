@@ -64,6 +64,7 @@
 #include "../far/catmarkSubdivisionTables.h"
 #include "../far/loopSubdivisionTables.h"
 #include "../far/vertexEditTables.h"
+#include "../far/kernelInstrumentation.h"
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
@@ -83,6 +84,14 @@ namespace OPENSUBDIV_VERSION {
 ///
 /// Note : the caller is responsible for deleting a custom dispatcher
 ///
+/// The subdivision tables compute the vertex-vertices with a single fused
+/// kernel (Apply*VertexVerticesKernel). Dispatchers that only implement the
+/// multi-pass "A" and "B" kernels can forward the fused kernel to
+/// Apply*VertexVerticesMultiPass.
+///
+/// The kernels launched by Refine are reported to the installed
+/// FarKernelInstrumentation, if any.
+///
 template <class U> class FarDispatcher {
 
 protected:
@@ -92,9 +101,13 @@ protected:
     friend class FarLoopSubdivisionTables<U>;
     friend class FarVertexEditTables<U>;
     friend class FarMesh<U>;
+    friend class FarKernelScope<U>;
 
     virtual void Refine(FarMesh<U> * mesh, int maxlevel, void * clientdata=0) const;
 
+    // Only computes the refined vertices listed in 'dirty' (see FarDependencyTables)
+    virtual void RefineDirty(FarMesh<U> * mesh, FarDirtyVertices const * dirty, void * clientdata=0) const;
+
 
     virtual void ApplyBilinearFaceVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
 
@@ -107,6 +120,8 @@ protected:
 
     virtual void ApplyCatmarkEdgeVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
 
+    virtual void ApplyCatmarkVertexVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
+
     virtual void ApplyCatmarkVertexVerticesKernelB(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
 
     virtual void ApplyCatmarkVertexVerticesKernelA(FarMesh<U> * mesh, int offset, bool pass, int level, int start, int end, void * clientdata) const;
@@ -114,6 +129,8 @@ protected:
 
     virtual void ApplyLoopEdgeVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
 
+    virtual void ApplyLoopVertexVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
+
     virtual void ApplyLoopVertexVerticesKernelB(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
 
     virtual void ApplyLoopVertexVerticesKernelA(FarMesh<U> * mesh, int offset, bool pass, int level, int start, int end, void * clientdata) const;
@@ -121,6 +138,18 @@ protected:
 
     virtual void ApplyVertexEdits(FarMesh<U> *mesh, int offset, int level, void * clientdata) const;
 
+
+    // Returns the size in bytes of the vertices written by the kernels (see
+    // FarKernelLaunch::bytes)
+    virtual size_t GetVertexSize(void * clientdata) const { return sizeof(U); }
+
+
+    // Applies the multi-pass kernels ("B" then "A" twice) to the vertex-vertices of a level
+    void ApplyCatmarkVertexVerticesMultiPass(FarMesh<U> * mesh, int offset, int level, void * clientdata) const;
+
+    // Applies the multi-pass kernels ("B" then "A" twice) to the vertex-vertices of a level
+    void ApplyLoopVertexVerticesMultiPass(FarMesh<U> * mesh, int offset, int level, void * clientdata) const;
+
 private:
     static FarDispatcher _DefaultDispatcher;
 };
@@ -153,83 +182,115 @@ FarDispatcher<U>::Refine( FarMesh<U> * mesh, int maxlevel, void * data) const {
     }
 }
 
+template <class U> void
+FarDispatcher<U>::RefineDirty( FarMesh<U> * mesh, FarDirtyVertices const * dirty, void * data) const {
+
+    assert(mesh and dirty);
+
+    FarSubdivisionTables<U> const * tables = mesh->GetSubdivisionTables();
+
+    // hierarchical edits cannot be restricted to the dirty vertices
+    assert(not mesh->GetVertexEdit());
+
+    int maxlevel = std::min(dirty->GetNumLevels()+1, tables->GetMaxLevel());
+
+    for (int i=1; i<maxlevel; ++i)
+        tables->ApplyDirty(i, dirty, this, data);
+}
+
 template <class U> void
 FarDispatcher<U>::ApplyBilinearFaceVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const {
     FarBilinearSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarBilinearSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-    assert(subdivision);
+        static_cast<FarBilinearSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(subdivision and subdivision->GetScheme()==FarSubdivisionTables<U>::k_Bilinear);
     subdivision->computeFacePoints(offset, level, start, end, clientdata);
 }
 
 template <class U> void
 FarDispatcher<U>::ApplyBilinearEdgeVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const {
     FarBilinearSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarBilinearSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-    assert(subdivision);
+        static_cast<FarBilinearSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(subdivision and subdivision->GetScheme()==FarSubdivisionTables<U>::k_Bilinear);
     subdivision->computeEdgePoints(offset, level, start, end, clientdata);
 }
 
 template <class U> void
 FarDispatcher<U>::ApplyBilinearVertexVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const {
     FarBilinearSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarBilinearSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-    assert(subdivision);
+        static_cast<FarBilinearSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(subdivision and subdivision->GetScheme()==FarSubdivisionTables<U>::k_Bilinear);
     subdivision->computeVertexPoints(offset, level, start, end, clientdata);
 }
 
 template <class U> void
 FarDispatcher<U>::ApplyCatmarkFaceVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const {
     FarCatmarkSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-    assert(subdivision);
+        static_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(subdivision and subdivision->GetScheme()==FarSubdivisionTables<U>::k_Catmark);
     subdivision->computeFacePoints(offset, level, start, end, clientdata);
 }
 
 template <class U> void
 FarDispatcher<U>::ApplyCatmarkEdgeVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const {
     FarCatmarkSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-    assert(subdivision);
+        static_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(subdivision and subdivision->GetScheme()==FarSubdivisionTables<U>::k_Catmark);
     subdivision->computeEdgePoints(offset, level, start, end, clientdata);
 }
 
+template <class U> void
+FarDispatcher<U>::ApplyCatmarkVertexVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const {
+    FarCatmarkSubdivisionTables<U> const * subdivision =
+        static_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(subdivision and subdivision->GetScheme()==FarSubdivisionTables<U>::k_Catmark);
+    subdivision->computeVertexPoints(offset, level, start, end, clientdata);
+}
+
 template <class U> void
 FarDispatcher<U>::ApplyCatmarkVertexVerticesKernelB(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const {
     FarCatmarkSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-    assert(subdivision);
+        static_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(subdivision and subdivision->GetScheme()==FarSubdivisionTables<U>::k_Catmark);
     subdivision->computeVertexPointsB(offset, level, start, end, clientdata);
 }
 
 template <class U> void
 FarDispatcher<U>::ApplyCatmarkVertexVerticesKernelA(FarMesh<U> * mesh, int offset, bool pass, int level, int start, int end, void * clientdata) const {
     FarCatmarkSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-    assert(subdivision);
+        static_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(subdivision and subdivision->GetScheme()==FarSubdivisionTables<U>::k_Catmark);
     subdivision->computeVertexPointsA(offset, pass, level, start, end, clientdata);
 }
 
 template <class U> void
 FarDispatcher<U>::ApplyLoopEdgeVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const {
     FarLoopSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarLoopSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-    assert(subdivision);
+        static_cast<FarLoopSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(subdivision and subdivision->GetScheme()==FarSubdivisionTables<U>::k_Loop);
     subdivision->computeEdgePoints(offset, level, start, end, clientdata);
 }
 
+template <class U> void
+FarDispatcher<U>::ApplyLoopVertexVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const {
+    FarLoopSubdivisionTables<U> const * subdivision =
+        static_cast<FarLoopSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(subdivision and subdivision->GetScheme()==FarSubdivisionTables<U>::k_Loop);
+    subdivision->computeVertexPoints(offset, level, start, end, clientdata);
+}
+
 template <class U> void
 FarDispatcher<U>::ApplyLoopVertexVerticesKernelB(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const {
     FarLoopSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarLoopSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-    assert(subdivision);
+        static_cast<FarLoopSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(subdivision and subdivision->GetScheme()==FarSubdivisionTables<U>::k_Loop);
     subdivision->computeVertexPointsB(offset, level, start, end, clientdata);
 }
 
 template <class U> void
 FarDispatcher<U>::ApplyLoopVertexVerticesKernelA(FarMesh<U> * mesh, int offset, bool pass, int level, int start, int end, void * clientdata) const {
     FarLoopSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarLoopSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-    assert(subdivision);
+        static_cast<FarLoopSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(subdivision and subdivision->GetScheme()==FarSubdivisionTables<U>::k_Loop);
     subdivision->computeVertexPointsA(offset, pass, level, start, end, clientdata);
 }
 
@@ -240,6 +301,46 @@ FarDispatcher<U>::ApplyVertexEdits(FarMesh<U> * mesh, int offset, int level, voi
         vertEdit->computeVertexEdits(level, clientdata);
 }
 
+template <class U> void
+FarDispatcher<U>::ApplyCatmarkVertexVerticesMultiPass(FarMesh<U> * mesh, int offset, int level, void * clientdata) const {
+    FarSubdivisionTables<U> const * tables = mesh->GetSubdivisionTables();
+    assert(tables);
+    typename FarSubdivisionTables<U>::VertexKernelBatch const & batch = tables->_batches[level-1];
+
+    if (batch.kernelB.first < batch.kernelB.second) {
+        FarKernelScope<U> scope(this, clientdata, tables, FarKernelLaunch::k_VertexVerticesB, level, offset, batch.kernelB.first, batch.kernelB.second);
+        ApplyCatmarkVertexVerticesKernelB(mesh, offset, level, batch.kernelB.first, batch.kernelB.second, clientdata);
+    }
+    if (batch.kernelA1.first < batch.kernelA1.second) {
+        FarKernelScope<U> scope(this, clientdata, tables, FarKernelLaunch::k_VertexVerticesA1, level, offset, batch.kernelA1.first, batch.kernelA1.second);
+        ApplyCatmarkVertexVerticesKernelA(mesh, offset, false, level, batch.kernelA1.first, batch.kernelA1.second, clientdata);
+    }
+    if (batch.kernelA2.first < batch.kernelA2.second) {
+        FarKernelScope<U> scope(this, clientdata, tables, FarKernelLaunch::k_VertexVerticesA2, level, offset, batch.kernelA2.first, batch.kernelA2.second);
+        ApplyCatmarkVertexVerticesKernelA(mesh, offset, true, level, batch.kernelA2.first, batch.kernelA2.second, clientdata);
+    }
+}
+
+template <class U> void
+FarDispatcher<U>::ApplyLoopVertexVerticesMultiPass(FarMesh<U> * mesh, int offset, int level, void * clientdata) const {
+    FarSubdivisionTables<U> const * tables = mesh->GetSubdivisionTables();
+    assert(tables);
+    typename FarSubdivisionTables<U>::VertexKernelBatch const & batch = tables->_batches[level-1];
+
+    if (batch.kernelB.first < batch.kernelB.second) {
+        FarKernelScope<U> scope(this, clientdata, tables, FarKernelLaunch::k_VertexVerticesB, level, offset, batch.kernelB.first, batch.kernelB.second);
+        ApplyLoopVertexVerticesKernelB(mesh, offset, level, batch.kernelB.first, batch.kernelB.second, clientdata);
+    }
+    if (batch.kernelA1.first < batch.kernelA1.second) {
+        FarKernelScope<U> scope(this, clientdata, tables, FarKernelLaunch::k_VertexVerticesA1, level, offset, batch.kernelA1.first, batch.kernelA1.second);
+        ApplyLoopVertexVerticesKernelA(mesh, offset, false, level, batch.kernelA1.first, batch.kernelA1.second, clientdata);
+    }
+    if (batch.kernelA2.first < batch.kernelA2.second) {
+        FarKernelScope<U> scope(this, clientdata, tables, FarKernelLaunch::k_VertexVerticesA2, level, offset, batch.kernelA2.first, batch.kernelA2.second);
+        ApplyLoopVertexVerticesKernelA(mesh, offset, true, level, batch.kernelA2.first, batch.kernelA2.second, clientdata);
+    }
+}
+
 } // end namespace OPENSUBDIV_VERSION
 using namespace OPENSUBDIV_VERSION;
 
@@ -0,0 +1,177 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+
+#ifndef FAR_FVAR_TABLES_H
+#define FAR_FVAR_TABLES_H
+
+#include "../version.h"
+
+#include "../far/stencilTables.h"
+
+#include <cassert>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Face-varying interpolation tables.
+///
+/// The face-varying data of a mesh is stored per face-vertex ("corner") : the
+/// tables compute the corners of each subdivision level as weighted sums of
+/// the corners of the previous level, following the face-varying boundary
+/// interpolation rules of the Hbr mesh the tables were created from.
+///
+/// All the levels share a single buffer of GetNumCorners() corners, each made
+/// of GetTotalFVarWidth() floats :
+///
+///    - the corners of level 0 are the face-vertices of the coarse faces, in
+///      face order (face 'i' of 'n' vertices owns 'n' consecutive corners)
+///
+///    - the corners of the levels 1 to N are laid out like the data returned
+///      by FarMesh::GetFVarData() : 4 corners per refined quad
+///
+/// The tables of a given level and face-varying datum are stencil tables :
+/// stencil 'i' computes corner GetFirstVertexOffset()+i and its control
+/// indices are corners of the previous level. The discontinuities of the
+/// data (seams) are captured when the tables are created : the coarse values
+/// can then be modified freely, as long as the seams do not change.
+///
+class FarFVarTables {
+
+public:
+    ~FarFVarTables();
+
+    /// Returns the number of subdivision levels
+    int GetMaxLevel() const { return (int)_firstCorners.size()-2; }
+
+    /// Returns the number of corners across all the levels
+    int GetNumCorners() const { return _firstCorners.back(); }
+
+    /// Returns the number of corners of a given level
+    int GetNumCorners(int level) const {
+        return _firstCorners[level+1]-_firstCorners[level];
+    }
+
+    /// Returns the index of the first corner of a given level
+    int GetFirstCorner(int level) const { return _firstCorners[level]; }
+
+    /// Returns the number of face-varying data items
+    int GetFVarCount() const { return (int)_widths.size(); }
+
+    /// Returns the width of each face-varying data item
+    std::vector<int> const & GetFVarWidths() const { return _widths; }
+
+    /// Returns the offset of each face-varying data item within a corner
+    std::vector<int> const & GetFVarOffsets() const { return _offsets; }
+
+    /// Returns the number of floats per corner
+    int GetTotalFVarWidth() const { return _totalWidth; }
+
+    /// Returns the tables computing the data item 'item' of the corners of
+    /// 'level' (from 1 to GetMaxLevel())
+    FarStencilTables const * GetTables(int level, int item) const;
+
+    /// Memory required to store the tables
+    int GetMemoryUsed() const;
+
+private:
+    template <class X, class Y> friend class FarFVarTablesFactory;
+    template <class X> friend class FarMeshSerializer;
+
+    FarFVarTables() : _totalWidth(0) { }
+
+    // non-copyable, so these are not implemented:
+    FarFVarTables(FarFVarTables const &);
+    FarFVarTables & operator = (FarFVarTables const &);
+
+    std::vector<int> _firstCorners,  // first corner of each level (+ total)
+                     _widths,        // width of each data item
+                     _offsets;       // offset of each data item in a corner
+
+    int _totalWidth;
+
+    // stencils of each data item at each level : level 'l' item 'i' is at
+    // index (l-1)*GetFVarCount()+i
+    std::vector<FarStencilTables *> _tables;
+};
+
+inline
+FarFVarTables::~FarFVarTables() {
+    for (int i=0; i<(int)_tables.size(); ++i)
+        delete _tables[i];
+}
+
+inline FarStencilTables const *
+FarFVarTables::GetTables(int level, int item) const {
+    assert( level>0 and level<=GetMaxLevel() and item>=0 and item<GetFVarCount() );
+    return _tables[(level-1)*GetFVarCount()+item];
+}
+
+inline int
+FarFVarTables::GetMemoryUsed() const {
+    int result = (int)((_firstCorners.size()+_widths.size()+_offsets.size())*sizeof(int));
+    for (int i=0; i<(int)_tables.size(); ++i)
+        result += _tables[i]->GetMemoryUsed();
+    return result;
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_FVAR_TABLES_H */
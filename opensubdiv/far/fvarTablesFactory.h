@@ -0,0 +1,447 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+
+#ifndef FAR_FVAR_TABLES_FACTORY_H
+#define FAR_FVAR_TABLES_FACTORY_H
+
+#include "../version.h"
+
+#include "../hbr/mesh.h"
+#include "../hbr/fvarEdit.h"
+
+#include "../far/fvarTables.h"
+
+#include <cassert>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+template <class T, class U> class FarMeshFactory;
+
+/// \brief A specialized factory for FarFVarTables
+///
+/// The factory applies the face-varying subdivision rules of Hbr to symbolic
+/// corners : instead of interpolating the face-varying data of the children
+/// of each face, it records the corners of the parent level and the weights
+/// that the rules apply to them.
+///
+template <class T, class U> class FarFVarTablesFactory {
+
+protected:
+    template <class X, class Y> friend class FarMeshFactory;
+
+    /// Creates a FarFVarTables instance from the faces refined by the factory.
+    /// Returns 0 if the face-varying interpolation of the mesh cannot be
+    /// expressed with the tables (Loop meshes, face-varying edits).
+    static FarFVarTables * Create( FarMeshFactory<T,U> const * factory );
+
+private:
+    // Index of the first corner of each face, indexed by Hbr face ID
+    typedef std::vector<int> CornerMap;
+
+    typedef std::vector< std::pair<int, float> > Stencil;
+
+    // Stencil held by each face-varying datum of the Hbr vertices
+    typedef std::map<HbrFVarData<T> const *, Stencil> StencilMap;
+
+    // Adds corner 'j' of face 'f' to a stencil
+    static void addCorner( Stencil & stencil, CornerMap const & corners,
+                           HbrFace<T> const * f, int j, float weight );
+
+    // Adds all the corners of face 'f' to a stencil
+    static void addFace( Stencil & stencil, CornerMap const & corners,
+                         HbrFace<T> const * f, float weight );
+
+    // Returns the corner of vertex 'v' in face 'f'
+    static int findCorner( HbrFace<T> const * f, HbrVertex<T> const * v );
+
+    // Face-varying rules of the vertex-vertex of 'face->GetVertex(index)'.
+    // Returns true if the smooth rule was applied.
+    static bool computeVertexCorner( Stencil & stencil, CornerMap const & corners,
+                                     HbrMesh<T> * mesh, HbrFace<T> * face,
+                                     int index, int item );
+
+    // Face-varying rules of the edge-vertex of 'edge', between the corners
+    // 'org' and 'dst' of 'face'. Returns true if the smooth rule was applied.
+    static bool computeEdgeCorner( Stencil & stencil, CornerMap const & corners,
+                                   HbrMesh<T> * mesh, HbrFace<T> * face,
+                                   HbrHalfedge<T> * edge, int org, int dst, int item );
+};
+
+template <class T, class U> void
+FarFVarTablesFactory<T,U>::addCorner( Stencil & stencil, CornerMap const & corners,
+                                      HbrFace<T> const * f, int j, float weight ) {
+
+    assert( corners[f->GetID()]>=0 );
+    stencil.push_back(std::make_pair(corners[f->GetID()]+j, weight));
+}
+
+template <class T, class U> void
+FarFVarTablesFactory<T,U>::addFace( Stencil & stencil, CornerMap const & corners,
+                                    HbrFace<T> const * f, float weight ) {
+
+    for (int j=0; j<f->GetNumVertices(); ++j)
+        addCorner(stencil, corners, f, j, weight);
+}
+
+template <class T, class U> int
+FarFVarTablesFactory<T,U>::findCorner( HbrFace<T> const * f, HbrVertex<T> const * v ) {
+
+    int j;
+    for (j=0; j<f->GetNumVertices(); ++j)
+        if (f->GetVertex(j)==v)
+            break;
+    assert( j!=f->GetNumVertices() );
+    return j;
+}
+
+// Follows HbrCatmarkSubdivision<T>::transferFVarToChild : the bilinear scheme
+// applies the same face-varying rules.
+template <class T, class U> bool
+FarFVarTablesFactory<T,U>::computeVertexCorner( Stencil & stencil, CornerMap const & corners,
+                                                HbrMesh<T> * mesh, HbrFace<T> * face,
+                                                int index, int item ) {
+
+    typename HbrMesh<T>::InterpolateBoundaryMethod fvarinterp = mesh->GetFVarInterpolateBoundaryMethod();
+
+    HbrVertex<T> * v = face->GetVertex(index);
+
+    bool infcorner = false;
+    const unsigned char fvarmask = v->GetFVarMask(item);
+    if (fvarinterp == HbrMesh<T>::k_InterpolateBoundaryEdgeAndCorner) {
+        if (fvarmask >= HbrVertex<T>::k_Corner) {
+            infcorner = true;
+        } else if (mesh->GetFVarPropagateCorners()) {
+            if (v->IsFVarCorner(item)) {
+                infcorner = true;
+            }
+        } else {
+            if (face->GetEdge(index)->GetFVarSharpness(item, true) and
+                face->GetEdge(index)->GetPrev()->GetFVarSharpness(item, true)) {
+                infcorner = true;
+            }
+        }
+    }
+
+    if (fvarinterp == HbrMesh<T>::k_InterpolateBoundaryNone or
+        (fvarinterp == HbrMesh<T>::k_InterpolateBoundaryAlwaysSharp and fvarmask >= 1) or
+        v->GetSharpness() > HbrVertex<T>::k_Smooth or
+        infcorner) {
+
+        // Infinitely sharp vertex rule
+        addCorner(stencil, corners, face, index, 1.0f);
+
+    } else if (fvarmask == 1) {
+
+        // Dart rule : 0.125 of the values of the vertex on each side of its
+        // single incident face-varying sharp edge
+        addCorner(stencil, corners, face, index, 0.75f);
+
+        HbrHalfedge<T> * start = v->GetIncidentEdge(), * edge = start;
+        while (edge) {
+            if (edge->GetFVarSharpness(item))
+                break;
+            HbrHalfedge<T> * nextedge = v->GetNextEdge(edge);
+            if (nextedge == start) {
+                assert(0);
+                break;
+            } else if (not nextedge) {
+                // a vertex on a boundary cannot be a face-varying dart
+                assert(0);
+                edge = edge->GetPrev();
+                break;
+            }
+            edge = nextedge;
+        }
+        HbrVertex<T> * w = edge->GetDestVertex();
+        HbrFace<T> * bestface = edge->GetLeftFace();
+        addCorner(stencil, corners, bestface, findCorner(bestface, w), 0.125f);
+        bestface = edge->GetRightFace();
+        addCorner(stencil, corners, bestface, findCorner(bestface, w), 0.125f);
+
+    } else if (fvarmask != 0) {
+
+        // Boundary rule : 0.125 of the face-varying boundary neighbors found
+        // by cycling counterclockwise, then clockwise around v
+        addCorner(stencil, corners, face, index, 0.75f);
+
+        HbrFace<T> * bestface = face;
+        HbrHalfedge<T> * bestedge = face->GetEdge(index)->GetPrev();
+        HbrHalfedge<T> * starte = bestedge->GetOpposite();
+        HbrVertex<T> * w = 0;
+        if (not starte) {
+            w = face->GetEdge(index)->GetPrev()->GetOrgVertex();
+        } else {
+            HbrHalfedge<T> * e = starte, * next;
+            do {
+                if (e->GetFVarSharpness(item) or not e->GetLeftFace()) {
+                    bestface = e->GetRightFace();
+                    bestedge = e;
+                    break;
+                }
+                next = v->GetNextEdge(e);
+                if (not next) {
+                    bestface = e->GetLeftFace();
+                    w = e->GetPrev()->GetOrgVertex();
+                    break;
+                }
+                e = next;
+            } while (e and e != starte);
+        }
+        if (not w)
+            w = bestedge->GetDestVertex();
+        addCorner(stencil, corners, bestface, findCorner(bestface, w), 0.125f);
+
+        bestface = face;
+        bestedge = face->GetEdge(index);
+        starte = bestedge;
+        if (HbrHalfedge<T> * e = starte) {
+            do {
+                if (e->GetFVarSharpness(item) or not e->GetRightFace()) {
+                    bestface = e->GetLeftFace();
+                    bestedge = e;
+                    break;
+                }
+                e = v->GetPreviousEdge(e);
+            } while (e and e != starte);
+        }
+        w = bestedge->GetDestVertex();
+        addCorner(stencil, corners, bestface, findCorner(bestface, w), 0.125f);
+
+    } else {
+
+        // Smooth rule : (n-2)/n of the vertex, 1/n^2 of the surrounding
+        // edge-vertices and face averages
+        int valence = v->GetValence();
+        float invvalencesquared = 1.0f / (valence * valence);
+
+        addCorner(stencil, corners, face, index, invvalencesquared * valence * (valence - 2));
+
+        HbrHalfedge<T> * start = v->GetIncidentEdge(), * edge = start;
+        while (edge) {
+            HbrFace<T> * g = edge->GetLeftFace();
+            int nv = g->GetNumVertices();
+            float weight = invvalencesquared / nv;
+            for (int j=0; j<nv; ++j) {
+                addCorner(stencil, corners, g, j, weight);
+                if (g->GetEdge(j)->GetOrgVertex() == v)
+                    addCorner(stencil, corners, g, (j+1)%nv, invvalencesquared);
+            }
+            edge = v->GetNextEdge(edge);
+            if (edge == start)
+                break;
+        }
+        return true;
+    }
+    return false;
+}
+
+template <class T, class U> bool
+FarFVarTablesFactory<T,U>::computeEdgeCorner( Stencil & stencil, CornerMap const & corners,
+                                              HbrMesh<T> * mesh, HbrFace<T> * face,
+                                              HbrHalfedge<T> * edge, int org, int dst, int item ) {
+
+    if (mesh->GetFVarInterpolateBoundaryMethod() == HbrMesh<T>::k_InterpolateBoundaryNone or
+        edge->GetFVarSharpness(item) or edge->IsBoundary()) {
+
+        // Sharp edge rule
+        addCorner(stencil, corners, face, org, 0.5f);
+        addCorner(stencil, corners, face, dst, 0.5f);
+        return false;
+    } else {
+        // Smooth edge rule : 0.25 of the end points, of the face-vertex and
+        // of the average of the opposite face
+        addCorner(stencil, corners, face, org, 0.25f);
+        addCorner(stencil, corners, face, dst, 0.25f);
+        addFace(stencil, corners, face, 0.25f / face->GetNumVertices());
+
+        HbrFace<T> * oppFace = edge->GetRightFace();
+        addFace(stencil, corners, oppFace, 0.25f / oppFace->GetNumVertices());
+        return true;
+    }
+}
+
+template <class T, class U> FarFVarTables *
+FarFVarTablesFactory<T,U>::Create( FarMeshFactory<T,U> const * factory ) {
+
+    assert( factory );
+
+    HbrMesh<T> * mesh = factory->_hbrMesh;
+
+    if (factory->_adaptive or mesh->GetTotalFVarWidth()==0 or
+        not (FarMeshFactory<T,U>::isCatmark(mesh) or
+             FarMeshFactory<T,U>::isBilinear(mesh)))
+        return 0;
+
+    std::vector<HbrHierarchicalEdit<T>*> const & hEdits = mesh->GetHierarchicalEdits();
+    for (int i=0; i<(int)hEdits.size(); ++i)
+        if (dynamic_cast<HbrFVarEdit<T> *>(hEdits[i]))
+            return 0;
+
+    std::vector<std::vector< HbrFace<T> *> > const & facesList = factory->_facesList;
+
+    int maxlevel = factory->_maxlevel,
+        fvarcount = mesh->GetFVarCount();
+
+    FarFVarTables * result = new FarFVarTables;
+
+    result->_widths.assign(mesh->GetFVarWidths(), mesh->GetFVarWidths()+fvarcount);
+    result->_offsets.assign(mesh->GetFVarIndices(), mesh->GetFVarIndices()+fvarcount);
+    result->_totalWidth = mesh->GetTotalFVarWidth();
+
+    // Number the corners : the coarse faces own one corner per vertex, the
+    // refined quads 4 corners
+    CornerMap corners(mesh->GetNumFaces(), -1);
+
+    result->_firstCorners.resize(maxlevel+2);
+    result->_firstCorners[0] = 0;
+    for (int l=0, corner=0; l<=maxlevel; ++l) {
+        for (int i=0; i<(int)facesList[l].size(); ++i) {
+            HbrFace<T> const * f = facesList[l][i];
+            corners[f->GetID()] = corner;
+            corner += l==0 ? f->GetNumVertices() : 4;
+        }
+        result->_firstCorners[l+1] = corner;
+    }
+
+    // The face-varying data of a refined vertex is shared by its incident
+    // faces unless it is discontinuous. Hbr computes the data of the faces in
+    // the order they are created (in ID order) : the sharp rules overwrite
+    // the shared data, while the smooth rules only initialize it. The
+    // stencils of the shared data are resolved the same way, so that the
+    // corners match the face-varying data of the Hbr mesh.
+    result->_tables.resize(maxlevel*fvarcount);
+    for (int l=1; l<=maxlevel; ++l) {
+
+        int numCorners = result->GetNumCorners(l);
+
+        for (int item=0; item<fvarcount; ++item) {
+
+            StencilMap stencils;
+
+            for (int i=0; i<(int)facesList[l].size(); ++i) {
+
+                HbrFace<T> * child = facesList[l][i],
+                           * face = child->GetParent();
+                assert( face and child->GetNumVertices()==4 );
+
+                int nv = face->GetNumVertices(), index = 0;
+                while (face->GetChild(index)!=child)
+                    ++index;
+
+                HbrHalfedge<T> * edge = face->GetEdge(index);
+
+                // The children of quads are rotated to preserve the
+                // parametric space of the parent
+                bool extraordinary = (nv != 4);
+                for (int j=0; j<4; ++j) {
+
+                    Stencil stencil;
+                    bool smooth = true;
+                    switch (extraordinary ? j : (j+4-index)%4) {
+                        case 0 : smooth = computeVertexCorner(stencil, corners, mesh, face, index, item); break;
+                        case 1 : smooth = computeEdgeCorner(stencil, corners, mesh, face, edge,
+                                                            index, (index+1)%nv, item); break;
+                        case 2 : addFace(stencil, corners, face, 1.0f / nv); break;
+                        case 3 : smooth = computeEdgeCorner(stencil, corners, mesh, face, edge->GetPrev(),
+                                                            (index+nv-1)%nv, index, item); break;
+                    }
+
+                    HbrFVarData<T> const * fvdata = &child->GetVertex(j)->GetFVarData(child);
+                    typename StencilMap::iterator it = stencils.find(fvdata);
+                    if (it==stencils.end())
+                        stencils[fvdata].swap(stencil);
+                    else if (not smooth)
+                        it->second.swap(stencil);
+                }
+            }
+
+            FarStencilTables * tables = new FarStencilTables;
+            result->_tables[(l-1)*fvarcount+item] = tables;
+
+            tables->_firstVertexOffset = result->GetFirstCorner(l);
+            tables->_numControlVertices = result->GetFirstCorner(l);
+            tables->_sizes.reserve(numCorners);
+            tables->_offsets.reserve(numCorners);
+
+            for (int i=0; i<(int)facesList[l].size(); ++i) {
+                HbrFace<T> * child = facesList[l][i];
+                for (int j=0; j<4; ++j) {
+                    Stencil const & stencil = stencils[&child->GetVertex(j)->GetFVarData(child)];
+                    tables->_sizes.push_back((int)stencil.size());
+                    tables->_offsets.push_back((int)tables->_indices.size());
+                    for (int k=0; k<(int)stencil.size(); ++k) {
+                        tables->_indices.push_back(stencil[k].first);
+                        tables->_weights.push_back(stencil[k].second);
+                    }
+                }
+            }
+            assert( tables->GetNumStencils()==numCorners );
+        }
+    }
+    return result;
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_FVAR_TABLES_FACTORY_H */
@@ -0,0 +1,257 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef FAR_KERNEL_INSTRUMENTATION_H
+#define FAR_KERNEL_INSTRUMENTATION_H
+
+#include "../version.h"
+
+#include "../far/subdivisionTables.h"
+
+#include <cstddef>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+template <class U> class FarDispatcher;
+template <class U> class FarBilinearSubdivisionTables;
+template <class U> class FarCatmarkSubdivisionTables;
+
+/// \brief A subdivision kernel launched by a dispatcher.
+///
+/// Describes the vertices [start, end) of a level computed by a kernel, which
+/// are written at offset+start. 'bytes' estimates the memory touched by the
+/// kernel : the subdivision table entries it reads and the vertices it writes
+/// (the vertices it reads are not counted).
+struct FarKernelLaunch {
+
+    enum Kernel {
+        k_FaceVertices=0,   ///< face-vertices
+        k_EdgeVertices,     ///< edge-vertices
+        k_VertexVertices,   ///< vertex-vertices (fused kernel)
+        k_VertexVerticesB,  ///< vertex-vertices "B" pass (multi-pass dispatchers)
+        k_VertexVerticesA1, ///< vertex-vertices first "A" pass
+        k_VertexVerticesA2, ///< vertex-vertices second "A" pass
+        k_VertexEdits,      ///< hierarchical edits of the level
+        k_NumKernels
+    };
+
+    int scheme;       ///< FarSubdivisionTables::Scheme of the mesh
+    Kernel kernel;
+    int level,
+        offset,
+        start,
+        end;
+    size_t bytes;
+};
+
+/// \brief Instrumentation of the subdivision kernels.
+///
+/// Once installed, the instrumentation is called before and after every
+/// kernel launched by FarDispatcher::Refine and the Osd CPU and OMP
+/// dispatchers (refinements of dirty vertices are not instrumented). When no
+/// instrumentation is installed, the cost is a test per kernel launch.
+///
+/// The k_VertexVerticesB/A1/A2 passes of the dispatchers that compute the
+/// vertex-vertices in multiple passes are reported within the k_VertexVertices
+/// launch of the level.
+///
+/// The instrumentation is called by the threads refining the meshes : meshes
+/// refined concurrently (ex. asynchronous controllers, OMP batches of small
+/// meshes) call it concurrently.
+///
+class FarKernelInstrumentation {
+public:
+    virtual ~FarKernelInstrumentation() { }
+
+    /// Called before the kernel runs
+    virtual void BeginKernel(FarKernelLaunch const & launch) = 0;
+
+    /// Called after the kernel completes
+    virtual void EndKernel(FarKernelLaunch const & launch) = 0;
+
+    /// Installs the instrumentation of the kernels (NULL to uninstall). The
+    /// instrumentation is not owned and must not be (un)installed while
+    /// meshes are refined.
+    static void Install(FarKernelInstrumentation * instrumentation) {
+        instance() = instrumentation;
+    }
+
+    /// Returns the installed instrumentation (NULL if none)
+    static FarKernelInstrumentation * GetInstalled() {
+        return instance();
+    }
+
+private:
+    static FarKernelInstrumentation *& instance() {
+        static FarKernelInstrumentation * installed = 0;
+        return installed;
+    }
+};
+
+/// \brief Reports the kernel launched in its scope by a dispatcher to the
+/// installed instrumentation, if any.
+///
+template <class U> class FarKernelScope {
+public:
+    FarKernelScope(FarDispatcher<U> const * dispatch, void * clientdata,
+                   FarSubdivisionTables<U> const * tables,
+                   FarKernelLaunch::Kernel kernel, int level, int offset,
+                   int start, int end) :
+        _instrumentation(FarKernelInstrumentation::GetInstalled()) {
+
+        if (_instrumentation)
+            begin(dispatch, clientdata, tables, kernel, level, offset, start, end);
+    }
+
+    ~FarKernelScope() {
+        if (_instrumentation)
+            _instrumentation->EndKernel(_launch);
+    }
+
+private:
+    void begin(FarDispatcher<U> const * dispatch, void * clientdata,
+               FarSubdivisionTables<U> const * tables,
+               FarKernelLaunch::Kernel kernel, int level, int offset,
+               int start, int end);
+
+    // Returns the bytes of the table entries read by the kernel
+    static size_t getTableBytes(FarSubdivisionTables<U> const * tables,
+                                FarKernelLaunch::Kernel kernel, int level,
+                                int start, int end);
+
+    FarKernelInstrumentation * _instrumentation;
+    FarKernelLaunch _launch;
+};
+
+template <class U> void
+FarKernelScope<U>::begin(FarDispatcher<U> const * dispatch, void * clientdata,
+                         FarSubdivisionTables<U> const * tables,
+                         FarKernelLaunch::Kernel kernel, int level, int offset,
+                         int start, int end) {
+
+    _launch.scheme = tables->GetScheme();
+    _launch.kernel = kernel;
+    _launch.level = level;
+    _launch.offset = offset;
+    _launch.start = start;
+    _launch.end = end;
+    _launch.bytes = size_t(end-start) * dispatch->GetVertexSize(clientdata) +
+                    getTableBytes(tables, kernel, level, start, end);
+
+    _instrumentation->BeginKernel(_launch);
+}
+
+template <class U> size_t
+FarKernelScope<U>::getTableBytes(FarSubdivisionTables<U> const * tables,
+                                 FarKernelLaunch::Kernel kernel, int level,
+                                 int start, int end) {
+
+    typedef FarSubdivisionTables<U> Tables;
+
+    if (end <= start)
+        return 0;
+
+    int n = end-start,
+        last = end-1;
+
+    // (the rows of the kernels are laid out as in the Osd CPU kernels)
+    switch (kernel) {
+        case FarKernelLaunch::k_FaceVertices : {
+            int const * F_ITa = tables->GetScheme() == Tables::k_Catmark ?
+                static_cast<FarCatmarkSubdivisionTables<U> const *>(tables)->Get_F_ITa()[level-1] :
+                static_cast<FarBilinearSubdivisionTables<U> const *>(tables)->Get_F_ITa()[level-1];
+            int nindices = F_ITa[2*last] + F_ITa[2*last+1] - F_ITa[2*start];
+            return n*2*sizeof(int) + nindices*sizeof(unsigned int);
+        }
+
+        case FarKernelLaunch::k_EdgeVertices :
+            if (tables->GetScheme() == Tables::k_Bilinear)
+                return n*2*sizeof(int);
+            return n*(4*sizeof(int) + 2*sizeof(float));
+
+        case FarKernelLaunch::k_VertexVertices :
+        case FarKernelLaunch::k_VertexVerticesB :
+        case FarKernelLaunch::k_VertexVerticesA1 :
+        case FarKernelLaunch::k_VertexVerticesA2 : {
+            if (tables->GetScheme() == Tables::k_Bilinear)
+                return n*sizeof(int);
+            size_t bytes = n*(5*sizeof(int) + sizeof(float) + sizeof(unsigned char));
+            if (kernel == FarKernelLaunch::k_VertexVertices or
+                kernel == FarKernelLaunch::k_VertexVerticesB) {
+                // the indices of the neighbors (2 per edge for Catmark)
+                int const * V_ITa = tables->Get_V_ITa()[level-1];
+                int valence = V_ITa[5*last+1] > 0 ? V_ITa[5*last+1] : 0;
+                if (tables->GetScheme() == Tables::k_Catmark)
+                    valence *= 2;
+                int nindices = V_ITa[5*last] + valence - V_ITa[5*start];
+                if (nindices > 0)
+                    bytes += nindices*sizeof(unsigned int);
+            }
+            return bytes;
+        }
+
+        default :
+            return 0;
+    }
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_KERNEL_INSTRUMENTATION_H */
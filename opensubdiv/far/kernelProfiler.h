@@ -0,0 +1,232 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef FAR_KERNEL_PROFILER_H
+#define FAR_KERNEL_PROFILER_H
+
+#include "../version.h"
+
+#include "../far/kernelInstrumentation.h"
+
+#include <cassert>
+#include <cstdio>
+#include <vector>
+
+#if (_WIN32 or _WIN64)
+    #include <windows.h>
+#else
+    #include <sys/time.h>
+#endif
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Instrumentation accumulating the launches, vertices, bytes and
+/// time of the subdivision kernels per level.
+///
+/// Usage :
+///
+///     FarKernelProfiler profiler;
+///     FarKernelInstrumentation::Install(&profiler);
+///     ... refine ...
+///     FarKernelInstrumentation::Install(0);
+///     profiler.Print();
+///
+/// The profiler is not thread-safe : the meshes profiled must be refined one
+/// at a time. The time of the kernels of asynchronous dispatchers (ex. GPU) is
+/// the time to issue the kernels.
+///
+class FarKernelProfiler : public FarKernelInstrumentation {
+public:
+
+    struct Counters {
+        Counters() : launches(0), vertices(0), bytes(0), time(0.0) { }
+
+        int launches;
+        long vertices;
+        double bytes,
+               time;  ///< in seconds
+    };
+
+    FarKernelProfiler() { }
+
+    virtual void BeginKernel(FarKernelLaunch const & launch) {
+        _starts.push_back(getTime());
+    }
+
+    virtual void EndKernel(FarKernelLaunch const & launch);
+
+    /// Returns the maximum level refined
+    int GetMaxLevel() const {
+        return (int)_counters.size()/FarKernelLaunch::k_NumKernels;
+    }
+
+    /// Returns the counters of a kernel at a level
+    Counters const & GetCounters(int level, FarKernelLaunch::Kernel kernel) const {
+        assert(level>0 and level<=GetMaxLevel());
+        return _counters[(level-1)*FarKernelLaunch::k_NumKernels+kernel];
+    }
+
+    /// Clears the counters
+    void Reset() {
+        _counters.clear();
+        _starts.clear();
+    }
+
+    /// Prints the counters of the kernels per level. The totals of the levels
+    /// do not include the multi-pass vertex-vertices kernels, which run within
+    /// the vertex-vertices kernels.
+    void Print(FILE * out=stdout) const;
+
+private:
+    // Returns the current time in seconds
+    static double getTime();
+
+    static void printCounters(FILE * out, int level, char const * name, Counters const & c);
+
+    std::vector<Counters> _counters;  // per (level-1, kernel)
+    std::vector<double> _starts;      // stack of the start times of the nested kernels
+};
+
+inline void
+FarKernelProfiler::EndKernel(FarKernelLaunch const & launch) {
+
+    assert(not _starts.empty() and launch.level>0);
+    double elapsed = getTime() - _starts.back();
+    _starts.pop_back();
+
+    int index = (launch.level-1)*FarKernelLaunch::k_NumKernels+launch.kernel;
+    if (index >= (int)_counters.size())
+        _counters.resize(launch.level*FarKernelLaunch::k_NumKernels);
+
+    Counters & c = _counters[index];
+    ++c.launches;
+    c.vertices += launch.end-launch.start;
+    c.bytes += (double)launch.bytes;
+    c.time += elapsed;
+}
+
+inline void
+FarKernelProfiler::Print(FILE * out) const {
+
+    static char const * names[FarKernelLaunch::k_NumKernels] = {
+        "face", "edge", "vertex", "vertex B", "vertex A1", "vertex A2", "edits" };
+
+    fprintf(out, "%5s %-10s %8s %10s %12s %10s %8s\n",
+            "level", "kernel", "launches", "vertices", "bytes", "time (ms)", "GB/s");
+
+    Counters total;
+    for (int level=1; level<=GetMaxLevel(); ++level) {
+
+        Counters levelTotal;
+        for (int kernel=0; kernel<FarKernelLaunch::k_NumKernels; ++kernel) {
+            Counters const & c = GetCounters(level, (FarKernelLaunch::Kernel)kernel);
+            if (c.launches==0)
+                continue;
+            printCounters(out, level, names[kernel], c);
+
+            if (kernel==FarKernelLaunch::k_VertexVerticesB or
+                kernel==FarKernelLaunch::k_VertexVerticesA1 or
+                kernel==FarKernelLaunch::k_VertexVerticesA2)
+                continue;
+            levelTotal.launches += c.launches;
+            levelTotal.vertices += c.vertices;
+            levelTotal.bytes += c.bytes;
+            levelTotal.time += c.time;
+        }
+        printCounters(out, level, "total", levelTotal);
+
+        total.launches += levelTotal.launches;
+        total.vertices += levelTotal.vertices;
+        total.bytes += levelTotal.bytes;
+        total.time += levelTotal.time;
+    }
+    printCounters(out, 0, "total", total);
+}
+
+inline void
+FarKernelProfiler::printCounters(FILE * out, int level, char const * name, Counters const & c) {
+
+    char levelName[16] = "all";
+    if (level>0)
+        sprintf(levelName, "%d", level);
+
+    fprintf(out, "%5s %-10s %8d %10ld %12.0f %10.3f %8.2f\n",
+            levelName, name, c.launches, c.vertices, c.bytes, c.time*1000.0,
+            c.time>0.0 ? c.bytes/c.time*1e-9 : 0.0);
+}
+
+inline double
+FarKernelProfiler::getTime() {
+
+#if (_WIN32 or _WIN64)
+    LARGE_INTEGER frequency, time;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&time);
+    return (double)time.QuadPart/frequency.QuadPart;
+#else
+    struct timeval t;
+    gettimeofday(&t, 0);
+    return t.tv_sec + t.tv_usec/1000000.0;
+#endif
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_KERNEL_PROFILER_H */
@@ -96,10 +96,14 @@ FarLoopSubdivisionTablesFactory<T,U>::Create( FarMeshFactory<T,U> * meshFactory,
     
     std::vector<int> & remap = meshFactory->getRemappingTable();
     
-    FarSubdivisionTablesFactory<T,U> tablesFactory( meshFactory->GetHbrMesh(),  maxlevel, remap );
+    FarSubdivisionTablesFactory<T,U> tablesFactory( meshFactory->GetHbrMesh(), maxlevel, remap,
+                                                    meshFactory->_vertexOrdering );
 
     FarLoopSubdivisionTables<U> * result = new FarLoopSubdivisionTables<U>(farMesh, maxlevel);
 
+    // threads filling the indexing tables (see FarMeshFactory::SetNumThreads)
+    int nthreads = meshFactory->getThreadCount();
+
     // Allocate memory for the indexing tables
     result->_E_IT.Resize(tablesFactory.GetNumEdgeVerticesTotal(maxlevel)*4);
     result->_E_W.Resize(tablesFactory.GetNumEdgeVerticesTotal(maxlevel)*2);
@@ -107,6 +111,7 @@ FarLoopSubdivisionTablesFactory<T,U>::Create( FarMeshFactory<T,U> * meshFactory,
     result->_V_ITa.Resize(tablesFactory.GetNumVertexVerticesTotal(maxlevel)*5);
     result->_V_IT.Resize(tablesFactory.GetVertVertsValenceSum());
     result->_V_W.Resize(tablesFactory.GetNumVertexVerticesTotal(maxlevel));
+    result->_V_R.Resize(tablesFactory.GetNumVertexVerticesTotal(maxlevel));
 
     for (int level=1; level<=maxlevel; ++level) {
 
@@ -120,6 +125,9 @@ FarLoopSubdivisionTablesFactory<T,U>::Create( FarMeshFactory<T,U> * meshFactory,
         int * E_IT = result->_E_IT[level-1];
         float * E_W = result->_E_W[level-1];
         batch->kernelE = (int)tablesFactory._edgeVertsList[level].size();
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if(nthreads>1)
+#endif
         for (int i=0; i < batch->kernelE; ++i) {
 
             HbrVertex<T> * v = tablesFactory._edgeVertsList[level][i];
@@ -156,11 +164,18 @@ FarLoopSubdivisionTablesFactory<T,U>::Create( FarMeshFactory<T,U> * meshFactory,
 
         batch->InitVertexKernels( (int)tablesFactory._vertVertsList[level].size(), 0 );
 
-        int offset = 0;
         int * V_ITa = result->_V_ITa[level-1];
         unsigned int * V_IT = result->_V_IT[level-1];
         float * V_W = result->_V_W[level-1];
+        unsigned char * V_R = result->_V_R[level-1];
         int nverts = (int)tablesFactory._vertVertsList[level].size();
+
+        std::vector<int> offsets, ranks(nverts);
+        tablesFactory.computeVertVertsOffsets(level, 1, nthreads, offsets);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if(nthreads>1)
+#endif
         for (int i=0; i < nverts; ++i) {
 
             HbrVertex<T> * v = tablesFactory._vertVertsList[level][i],
@@ -191,7 +206,9 @@ FarLoopSubdivisionTablesFactory<T,U>::Create( FarMeshFactory<T,U> * meshFactory,
                 npasses = 1;
             }
 
-            int rank = FarSubdivisionTablesFactory<T,U>::GetMaskRanking(masks[0], masks[1]);
+            int rank = FarSubdivisionTables<U>::GetMaskRanking(masks[0], masks[1]);
+
+            int offset = offsets[i];
 
             V_ITa[5*i+0] = offset;
             V_ITa[5*i+1] = 0;
@@ -260,11 +277,18 @@ FarLoopSubdivisionTablesFactory<T,U>::Create( FarMeshFactory<T,U> * meshFactory,
             else
                 V_W[i] = weights[0];
 
-            batch->AddVertex( i, rank );
+            V_R[i] = FarSubdivisionTables<U>::GetVertexRule(rank);
+
+            ranks[i] = rank;
         }
+
+        for (int i=0; i < nverts; ++i)
+            batch->AddVertex( i, ranks[i] );
+
         result->_V_ITa.SetMarker(level, &V_ITa[5*nverts]);
-        result->_V_IT.SetMarker(level, &V_IT[offset]);
+        result->_V_IT.SetMarker(level, &V_IT[offsets[nverts]]);
         result->_V_W.SetMarker(level, &V_W[nverts]);
+        result->_V_R.SetMarker(level, &V_R[nverts]);
 
         if (nverts>0) {
             batch->kernelB.second++;
@@ -0,0 +1,215 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+
+#ifndef FAR_MAPPED_FILE_H
+#define FAR_MAPPED_FILE_H
+
+#include "../version.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief A read-only view of the contents of a file.
+///
+/// The file is memory-mapped whenever the platform allows it : the pages are
+/// loaded on demand and shared between all the processes mapping the same
+/// file. Otherwise (or if mapping is not requested) the contents of the file
+/// are read into a heap allocated buffer.
+///
+class FarMappedFile {
+public:
+    /// Opens 'filename' and maps its contents. Returns 0 on failure.
+    static FarMappedFile * Create(char const * filename, bool map=true);
+
+    /// Destructor : unmaps the file
+    ~FarMappedFile();
+
+    /// Returns a pointer to the contents of the file
+    void const * GetData() const { return _data; }
+
+    /// Returns the size of the file in bytes
+    size_t GetSize() const { return _size; }
+
+    /// True if the contents of the file are memory-mapped
+    bool IsMapped() const { return _mapped; }
+
+private:
+    FarMappedFile() : _data(0), _size(0), _mapped(false) { }
+
+    // non-copyable, so these are not implemented:
+    FarMappedFile(FarMappedFile const &);
+    FarMappedFile & operator = (FarMappedFile const &);
+
+    bool read(char const * filename);
+
+    bool map(char const * filename);
+
+    void * _data;
+    size_t _size;
+    bool   _mapped;
+};
+
+inline FarMappedFile *
+FarMappedFile::Create(char const * filename, bool map) {
+
+    FarMappedFile * result = new FarMappedFile;
+
+    if ( (map and result->map(filename)) or result->read(filename) )
+        return result;
+
+    delete result;
+    return 0;
+}
+
+inline
+FarMappedFile::~FarMappedFile() {
+    if (_mapped) {
+#if defined(_WIN32)
+        UnmapViewOfFile(_data);
+#else
+        munmap(_data, _size);
+#endif
+        return;
+    }
+    free(_data);
+}
+
+inline bool
+FarMappedFile::read(char const * filename) {
+
+    FILE * f = fopen(filename, "rb");
+    if (not f)
+        return false;
+
+    bool success = false;
+    if (fseek(f, 0, SEEK_END)==0) {
+        long size = ftell(f);
+        if (size>0 and fseek(f, 0, SEEK_SET)==0) {
+            // malloc'ed memory is aligned for any of the tables data types
+            _data = malloc(size);
+            _size = (size_t)size;
+            success = _data and fread(_data, 1, _size, f)==_size;
+        }
+    }
+    fclose(f);
+    return success;
+}
+
+inline bool
+FarMappedFile::map(char const * filename) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file==INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    // (a view of the whole file must fit in the address space)
+    if (GetFileSizeEx(file, &size) and size.QuadPart>0 and
+        (ULONGLONG)size.QuadPart<=(ULONGLONG)(size_t)-1) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping) {
+            void * data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (data) {
+                _data = data;
+                _size = (size_t)size.QuadPart;
+                _mapped = true;
+            }
+            // the view remains valid after the handles are closed
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+    return _mapped;
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd<0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st)==0 and st.st_size>0) {
+        void * data = mmap(0, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data!=MAP_FAILED) {
+            _data = data;
+            _size = (size_t)st.st_size;
+            _mapped = true;
+        }
+    }
+    // the mapping remains valid after the descriptor is closed
+    close(fd);
+    return _mapped;
+#endif
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_MAPPED_FILE_H */
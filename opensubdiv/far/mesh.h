@@ -63,6 +63,8 @@
 #include "../far/subdivisionTables.h"
 #include "../far/patchTables.h"
 #include "../far/vertexEditTables.h"
+#include "../far/fvarTables.h"
+#include "../far/mappedFile.h"
 
 #include <cassert>
 #include <vector>
@@ -109,6 +111,10 @@ public:
     std::vector<float> const & GetFVarData(int level) const;
     int GetTotalFVarWidth() const { return _totalFVarWidth; }
 
+    /// Returns the tables refining the fvar data of the coarse faces (0 if
+    /// the mesh was created without fvar data or adaptively)
+    FarFVarTables const * GetFVarTables() const { return _fvarTables; }
+
     /// Returns patch tables
     FarPatchTables const * GetPatchTables() const { return _patchTables; }
 
@@ -126,8 +132,10 @@ private:
     // Note : the vertex classes are renamed <X,Y> so as not to shadow the 
     // declaration of the templated vertex class U.
     template <class X, class Y> friend class FarMeshFactory;
+    template <class X> friend class FarMeshSerializer;
+    template <class X> friend class FarTopologyMeshFactory;
 
-    FarMesh() : _subdivisionTables(0), _patchTables(0), _vertexEditTables(0) { }
+    FarMesh() : _subdivisionTables(0), _patchTables(0), _vertexEditTables(0), _totalFVarWidth(0), _fvarTables(0), _mappedFile(0) { }
 
     // non-copyable, so these are not implemented:
     FarMesh(FarMesh<U> const &);
@@ -154,6 +162,12 @@ private:
     // fvar data for each face
     std::vector< std::vector<float> > _fvarData;
     int _totalFVarWidth;    // from hbrMesh
+
+    // fvar refinement tables
+    FarFVarTables * _fvarTables;
+
+    // file mapping holding the tables of a deserialized mesh
+    FarMappedFile * _mappedFile;
 };
 
 template <class U>
@@ -162,6 +176,8 @@ FarMesh<U>::~FarMesh()
     delete _subdivisionTables;
     delete _patchTables;
     delete _vertexEditTables;
+    delete _fvarTables;
+    delete _mappedFile;
 }
 
 template <class U> std::vector<int> const &
@@ -75,6 +75,7 @@
 #include "../far/dispatcher.h"
 #include "../far/bilinearSubdivisionTablesFactory.h"
 #include "../far/catmarkSubdivisionTablesFactory.h"
+#include "../far/fvarTablesFactory.h"
 #include "../far/loopSubdivisionTablesFactory.h"
 #include "../far/patchTablesFactory.h"
 #include "../far/vertexEditTablesFactory.h"
@@ -82,6 +83,10 @@
 #include <typeinfo>
 #include <set>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
@@ -100,15 +105,45 @@ template <class T, class U=T> class FarMeshFactory {
 
 public:
 
+    /// \brief Ordering of the refined vertices within each type of
+    /// subdivision kernel (face / edge / vertex points of a level).
+    enum VertexOrdering {
+        k_OrderKernel=0,      ///< order in which Hbr created the vertices (default)
+        k_OrderParents,       ///< vertices follow the order of their parent vertices
+        k_OrderCuthillMcKee   ///< same as k_OrderParents, with the coarse vertices ranked
+                              ///  by a reverse Cuthill-McKee traversal of the coarse mesh
+    };
+
     /// \brief Constructor for the factory.
     /// Analyzes the HbrMesh and stores transient data used to create the 
     /// adaptive patch representation. Once the new rep has been instantiated
     /// with 'Create', this factory object can be deleted safely.
-    FarMeshFactory(HbrMesh<T> * mesh, int maxlevel, bool adaptive=false);
-
-    /// Create a table-based mesh representation
+    ///
+    /// The non-adaptive refinement of the HbrMesh is concurrent if numThreads
+    /// is not 1 (see SetNumThreads), the mesh is not refined yet, has no
+    /// hierarchical edits and no thread arenas : the factory then sets up
+    /// numThreads thread arenas in the mesh (see HbrMesh::SetThreadArenas).
+    /// The vertices and faces created concurrently are numbered in an order
+    /// which does not depend on the number of threads, but differs from the
+    /// serial refinement.
+    FarMeshFactory(HbrMesh<T> * mesh, int maxlevel, bool adaptive=false, int numThreads=1);
+
+    /// \brief Create a table-based mesh representation
+    ///
+    /// @param requirePtexCoordinate  generate the ptex coordinates of the faces
+    ///
+    /// @param requireFVarData        generate the face-varying data of the faces
+    ///
+    /// @param ordering               ordering of the refined vertices : the
+    ///                               locality orderings keep the gathers of the
+    ///                               subdivision kernels close to each other in
+    ///                               the vertex buffer, which reduces cache misses
+    ///                               on large meshes. The remapping table reflects
+    ///                               the ordering.
+    ///
     FarMesh<U> * Create( bool requirePtexCoordinate=false,       // XXX yuck.
-                         bool requireFVarData=false );
+                         bool requireFVarData=false,
+                         VertexOrdering ordering=k_OrderKernel );
 
     /// The Hbr mesh that this factory is converting
     HbrMesh<T> const * GetHbrMesh() const { return _hbrMesh; }
@@ -116,6 +151,19 @@ public:
     /// Maximum level of subidivision supported by this factory
     int GetMaxLevel() const { return _maxlevel; }
 
+    /// \brief Sets the number of threads filling the subdivision tables and
+    /// the refined faces in 'Create' (requires OpenMP).
+    ///
+    /// 1 (default) fills them serially, 0 uses the default number of OpenMP
+    /// threads. The tables do not depend on the number of threads. The
+    /// refinement of the HbrMesh uses the number of threads given to the
+    /// constructor.
+    ///
+    void SetNumThreads( int numThreads ) { _numThreads = numThreads; }
+
+    /// Returns the number of threads set with SetNumThreads
+    int GetNumThreads() const { return _numThreads; }
+
     /// The number of coarse vertices found in the HbrMesh before refinement
     int GetNumCoarseVertices() const { return _numCoarseVertices; }
 
@@ -133,6 +181,7 @@ public:
 private:
     friend class FarBilinearSubdivisionTablesFactory<T,U>;
     friend class FarCatmarkSubdivisionTablesFactory<T,U>;
+    friend class FarFVarTablesFactory<T,U>;
     friend class FarLoopSubdivisionTablesFactory<T,U>;
     friend class FarSubdivisionTablesFactory<T,U>;
     friend class FarVertexEditTablesFactory<T,U>;
@@ -171,7 +220,10 @@ private:
     static void refineVertexNeighbors(HbrVertex<T> * v);
 
     // Densely refine the Hbr mesh
-    static void refine( HbrMesh<T> * mesh, int maxlevel );
+    void refine( HbrMesh<T> * mesh, int maxlevel );
+
+    // Densely refine the Hbr mesh with several threads
+    void refineConcurrently( HbrMesh<T> * mesh, int maxlevel );
 
     // Adaptively refine the Hbr mesh
     int refineAdaptive( HbrMesh<T> * mesh, int maxIsolate );
@@ -187,11 +239,18 @@ private:
     // non-adaptive stuff
     void generateQuadsTopology( std::vector<int> & vec, int level );
 
+    // Number of OpenMP threads filling the tables (1 without OpenMP)
+    int getThreadCount() const;
+
 private:
     HbrMesh<T> * _hbrMesh;
 
     bool _adaptive;
 
+    VertexOrdering _vertexOrdering;
+
+    int _numThreads;
+
     int _maxlevel,
         _numVertices,
         _numCoarseVertices,
@@ -221,6 +280,12 @@ FarMeshFactory<T,U>::sumList( std::vector<std::vector<Type> > const & list, int
 template <class T, class U> void
 FarMeshFactory<T,U>::refine( HbrMesh<T> * mesh, int maxlevel ) {
 
+    if (getThreadCount()>1 and mesh->GetNumFaces()==mesh->GetNumCoarseFaces() and
+        mesh->GetHierarchicalEdits().empty() and not mesh->HasThreadArenas()) {
+        refineConcurrently( mesh, maxlevel );
+        return;
+    }
+
     for (int l=0, firstface=0; l<maxlevel; ++l ) {
 
         int nfaces = mesh->GetNumFaces();
@@ -239,6 +304,67 @@ FarMeshFactory<T,U>::refine( HbrMesh<T> * mesh, int maxlevel ) {
     }
 }
 
+#ifdef _OPENMP
+// Index of the calling thread in the Hbr thread arenas
+static inline int
+getOmpThreadIndex() {
+    return omp_get_thread_num();
+}
+#endif
+
+// Refines the faces of each level concurrently, running each stage of
+// HbrMesh::RefineConcurrently on all of them in turn. The IDs of the vertices
+// and faces created by a stage are reserved face by face, in the order of the
+// faces, so that they do not depend on the threads.
+template <class T, class U> void
+FarMeshFactory<T,U>::refineConcurrently( HbrMesh<T> * mesh, int maxlevel ) {
+#ifdef _OPENMP
+    typedef typename HbrMesh<T>::RefineStage RefineStage;
+
+    int nthreads = getThreadCount();
+
+    mesh->SetThreadArenas( nthreads, getOmpThreadIndex );
+
+    std::vector<HbrFace<T> *> faces;
+    std::vector<int> firstIDs;
+
+    for (int l=0, firstface=0; l<maxlevel; ++l ) {
+
+        int nfaces = mesh->GetNumFaces();
+
+        faces.clear();
+        for (int i=firstface; i<nfaces; ++i) {
+            HbrFace<T> * f = mesh->GetFace(i);
+            if (f->GetDepth()==l)
+                faces.push_back(f);
+        }
+        int n = (int)faces.size();
+        firstIDs.resize(n+1);
+
+        for (int stage=HbrMesh<T>::k_RefineFaceVertices; stage<=HbrMesh<T>::k_RefineChildFaces; ++stage) {
+
+#pragma omp parallel for num_threads(nthreads)
+            for (int i=0; i<n; ++i)
+                firstIDs[i+1] = mesh->GetRefineStageCount(faces[i], (RefineStage)stage);
+
+            firstIDs[0] = 0;
+            for (int i=0; i<n; ++i)
+                firstIDs[i+1] += firstIDs[i];
+
+            int first = mesh->ReserveIDs((RefineStage)stage, firstIDs[n]);
+
+#pragma omp parallel for num_threads(nthreads) schedule(dynamic, 64)
+            for (int i=0; i<n; ++i)
+                mesh->RefineConcurrently(faces[i], (RefineStage)stage, first+firstIDs[i]);
+        }
+
+        firstface = nfaces;
+    }
+#else
+    assert(0);
+#endif
+}
+
 // Scan the faces of a mesh and compute the max level of subdivision required
 template <class T, class U> int 
 FarMeshFactory<T,U>::computeAdaptiveMaxLevel( HbrMesh<T> * mesh, int nfaces, int maxIsolate ) {
@@ -293,6 +419,11 @@ FarMeshFactory<T,U>::vertexIsRegularBoundary( HbrVertex<T> * v ) {
 template <class T, class U> bool 
 FarMeshFactory<T,U>::vertexIsBSpline( HbrVertex<T> * v, bool next ) {
 
+    // Loop : box-spline patches require smooth interior vertices of valence 6
+    // (there are no regular boundary triangle patches)
+    if (isLoop(v->GetMesh()))
+        return not (v->IsExtraordinary() or v->OnBoundary() or v->IsSharp(next));
+
     int valence = v->GetValence();    
     
     bool isRegBoundary = v->OnBoundary() and (valence==3);
@@ -334,6 +465,11 @@ FarMeshFactory<T,U>::refineVertexNeighbors(HbrVertex<T> * v) {
             inext = inext->GetNext();
         } while (istart != inext);
 
+        // Refining the vertices of a Loop triangle only creates its corner
+        // children : the middle child is needed to cover the tagged triangle
+        if (isLoop(v->GetMesh()))
+            next->GetFace()->Refine();
+
         next = v->GetNextEdge( next );
     } while (next and next!=start);
 }
@@ -354,6 +490,8 @@ FarMeshFactory<T,U>::refineAdaptive( HbrMesh<T> * mesh, int maxIsolate ) {
     int ncoarsefaces = mesh->GetNumCoarseFaces(),
         ncoarseverts = mesh->GetNumVertices();
 
+    bool loop = isLoop(mesh);
+
     // XXX manuelk : disabling guesstimate of the max. isolate level for now
     //int maxlevel = computeAdaptiveMaxLevel(mesh, ncoarsefaces, maxIsolate);    
     int maxlevel = maxIsolate+1;    
@@ -424,13 +562,14 @@ FarMeshFactory<T,U>::refineAdaptive( HbrMesh<T> * mesh, int maxIsolate ) {
             if (not vertexIsBSpline(v, true))
                 nextverts.insert(v->Subdivide());
             
-            // Refine edges with creases or edits
+            // Refine edges with creases or edits (and boundary edges with
+            // Loop, which has no regular boundary patches)
             int valence = v->GetValence();
             _maxValence = std::max(_maxValence, valence);
 
             HbrHalfedge<T> * e = v->GetIncidentEdge();
             for (int j=0; j<valence; ++j) {
-                if (e->IsSharp(false) and (not e->IsBoundary())) {
+                if (e->IsSharp(false) and (loop or (not e->IsBoundary()))) {
                     nextverts.insert( e->Subdivide() );
                     nextverts.insert( e->GetOrgVertex()->Subdivide() );
                     nextverts.insert( e->GetDestVertex()->Subdivide() );
@@ -466,6 +605,20 @@ FarMeshFactory<T,U>::refineAdaptive( HbrMesh<T> * mesh, int maxIsolate ) {
             }
         }
     }
+
+    // Loop : the box-spline patches gather the 1-ring of the vertices of the
+    // un-refined triangles, which may not exist yet next to coarser triangles
+    if (loop) {
+        int nfaces = mesh->GetNumFaces();
+        for (int i=0; i<nfaces; ++i) {
+            HbrFace<T> * f = mesh->GetFace(i);
+            if (f->_adaptiveFlags.isTagged or 
+                (f->GetParent() and (not f->GetParent()->_adaptiveFlags.isTagged)))
+                continue;
+            for (int j=0; j<f->GetNumVertices(); ++j)
+                f->GetVertex(j)->GuaranteeNeighbors();
+        }
+    }
     return maxlevel-1;
 }
 
@@ -473,9 +626,11 @@ FarMeshFactory<T,U>::refineAdaptive( HbrMesh<T> * mesh, int maxIsolate ) {
 // random order, so the builder runs 2 passes over the entire vertex list to
 // gather the counters needed to generate the indexing tables.
 template <class T, class U>
-FarMeshFactory<T,U>::FarMeshFactory( HbrMesh<T> * mesh, int maxlevel, bool adaptive ) :
+FarMeshFactory<T,U>::FarMeshFactory( HbrMesh<T> * mesh, int maxlevel, bool adaptive, int numThreads ) :
     _hbrMesh(mesh),
     _adaptive(adaptive),
+    _vertexOrdering(k_OrderKernel),
+    _numThreads(numThreads),
     _maxlevel(maxlevel),
     _numVertices(-1),
     _numCoarseVertices(-1),
@@ -553,6 +708,9 @@ FarMeshFactory<T,U>::generateQuadsTopology( std::vector<int> & vec, int level )
 
     vec.resize( nv * _facesList[level].size(), -1 );
 
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(getThreadCount()) if(getThreadCount()>1)
+#endif
     for (int i=0; i<(int)_facesList[level].size(); ++i) {
         HbrFace<T> * f = _facesList[level][i];
         assert( f and f->GetNumVertices()==nv);
@@ -561,6 +719,15 @@ FarMeshFactory<T,U>::generateQuadsTopology( std::vector<int> & vec, int level )
     }
 }
 
+template <class T, class U> int
+FarMeshFactory<T,U>::getThreadCount() const {
+#ifdef _OPENMP
+    return _numThreads>0 ? _numThreads : omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
 template <class T, class U> void
 copyVertex( T & dest, U const & src ) {
 }
@@ -719,7 +886,8 @@ FarMeshFactory<T,U>::generateFVarData( std::vector<float> & vec, int level ) {
 
 template <class T, class U> FarMesh<U> *
 FarMeshFactory<T,U>::Create( bool requirePtexCoordinate,       // XXX yuck.
-                             bool requireFVarData ) {
+                             bool requireFVarData,
+                             VertexOrdering ordering ) {
 
     assert( GetHbrMesh() );
 
@@ -727,6 +895,9 @@ FarMeshFactory<T,U>::Create( bool requirePtexCoordinate,       // XXX yuck.
     if (GetMaxLevel()<1)
         return 0;
 
+    // read by the subdivision tables factories when they build the remapping table
+    _vertexOrdering = ordering;
+
     FarMesh<U> * result = new FarMesh<U>();
     
     if ( isBilinear( GetHbrMesh() ) ) {
@@ -785,6 +956,9 @@ FarMeshFactory<T,U>::Create( bool requirePtexCoordinate,       // XXX yuck.
             result->_fvarData.resize(GetMaxLevel()+1);
             for (int l=1; l<=GetMaxLevel(); ++l)
                 generateFVarData(result->_fvarData[l], l);
+
+            // Tables refining the face-varying data on demand
+            result->_fvarTables = FarFVarTablesFactory<T,U>::Create(this);
         }
     }
     
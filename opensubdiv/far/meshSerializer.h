@@ -0,0 +1,1128 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+
+#ifndef FAR_MESH_SERIALIZER_H
+#define FAR_MESH_SERIALIZER_H
+
+#include "../version.h"
+
+#include "../far/mesh.h"
+#include "../far/bilinearSubdivisionTables.h"
+#include "../far/catmarkSubdivisionTables.h"
+#include "../far/loopSubdivisionTables.h"
+#include "../far/mappedFile.h"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Binary serialization of FarMesh tables
+///
+/// FarMeshSerializer saves the topological tables of a FarMesh into a compact
+/// binary format that can be loaded back without re-building the HbrMesh and
+/// running the Far factories.
+///
+/// The format is position independent : it is a sequence of records read in
+/// order, where each array is preceded by its number of elements and padded
+/// to a 16 bytes boundary. The FarTable arrays of a loaded mesh (subdivision,
+/// patch and vertex-edit tables) point directly into the serialized data :
+/// when loading from a file, the file is memory-mapped and these tables share
+/// the pages of the file (read-only) with any other process loading it. The
+/// remaining tables (face-vertices, ptex coordinates, face-varying data and
+/// tables, patch valences & quad offsets) are exposed as std::vectors and are
+/// copied.
+///
+/// The format is native-endian and versioned : data written by a different
+/// version of the serializer or on a different architecture is rejected.
+///
+/// Note : vertex data is not serialized : the coarse vertices of a loaded mesh
+/// are default-constructed and must be initialized by the client.
+///
+template <class U> class FarMeshSerializer {
+
+public:
+    enum { kVersion = 3 };
+
+    /// Appends the serialized tables of 'mesh' to 'buffer'. If 'remapTable' is
+    /// not null, the vertex remapping table of the factory that created the
+    /// mesh is saved along with the mesh.
+    static void Write(FarMesh<U> const * mesh, std::vector<char> & buffer,
+                      std::vector<int> const * remapTable=0);
+
+    /// Writes the serialized tables of 'mesh' to a file. Returns false on failure.
+    static bool Write(FarMesh<U> const * mesh, char const * filename,
+                      std::vector<int> const * remapTable=0);
+
+    /// Creates a mesh from serialized data. The indexing tables of the mesh
+    /// point into 'data', which must be aligned to at least 4 bytes and
+    /// remain valid (and unchanged) for as long as the mesh is in use. Returns
+    /// 0 if the data is not valid. If 'remapTable' is not null, it receives
+    /// the remapping table saved with the mesh (if any).
+    static FarMesh<U> * Read(void const * data, size_t size,
+                             std::vector<int> * remapTable=0);
+
+    /// Creates a mesh from a file. If 'map' is true the file is memory-mapped
+    /// and the mesh retains the mapping until it is deleted. Returns 0 if the
+    /// file cannot be read or is not valid.
+    static FarMesh<U> * Read(char const * filename, std::vector<int> * remapTable=0,
+                             bool map=true);
+
+private:
+
+    enum Scheme {
+        kBilinear=0,
+        kCatmark,
+        kLoop
+    };
+
+    enum Flags {
+        kHasPatchTables   = 0x1,
+        kHasVertexEdits   = 0x2,
+        kHasRemapTable    = 0x4,
+        kHasFVarTables    = 0x8
+    };
+
+    static const int kAlignment = 16;
+
+    // Sequential writer of aligned records
+    class Writer {
+    public:
+        Writer(std::vector<char> & buffer) : _buffer(buffer), _start(buffer.size()) { }
+
+        template <class T> void Write(T value) {
+            append(&value, sizeof(T));
+        }
+
+        template <class T> void WriteArray(T const * data, int n) {
+            Write(n);
+            align();
+            append(data, n*sizeof(T));
+        }
+
+        template <class T> void WriteVector(std::vector<T> const & v) {
+            WriteArray(v.empty() ? 0 : &v[0], (int)v.size());
+        }
+
+        template <class T> void WriteTable(FarTable<T> const & table) {
+            WriteVector(table.GetMarkers());
+            WriteArray(table.GetSize() ? table.getData() : 0, table.GetSize());
+        }
+
+    private:
+        void append(void const * data, size_t size) {
+            if (size>0) {
+                char const * ptr = static_cast<char const *>(data);
+                _buffer.insert(_buffer.end(), ptr, ptr+size);
+            }
+        }
+
+        void align() {
+            while ((_buffer.size()-_start) % kAlignment)
+                _buffer.push_back(0);
+        }
+
+        std::vector<char> & _buffer;
+        size_t _start;
+    };
+
+    // Sequential reader of aligned records : reads past the end of the data
+    // are flagged and return empty values.
+    class Reader {
+    public:
+        Reader(char const * data, size_t size) : _data(data), _size(size), _pos(0), _valid(true) { }
+
+        bool IsValid() const { return _valid; }
+
+        template <class T> T Read() {
+            T value = T();
+            if (check(sizeof(T))) {
+                memcpy(&value, _data+_pos, sizeof(T));
+                _pos += sizeof(T);
+            }
+            return value;
+        }
+
+        // Reads a number of records, each at least 'recordSize' bytes long
+        int ReadCount(size_t recordSize) {
+            int n = Read<int>();
+            if (n<0 or not check((size_t)n*recordSize)) {
+                _valid = false;
+                return 0;
+            }
+            return n;
+        }
+
+        template <class T> T const * ReadArray(int & n) {
+            n = Read<int>();
+            _pos = (_pos + kAlignment - 1) / kAlignment * kAlignment;
+            if (n<0 or not check((size_t)n*sizeof(T))) {
+                _valid = false;
+                n = 0;
+                return 0;
+            }
+            T const * result = reinterpret_cast<T const *>(_data+_pos);
+            _pos += n*sizeof(T);
+            return result;
+        }
+
+        template <class T> void ReadVector(std::vector<T> & v) {
+            int n;
+            T const * data = ReadArray<T>(n);
+            v.assign(data, data+n);
+        }
+
+        template <class T> void ReadTable(FarTable<T> & table) {
+            FarTableMarkers markers;
+            ReadVector(markers);
+            int n;
+            T const * data = ReadArray<T>(n);
+            for (int i=0; i<(int)markers.size(); ++i)
+                if (markers[i]<0 or markers[i]>n)
+                    _valid = false;
+            if (_valid)
+                table.SetExternalData(data, n, markers);
+        }
+
+    private:
+        bool check(size_t size) {
+            _valid = _valid and _pos<=_size and size<=(_size-_pos);
+            return _valid;
+        }
+
+        char const * _data;
+        size_t _size,
+               _pos;
+        bool _valid;
+    };
+
+    static void writeSubdivisionTables(Writer & writer, FarSubdivisionTables<U> const * tables);
+
+    static void writePatchTables(Writer & writer, FarPatchTables const * tables);
+
+    static void writeVertexEditTables(Writer & writer, FarVertexEditTables<U> const * tables);
+
+    static void writeFVarTables(Writer & writer, FarFVarTables const * tables);
+
+    static FarSubdivisionTables<U> * readSubdivisionTables(Reader & reader, FarMesh<U> * mesh, int scheme);
+
+    static FarPatchTables * readPatchTables(Reader & reader);
+
+    static FarVertexEditTables<U> * readVertexEditTables(Reader & reader, FarMesh<U> * mesh);
+
+    static FarFVarTables * readFVarTables(Reader & reader);
+
+    // The kernels index the vertex buffer and the tables with the values
+    // read : these are checked before the mesh is returned, so that corrupted
+    // data is rejected instead of causing out-of-bounds accesses.
+
+    // True if the table has 'nmarkers' non-decreasing markers
+    template <class T> static bool checkMarkers(FarTable<T> const & table, int nmarkers);
+
+    // True if 'count' rows of 'width' entries fit in the table from 'level' on
+    template <class T> static bool checkRows(FarTable<T> const & table, int level, int count, int width);
+
+    // True if 'count' entries fit in the table from 'start' past 'level'
+    template <class T> static bool checkRange(FarTable<T> const & table, int level, int start, int count);
+
+    static bool isIndex(int index, int nverts) {
+        return (unsigned int)index < (unsigned int)nverts;
+    }
+
+    static bool validateSubdivisionTables(FarSubdivisionTables<U> const * tables, int scheme, int nverts);
+
+    static bool validatePatchTables(FarPatchTables const * tables, int maxlevel, int fvarwidth, int nverts);
+
+    static bool validateVertexEditTables(FarVertexEditTables<U> const * tables, int maxlevel, int nverts);
+
+    static bool validateFVarTables(FarFVarTables const * tables, int fvarwidth);
+
+    static bool validate(FarMesh<U> const * mesh, int scheme, int nverts);
+
+    static char const * getMagic() { return "OSDFAR\0\0"; }
+};
+
+// Identifies the binary layout of the data types of the tables
+static inline int
+FarMeshSerializerGetLayoutTag() {
+    return (int)(0x01020304u) ^ (int)(sizeof(int)<<24) ^ (int)(sizeof(float)<<16) ^ (int)sizeof(void*);
+}
+
+template <class U> void
+FarMeshSerializer<U>::Write(FarMesh<U> const * mesh, std::vector<char> & buffer,
+                            std::vector<int> const * remapTable) {
+
+    assert(mesh and mesh->_subdivisionTables);
+
+    FarSubdivisionTables<U> const * tables = mesh->_subdivisionTables;
+
+    int scheme = kCatmark;
+    if (dynamic_cast<FarBilinearSubdivisionTables<U> const *>(tables))
+        scheme = kBilinear;
+    else if (dynamic_cast<FarLoopSubdivisionTables<U> const *>(tables))
+        scheme = kLoop;
+    else
+        assert(dynamic_cast<FarCatmarkSubdivisionTables<U> const *>(tables));
+
+    int flags = (mesh->_patchTables ? kHasPatchTables : 0) |
+                (mesh->_vertexEditTables ? kHasVertexEdits : 0) |
+                (remapTable ? kHasRemapTable : 0) |
+                (mesh->_fvarTables ? kHasFVarTables : 0);
+
+    Writer writer(buffer);
+
+    char const * magic = getMagic();
+    for (int i=0; i<8; ++i)
+        writer.Write(magic[i]);
+    writer.Write((int)kVersion);
+    writer.Write(FarMeshSerializerGetLayoutTag());
+    writer.Write(scheme);
+    writer.Write(flags);
+    writer.Write(mesh->GetNumVertices());
+    writer.Write(mesh->_totalFVarWidth);
+
+    writeSubdivisionTables(writer, tables);
+
+    writer.Write((int)mesh->_faceverts.size());
+    for (int i=0; i<(int)mesh->_faceverts.size(); ++i)
+        writer.WriteVector(mesh->_faceverts[i]);
+
+    writer.Write((int)mesh->_ptexcoordinates.size());
+    for (int i=0; i<(int)mesh->_ptexcoordinates.size(); ++i)
+        writer.WriteVector(mesh->_ptexcoordinates[i]);
+
+    writer.Write((int)mesh->_fvarData.size());
+    for (int i=0; i<(int)mesh->_fvarData.size(); ++i)
+        writer.WriteVector(mesh->_fvarData[i]);
+
+    if (mesh->_patchTables)
+        writePatchTables(writer, mesh->_patchTables);
+
+    if (mesh->_vertexEditTables)
+        writeVertexEditTables(writer, mesh->_vertexEditTables);
+
+    if (remapTable)
+        writer.WriteVector(*remapTable);
+
+    if (mesh->_fvarTables)
+        writeFVarTables(writer, mesh->_fvarTables);
+}
+
+template <class U> bool
+FarMeshSerializer<U>::Write(FarMesh<U> const * mesh, char const * filename,
+                            std::vector<int> const * remapTable) {
+
+    std::vector<char> buffer;
+    Write(mesh, buffer, remapTable);
+
+    FILE * f = fopen(filename, "wb");
+    if (not f)
+        return false;
+
+    bool success = fwrite(&buffer[0], 1, buffer.size(), f)==buffer.size();
+    return (fclose(f)==0) and success;
+}
+
+template <class U> FarMesh<U> *
+FarMeshSerializer<U>::Read(void const * data, size_t size, std::vector<int> * remapTable) {
+
+    // the tables are accessed in place : the data must be aligned
+    if (not data or (reinterpret_cast<size_t>(data) % sizeof(int)))
+        return 0;
+
+    Reader reader(static_cast<char const *>(data), size);
+
+    char magic[8];
+    for (int i=0; i<8; ++i)
+        magic[i] = reader.Read<char>();
+    int version = reader.Read<int>(),
+        layout = reader.Read<int>(),
+        scheme = reader.Read<int>(),
+        flags = reader.Read<int>(),
+        nverts = reader.Read<int>();
+
+    if (not reader.IsValid() or memcmp(magic, getMagic(), 8) or version!=kVersion or
+        layout!=FarMeshSerializerGetLayoutTag() or scheme<kBilinear or scheme>kLoop or nverts<0)
+        return 0;
+
+    FarMesh<U> * mesh = new FarMesh<U>;
+
+    mesh->_totalFVarWidth = reader.Read<int>();
+
+    mesh->_subdivisionTables = readSubdivisionTables(reader, mesh, scheme);
+
+    mesh->_faceverts.resize(reader.ReadCount(sizeof(int)));
+    for (int i=0; i<(int)mesh->_faceverts.size(); ++i)
+        reader.ReadVector(mesh->_faceverts[i]);
+
+    mesh->_ptexcoordinates.resize(reader.ReadCount(sizeof(int)));
+    for (int i=0; i<(int)mesh->_ptexcoordinates.size(); ++i)
+        reader.ReadVector(mesh->_ptexcoordinates[i]);
+
+    mesh->_fvarData.resize(reader.ReadCount(sizeof(int)));
+    for (int i=0; i<(int)mesh->_fvarData.size(); ++i)
+        reader.ReadVector(mesh->_fvarData[i]);
+
+    if (flags & kHasPatchTables)
+        mesh->_patchTables = readPatchTables(reader);
+
+    if (flags & kHasVertexEdits)
+        mesh->_vertexEditTables = readVertexEditTables(reader, mesh);
+
+    if (flags & kHasRemapTable) {
+        std::vector<int> remap;
+        reader.ReadVector(remap);
+        if (remapTable)
+            remapTable->swap(remap);
+    }
+
+    if (flags & kHasFVarTables)
+        mesh->_fvarTables = readFVarTables(reader);
+
+    if (not reader.IsValid() or not mesh->_subdivisionTables or
+        not validate(mesh, scheme, nverts)) {
+        delete mesh;
+        return 0;
+    }
+
+    mesh->_vertices.resize(nverts);
+
+    return mesh;
+}
+
+template <class U> FarMesh<U> *
+FarMeshSerializer<U>::Read(char const * filename, std::vector<int> * remapTable, bool map) {
+
+    FarMappedFile * file = FarMappedFile::Create(filename, map);
+    if (not file)
+        return 0;
+
+    FarMesh<U> * mesh = Read(file->GetData(), file->GetSize(), remapTable);
+    if (not mesh) {
+        delete file;
+        return 0;
+    }
+
+    mesh->_mappedFile = file;
+    return mesh;
+}
+
+template <class U> void
+FarMeshSerializer<U>::writeSubdivisionTables(Writer & writer, FarSubdivisionTables<U> const * tables) {
+
+    writer.WriteVector(tables->_vertsOffsets);
+    writer.Write(tables->_numCoarseVertices);
+
+    writer.WriteTable(tables->_E_IT);
+    writer.WriteTable(tables->_E_W);
+    writer.WriteTable(tables->_V_ITa);
+    writer.WriteTable(tables->_V_IT);
+    writer.WriteTable(tables->_V_W);
+    writer.WriteTable(tables->_V_R);
+
+    if (FarCatmarkSubdivisionTables<U> const * catmark =
+        dynamic_cast<FarCatmarkSubdivisionTables<U> const *>(tables)) {
+        writer.WriteTable(catmark->_F_ITa);
+        writer.WriteTable(catmark->_F_IT);
+    } else if (FarBilinearSubdivisionTables<U> const * bilinear =
+        dynamic_cast<FarBilinearSubdivisionTables<U> const *>(tables)) {
+        writer.WriteTable(bilinear->_F_ITa);
+        writer.WriteTable(bilinear->_F_IT);
+    }
+
+    writer.Write((int)tables->_batches.size());
+    for (int i=0; i<(int)tables->_batches.size(); ++i) {
+        typename FarSubdivisionTables<U>::VertexKernelBatch const & batch = tables->_batches[i];
+        writer.Write(batch.kernelF);
+        writer.Write(batch.kernelE);
+        writer.Write(batch.kernelB.first);
+        writer.Write(batch.kernelB.second);
+        writer.Write(batch.kernelA1.first);
+        writer.Write(batch.kernelA1.second);
+        writer.Write(batch.kernelA2.first);
+        writer.Write(batch.kernelA2.second);
+    }
+}
+
+template <class U> FarSubdivisionTables<U> *
+FarMeshSerializer<U>::readSubdivisionTables(Reader & reader, FarMesh<U> * mesh, int scheme) {
+
+    std::vector<int> vertsOffsets;
+    reader.ReadVector(vertsOffsets);
+    // the tables describe at least one level of subdivision
+    if (vertsOffsets.size()<2 or not reader.IsValid())
+        return 0;
+
+    int maxlevel = (int)vertsOffsets.size()-1;
+
+    FarSubdivisionTables<U> * tables = 0;
+    FarCatmarkSubdivisionTables<U> * catmark = 0;
+    FarBilinearSubdivisionTables<U> * bilinear = 0;
+    switch (scheme) {
+        case kBilinear : tables = bilinear = new FarBilinearSubdivisionTables<U>(mesh, maxlevel); break;
+        case kCatmark  : tables = catmark = new FarCatmarkSubdivisionTables<U>(mesh, maxlevel); break;
+        case kLoop     : tables = new FarLoopSubdivisionTables<U>(mesh, maxlevel); break;
+    }
+
+    tables->_vertsOffsets.swap(vertsOffsets);
+    tables->_numCoarseVertices = reader.Read<unsigned int>();
+
+    reader.ReadTable(tables->_E_IT);
+    reader.ReadTable(tables->_E_W);
+    reader.ReadTable(tables->_V_ITa);
+    reader.ReadTable(tables->_V_IT);
+    reader.ReadTable(tables->_V_W);
+    reader.ReadTable(tables->_V_R);
+
+    if (catmark) {
+        reader.ReadTable(catmark->_F_ITa);
+        reader.ReadTable(catmark->_F_IT);
+    } else if (bilinear) {
+        reader.ReadTable(bilinear->_F_ITa);
+        reader.ReadTable(bilinear->_F_IT);
+    }
+
+    tables->_batches.resize(reader.ReadCount(8*sizeof(int)));
+    for (int i=0; i<(int)tables->_batches.size(); ++i) {
+        typename FarSubdivisionTables<U>::VertexKernelBatch & batch = tables->_batches[i];
+        batch.kernelF = reader.Read<int>();
+        batch.kernelE = reader.Read<int>();
+        batch.kernelB.first = reader.Read<int>();
+        batch.kernelB.second = reader.Read<int>();
+        batch.kernelA1.first = reader.Read<int>();
+        batch.kernelA1.second = reader.Read<int>();
+        batch.kernelA2.first = reader.Read<int>();
+        batch.kernelA2.second = reader.Read<int>();
+    }
+    return tables;
+}
+
+template <class U> void
+FarMeshSerializer<U>::writePatchTables(Writer & writer, FarPatchTables const * tables) {
+
+    writer.Write(tables->_maxValence);
+
+    FarPatchTables::Patches const & full = tables->_full;
+    writer.WriteTable(full._R_IT);
+    writer.WriteTable(full._B_IT);
+    writer.WriteTable(full._C_IT);
+    writer.WriteTable(full._G_IT);
+    writer.WriteTable(full._G_B_IT);
+    writer.WriteTable(full._LR_IT);
+    writer.WriteTable(full._LE_IT);
+
+    writer.WriteVector(full._R_PTX);
+    writer.WriteVector(full._B_PTX);
+    writer.WriteVector(full._C_PTX);
+    writer.WriteVector(full._G_PTX);
+    writer.WriteVector(full._G_B_PTX);
+
+    writer.WriteVector(full._R_FVD);
+    writer.WriteVector(full._B_FVD);
+    writer.WriteVector(full._C_FVD);
+    writer.WriteVector(full._G_FVD);
+    writer.WriteVector(full._G_B_FVD);
+
+    for (int i=0; i<5; ++i) {
+        FarPatchTables::TPatches const & transition = tables->_transition[i];
+        writer.WriteTable(transition._R_IT);
+        writer.WriteVector(transition._R_PTX);
+        writer.WriteVector(transition._R_FVD);
+        for (int j=0; j<4; ++j) {
+            writer.WriteTable(transition._B_IT[j]);
+            writer.WriteVector(transition._B_PTX[j]);
+            writer.WriteVector(transition._B_FVD[j]);
+            writer.WriteTable(transition._C_IT[j]);
+            writer.WriteVector(transition._C_PTX[j]);
+            writer.WriteVector(transition._C_FVD[j]);
+        }
+    }
+
+    writer.WriteVector(tables->_vertexValenceTable);
+    writer.WriteVector(tables->_quadOffsetTable);
+}
+
+template <class U> FarPatchTables *
+FarMeshSerializer<U>::readPatchTables(Reader & reader) {
+
+    int maxvalence = reader.Read<int>();
+
+    // the markers of each table are overwritten by ReadTable
+    FarPatchTables * tables = new FarPatchTables(0, maxvalence);
+
+    FarPatchTables::Patches & full = tables->_full;
+    reader.ReadTable(full._R_IT);
+    reader.ReadTable(full._B_IT);
+    reader.ReadTable(full._C_IT);
+    reader.ReadTable(full._G_IT);
+    reader.ReadTable(full._G_B_IT);
+    reader.ReadTable(full._LR_IT);
+    reader.ReadTable(full._LE_IT);
+
+    reader.ReadVector(full._R_PTX);
+    reader.ReadVector(full._B_PTX);
+    reader.ReadVector(full._C_PTX);
+    reader.ReadVector(full._G_PTX);
+    reader.ReadVector(full._G_B_PTX);
+
+    reader.ReadVector(full._R_FVD);
+    reader.ReadVector(full._B_FVD);
+    reader.ReadVector(full._C_FVD);
+    reader.ReadVector(full._G_FVD);
+    reader.ReadVector(full._G_B_FVD);
+
+    for (int i=0; i<5; ++i) {
+        FarPatchTables::TPatches & transition = tables->_transition[i];
+        reader.ReadTable(transition._R_IT);
+        reader.ReadVector(transition._R_PTX);
+        reader.ReadVector(transition._R_FVD);
+        for (int j=0; j<4; ++j) {
+            reader.ReadTable(transition._B_IT[j]);
+            reader.ReadVector(transition._B_PTX[j]);
+            reader.ReadVector(transition._B_FVD[j]);
+            reader.ReadTable(transition._C_IT[j]);
+            reader.ReadVector(transition._C_PTX[j]);
+            reader.ReadVector(transition._C_FVD[j]);
+        }
+    }
+
+    reader.ReadVector(tables->_vertexValenceTable);
+    reader.ReadVector(tables->_quadOffsetTable);
+
+    return tables;
+}
+
+template <class U> void
+FarMeshSerializer<U>::writeVertexEditTables(Writer & writer, FarVertexEditTables<U> const * tables) {
+
+    writer.Write((int)tables->_batches.size());
+    for (int i=0; i<(int)tables->_batches.size(); ++i) {
+        typename FarVertexEditTables<U>::VertexEditBatch const & batch = tables->_batches[i];
+        writer.Write(batch._primvarIndex);
+        writer.Write(batch._primvarWidth);
+        writer.Write((int)batch._op);
+        writer.WriteTable(batch._vertIndices);
+        writer.WriteTable(batch._edits);
+    }
+}
+
+template <class U> FarVertexEditTables<U> *
+FarMeshSerializer<U>::readVertexEditTables(Reader & reader, FarMesh<U> * mesh) {
+
+    int nbatches = reader.ReadCount(3*sizeof(int));
+
+    FarVertexEditTables<U> * tables = new FarVertexEditTables<U>(mesh, 0);
+
+    tables->_batches.reserve(nbatches);
+    for (int i=0; i<nbatches and reader.IsValid(); ++i) {
+        int index = reader.Read<int>(),
+            width = reader.Read<int>(),
+            op = reader.Read<int>();
+
+        tables->_batches.push_back(typename FarVertexEditTables<U>::VertexEditBatch(
+            index, width, op==FarVertexEdit::Add ? FarVertexEdit::Add : FarVertexEdit::Set));
+
+        typename FarVertexEditTables<U>::VertexEditBatch & batch = tables->_batches.back();
+        reader.ReadTable(batch._vertIndices);
+        reader.ReadTable(batch._edits);
+    }
+    return tables;
+}
+
+template <class U> template <class T> bool
+FarMeshSerializer<U>::checkMarkers(FarTable<T> const & table, int nmarkers) {
+
+    // ReadTable already checked that the markers lie within the data
+    FarTableMarkers const & markers = table.GetMarkers();
+    if ((int)markers.size()!=nmarkers)
+        return false;
+    for (int i=1; i<nmarkers; ++i)
+        if (markers[i]<markers[i-1])
+            return false;
+    return true;
+}
+
+template <class U> template <class T> bool
+FarMeshSerializer<U>::checkRows(FarTable<T> const & table, int level, int count, int width) {
+
+    int size = table.GetSize() - table.GetMarkers()[level];
+    return count>=0 and width>0 and count<=size/width;
+}
+
+template <class U> template <class T> bool
+FarMeshSerializer<U>::checkRange(FarTable<T> const & table, int level, int start, int count) {
+
+    int size = table.GetSize() - table.GetMarkers()[level];
+    return start>=0 and count>=0 and start<=size and count<=size-start;
+}
+
+template <class U> void
+FarMeshSerializer<U>::writeFVarTables(Writer & writer, FarFVarTables const * tables) {
+
+    writer.WriteVector(tables->_firstCorners);
+    writer.WriteVector(tables->_widths);
+    writer.WriteVector(tables->_offsets);
+    writer.Write(tables->_totalWidth);
+
+    writer.Write((int)tables->_tables.size());
+    for (int i=0; i<(int)tables->_tables.size(); ++i) {
+        FarStencilTables const * stencils = tables->_tables[i];
+        writer.Write(stencils->_numControlVertices);
+        writer.Write(stencils->_firstVertexOffset);
+        writer.WriteVector(stencils->_sizes);
+        writer.WriteVector(stencils->_offsets);
+        writer.WriteVector(stencils->_indices);
+        writer.WriteVector(stencils->_weights);
+    }
+}
+
+template <class U> FarFVarTables *
+FarMeshSerializer<U>::readFVarTables(Reader & reader) {
+
+    FarFVarTables * tables = new FarFVarTables;
+
+    reader.ReadVector(tables->_firstCorners);
+    reader.ReadVector(tables->_widths);
+    reader.ReadVector(tables->_offsets);
+    tables->_totalWidth = reader.Read<int>();
+
+    // (each stencil table is at least 6 ints long)
+    tables->_tables.resize(reader.ReadCount(6*sizeof(int)), 0);
+    for (int i=0; i<(int)tables->_tables.size(); ++i) {
+        FarStencilTables * stencils = new FarStencilTables;
+        tables->_tables[i] = stencils;
+        stencils->_numControlVertices = reader.Read<int>();
+        stencils->_firstVertexOffset = reader.Read<int>();
+        reader.ReadVector(stencils->_sizes);
+        reader.ReadVector(stencils->_offsets);
+        reader.ReadVector(stencils->_indices);
+        reader.ReadVector(stencils->_weights);
+    }
+    return tables;
+}
+
+template <class U> bool
+FarMeshSerializer<U>::validateSubdivisionTables(FarSubdivisionTables<U> const * tables, int scheme, int nverts) {
+
+    typedef typename FarSubdivisionTables<U>::VertexKernelBatch Batch;
+
+    std::vector<int> const & vertsOffsets = tables->_vertsOffsets;
+
+    int maxlevel = (int)vertsOffsets.size()-1;
+
+    if ((int)tables->_batches.size()!=maxlevel or
+        tables->_numCoarseVertices>(unsigned int)nverts)
+        return false;
+
+    if (not checkMarkers(tables->_E_IT, maxlevel+1) or
+        not checkMarkers(tables->_E_W, maxlevel+1) or
+        not checkMarkers(tables->_V_ITa, maxlevel+1) or
+        not checkMarkers(tables->_V_IT, maxlevel+1) or
+        not checkMarkers(tables->_V_W, maxlevel+1) or
+        not checkMarkers(tables->_V_R, maxlevel+1))
+        return false;
+
+    FarTable<int> const * F_ITa = 0;
+    FarTable<unsigned int> const * F_IT = 0;
+    if (scheme==kCatmark) {
+        FarCatmarkSubdivisionTables<U> const * catmark =
+            static_cast<FarCatmarkSubdivisionTables<U> const *>(tables);
+        F_ITa = &catmark->_F_ITa;
+        F_IT = &catmark->_F_IT;
+    } else if (scheme==kBilinear) {
+        FarBilinearSubdivisionTables<U> const * bilinear =
+            static_cast<FarBilinearSubdivisionTables<U> const *>(tables);
+        F_ITa = &bilinear->_F_ITa;
+        F_IT = &bilinear->_F_IT;
+    }
+    if (F_ITa and (not checkMarkers(*F_ITa, maxlevel+1) or not checkMarkers(*F_IT, maxlevel+1)))
+        return false;
+
+    // the vertices of each level must fit in the vertex buffer : the offsets
+    // are checked incrementally to avoid integer overflows
+    if (vertsOffsets[0]<0 or vertsOffsets[0]>nverts)
+        return false;
+
+    // number of V_IT entries per vertex-vertex valence
+    int stride = scheme==kCatmark ? 2 : 1;
+
+    for (int level=1; level<=maxlevel; ++level) {
+
+        Batch const & batch = tables->_batches[level-1];
+
+        int nfaces = batch.kernelF,
+            nedges = batch.kernelE,
+            nvertices = std::max(batch.kernelB.second,
+                            std::max(batch.kernelA1.second, batch.kernelA2.second));
+
+        if (batch.kernelB.first<0 or batch.kernelA1.first<0 or batch.kernelA2.first<0 or
+            batch.kernelB.second<0 or batch.kernelA1.second<0 or batch.kernelA2.second<0)
+            return false;
+
+        int offset = vertsOffsets[level],
+            remaining = nverts - offset;
+        if (offset<vertsOffsets[level-1] or offset>nverts or
+            nfaces<0 or nfaces>remaining or
+            nedges<0 or nedges>(remaining-=nfaces) or
+            nvertices>(remaining-=nedges))
+            return false;
+
+        // face-vertices
+        if (F_ITa) {
+            if (not checkRows(*F_ITa, level-1, nfaces, 2))
+                return false;
+
+            int const * ITa = (*F_ITa)[level-1];
+            unsigned int const * IT = (*F_IT)[level-1];
+            for (int i=0; i<nfaces; ++i) {
+                int h = ITa[2*i],
+                    n = ITa[2*i+1];
+                if (n<=0 or not checkRange(*F_IT, level-1, h, n))
+                    return false;
+                for (int j=0; j<n; ++j)
+                    if (IT[h+j]>=(unsigned int)nverts)
+                        return false;
+            }
+        } else if (nfaces!=0) {
+            return false;
+        }
+
+        // edge-vertices
+        int const * E_IT = tables->_E_IT[level-1];
+        if (scheme==kBilinear) {
+            if (not checkRows(tables->_E_IT, level-1, nedges, 2))
+                return false;
+            for (int i=0; i<nedges; ++i)
+                if (not isIndex(E_IT[2*i], nverts) or not isIndex(E_IT[2*i+1], nverts))
+                    return false;
+        } else {
+            if (not checkRows(tables->_E_IT, level-1, nedges, 4) or
+                not checkRows(tables->_E_W, level-1, nedges, 2))
+                return false;
+            for (int i=0; i<nedges; ++i) {
+                int const * e = E_IT + 4*i;
+                if (not isIndex(e[0], nverts) or not isIndex(e[1], nverts) or
+                    (e[2]!=-1 and (not isIndex(e[2], nverts) or not isIndex(e[3], nverts))))
+                    return false;
+            }
+        }
+
+        // vertex-vertices
+        int const * V_ITa = tables->_V_ITa[level-1];
+        if (scheme==kBilinear) {
+            if (not checkRows(tables->_V_ITa, level-1, nvertices, 1))
+                return false;
+            for (int i=0; i<nvertices; ++i)
+                if (not isIndex(V_ITa[i], nverts))
+                    return false;
+        } else {
+            if (not checkRows(tables->_V_ITa, level-1, nvertices, 5) or
+                not checkRows(tables->_V_W, level-1, nvertices, 1) or
+                not checkRows(tables->_V_R, level-1, nvertices, 1))
+                return false;
+
+            unsigned int const * V_IT = tables->_V_IT[level-1];
+            unsigned char const * V_R = tables->_V_R[level-1];
+            for (int i=0; i<nvertices; ++i) {
+                int const * v = V_ITa + 5*i;
+                int h = v[0],
+                    n = v[1],
+                    eidx0 = v[3],
+                    eidx1 = v[4];
+
+                if (not isIndex(v[2], nverts) or
+                    (eidx0!=-1 and not isIndex(eidx0, nverts)) or
+                    (eidx1!=-1 and not isIndex(eidx1, nverts)))
+                    return false;
+
+                // crease rules read both crease edges
+                unsigned char rule = V_R[i];
+                if ((eidx0!=-1 or rule==FarSubdivisionTables<U>::k_RuleSmoothCrease or
+                                  rule==FarSubdivisionTables<U>::k_RuleCreaseCorner or
+                                  rule==FarSubdivisionTables<U>::k_RuleCrease) and
+                    (eidx0==-1 or eidx1==-1))
+                    return false;
+
+                if (n>0) {
+                    if (n>INT_MAX/stride or not checkRange(tables->_V_IT, level-1, h, n*stride))
+                        return false;
+                    for (int j=0; j<n*stride; ++j)
+                        if (V_IT[h+j]>=(unsigned int)nverts)
+                            return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+template <class U> bool
+FarMeshSerializer<U>::validatePatchTables(FarPatchTables const * tables, int maxlevel, int fvarwidth, int nverts) {
+
+    // patches are gathered up to one level past the subdivision tables
+    int nmarkers = maxlevel+2;
+
+    struct PatchArrays {
+        FarPatchTables::PTable const * table;
+        FarPatchTables::PtexCoordinateTable const * ptx;
+        FarPatchTables::FVarDataTable const * fvd;
+        int ringsize;
+    } patches[7+5*9];
+
+    FarPatchTables::Patches const & full = tables->_full;
+    PatchArrays fullPatches[7] = {
+        { &full._R_IT,   &full._R_PTX,   &full._R_FVD,   16 },
+        { &full._B_IT,   &full._B_PTX,   &full._B_FVD,   12 },
+        { &full._C_IT,   &full._C_PTX,   &full._C_FVD,    9 },
+        { &full._G_IT,   &full._G_PTX,   &full._G_FVD,    4 },
+        { &full._G_B_IT, &full._G_B_PTX, &full._G_B_FVD,  4 },
+        { &full._LR_IT,  0,              0,              12 },
+        { &full._LE_IT,  0,              0,               3 } };
+
+    int npatchTypes = 0;
+    for (int i=0; i<7; ++i)
+        patches[npatchTypes++] = fullPatches[i];
+
+    for (int i=0; i<5; ++i) {
+        FarPatchTables::TPatches const & transition = tables->_transition[i];
+        PatchArrays regular = { &transition._R_IT, &transition._R_PTX, &transition._R_FVD, 16 };
+        patches[npatchTypes++] = regular;
+        for (int j=0; j<4; ++j) {
+            PatchArrays boundary = { &transition._B_IT[j], &transition._B_PTX[j], &transition._B_FVD[j], 12 },
+                    corner = { &transition._C_IT[j], &transition._C_PTX[j], &transition._C_FVD[j], 9 };
+            patches[npatchTypes++] = boundary;
+            patches[npatchTypes++] = corner;
+        }
+    }
+
+    for (int i=0; i<npatchTypes; ++i) {
+        PatchArrays const & p = patches[i];
+
+        if (not checkMarkers(*p.table, nmarkers) or p.table->GetSize()%p.ringsize)
+            return false;
+
+        int npatches = p.table->GetSize()/p.ringsize;
+        if (p.ptx and not p.ptx->empty() and (int)p.ptx->size()!=2*npatches)
+            return false;
+        if (p.fvd and not p.fvd->empty() and
+            (fvarwidth<=0 or (int)p.fvd->size()/(4*fvarwidth)!=npatches or (int)p.fvd->size()%(4*fvarwidth)))
+            return false;
+
+        unsigned int const * cvs = p.table->GetSize() ? (*p.table)[0] : 0;
+        for (int j=0; j<p.table->GetSize(); ++j)
+            if (cvs[j]>=(unsigned int)nverts)
+                return false;
+    }
+
+    int ngregory = full._G_IT.GetSize() + full._G_B_IT.GetSize();
+
+    // one quad offset per Gregory patch control vertex
+    if (not tables->_quadOffsetTable.empty() and (int)tables->_quadOffsetTable.size()!=ngregory)
+        return false;
+
+    // the valence table has one row of 2*maxvalence+1 entries per vertex : the
+    // rows of Gregory patch vertices are read and index the table itself
+    FarPatchTables::VertexValenceTable const & valences = tables->_vertexValenceTable;
+    if (not valences.empty()) {
+        int maxvalence = tables->_maxValence;
+        if (maxvalence<0 or maxvalence>(INT_MAX-1)/2)
+            return false;
+
+        int stride = 2*maxvalence+1,
+            nrows = (int)valences.size()/stride;
+        if ((int)valences.size()%stride)
+            return false;
+
+        int nindices = std::min(nrows, nverts);
+        for (int i=0; i<nrows; ++i) {
+            int const * row = &valences[i*stride];
+            int valence = row[0]<0 ? -row[0] : row[0];
+            if (valence>maxvalence)
+                return false;
+            for (int j=0; j<2*valence; ++j)
+                if (not isIndex(row[1+j], nindices))
+                    return false;
+        }
+
+        for (int i=3; i<5; ++i) {
+            FarPatchTables::PTable const & gregory = *patches[i].table;
+            for (int j=0; j<gregory.GetSize(); ++j)
+                if (gregory[0][j]>=(unsigned int)nrows)
+                    return false;
+        }
+    }
+    return true;
+}
+
+template <class U> bool
+FarMeshSerializer<U>::validateVertexEditTables(FarVertexEditTables<U> const * tables, int maxlevel, int nverts) {
+
+    for (int i=0; i<(int)tables->_batches.size(); ++i) {
+        typename FarVertexEditTables<U>::VertexEditBatch const & batch = tables->_batches[i];
+
+        if (batch._primvarIndex<0 or batch._primvarWidth<=0 or
+            not checkMarkers(batch._vertIndices, maxlevel+1) or
+            not checkMarkers(batch._edits, maxlevel+1))
+            return false;
+
+        unsigned int const * indices = batch._vertIndices.GetSize() ? batch._vertIndices[0] : 0;
+        for (int j=0; j<batch._vertIndices.GetSize(); ++j)
+            if (indices[j]>=(unsigned int)nverts)
+                return false;
+
+        // each edited vertex reads 'width' edit values
+        for (int level=0; level<maxlevel; ++level)
+            if (not checkRows(batch._edits, level, batch._vertIndices.GetNumElements(level), batch._primvarWidth))
+                return false;
+    }
+    return true;
+}
+
+template <class U> bool
+FarMeshSerializer<U>::validateFVarTables(FarFVarTables const * tables, int fvarwidth) {
+
+    std::vector<int> const & firstCorners = tables->_firstCorners;
+    if (firstCorners.size()<2 or firstCorners[0]!=0 or tables->_totalWidth!=fvarwidth)
+        return false;
+    for (int i=1; i<(int)firstCorners.size(); ++i)
+        if (firstCorners[i]<firstCorners[i-1])
+            return false;
+
+    // the data items are sub-ranges of the corners
+    int fvarcount = tables->GetFVarCount();
+    if ((int)tables->_offsets.size()!=fvarcount)
+        return false;
+    for (int i=0; i<fvarcount; ++i) {
+        int width = tables->_widths[i],
+            offset = tables->_offsets[i];
+        if (width<0 or offset<0 or width>fvarwidth-offset)
+            return false;
+    }
+
+    // the stencils of a level compute each of its corners from the corners
+    // of the previous levels
+    int maxlevel = tables->GetMaxLevel();
+    if ((int)tables->_tables.size()!=maxlevel*fvarcount)
+        return false;
+    for (int level=1; level<=maxlevel; ++level) {
+        for (int item=0; item<fvarcount; ++item) {
+            FarStencilTables const * stencils = tables->GetTables(level, item);
+
+            int nstencils = stencils->GetNumStencils(),
+                nindices = (int)stencils->_indices.size();
+            if (stencils->_firstVertexOffset!=tables->GetFirstCorner(level) or
+                nstencils!=tables->GetNumCorners(level) or
+                (int)stencils->_offsets.size()!=nstencils or
+                (int)stencils->_weights.size()!=nindices)
+                return false;
+
+            for (int i=0; i<nstencils; ++i) {
+                int size = stencils->_sizes[i],
+                    offset = stencils->_offsets[i];
+                if (size<0 or offset<0 or size>nindices-offset)
+                    return false;
+            }
+            for (int i=0; i<nindices; ++i)
+                if (not isIndex(stencils->_indices[i], stencils->_firstVertexOffset))
+                    return false;
+        }
+    }
+    return true;
+}
+
+template <class U> bool
+FarMeshSerializer<U>::validate(FarMesh<U> const * mesh, int scheme, int nverts) {
+
+    FarSubdivisionTables<U> const * tables = mesh->_subdivisionTables;
+
+    int maxlevel = (int)tables->_vertsOffsets.size()-1;
+
+    if (not validateSubdivisionTables(tables, scheme, nverts))
+        return false;
+
+    if (mesh->_patchTables and
+        not validatePatchTables(mesh->_patchTables, maxlevel, mesh->_totalFVarWidth, nverts))
+        return false;
+
+    if (mesh->_vertexEditTables and
+        not validateVertexEditTables(mesh->_vertexEditTables, maxlevel, nverts))
+        return false;
+
+    if (mesh->_fvarTables and
+        not validateFVarTables(mesh->_fvarTables, mesh->_totalFVarWidth))
+        return false;
+
+    for (int i=0; i<(int)mesh->_faceverts.size(); ++i) {
+        std::vector<int> const & faceverts = mesh->_faceverts[i];
+        for (int j=0; j<(int)faceverts.size(); ++j)
+            if (not isIndex(faceverts[j], nverts))
+                return false;
+    }
+    return true;
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_MESH_SERIALIZER_H */
@@ -68,6 +68,12 @@ namespace OPENSUBDIV_VERSION {
 /// FarPatchTables contain the lists of vertices for each patch of an adaptive
 /// mesh representation.
 ///
+/// Catmull-Clark meshes are represented with bicubic B-spline, Gregory and
+/// transition patches. Loop meshes are represented with quartic box-spline
+/// patches on the triangles of regular vertices, and with end patches on the
+/// triangles left irregular at the highest level of isolation (ptex and
+/// face-varying tables are not generated for Loop patches).
+///
 class FarPatchTables {
 
 public:
@@ -96,6 +102,12 @@ public:
     /// Returns a FarTable containing the vertex indices for all the Full Gregory Boundary patches
     PTable const & GetFullBoundaryGregoryPatches() const { return _full._G_B_IT; }
 
+    /// Returns a FarTable containing the vertex indices for all the Loop Regular (box-spline) patches
+    PTable const & GetFullLoopRegularPatches() const { return _full._LR_IT; }
+
+    /// Returns a FarTable containing the vertex indices for all the Loop End patches
+    PTable const & GetFullLoopEndPatches() const { return _full._LE_IT; }
+
     /// Returns a vertex valence table used by Gregory patches
     VertexValenceTable const & GetVertexValenceTable() const { return _vertexValenceTable; }
 
@@ -125,6 +137,29 @@ public:
     /// Ringsize of Gregory Patches in table.
     static int GetGregoryPatchRingsize() { return 4; }
 
+    /// \brief Ringsize of Loop Regular Patches in table.
+    ///
+    /// The 12 control vertices of a triangle are ordered as follows : the
+    /// triangle is (6, 7, 3), with 6 at (u,v)=(0,0), 7 at (1,0) and 3 at (0,1).
+    ///
+    ///           0     1
+    ///
+    ///        2     3     4
+    ///
+    ///     5     6     7     8
+    ///
+    ///        9     10    11
+    ///
+    static int GetLoopRegularPatchRingsize() { return 12; }
+
+    /// \brief Ringsize of Loop End Patches in table.
+    ///
+    /// End patches are the triangles containing an extraordinary, boundary or
+    /// creased vertex at the highest level of isolation : the triangle of its
+    /// 3 vertices approximates the limit surface.
+    ///
+    static int GetLoopEndPatchRingsize() { return 3; }
+
 
     /// Returns a PtexCoordinateTable for each type of patch
     PtexCoordinateTable const & GetFullRegularPtexCoordinates() const { return _full._R_PTX; }
@@ -166,6 +201,7 @@ public:
 private:
 
     template <class T> friend class FarPatchTablesFactory;
+    template <class X> friend class FarMeshSerializer;
 
     // Private constructor
     FarPatchTables( int maxlevel, int maxvalence ) : _full(maxlevel+1), _maxValence(maxvalence) {
@@ -179,7 +215,9 @@ private:
                _B_IT,   // boundary patches
                _C_IT,   // corner patches
                _G_IT,   // gregory patches
-               _G_B_IT; // gregory boundary patches
+               _G_B_IT, // gregory boundary patches
+               _LR_IT,  // loop regular patches
+               _LE_IT;  // loop end patches
 
         PtexCoordinateTable _R_PTX,
                             _B_PTX,
@@ -197,7 +235,9 @@ private:
                                 _B_IT(maxlevel),
                                 _C_IT(maxlevel),
                                 _G_IT(maxlevel),
-                                _G_B_IT(maxlevel)
+                                _G_B_IT(maxlevel),
+                                _LR_IT(maxlevel),
+                                _LE_IT(maxlevel)
         { }
     };
     
@@ -62,6 +62,8 @@
 
 #include "../far/patchTables.h"
 
+#include <typeinfo>
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
@@ -93,6 +95,20 @@ protected:
 
 private:
 
+    // True if the HbrMesh applies the Loop subdivision scheme
+    static bool isLoop(HbrMesh<T> const * mesh);
+
+    // Identifies the Loop regular and end patches among the triangles that
+    // were not refined
+    void tagLoopPatches();
+
+    // True if a triangle can be represented with a box-spline patch
+    static bool triangleIsBoxSpline( HbrFace<T> * f );
+
+    // Populates an array of indices with the 12 control vertices of a Loop
+    // regular patch
+    void getLoopOneRing( HbrFace<T> * f, unsigned int * result );
+
     // Returns true if one of v's neighboring faces has vertices carrying the tag "wasTagged"
     static bool vertexHasTaggedNeighbors(HbrVertex<T> * v);
 
@@ -118,7 +134,9 @@ private:
         X R_P,       // regular patch 
           B_P[4],    // boundary patch (4 rotations)
           C_P[4],    // corner patch (4 rotations)
-          G_P[2];    // gregory patch (boundary & corner)
+          G_P[2],    // gregory patch (boundary & corner)
+          LR_P,      // loop regular patch
+          LE_P;      // loop end patch
         
         Pointers() { memset(this, 0, sizeof(Pointers<X>)); }
     };
@@ -134,7 +152,9 @@ private:
         int R_C,                  // regular patch 
             B_C[4],               // boundary patch (4 rotations)
             C_C[4],               // corner patch (4 rotations)
-            G_C[2];               // gregory patch (boundary & corner)
+            G_C[2],               // gregory patch (boundary & corner)
+            LR_C,                 // loop regular patch
+            LE_C;                 // loop end patch
         
         Counters() { memset(this, 0, sizeof(Counters)); }
     };
@@ -173,6 +193,63 @@ FarPatchTablesFactory<T>::vertexHasTaggedNeighbors(HbrVertex<T> * v) {
     return false;
 }
 
+template <class T> bool
+FarPatchTablesFactory<T>::isLoop(HbrMesh<T> const * mesh) {
+    return typeid(*(mesh->GetSubdivision()))==typeid(HbrLoopSubdivision<T>);
+}
+
+// The patches of a Loop mesh are the triangles that were not refined, but
+// whose parent was (or coarse triangles that were not refined)
+template <class T> void
+FarPatchTablesFactory<T>::tagLoopPatches() {
+
+    for (int i=0; i<getNumFaces(); ++i) {
+
+        HbrFace<T> * f = getMesh()->GetFace(i);
+
+        if (f->_adaptiveFlags.isTagged or f->IsHole() or
+            (f->GetParent() and (not f->GetParent()->_adaptiveFlags.isTagged)))
+            continue;
+
+        assert(f->GetNumVertices()==3);
+
+        if (triangleIsBoxSpline(f)) {
+            f->_adaptiveFlags.patchType = HbrFace<T>::kFull;
+            _fullCtr.LR_C++;
+        } else {
+            f->_adaptiveFlags.patchType = HbrFace<T>::kEnd;
+            _fullCtr.LE_C++;
+        }
+    }
+}
+
+// The limit surface of a triangle is a quartic box-spline if its vertices are
+// smooth, interior and of valence 6, with no sharp edges around them
+template <class T> bool
+FarPatchTablesFactory<T>::triangleIsBoxSpline( HbrFace<T> * f ) {
+
+    if (f->HasVertexEdits())
+        return false;
+
+    for (int i=0; i<3; ++i) {
+
+        HbrVertex<T> * v = f->GetVertex(i);
+
+        if (v->OnBoundary() or v->GetValence()!=6 or
+            v->GetSharpness()>HbrVertex<T>::k_Smooth)
+            return false;
+
+        HbrHalfedge<T> * start = v->GetIncidentEdge(),
+                       * e = start;
+        do {
+            if (e->GetSharpness()>HbrHalfedge<T>::k_Smooth)
+                return false;
+            e = v->GetNextEdge(e);
+        } while (e and e!=start);
+    }
+    return true;
+}
+
 // Returns a rotation index for boundary patches (range [0-3])
 template <class T> unsigned char 
 FarPatchTablesFactory<T>::computeBoundaryPatchRotation( HbrFace<T> * f ) {
@@ -207,6 +284,11 @@ FarPatchTablesFactory<T>::FarPatchTablesFactory( HbrMesh<T> const * mesh, int nf
 {
     assert(mesh and nfaces>0);
 
+    if (isLoop(mesh)) {
+        tagLoopPatches();
+        return;
+    }
+
     // First pass : identify transition / watertight-critical
     for (int i=0; i<nfaces; ++i) {
 
@@ -460,6 +542,8 @@ FarPatchTablesFactory<T>::setMarkers(int level, FarPatchTables * result, IndexPo
     result->_full._C_IT.SetMarker(level, fptrs.C_P[0]);
     result->_full._G_IT.SetMarker(level, fptrs.G_P[0]);
     result->_full._G_B_IT.SetMarker(level, fptrs.G_P[1]);
+    result->_full._LR_IT.SetMarker(level, fptrs.LR_P);
+    result->_full._LE_IT.SetMarker(level, fptrs.LE_P);
     
     for (unsigned char i=0; i<5; ++i) {
         result->_transition[i]._R_IT.SetMarker(level, tptrs[i].R_P);
@@ -508,6 +592,14 @@ FarPatchTablesFactory<T>::Create( int maxlevel, int maxvalence, bool requirePtex
     result->_full._G_B_IT.Resize(_fullCtr.G_C[1]*4);
     fptrs.G_P[1] = result->_full._G_B_IT[0];
 
+    // Loop Regular patches
+    result->_full._LR_IT.Resize(_fullCtr.LR_C*12);
+    fptrs.LR_P = result->_full._LR_IT[0];
+
+    // Loop End patches
+    result->_full._LE_IT.Resize(_fullCtr.LE_C*3);
+    fptrs.LE_P = result->_full._LE_IT[0];
+
     // Quad-offsets tables (for Gregory patches)
     FarPatchTables::QuadOffsetTable quad_G_C0;
     quad_G_C0.resize(_fullCtr.G_C[0]*4);
@@ -598,6 +690,32 @@ FarPatchTablesFactory<T>::Create( int maxlevel, int maxvalence, bool requirePtex
         }
     }
 
+    // Loop patches are gathered level by level : the adaptive refinement of
+    // a Loop mesh does not create the triangles in order of depth
+    if (isLoop(getMesh())) {
+        for (int level=0; level<maxlevel; ++level) {
+            for (int i=0; i<getNumFaces(); ++i) {
+
+                HbrFace<T> * f = getMesh()->GetFace(i);
+                if (f->GetDepth()!=level)
+                    continue;
+
+                if (f->_adaptiveFlags.patchType==HbrFace<T>::kFull) {
+                    // Loop Regular Patch (12 CVs)
+                    getLoopOneRing(f, fptrs.LR_P);
+                    fptrs.LR_P+=12;
+                } else if (f->_adaptiveFlags.patchType==HbrFace<T>::kEnd) {
+                    // Loop End Patch (3 CVs)
+                    for (int j=0; j<3; ++j)
+                        fptrs.LE_P[j] = _remapTable[f->GetVertex(j)->GetID()];
+                    fptrs.LE_P+=3;
+                }
+            }
+            setMarkers(level+1, result, fptrs, tptrs);
+        }
+        return result;
+    }
+
     int currentDepth = 0;
 
     int fvarWidth = getMesh()->GetTotalFVarWidth();
@@ -923,6 +1041,32 @@ FarPatchTablesFactory<T>::getOneRing( HbrFace<T> * f, int ringsize, unsigned int
     assert(idx==ringsize);
 }
 
+// Gathers the 12 control vertices of a Loop regular patch (see
+// FarPatchTables::GetLoopRegularPatchRingsize for the ordering)
+template <class T> void 
+FarPatchTablesFactory<T>::getLoopOneRing( HbrFace<T> * f, unsigned int * result ) {
+
+    assert( f and f->GetNumVertices()==3 );
+
+    // Indices of the 6 neighbors of each vertex of the triangle, in the order
+    // in which they are found circulating counter-clockwise from the next
+    // vertex of the triangle
+    static const unsigned int remapRing[3][6] = { {7,3,2,5,9,10},
+                                                  {3,6,10,11,8,4},
+                                                  {6,7,4,1,0,2} };
+
+    for (int i=0; i<3; ++i) {
+        HbrVertex<T> * v = f->GetVertex(i);
+        HbrHalfedge<T> * e = f->GetEdge(i);
+        for (int j=0; j<6; ++j) {
+            assert(e);
+            result[remapRing[i][j]] = _remapTable[e->GetDestVertex()->GetID()];
+            e = v->GetNextEdge(e);
+        }
+        assert(e==f->GetEdge(i));
+    }
+}
+
 // Populate the quad-offsets table used by Gregory patches
 template <class T> void
 FarPatchTablesFactory<T>::getQuadOffsets( HbrFace<T> * f, unsigned int * result ) {
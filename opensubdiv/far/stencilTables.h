@@ -0,0 +1,143 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+
+#ifndef FAR_STENCIL_TABLES_H
+#define FAR_STENCIL_TABLES_H
+
+#include "../version.h"
+
+#include <cassert>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Flattened interpolation tables.
+///
+/// A stencil expresses a refined vertex directly as a weighted sum of the
+/// coarse (level 0) vertices of the mesh : all the levels of subdivision
+/// between the control cage and the refined vertex are collapsed into a
+/// single set of weights. Stencils have no data dependencies on each other,
+/// so the whole set can be applied in a single parallel pass that only reads
+/// the coarse vertices, instead of walking the subdivision tables level by
+/// level.
+///
+/// The stencils are stored in a compressed row format : stencil 'i' has
+/// GetSizes()[i] control vertices, listed in GetControlIndices() and
+/// GetWeights() starting at GetOffsets()[i]. Stencil 'i' computes the vertex
+/// GetFirstVertexOffset()+i of the mesh vertex buffer.
+///
+/// Stencils are created with a FarStencilTablesFactory.
+///
+class FarStencilTables {
+
+public:
+    /// Returns the number of stencils in the table
+    int GetNumStencils() const { return (int)_sizes.size(); }
+
+    /// Returns the number of coarse vertices the stencils are applied to
+    int GetNumControlVertices() const { return _numControlVertices; }
+
+    /// Returns the index of the vertex computed by the first stencil
+    int GetFirstVertexOffset() const { return _firstVertexOffset; }
+
+    /// Returns the number of control vertices of each stencil
+    std::vector<int> const & GetSizes() const { return _sizes; }
+
+    /// Returns the offset to the first control vertex of each stencil
+    std::vector<int> const & GetOffsets() const { return _offsets; }
+
+    /// Returns the indices of the control vertices of all the stencils
+    std::vector<int> const & GetControlIndices() const { return _indices; }
+
+    /// Returns the interpolation weights of all the stencils
+    std::vector<float> const & GetWeights() const { return _weights; }
+
+    /// Memory required to store the stencils
+    int GetMemoryUsed() const;
+
+private:
+    template <class U> friend class FarStencilTablesFactory;
+    template <class T, class U> friend class FarFVarTablesFactory;
+    template <class U> friend class FarMeshSerializer;
+
+    FarStencilTables() : _numControlVertices(0), _firstVertexOffset(0) { }
+
+    std::vector<int>   _sizes,    // number of control vertices per stencil
+                       _offsets,  // offset to the first control vertex of each stencil
+                       _indices;  // indices of the control vertices
+
+    std::vector<float> _weights;  // weights of the control vertices
+
+    int _numControlVertices,
+        _firstVertexOffset;
+};
+
+inline int
+FarStencilTables::GetMemoryUsed() const {
+    return (int)(_sizes.size()*sizeof(int)+
+                 _offsets.size()*sizeof(int)+
+                 _indices.size()*sizeof(int)+
+                 _weights.size()*sizeof(float));
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_STENCIL_TABLES_H */
@@ -0,0 +1,518 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+
+#ifndef FAR_STENCIL_TABLES_FACTORY_H
+#define FAR_STENCIL_TABLES_FACTORY_H
+
+#include "../version.h"
+
+#include "../far/dispatcher.h"
+#include "../far/mesh.h"
+#include "../far/stencilTables.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief A specialized factory for FarStencilTables
+///
+/// The factory applies the subdivision tables of a FarMesh to symbolic
+/// vertices : instead of interpolating vertex data, each compute kernel
+/// combines the stencils of the source vertices, so that the weights are
+/// composed across the subdivision levels.
+///
+template <class U> class FarStencilTablesFactory {
+
+public:
+    /// Creates the stencils of the vertices of subdivision levels 'firstLevel'
+    /// to 'lastLevel' (included) of the mesh.
+    ///
+    /// @param mesh        the mesh to generate the stencils from
+    ///
+    /// @param varying     generates stencils for varying interpolation instead
+    ///                    of vertex interpolation
+    ///
+    /// @param firstLevel  first level of subdivision (a negative value selects
+    ///                    'lastLevel' only)
+    ///
+    /// @param lastLevel   last level of subdivision (a negative value selects
+    ///                    the finest level of the mesh)
+    ///
+    /// Returns 0 if the mesh has hierarchical vertex edits, since these cannot
+    /// be expressed as a weighted sum of the coarse vertices.
+    ///
+    static FarStencilTables * Create( FarMesh<U> const * mesh,
+                                      bool varying=false,
+                                      int firstLevel=-1,
+                                      int lastLevel=-1 );
+
+private:
+    typedef std::vector< std::pair<int, float> > Stencil;
+
+    // Symbolic vertex buffer : holds one stencil per mesh vertex and
+    // accumulates the weights of the stencil being computed.
+    class StencilBuffer {
+    public:
+        StencilBuffer( int numVertices, int numControlVertices, bool varying );
+
+        bool IsVarying() const { return _varying; }
+
+        // Starts a new stencil with no weights
+        void Clear();
+
+        // Adds the weights of stencil 'index' scaled by 'weight'
+        void AddWithWeight( int index, float weight );
+
+        // Saves the accumulated weights in stencil 'index'
+        void Store( int index );
+
+        // Releases the memory used by the stencils of a range of vertices
+        void Release( int first, int count );
+
+        Stencil const & GetStencil( int index ) const { return _stencils[index]; }
+
+    private:
+        std::vector<Stencil> _stencils;
+
+        std::vector<float> _weights;  // dense accumulation buffer
+        std::vector<char>  _used;     // control vertices with a weight
+        std::vector<int>   _indices;  // list of the control vertices used
+
+        bool _varying;
+    };
+
+    // Dispatcher applying the compute kernels to a StencilBuffer
+    class StencilDispatcher : public FarDispatcher<U> {
+    protected:
+        virtual void ApplyBilinearFaceVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
+
+        virtual void ApplyBilinearEdgeVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
+
+        virtual void ApplyBilinearVertexVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
+
+
+        virtual void ApplyCatmarkFaceVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
+
+        virtual void ApplyCatmarkEdgeVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
+
+        virtual void ApplyCatmarkVertexVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
+
+
+        virtual void ApplyLoopEdgeVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
+
+        virtual void ApplyLoopVertexVerticesKernel(FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata) const;
+
+    private:
+        static void computeFacePoints( FarTable<unsigned int> const & F_IT, FarTable<int> const & F_ITa,
+                                       int offset, int level, int start, int end, StencilBuffer * buffer );
+
+        static void computeEdgePoints( FarSubdivisionTables<U> const * tables,
+                                       int offset, int level, int start, int end, StencilBuffer * buffer );
+
+        static void computeVertexPoints( FarSubdivisionTables<U> const * tables, bool loop,
+                                         int offset, int level, int start, int end, StencilBuffer * buffer );
+    };
+};
+
+template <class U> FarStencilTables *
+FarStencilTablesFactory<U>::Create( FarMesh<U> const * mesh, bool varying, int firstLevel, int lastLevel ) {
+
+    assert( mesh );
+
+    if (mesh->GetVertexEdit())
+        return 0;
+
+    FarSubdivisionTables<U> const * tables = mesh->GetSubdivisionTables();
+    assert( tables );
+
+    int maxlevel = tables->GetMaxLevel()-1;
+
+    if (lastLevel<0 or lastLevel>maxlevel)
+        lastLevel = maxlevel;
+
+    if (firstLevel<0 or firstLevel>lastLevel)
+        firstLevel = lastLevel;
+
+    int numControlVertices = tables->GetNumVertices(0);
+
+    StencilBuffer buffer( mesh->GetNumVertices(), numControlVertices, varying );
+
+    StencilDispatcher dispatcher;
+
+    for (int level=1; level<=lastLevel; ++level) {
+
+        tables->Apply( level, &dispatcher, &buffer );
+
+        // the kernels only read from the current and the previous levels
+        int release = level-1;
+        if (release>0 and release<firstLevel)
+            buffer.Release( tables->GetFirstVertexOffset(release), tables->GetNumVertices(release) );
+    }
+
+    FarStencilTables * result = new FarStencilTables;
+
+    result->_numControlVertices = numControlVertices;
+    result->_firstVertexOffset = firstLevel>0 ? tables->GetFirstVertexOffset(firstLevel) : 0;
+
+    int first = result->_firstVertexOffset,
+        last = tables->GetFirstVertexOffset(lastLevel) + tables->GetNumVertices(lastLevel),
+        nstencils = last - first,
+        nweights = 0;
+
+    for (int i=first; i<last; ++i)
+        nweights += (int)buffer.GetStencil(i).size();
+
+    result->_sizes.resize(nstencils);
+    result->_offsets.resize(nstencils);
+    result->_indices.resize(nweights);
+    result->_weights.resize(nweights);
+
+    for (int i=0, offset=0; i<nstencils; ++i) {
+
+        Stencil const & stencil = buffer.GetStencil(first+i);
+
+        result->_sizes[i] = (int)stencil.size();
+        result->_offsets[i] = offset;
+
+        for (int j=0; j<(int)stencil.size(); ++j, ++offset) {
+            result->_indices[offset] = stencil[j].first;
+            result->_weights[offset] = stencil[j].second;
+        }
+    }
+    return result;
+}
+
+template <class U>
+FarStencilTablesFactory<U>::StencilBuffer::StencilBuffer( int numVertices, int numControlVertices, bool varying ) :
+    _stencils(numVertices),
+    _weights(numControlVertices, 0.0f),
+    _used(numControlVertices, 0),
+    _varying(varying) {
+
+    // coarse vertices are their own stencil
+    for (int i=0; i<numControlVertices; ++i)
+        _stencils[i].push_back( std::make_pair(i, 1.0f) );
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::StencilBuffer::Clear() {
+    assert( _indices.empty() );
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::StencilBuffer::AddWithWeight( int index, float weight ) {
+
+    Stencil const & src = _stencils[index];
+
+    for (int i=0; i<(int)src.size(); ++i) {
+        int cv = src[i].first;
+        if (not _used[cv]) {
+            _used[cv] = 1;
+            _weights[cv] = 0.0f;
+            _indices.push_back(cv);
+        }
+        _weights[cv] += src[i].second * weight;
+    }
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::StencilBuffer::Store( int index ) {
+
+    // sorted control vertices improve the locality of the gathers
+    std::sort( _indices.begin(), _indices.end() );
+
+    Stencil & dst = _stencils[index];
+    dst.clear();
+    dst.reserve(_indices.size());
+
+    for (int i=0; i<(int)_indices.size(); ++i) {
+        int cv = _indices[i];
+        if (_weights[cv]!=0.0f)
+            dst.push_back( std::make_pair(cv, _weights[cv]) );
+        _used[cv] = 0;
+    }
+    _indices.clear();
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::StencilBuffer::Release( int first, int count ) {
+    for (int i=first; i<(first+count); ++i)
+        Stencil().swap(_stencils[i]);
+}
+
+//
+// Symbolic compute kernels : these replicate the vertex interpolation of the
+// FarSubdivisionTables kernels, and the varying interpolation of the Osd kernels.
+//
+
+template <class U> void
+FarStencilTablesFactory<U>::StencilDispatcher::computeFacePoints( FarTable<unsigned int> const & F_IT, FarTable<int> const & F_ITa,
+                                                                  int offset, int level, int start, int end, StencilBuffer * buffer ) {
+
+    const int * ITa = F_ITa[level-1];
+    const unsigned int * IT = F_IT[level-1];
+
+    for (int i=start; i<end; ++i) {
+
+        buffer->Clear();
+
+        int h = ITa[2*i  ],
+            n = ITa[2*i+1];
+        float weight = 1.0f/n;
+
+        for (int j=0; j<n; ++j)
+            buffer->AddWithWeight( IT[h+j], weight );
+
+        buffer->Store( offset+i );
+    }
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::StencilDispatcher::computeEdgePoints( FarSubdivisionTables<U> const * tables,
+                                                                  int offset, int level, int start, int end, StencilBuffer * buffer ) {
+
+    const int * E_IT = tables->Get_E_IT()[level-1];
+    const float * E_W = tables->Get_E_W()[level-1];
+
+    for (int i=start; i<end; ++i) {
+
+        buffer->Clear();
+
+        int eidx0 = E_IT[4*i+0],
+            eidx1 = E_IT[4*i+1],
+            eidx2 = E_IT[4*i+2],
+            eidx3 = E_IT[4*i+3];
+
+        if (buffer->IsVarying()) {
+            buffer->AddWithWeight( eidx0, 0.5f );
+            buffer->AddWithWeight( eidx1, 0.5f );
+        } else {
+            float vertWeight = E_W[i*2+0];
+
+            buffer->AddWithWeight( eidx0, vertWeight );
+            buffer->AddWithWeight( eidx1, vertWeight );
+
+            if (eidx2!=-1) {
+                float faceWeight = E_W[i*2+1];
+
+                buffer->AddWithWeight( eidx2, faceWeight );
+                buffer->AddWithWeight( eidx3, faceWeight );
+            }
+        }
+        buffer->Store( offset+i );
+    }
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::StencilDispatcher::computeVertexPoints( FarSubdivisionTables<U> const * tables, bool loop,
+                                                                    int offset, int level, int start, int end, StencilBuffer * buffer ) {
+
+    const int * V_ITa = tables->Get_V_ITa()[level-1];
+    const unsigned int * V_IT = tables->Get_V_IT()[level-1];
+    const float * V_W = tables->Get_V_W()[level-1];
+    const unsigned char * V_R = tables->Get_V_R()[level-1];
+
+    for (int i=start; i<end; ++i) {
+
+        buffer->Clear();
+
+        int     h=V_ITa[5*i  ],
+                n=V_ITa[5*i+1],
+                p=V_ITa[5*i+2],
+            eidx0=V_ITa[5*i+3],
+            eidx1=V_ITa[5*i+4];
+
+        if (buffer->IsVarying()) {
+            buffer->AddWithWeight( p, 1.0f );
+            buffer->Store( offset+i );
+            continue;
+        }
+
+        unsigned char rule = V_R[i];
+
+        float weight = V_W[i];
+
+        if (rule<=FarSubdivisionTables<U>::k_RuleSmoothCrease) {
+            if (loop) {
+                float wp = 1.0f/n,
+                    beta = 0.25f * cosf((float)M_PI * 2.0f * wp) + 0.375f;
+                beta = beta*beta;
+                beta = (0.625f-beta)*wp;
+
+                buffer->AddWithWeight( p, weight * (1.0f-(beta*n)) );
+
+                for (int j=0; j<n; ++j)
+                    buffer->AddWithWeight( V_IT[h+j], weight * beta );
+            } else {
+                float wp = 1.0f/(n*n),
+                      wv = (n-2.0f)*n*wp;
+
+                buffer->AddWithWeight( p, weight * wv );
+
+                for (int j=0; j<n; ++j) {
+                    buffer->AddWithWeight( V_IT[h+j*2  ], weight * wp );
+                    buffer->AddWithWeight( V_IT[h+j*2+1], weight * wp );
+                }
+            }
+        }
+
+        switch (rule) {
+            case FarSubdivisionTables<U>::k_RuleSmoothCorner :
+                buffer->AddWithWeight( p, 1.0f - weight );
+                break;
+            case FarSubdivisionTables<U>::k_RuleSmoothCrease : {
+                float w = 1.0f - weight;
+                buffer->AddWithWeight( p, w * 0.75f );
+                buffer->AddWithWeight( eidx0, w * 0.125f );
+                buffer->AddWithWeight( eidx1, w * 0.125f );
+            } break;
+            case FarSubdivisionTables<U>::k_RuleCreaseCorner :
+                buffer->AddWithWeight( p, 1.0f - weight );
+                buffer->AddWithWeight( p, weight * 0.75f );
+                buffer->AddWithWeight( eidx0, weight * 0.125f );
+                buffer->AddWithWeight( eidx1, weight * 0.125f );
+                break;
+            case FarSubdivisionTables<U>::k_RuleCorner :
+                buffer->AddWithWeight( p, 1.0f );
+                break;
+            case FarSubdivisionTables<U>::k_RuleCrease :
+                buffer->AddWithWeight( p, 0.75f );
+                buffer->AddWithWeight( eidx0, 0.125f );
+                buffer->AddWithWeight( eidx1, 0.125f );
+                break;
+            default : break;
+        }
+        buffer->Store( offset+i );
+    }
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::StencilDispatcher::ApplyBilinearFaceVerticesKernel( FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata ) const {
+    FarBilinearSubdivisionTables<U> const * subdivision =
+        dynamic_cast<FarBilinearSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(subdivision);
+    computeFacePoints( subdivision->Get_F_IT(), subdivision->Get_F_ITa(), offset, level, start, end, static_cast<StencilBuffer *>(clientdata) );
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::StencilDispatcher::ApplyBilinearEdgeVerticesKernel( FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata ) const {
+
+    StencilBuffer * buffer = static_cast<StencilBuffer *>(clientdata);
+
+    const int * E_IT = mesh->GetSubdivisionTables()->Get_E_IT()[level-1];
+
+    for (int i=start; i<end; ++i) {
+        buffer->Clear();
+        buffer->AddWithWeight( E_IT[2*i+0], 0.5f );
+        buffer->AddWithWeight( E_IT[2*i+1], 0.5f );
+        buffer->Store( offset+i );
+    }
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::StencilDispatcher::ApplyBilinearVertexVerticesKernel( FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata ) const {
+
+    StencilBuffer * buffer = static_cast<StencilBuffer *>(clientdata);
+
+    const int * V_ITa = mesh->GetSubdivisionTables()->Get_V_ITa()[level-1];
+
+    for (int i=start; i<end; ++i) {
+        buffer->Clear();
+        buffer->AddWithWeight( V_ITa[i], 1.0f );
+        buffer->Store( offset+i );
+    }
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::StencilDispatcher::ApplyCatmarkFaceVerticesKernel( FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata ) const {
+    FarCatmarkSubdivisionTables<U> const * subdivision =
+        dynamic_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(subdivision);
+    computeFacePoints( subdivision->Get_F_IT(), subdivision->Get_F_ITa(), offset, level, start, end, static_cast<StencilBuffer *>(clientdata) );
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::StencilDispatcher::ApplyCatmarkEdgeVerticesKernel( FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata ) const {
+    computeEdgePoints( mesh->GetSubdivisionTables(), offset, level, start, end, static_cast<StencilBuffer *>(clientdata) );
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::StencilDispatcher::ApplyCatmarkVertexVerticesKernel( FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata ) const {
+    computeVertexPoints( mesh->GetSubdivisionTables(), false, offset, level, start, end, static_cast<StencilBuffer *>(clientdata) );
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::StencilDispatcher::ApplyLoopEdgeVerticesKernel( FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata ) const {
+    computeEdgePoints( mesh->GetSubdivisionTables(), offset, level, start, end, static_cast<StencilBuffer *>(clientdata) );
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::StencilDispatcher::ApplyLoopVertexVerticesKernel( FarMesh<U> * mesh, int offset, int level, int start, int end, void * clientdata ) const {
+    computeVertexPoints( mesh->GetSubdivisionTables(), true, offset, level, start, end, static_cast<StencilBuffer *>(clientdata) );
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_STENCIL_TABLES_FACTORY_H */
@@ -61,6 +61,7 @@
 #include "../version.h"
 
 #include "../far/table.h"
+#include "../far/dependencyTables.h"
 
 #include <cassert>
 #include <utility>
@@ -90,6 +91,10 @@ template <class U> class FarDispatcher;
 /// - _<T>_ITa : codex for the two previous tables
 /// (where T denotes a face-vertex / edge-vertex / vertex-vertex)
 ///
+/// Vertex-vertices also store the subdivision rule applied to each vertex in
+/// _V_R, which allows compute kernels to interpolate each of them in a single
+/// pass.
+///
 ///
 /// Because each subdivision scheme (Catmark / Loop / Bilinear) introduces variations
 /// in the subdivision rules, a derived class specialization is associated with
@@ -104,6 +109,17 @@ public:
     /// Destructor
     virtual ~FarSubdivisionTables<U>() {}
 
+    /// Subdivision schemes
+    enum Scheme {
+        k_Bilinear=0,
+        k_Catmark,
+        k_Loop
+    };
+
+    /// Returns the subdivision scheme of the tables : the tables can be
+    /// statically cast to the matching derived class (no RTTI required)
+    Scheme GetScheme() const { return _scheme; }
+
     /// Return the highest level of subdivision possible with these tables
     int GetMaxLevel() const { return (int)(_vertsOffsets.size()); }
 
@@ -113,6 +129,10 @@ public:
     /// Compute the positions of refined vertices using the specified kernels
     virtual void Apply( int level, FarDispatcher<U> const *dispatch, void * data=0 ) const=0;
 
+    /// Compute the positions of the refined vertices of a level that are
+    /// listed in 'dirty' using the specified kernels
+    virtual void ApplyDirty( int level, FarDirtyVertices const * dirty, FarDispatcher<U> const *dispatch, void * data=0 ) const=0;
+
     /// Pointer back to the mesh owning the table
     FarMesh<U> * GetMesh() { return _mesh; }
 
@@ -149,14 +169,40 @@ public:
     /// Returns the vertex vertices weights table
     FarTable<float> const &        Get_V_W() const { return _V_W; }
 
+    /// Returns the vertex vertices rules table (see VertexRule)
+    FarTable<unsigned char> const & Get_V_R() const { return _V_R; }
+
+    /// Subdivision rules applied to the vertex-vertices by the fused kernels.
+    /// Blended rules interpolate between the k_Smooth / k_Dart rule (weighted
+    /// by _V_W) and the sharp rule (weighted by 1 - _V_W). The k_Crease /
+    /// k_Corner blend applies k_Crease with _V_W and k_Corner with 1 - _V_W.
+    enum VertexRule {
+        k_RuleSmooth=0,      ///< k_Smooth or k_Dart
+        k_RuleSmoothCorner,  ///< k_Smooth / k_Dart blended with k_Corner
+        k_RuleSmoothCrease,  ///< k_Smooth / k_Dart blended with k_Crease
+        k_RuleCreaseCorner,  ///< k_Crease blended with k_Corner
+        k_RuleCorner,        ///< k_Corner
+        k_RuleCrease         ///< k_Crease
+    };
+
     /// Returns the number of indexing tables needed to represent this particular
     /// subdivision scheme.
     virtual int GetNumTables() const { return 5; }
 
+    /// Returns an integer based on the order in which the kernels are applied
+    /// to a vertex with the given pair of masks
+    static int GetMaskRanking( unsigned char mask0, unsigned char mask1 );
+
+    /// Returns the rule of the fused vertex-vertices kernel matching a rank
+    static unsigned char GetVertexRule( int rank );
+
 protected:
     template <class X, class Y> friend class FarMeshFactory;
+    template <class X> friend class FarMeshSerializer;
+    template <class X> friend class FarTopologyMeshFactory;
+    friend class FarDispatcher<U>;
 
-    FarSubdivisionTables<U>( FarMesh<U> * mesh, int maxlevel );
+    FarSubdivisionTables<U>( FarMesh<U> * mesh, int maxlevel, Scheme scheme );
 
 #if defined(__clang__)
     // XXX(jcowles): seems like there is a compiler bug in clang that requires
@@ -218,6 +264,7 @@ protected:
     FarTable<int>          _V_ITa; // vertices from vertex refinement
     FarTable<unsigned int> _V_IT;  // indices of adjacent vertices
     FarTable<float>        _V_W;   // weights
+    FarTable<unsigned char> _V_R;  // subdivision rules
 
     std::vector<VertexKernelBatch> _batches; // batches of vertices for kernel execution
 
@@ -225,19 +272,22 @@ protected:
     
     unsigned int _numCoarseVertices;
 private:
+    Scheme _scheme;
 };
 
 template <class U>
-FarSubdivisionTables<U>::FarSubdivisionTables( FarMesh<U> * mesh, int maxlevel ) :
+FarSubdivisionTables<U>::FarSubdivisionTables( FarMesh<U> * mesh, int maxlevel, Scheme scheme ) :
     _mesh(mesh),
     _E_IT(maxlevel+1),
     _E_W(maxlevel+1),
     _V_ITa(maxlevel+1),
     _V_IT(maxlevel+1),
     _V_W(maxlevel+1),
+    _V_R(maxlevel+1),
     _batches(maxlevel),
     _vertsOffsets(maxlevel+1,0),
-    _numCoarseVertices(0)
+    _numCoarseVertices(0),
+    _scheme(scheme)
 {
     assert( maxlevel > 0 );
 }
@@ -288,7 +338,56 @@ FarSubdivisionTables<U>::GetMemoryUsed() const {
            _E_W.GetMemoryUsed()+
            _V_ITa.GetMemoryUsed()+
            _V_IT.GetMemoryUsed()+
-           _V_W.GetMemoryUsed();
+           _V_W.GetMemoryUsed()+
+           _V_R.GetMemoryUsed();
+}
+
+// The ranking matrix defines the order of execution for the various combinations
+// of Corner, Crease, Dart and Smooth topological configurations. This matrix is
+// somewhat arbitrary as it is possible to perform some permutations in the
+// ordering without adverse effects, but it does try to minimize kernel switching
+// during the exececution of Apply(). This table is identical for both the Loop
+// and Catmull-Clark schemes.
+//
+// The matrix is derived from this table :
+// Rules     +----+----+----+----+----+----+----+----+----+----+
+//   Pass 0  | Dt | Sm | Sm | Dt | Sm | Dt | Sm | Cr | Co | Cr |
+//   Pass 1  |    |    |    | Co | Co | Cr | Cr | Co |    |    |
+// Kernel    +----+----+----+----+----+----+----+----+----+----+
+//   Pass 0  | B  | B  | B  | B  | B  | B  | B  | A  | A  | A  |
+//   Pass 1  |    |    |    | A  | A  | A  | A  | A  |    |    |
+//           +----+----+----+----+----+----+----+----+----+----+
+// Rank      | 0  | 1  | 2  | 3  | 4  | 5  | 6  | 7  | 8  | 9  |
+//           +----+----+----+----+----+----+----+----+----+----+
+// with :
+//     - A : compute kernel applying k_Crease / k_Corner rules
+//     - B : compute kernel applying k_Smooth / k_Dart rules
+template <class U> int
+FarSubdivisionTables<U>::GetMaskRanking( unsigned char mask0, unsigned char mask1 ) {
+    static short masks[4][4] = { {    0,    1,    6,    4 },
+                                 { 0xFF,    2,    5,    3 },
+                                 { 0xFF, 0xFF,    9,    7 },
+                                 { 0xFF, 0xFF, 0xFF,    8 } };
+    return masks[mask0][mask1];
+}
+
+// Each rank of the ranking matrix maps to a single rule of the fused kernel,
+// so that the fused kernel produces in one pass the same result as the
+// sequence of "A" and "B" kernels.
+template <class U> unsigned char
+FarSubdivisionTables<U>::GetVertexRule( int rank ) {
+    static unsigned char rules[10] = { k_RuleSmooth,
+                                       k_RuleSmooth,
+                                       k_RuleSmooth,
+                                       k_RuleSmoothCorner,
+                                       k_RuleSmoothCorner,
+                                       k_RuleSmoothCrease,
+                                       k_RuleSmoothCrease,
+                                       k_RuleCreaseCorner,
+                                       k_RuleCorner,
+                                       k_RuleCrease };
+    assert(rank>=0 and rank<10);
+    return rules[rank];
 }
 
 } // end namespace OPENSUBDIV_VERSION
@@ -61,7 +61,9 @@
 #include "../far/meshFactory.h"
 #include "../far/subdivisionTables.h"
 
+#include <algorithm>
 #include <cassert>
+#include <climits>
 #include <utility>
 #include <vector>
 
@@ -71,6 +73,7 @@ namespace OPENSUBDIV_VERSION {
 template <class T, class U> class  FarBilinearSubdivisionTablesFactory;
 template <class T, class U> class  FarCatmarkSubdivisionTablesFactory;
 template <class T, class U> class  FarLoopSubdivisionTablesFactory;
+template <class T, class U> class  FarMeshFactory;
 
 /// \brief A specialized factory for FarSubdivisionTables
 ///
@@ -89,7 +92,8 @@ protected:
     // specialized subdivision scheme factories (Bilinear / Catmark / Loop).
     // It also populates the FarMeshFactory vertex remapping vector that ties the
     // Hbr vertex indices to the FarVertexEdit tables.
-    FarSubdivisionTablesFactory( HbrMesh<T> const * mesh, int maxlevel, std::vector<int> & remapTable );
+    FarSubdivisionTablesFactory( HbrMesh<T> const * mesh, int maxlevel, std::vector<int> & remapTable,
+                                 typename FarMeshFactory<T,U>::VertexOrdering ordering );
 
     /// Returns the number of coarse vertices found in the mesh
     int GetNumCoarseVertices() const { 
@@ -117,8 +121,11 @@ protected:
     /// Valence summation for face vertices 
     int GetVertVertsValenceSum() const { return _vertVertsValenceSum; }
 
-    // Returns an integer based on the order in which the kernels are applied
-    static int GetMaskRanking( unsigned char mask0, unsigned char mask1 );
+    // Computes the offsets of the indices gathered by the k_Smooth / k_Dart
+    // pass of each vertex-vertex of a level ('stride' indices per edge around
+    // the parent vertex), so that the vertices can be filled in parallel
+    void computeVertVertsOffsets( int level, int stride, int nthreads,
+                                  std::vector<int> & offsets ) const;
 
     // Per-level counters and offsets for each type of vertex (face,edge,vert)
     std::vector<int> _faceVertIdx,
@@ -142,12 +149,36 @@ private:
     static int sumVertVertexValence(HbrVertex<T> * vertex);
 
     // Compares vertices based on their topological configuration 
-    // (see subdivisionTables::GetMaskRanking for more details)
+    // (see FarSubdivisionTables::GetMaskRanking for more details)
     static bool compareVertices( HbrVertex<T> const *x, HbrVertex<T> const *y );
+
+    // Returns the rank of the kernel applied to a vertex-vertex
+    static int getVertexRanking( HbrVertex<T> const * v );
+
+    // Returns the position of a parent vertex in the locality ordering
+    static int getParentRank( HbrVertex<T> const * v, std::vector<int> const & remapTable,
+                                                      std::vector<int> const & coarseRanks );
+
+    // Sorts the vertices [first, last) of a list by increasing key (equal keys
+    // retain their relative order)
+    static void sortByKeys( std::vector<HbrVertex<T> *> & list, int first, int last,
+                            std::vector<int> const & keys );
+
+    // Sorts the face, edge and vertex vertices of a level in the order of their
+    // parents and renumbers the face and edge vertices in the remapping table
+    void sortByParents( int level, std::vector<int> & remapTable,
+                        std::vector<int> const & coarseRanks );
+
+    // Ranks the coarse vertices with a reverse Cuthill-McKee traversal of the
+    // coarse faces
+    static void computeCuthillMcKeeRanks( HbrMesh<T> const * mesh,
+                                          std::vector<HbrVertex<T> *> const & coarseVerts,
+                                          std::vector<int> & ranks );
 };
 
 template <class T, class U> 
-FarSubdivisionTablesFactory<T,U>::FarSubdivisionTablesFactory( HbrMesh<T> const * mesh, int maxlevel, std::vector<int> & remapTable ) :
+FarSubdivisionTablesFactory<T,U>::FarSubdivisionTablesFactory( HbrMesh<T> const * mesh, int maxlevel, std::vector<int> & remapTable,
+                                                               typename FarMeshFactory<T,U>::VertexOrdering ordering ) :
     _faceVertIdx(maxlevel+1,0),
     _edgeVertIdx(maxlevel+1,0),
     _vertVertIdx(maxlevel+1,0),
@@ -251,15 +282,27 @@ FarSubdivisionTablesFactory<T,U>::FarSubdivisionTablesFactory( HbrMesh<T> const
 
     // Sort the the vertices that are the child of a vertex based on their weight
     // mask. The masks combinations are ordered so as to minimize the compute
-    // kernel switching.(see subdivisionTables::GetMaskRanking for more details)
+    // kernel switching.(see FarSubdivisionTables::GetMaskRanking for more details)
     for (size_t i=1; i<_vertVertsList.size(); ++i)
         std::sort( _vertVertsList[i].begin(), _vertVertsList[i].end(), compareVertices );
 
 
-    // These vertices still need a remapped index
-    for (int l=1; l<(maxlevel+1); ++l)
+    // Locality ordering : the parents of the vertices of a level need their
+    // final index before the level can be sorted, so the levels are processed
+    // in order.
+    std::vector<int> coarseRanks;
+    if (ordering==FarMeshFactory<T,U>::k_OrderCuthillMcKee)
+        computeCuthillMcKeeRanks(mesh, _vertVertsList[0], coarseRanks);
+
+    for (int l=1; l<(maxlevel+1); ++l) {
+
+        if (ordering!=FarMeshFactory<T,U>::k_OrderKernel)
+            sortByParents(l, remapTable, l==1 ? coarseRanks : std::vector<int>());
+
+        // These vertices still need a remapped index
         for (size_t i=0; i<_vertVertsList[l].size(); ++i)
             remapTable[ _vertVertsList[l][i]->GetID() ]=_vertVertIdx[l]+(int)i;
+    }
 
 
 }
@@ -275,33 +318,40 @@ FarSubdivisionTablesFactory<T,U>::sumList( std::vector<std::vector<Type> > const
     return total;
 }
 
-// The ranking matrix defines the order of execution for the various combinations
-// of Corner, Crease, Dart and Smooth topological configurations. This matrix is
-// somewhat arbitrary as it is possible to perform some permutations in the
-// ordering without adverse effects, but it does try to minimize kernel switching
-// during the exececution of Apply(). This table is identical for both the Loop
-// and Catmull-Clark schemes.
-//
-// The matrix is derived from this table :
-// Rules     +----+----+----+----+----+----+----+----+----+----+
-//   Pass 0  | Dt | Sm | Sm | Dt | Sm | Dt | Sm | Cr | Co | Cr |
-//   Pass 1  |    |    |    | Co | Co | Cr | Cr | Co |    |    |
-// Kernel    +----+----+----+----+----+----+----+----+----+----+
-//   Pass 0  | B  | B  | B  | B  | B  | B  | B  | A  | A  | A  |
-//   Pass 1  |    |    |    | A  | A  | A  | A  | A  |    |    |
-//           +----+----+----+----+----+----+----+----+----+----+
-// Rank      | 0  | 1  | 2  | 3  | 4  | 5  | 6  | 7  | 8  | 9  |
-//           +----+----+----+----+----+----+----+----+----+----+
-// with :
-//     - A : compute kernel applying k_Crease / k_Corner rules
-//     - B : compute kernel applying k_Smooth / k_Dart rules
-template <class T, class U> int
-FarSubdivisionTablesFactory<T,U>::GetMaskRanking( unsigned char mask0, unsigned char mask1 ) {
-    static short masks[4][4] = { {    0,    1,    6,    4 },
-                                 { 0xFF,    2,    5,    3 },
-                                 { 0xFF, 0xFF,    9,    7 },
-                                 { 0xFF, 0xFF, 0xFF,    8 } };
-    return masks[mask0][mask1];
+template <class T, class U> void
+FarSubdivisionTablesFactory<T,U>::computeVertVertsOffsets( int level, int stride, int nthreads,
+                                                           std::vector<int> & offsets ) const {
+
+    int nverts = (int)_vertVertsList[level].size();
+
+    offsets.assign(nverts+1, 0);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if(nthreads>1)
+#endif
+    for (int i=0; i<nverts; ++i) {
+
+        HbrVertex<T> * pv = _vertVertsList[level][i]->GetParentVertex();
+        assert(pv);
+
+        // the first pass is the only one that can apply the k_Smooth or
+        // k_Dart rules (the mask of the second pass is sharper)
+        if (pv->GetMask(false) > HbrVertex<T>::k_Dart)
+            continue;
+
+        int valence = 0;
+        HbrHalfedge<T> *e = pv->GetIncidentEdge(),
+                       *start = e;
+        while (e) {
+            ++valence;
+            e = e->GetPrev()->GetOpposite();
+            if (e==start) break;
+        }
+        offsets[i+1] = stride * valence;
+    }
+
+    for (int i=0; i<nverts; ++i)
+        offsets[i+1] += offsets[i];
 }
 
 // Sums the number of adjacent vertices required to interpolate a Vert-Vertex 
@@ -345,11 +395,179 @@ FarSubdivisionTablesFactory<T,U>::compareVertices( HbrVertex<T> const * x, HbrVe
     HbrVertex<T> * px=x->GetParentVertex(),
                  * py=y->GetParentVertex();
 
-    assert( (GetMaskRanking(px->GetMask(false), px->GetMask(true) )!=0xFF) and
-            (GetMaskRanking(py->GetMask(false), py->GetMask(true) )!=0xFF) );
+    assert( (FarSubdivisionTables<U>::GetMaskRanking(px->GetMask(false), px->GetMask(true) )!=0xFF) and
+            (FarSubdivisionTables<U>::GetMaskRanking(py->GetMask(false), py->GetMask(true) )!=0xFF) );
+
+    return FarSubdivisionTables<U>::GetMaskRanking(px->GetMask(false), px->GetMask(true) ) <
+           FarSubdivisionTables<U>::GetMaskRanking(py->GetMask(false), py->GetMask(true) );
+}
+
+template <class T, class U> int
+FarSubdivisionTablesFactory<T,U>::getVertexRanking( HbrVertex<T> const * v ) {
+
+    HbrVertex<T> * pv = v->GetParentVertex();
+    assert(pv);
+    return FarSubdivisionTables<U>::GetMaskRanking(pv->GetMask(false), pv->GetMask(true));
+}
+
+template <class T, class U> int
+FarSubdivisionTablesFactory<T,U>::getParentRank( HbrVertex<T> const * v, std::vector<int> const & remapTable,
+                                                                         std::vector<int> const & coarseRanks ) {
+    int index = remapTable[ v->GetID() ];
+    if (index<0)
+        return INT_MAX;
+    return coarseRanks.empty() ? index : coarseRanks[index];
+}
+
+template <class T, class U> void
+FarSubdivisionTablesFactory<T,U>::sortByKeys( std::vector<HbrVertex<T> *> & list, int first, int last,
+                                              std::vector<int> const & keys ) {
+
+    // sorting (key, position) pairs keeps the sort stable
+    std::vector<std::pair<int, int> > order(last-first);
+    for (int i=first; i<last; ++i)
+        order[i-first] = std::make_pair(keys[i], i);
+
+    std::sort(order.begin(), order.end());
+
+    std::vector<HbrVertex<T> *> sorted(last-first);
+    for (int i=0; i<(last-first); ++i)
+        sorted[i] = list[order[i].second];
+
+    std::copy(sorted.begin(), sorted.end(), list.begin()+first);
+}
+
+// Children are sorted by the lowest rank of the parent vertices that their
+// kernel gathers from. The parents of the vertices of the first level are
+// ranked by coarseRanks if not empty, and by their index otherwise.
+template <class T, class U> void
+FarSubdivisionTablesFactory<T,U>::sortByParents( int level, std::vector<int> & remapTable,
+                                                 std::vector<int> const & coarseRanks ) {
+
+    std::vector<int> keys;
+
+    // Face-vertices : vertices of the parent face
+    std::vector<HbrVertex<T> *> & faceVerts = _faceVertsList[level];
+    int nfaceverts = (int)faceVerts.size();
+
+    keys.resize(nfaceverts);
+    for (int i=0; i<nfaceverts; ++i) {
+        HbrFace<T> * f = faceVerts[i]->GetParentFace();
+        assert(f);
+        int key = INT_MAX;
+        for (int j=0; j<f->GetNumVertices(); ++j)
+            key = std::min(key, getParentRank(f->GetVertex(j), remapTable, coarseRanks));
+        keys[i] = key;
+    }
+    sortByKeys(faceVerts, 0, nfaceverts, keys);
+
+    for (int i=0; i<nfaceverts; ++i)
+        remapTable[ faceVerts[i]->GetID() ] = _faceVertIdx[level]+i;
+
+    // Edge-vertices : end points of the parent edge
+    std::vector<HbrVertex<T> *> & edgeVerts = _edgeVertsList[level];
+    int nedgeverts = (int)edgeVerts.size();
+
+    keys.resize(nedgeverts);
+    for (int i=0; i<nedgeverts; ++i) {
+        HbrHalfedge<T> * e = edgeVerts[i]->GetParentEdge();
+        assert(e);
+        keys[i] = std::min(getParentRank(e->GetOrgVertex(), remapTable, coarseRanks),
+                           getParentRank(e->GetDestVertex(), remapTable, coarseRanks));
+    }
+    sortByKeys(edgeVerts, 0, nedgeverts, keys);
+
+    for (int i=0; i<nedgeverts; ++i)
+        remapTable[ edgeVerts[i]->GetID() ] = _edgeVertIdx[level]+i;
+
+    // Vertex-vertices : parent vertex. The vertices are sorted within each
+    // kernel rank, so that the kernel batches are not affected.
+    std::vector<HbrVertex<T> *> & vertVerts = _vertVertsList[level];
+    int nvertverts = (int)vertVerts.size();
+
+    keys.resize(nvertverts);
+    for (int i=0; i<nvertverts; ++i)
+        keys[i] = getParentRank(vertVerts[i]->GetParentVertex(), remapTable, coarseRanks);
+
+    for (int first=0, last=0; first<nvertverts; first=last) {
+        int rank = getVertexRanking(vertVerts[first]);
+        for (last=first+1; last<nvertverts and getVertexRanking(vertVerts[last])==rank; ++last);
+        sortByKeys(vertVerts, first, last, keys);
+    }
+}
+
+// Reverse Cuthill-McKee : breadth-first traversal of the vertex graph of the
+// coarse mesh, starting from low valence vertices and visiting neighbors by
+// increasing valence. Disconnected components are traversed in turn.
+template <class T, class U> void
+FarSubdivisionTablesFactory<T,U>::computeCuthillMcKeeRanks( HbrMesh<T> const * mesh,
+                                                            std::vector<HbrVertex<T> *> const & coarseVerts,
+                                                            std::vector<int> & ranks ) {
+
+    int nverts = 0;
+    for (int i=0; i<(int)coarseVerts.size(); ++i)
+        nverts = std::max(nverts, coarseVerts[i]->GetID()+1);
+
+    std::vector<std::vector<int> > neighbors(nverts);
+    for (int i=0; i<mesh->GetNumCoarseFaces(); ++i) {
+        HbrFace<T> * f = mesh->GetFace(i);
+        int nv = f->GetNumVertices();
+        for (int j=0; j<nv; ++j) {
+            int v0 = f->GetVertex(j)->GetID(),
+                v1 = f->GetVertex((j+1)%nv)->GetID();
+            neighbors[v0].push_back(v1);
+            neighbors[v1].push_back(v0);
+        }
+    }
+
+    std::vector<int> valences(nverts);
+    for (int i=0; i<nverts; ++i) {
+        std::vector<int> & n = neighbors[i];
+        std::sort(n.begin(), n.end());
+        n.erase(std::unique(n.begin(), n.end()), n.end());
+        valences[i] = (int)n.size();
+    }
+
+    std::vector<std::pair<int, int> > seeds(coarseVerts.size());
+    for (int i=0; i<(int)coarseVerts.size(); ++i) {
+        int id = coarseVerts[i]->GetID();
+        seeds[i] = std::make_pair(valences[id], id);
+    }
+    std::sort(seeds.begin(), seeds.end());
+
+    std::vector<int> order;
+    order.reserve(seeds.size());
+
+    std::vector<bool> visited(nverts, false);
+    std::vector<std::pair<int, int> > next;
+    for (int i=0; i<(int)seeds.size(); ++i) {
+
+        if (visited[seeds[i].second])
+            continue;
+
+        visited[seeds[i].second] = true;
+        order.push_back(seeds[i].second);
+
+        for (size_t head=order.size()-1; head<order.size(); ++head) {
+
+            std::vector<int> const & n = neighbors[order[head]];
+
+            next.clear();
+            for (int j=0; j<(int)n.size(); ++j)
+                if (not visited[n[j]]) {
+                    visited[n[j]] = true;
+                    next.push_back(std::make_pair(valences[n[j]], n[j]));
+                }
+            std::sort(next.begin(), next.end());
+
+            for (int j=0; j<(int)next.size(); ++j)
+                order.push_back(next[j].second);
+        }
+    }
 
-    return GetMaskRanking(px->GetMask(false), px->GetMask(true) ) <
-           GetMaskRanking(py->GetMask(false), py->GetMask(true) );
+    ranks.assign(nverts, INT_MAX);
+    for (int i=0; i<(int)order.size(); ++i)
+        ranks[order[i]] = (int)order.size()-1-i;
 }
 
 
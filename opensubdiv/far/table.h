@@ -73,33 +73,42 @@ namespace OPENSUBDIV_VERSION {
 // of markers pointing to the first index at the beginning of the sequence
 // describing a given level (note that "level 1" vertices are obtained by using
 // the indices starting at "level 0" of the tables)
+//
+// The data of a table can also be held by an external buffer (for instance a
+// memory-mapped file, see FarMeshSerializer) : the table then only points to
+// the data, which must outlive the table and is never modified through it.
+// The non-const accessors first copy the external data into the table.
 template <typename Type> class FarTable {
     std::vector<Type>   _data;     // table data
     FarTableMarkers     _markers;  // offsets to the first datum at each level
+    Type const *        _external; // external read-only table data (not owned)
+    int                 _externalSize;
 public:
-    FarTable() { }
+    FarTable() : _external(0), _externalSize(0) { }
 
-    FarTable(int maxlevel) : _markers(maxlevel) { }
+    FarTable(int maxlevel) : _markers(maxlevel), _external(0), _externalSize(0) { }
 
     // Reset max level and clear data
     void SetMaxLevel(int maxlevel) {
         _markers.resize(maxlevel, 0);
         _data.clear();
+        _external = 0;
+        _externalSize = 0;
     }
 
     /// True if there is no data in the table
     bool IsEmpty() const {
-        return _data.empty();
+        return GetSize()==0;
     };
 
     /// Returns the number of entries in the table.
     int GetSize() const {
-        return (int)_data.size();
+        return _external ? _externalSize : (int)_data.size();
     }
 
     /// Returns the memory required to store the data in this table.
     int GetMemoryUsed() const {
-        return (int)_data.size() * sizeof(Type);
+        return GetSize() * sizeof(Type);
     }
 
     /// Returns the number of elements in level "level"
@@ -111,32 +120,66 @@ public:
     /// Saves a pointer indicating the beginning of data pertaining to "level"
     /// of subdivision
     void SetMarker(int level, Type * marker) {
-        _markers[level] = (int)(marker - &_data[0]);
+        _markers[level] = (int)(marker - getData());
     }
 
     /// Resize the table to size (also resets markers)
     void Resize(int size) {
+        _external = 0;
+        _externalSize = 0;
         _data.resize(size);
         _markers[0] = 0;
     }
 
+    /// True if the table points to external read-only data
+    bool IsExternal() const {
+        return _external!=0;
+    }
+
+    /// Points the table at 'size' entries of external data with the given
+    /// level markers. The data is not copied and must not be modified
+    /// through the table.
+    void SetExternalData(Type const * data, int size, FarTableMarkers const & markers) {
+        std::vector<Type>().swap(_data);
+        _external = data;
+        _externalSize = size;
+        _markers = markers;
+    }
+
     /// Returns a pointer to the data at the beginning of level "level" of
-    /// subdivision
+    /// subdivision (external data is copied into the table first)
     Type * operator[](int level) {
         assert(level>=0 and level<(int)_markers.size());
-        return &_data[0] + _markers[level];
+        return getData() + _markers[level];
     }
 
     /// Returns a const pointer to the data at the beginning of level "level"
     /// of subdivision
     const Type * operator[](int level) const {
-        return const_cast<FarTable *>(this)->operator[](level);
+        assert(level>=0 and level<(int)_markers.size());
+        return getData() + _markers[level];
     }
 
     /// Returns the level markers as an std::vector<int> 
     const FarTableMarkers & GetMarkers() const {
         return _markers;
     }
+
+private:
+    template <class X> friend class FarMeshSerializer;
+
+    Type * getData() {
+        if (_external) {
+            _data.assign(_external, _external+_externalSize);
+            _external = 0;
+            _externalSize = 0;
+        }
+        return &_data[0];
+    }
+
+    const Type * getData() const {
+        return _external ? _external : &_data[0];
+    }
 };
 
 } // end namespace OPENSUBDIV_VERSION
@@ -0,0 +1,1076 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef FAR_TOPOLOGY_MESH_FACTORY_H
+#define FAR_TOPOLOGY_MESH_FACTORY_H
+
+#include "../version.h"
+
+#include "../far/mesh.h"
+#include "../far/dispatcher.h"
+#include "../far/bilinearSubdivisionTables.h"
+#include "../far/catmarkSubdivisionTables.h"
+#include "../far/loopSubdivisionTables.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Coarse mesh topology described with face-vertex arrays.
+///
+/// The arrays are not copied by FarTopologyMeshFactory : they only need to
+/// remain valid until FarTopologyMeshFactory::Create() returns.
+///
+struct FarTopologyDescriptor {
+
+    /// Subdivision schemes
+    enum Scheme {
+        k_Bilinear=0,
+        k_Catmark,
+        k_Loop
+    };
+
+    /// Boundary interpolation rules (see HbrMesh::InterpolateBoundaryMethod)
+    enum InterpolateBoundaryMethod {
+        k_InterpolateBoundaryNone=0,
+        k_InterpolateBoundaryEdgeOnly,
+        k_InterpolateBoundaryEdgeAndCorner
+    };
+
+    /// Constructor (describes an empty Catmark mesh)
+    FarTopologyDescriptor() :
+        scheme(k_Catmark),
+        numVertices(0),
+        numFaces(0),
+        numVertsPerFace(0),
+        faceVertices(0),
+        numCreases(0),
+        creaseVertices(0),
+        creaseSharpness(0),
+        numCorners(0),
+        cornerVertices(0),
+        cornerSharpness(0),
+        interpolateBoundary(k_InterpolateBoundaryNone),
+        smoothTriangles(false) { }
+
+    Scheme scheme;
+
+    int numVertices,                ///< number of coarse vertices
+        numFaces;                   ///< number of coarse faces
+
+    int const * numVertsPerFace;    ///< number of vertices of each face
+    int const * faceVertices;       ///< vertices of each face (consistently oriented)
+
+    int numCreases;                 ///< number of sharp edges
+    int const * creaseVertices;     ///< pairs of vertices of the sharp edges
+    float const * creaseSharpness;  ///< sharpness of each sharp edge
+
+    int numCorners;                 ///< number of sharp vertices
+    int const * cornerVertices;     ///< sharp vertices
+    float const * cornerSharpness;  ///< sharpness of each sharp vertex
+
+    InterpolateBoundaryMethod interpolateBoundary;
+
+    /// Catmark only : triangles use the smooth triangle edge weights
+    /// (see HbrCatmarkSubdivision<T>::k_New)
+    bool smoothTriangles;
+};
+
+/// \brief Instantiates a FarMesh from face-vertex arrays, without an HbrMesh.
+///
+/// The topology is refined uniformly in flat arrays that only hold the level
+/// being subdivided and its children, which requires a fraction of the memory
+/// and time needed to build and refine an HbrMesh. The subdivision rules,
+/// the sharpness of the refined edges and vertices and the layout of each
+/// level (face-vertices, edge-vertices, then vertex-vertices sorted by
+/// kernel rank) follow FarMeshFactory, so that the refined vertices are
+/// bitwise identical to the vertices of a FarMesh created from an HbrMesh of
+/// the same topology. Vertex-vertices of equal rank are kept in the order of
+/// their parents.
+///
+/// The coarse vertices keep their indices : their data is expected to be
+/// copied in the vertex buffer of the mesh before calling Subdivide().
+///
+/// Hierarchical edits, holes, face-varying data, ptex coordinates, feature
+/// adaptive patches and Chaikin creases require an HbrMesh and FarMeshFactory.
+///
+template <class U> class FarTopologyMeshFactory {
+
+public:
+
+    /// \brief Constructor for the factory.
+    ///
+    /// @param topology  the coarse topology
+    ///
+    /// @param maxlevel  the number of levels of uniform subdivision
+    ///
+    FarTopologyMeshFactory( FarTopologyDescriptor const & topology, int maxlevel );
+
+    /// \brief Create a table-based mesh representation
+    ///
+    /// Returns NULL if a face is degenerate, if an edge is shared by more than
+    /// 2 faces, if the faces are not consistently oriented, if a vertex is
+    /// non-manifold, or if a Loop mesh has non-triangular faces.
+    ///
+    FarMesh<U> * Create( );
+
+    /// Maximum level of subidivision supported by this factory
+    int GetMaxLevel() const { return _maxlevel; }
+
+    /// \brief Sets the number of threads refining the faces and filling the
+    /// subdivision tables in 'Create' (requires OpenMP).
+    ///
+    /// 1 (default) is serial, 0 uses the default number of OpenMP threads.
+    /// The tables do not depend on the number of threads.
+    ///
+    void SetNumThreads( int numThreads ) { _numThreads = numThreads; }
+
+    /// Returns the number of threads set with SetNumThreads
+    int GetNumThreads() const { return _numThreads; }
+
+private:
+
+    // Topology of a level of subdivision : each face is a loop of half-edges,
+    // a half-edge going from a vertex of the face to the next one.
+    struct Level {
+
+        int nverts;
+
+        std::vector<int> faceOffsets,    // first half-edge of each face (+ 1 sentinel)
+                         hedgeVerts,     // origin vertex of each half-edge
+                         hedgeFaces,     // face of each half-edge
+                         hedgeOpposites, // opposite half-edge (-1 on boundaries)
+                         hedgeEdges,     // edge of each half-edge
+                         edgeHedges,     // half-edge of the first face sharing each edge
+                         vertOffsets,    // first ring half-edge of each vertex (+ 1 sentinel)
+                         vertHedges;     // outgoing half-edges of each vertex, in ring order
+
+        std::vector<float> hedgeSharpness, // sharpness of the edge of each half-edge
+                           edgeSharpness,
+                           vertSharpness;
+
+        int GetNumFaces() const { return (int)faceOffsets.size()-1; }
+
+        int GetNumHedges() const { return (int)hedgeVerts.size(); }
+
+        int GetNumEdges() const { return (int)edgeHedges.size(); }
+
+        int GetNext( int h ) const {
+            return h+1 < faceOffsets[hedgeFaces[h]+1] ? h+1 : faceOffsets[hedgeFaces[h]];
+        }
+
+        int GetPrev( int h ) const {
+            return h > faceOffsets[hedgeFaces[h]] ? h-1 : faceOffsets[hedgeFaces[h]+1]-1;
+        }
+
+        int GetDestVertex( int h ) const { return hedgeVerts[GetNext(h)]; }
+
+        // Returns the vertex at the other end of an edge
+        int GetOtherVertex( int e, int v ) const {
+            int h = edgeHedges[e];
+            return hedgeVerts[h]==v ? GetDestVertex(h) : hedgeVerts[h];
+        }
+
+        int GetNumRingHedges( int v ) const { return vertOffsets[v+1]-vertOffsets[v]; }
+
+        // The ring of a boundary vertex starts with its outgoing boundary half-edge
+        bool IsBoundaryVertex( int v ) const {
+            return GetNumRingHedges(v)>0 and hedgeOpposites[vertHedges[vertOffsets[v]]]<0;
+        }
+
+        // Number of edges surrounding a vertex
+        int GetNumVertEdges( int v ) const {
+            return GetNumRingHedges(v) + (IsBoundaryVertex(v) ? 1 : 0);
+        }
+
+        // Edges surrounding a vertex in the order of HbrVertex : the edges of
+        // the outgoing half-edges, then the incoming boundary edge
+        int GetVertEdge( int v, int i ) const {
+            int first = vertOffsets[v], n = GetNumRingHedges(v);
+            return i<n ? hedgeEdges[vertHedges[first+i]] :
+                         hedgeEdges[GetPrev(vertHedges[first+n-1])];
+        }
+
+        void Clear();
+    };
+
+    // Vertex masks (see HbrVertex<T>::Mask)
+    enum Mask {
+        k_Smooth=0,
+        k_Dart,
+        k_Crease,
+        k_Corner
+    };
+
+    enum {
+        k_InfinitelySharp=10  // see HbrHalfedge<T>::k_InfinitelySharp
+    };
+
+    // Sharpness of a child edge or vertex ("normal" crease subdivision, see
+    // HbrSubdivision<T>::SubdivideCreaseWeight)
+    static float subdivideSharpness( float sharpness );
+
+    static bool isSharp( float sharpness, bool next ) {
+        return next ? (sharpness > 0.0f) : (sharpness >= 1.0f);
+    }
+
+    // Number of OpenMP threads (1 without OpenMP)
+    int getThreadCount() const;
+
+    // Creates the coarse level from the descriptor
+    bool initCoarseLevel( Level & level ) const;
+
+    // Finds the opposite half-edges, the edges and the vertex rings of a level
+    // from its faces
+    bool buildEdges( Level & level ) const;
+
+    // Returns the mask of a vertex (see HbrVertex<T>::GetMask)
+    static unsigned char computeMask( Level const & level, int v, bool next );
+
+    // Returns the fractional mask of a vertex (see HbrVertex<T>::GetFractionalMask)
+    static float computeFractionalMask( Level const & level, int v );
+
+    // Computes the masks of the vertices of a level and the position of their
+    // child vertex-vertices, sorted by kernel rank
+    void computeVertexOrder( Level const & level,
+                             std::vector<unsigned char> & masks,
+                             std::vector<int> & order ) const;
+
+    // Creates the faces and sharpness of the children of a level
+    void refineLevel( Level const & parent, std::vector<int> const & order,
+                      Level & child ) const;
+
+    // Appends the face-vertices tables of a level
+    void appendFaceVertices( FarSubdivisionTables<U> * tables,
+                             FarTable<int> & F_ITa, FarTable<unsigned int> & F_IT,
+                             int level, Level const & parent, int parentOffset ) const;
+
+    // Appends the vertex-vertices tables of a level (Catmark and Loop)
+    void appendVertexVertices( FarSubdivisionTables<U> * tables, int level,
+                               Level const & parent, int parentOffset, int childOffset,
+                               std::vector<unsigned char> const & masks,
+                               std::vector<int> const & order, bool catmark ) const;
+
+    void appendCatmarkTables( FarCatmarkSubdivisionTables<U> * tables, int level,
+                              Level const & parent, int parentOffset,
+                              std::vector<unsigned char> const & masks,
+                              std::vector<int> const & order ) const;
+
+    void appendLoopTables( FarLoopSubdivisionTables<U> * tables, int level,
+                           Level const & parent, int parentOffset,
+                           std::vector<unsigned char> const & masks,
+                           std::vector<int> const & order ) const;
+
+    void appendBilinearTables( FarBilinearSubdivisionTables<U> * tables, int level,
+                               Level const & parent, int parentOffset,
+                               std::vector<int> const & order ) const;
+
+    // Grows a table by the size of a new level and returns a pointer to it
+    template <class Type> static Type * growTable( FarTable<Type> & table, int level, int size );
+
+    FarTopologyDescriptor _topology;
+
+    int _maxlevel,
+        _numThreads;
+};
+
+template <class U>
+FarTopologyMeshFactory<U>::FarTopologyMeshFactory( FarTopologyDescriptor const & topology, int maxlevel ) :
+    _topology(topology), _maxlevel(maxlevel), _numThreads(1) {
+}
+
+template <class U> int
+FarTopologyMeshFactory<U>::getThreadCount() const {
+#ifdef _OPENMP
+    return _numThreads>0 ? _numThreads : omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+template <class U> void
+FarTopologyMeshFactory<U>::Level::Clear() {
+    nverts = 0;
+    faceOffsets.clear();
+    hedgeVerts.clear();
+    hedgeFaces.clear();
+    hedgeOpposites.clear();
+    hedgeEdges.clear();
+    edgeHedges.clear();
+    vertOffsets.clear();
+    vertHedges.clear();
+    hedgeSharpness.clear();
+    edgeSharpness.clear();
+    vertSharpness.clear();
+}
+
+template <class U> float
+FarTopologyMeshFactory<U>::subdivideSharpness( float sharpness ) {
+
+    if (sharpness >= k_InfinitelySharp)
+        return (float)k_InfinitelySharp;
+    sharpness -= 1.0f;
+    return sharpness < 0.0f ? 0.0f : sharpness;
+}
+
+template <class U> bool
+FarTopologyMeshFactory<U>::initCoarseLevel( Level & level ) const {
+
+    FarTopologyDescriptor const & desc = _topology;
+
+    level.Clear();
+    level.nverts = desc.numVertices;
+
+    level.faceOffsets.resize(desc.numFaces+1);
+    level.faceOffsets[0] = 0;
+    for (int i=0; i<desc.numFaces; ++i) {
+        int nv = desc.numVertsPerFace[i];
+        if (nv<3 or (desc.scheme==FarTopologyDescriptor::k_Loop and nv!=3))
+            return false;
+        level.faceOffsets[i+1] = level.faceOffsets[i] + nv;
+    }
+
+    int nhedges = level.faceOffsets[desc.numFaces];
+    level.hedgeVerts.resize(nhedges);
+    level.hedgeFaces.resize(nhedges);
+    for (int i=0; i<desc.numFaces; ++i)
+        for (int h=level.faceOffsets[i]; h<level.faceOffsets[i+1]; ++h) {
+            int v = desc.faceVertices[h];
+            if (v<0 or v>=desc.numVertices)
+                return false;
+            level.hedgeVerts[h] = v;
+            level.hedgeFaces[h] = i;
+        }
+
+    level.hedgeSharpness.assign(nhedges, 0.0f);
+    if (not buildEdges(level))
+        return false;
+
+    // Tags : the sharpness of the last crease applied to an edge prevails
+    for (int i=0; i<desc.numCreases; ++i) {
+        int v = desc.creaseVertices[2*i],
+            w = desc.creaseVertices[2*i+1];
+        if (v<0 or v>=level.nverts or w<0 or w>=level.nverts)
+            continue;
+        for (int j=level.vertOffsets[v]; j<level.vertOffsets[v+1]; ++j) {
+            int h = level.vertHedges[j],
+                e = level.hedgeEdges[h];
+            if (level.GetOtherVertex(e, v)==w) {
+                level.edgeSharpness[e] = std::max(0.0f, desc.creaseSharpness[i]);
+                break;
+            }
+        }
+        // the ring half-edges of v miss the incoming boundary edge
+        if (level.IsBoundaryVertex(v)) {
+            int e = level.GetVertEdge(v, level.GetNumRingHedges(v));
+            if (level.GetOtherVertex(e, v)==w)
+                level.edgeSharpness[e] = std::max(0.0f, desc.creaseSharpness[i]);
+        }
+    }
+
+    level.vertSharpness.assign(level.nverts, 0.0f);
+    for (int i=0; i<desc.numCorners; ++i) {
+        int v = desc.cornerVertices[i];
+        if (v>=0 and v<level.nverts)
+            level.vertSharpness[v] = std::max(0.0f, desc.cornerSharpness[i]);
+    }
+
+    // Boundary interpolation (see HbrMesh<T>::Finish)
+    if (desc.interpolateBoundary!=FarTopologyDescriptor::k_InterpolateBoundaryNone) {
+        for (int e=0; e<level.GetNumEdges(); ++e)
+            if (level.hedgeOpposites[level.edgeHedges[e]]<0)
+                level.edgeSharpness[e] = (float)k_InfinitelySharp;
+    }
+    if (desc.interpolateBoundary==FarTopologyDescriptor::k_InterpolateBoundaryEdgeAndCorner) {
+        for (int v=0; v<level.nverts; ++v)
+            if (level.IsBoundaryVertex(v) and level.GetNumVertEdges(v)==2)
+                level.vertSharpness[v] = (float)k_InfinitelySharp;
+    }
+    return true;
+}
+
+template <class U> bool
+FarTopologyMeshFactory<U>::buildEdges( Level & level ) const {
+
+    int nhedges = level.GetNumHedges(),
+        invalid = 0;
+
+    // Gather the outgoing half-edges of each vertex
+    level.vertOffsets.assign(level.nverts+1, 0);
+    for (int h=0; h<nhedges; ++h)
+        ++level.vertOffsets[level.hedgeVerts[h]+1];
+    for (int v=0; v<level.nverts; ++v)
+        level.vertOffsets[v+1] += level.vertOffsets[v];
+
+    std::vector<int> hedges(nhedges);
+    {   std::vector<int> counts(level.vertOffsets.begin(), level.vertOffsets.end()-1);
+        for (int h=0; h<nhedges; ++h)
+            hedges[counts[level.hedgeVerts[h]]++] = h;
+    }
+
+    // Match the half-edges with their opposite : an edge must connect its
+    // vertices once in each direction at most
+    level.hedgeOpposites.assign(nhedges, -1);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(getThreadCount()) if(getThreadCount()>1) reduction(+:invalid)
+#endif
+    for (int h=0; h<nhedges; ++h) {
+        int org = level.hedgeVerts[h],
+            dst = level.GetDestVertex(h);
+        if (org==dst)
+            ++invalid;
+        for (int j=level.vertOffsets[org]; j<level.vertOffsets[org+1]; ++j)
+            if (hedges[j]!=h and level.GetDestVertex(hedges[j])==dst)
+                ++invalid;
+        for (int j=level.vertOffsets[dst]; j<level.vertOffsets[dst+1]; ++j)
+            if (level.GetDestVertex(hedges[j])==org) {
+                level.hedgeOpposites[h] = hedges[j];
+                break;
+            }
+    }
+    if (invalid)
+        return false;
+
+    // Number the edges in the order of the first face sharing them
+    level.hedgeEdges.resize(nhedges);
+    level.edgeHedges.clear();
+    level.edgeSharpness.clear();
+    for (int h=0; h<nhedges; ++h) {
+        int opposite = level.hedgeOpposites[h];
+        if (opposite<0 or opposite>h) {
+            level.hedgeEdges[h] = (int)level.edgeHedges.size();
+            level.edgeHedges.push_back(h);
+            level.edgeSharpness.push_back(level.hedgeSharpness[h]);
+        } else
+            level.hedgeEdges[h] = level.hedgeEdges[opposite];
+    }
+
+    // Sort the outgoing half-edges of each vertex in the order of HbrVertex :
+    // the ring starts with the boundary half-edge, or with the half-edge of
+    // the first face, and turns around the vertex with prev->opposite
+    level.vertHedges.resize(nhedges);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(getThreadCount()) if(getThreadCount()>1) reduction(+:invalid)
+#endif
+    for (int v=0; v<level.nverts; ++v) {
+
+        int first = level.vertOffsets[v],
+            n = level.GetNumRingHedges(v);
+        if (n==0)
+            continue;
+
+        int start = hedges[first];
+        for (int j=first; j<first+n; ++j)
+            if (level.hedgeOpposites[hedges[j]]<0) {
+                start = hedges[j];
+                break;
+            }
+
+        // the faces around a vertex must form a single fan
+        int count = 0;
+        for (int h=start; h>=0; ) {
+            if (count==n) {
+                ++invalid;
+                break;
+            }
+            level.vertHedges[first+count++] = h;
+            h = level.hedgeOpposites[level.GetPrev(h)];
+            if (h==start)
+                break;
+        }
+        if (count!=n)
+            ++invalid;
+    }
+    return invalid==0;
+}
+
+template <class U> unsigned char
+FarTopologyMeshFactory<U>::computeMask( Level const & level, int v, bool next ) {
+
+    unsigned char mask = isSharp(level.vertSharpness[v], next) ? k_Corner : k_Smooth;
+
+    for (int i=0; i<level.GetNumVertEdges(v); ++i)
+        if (isSharp(level.edgeSharpness[level.GetVertEdge(v, i)], next) and mask<k_Corner)
+            ++mask;
+    return mask;
+}
+
+template <class U> float
+FarTopologyMeshFactory<U>::computeFractionalMask( Level const & level, int v ) {
+
+    float mask = 0, n = 0;
+
+    float sharpness = level.vertSharpness[v];
+    if (sharpness > 0.0f and sharpness < 1.0f) {
+        mask += sharpness; ++n;
+    }
+
+    for (int i=0; i<level.GetNumVertEdges(v); ++i) {
+        float esharp = level.edgeSharpness[level.GetVertEdge(v, i)];
+        if (esharp > 0.0f and esharp < 1.0f) {
+            mask += esharp; ++n;
+        }
+    }
+    assert (n > 0.0f and mask < n);
+    return (mask / n);
+}
+
+template <class U> void
+FarTopologyMeshFactory<U>::computeVertexOrder( Level const & level,
+                                               std::vector<unsigned char> & masks,
+                                               std::vector<int> & order ) const {
+
+    masks.resize(2*level.nverts);
+    order.resize(level.nverts);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(getThreadCount()) if(getThreadCount()>1)
+#endif
+    for (int v=0; v<level.nverts; ++v) {
+        masks[2*v+0] = computeMask(level, v, false);
+        masks[2*v+1] = computeMask(level, v, true);
+
+        order[v] = FarSubdivisionTables<U>::GetMaskRanking(masks[2*v], masks[2*v+1]);
+        assert(order[v]>=0 and order[v]<10);
+    }
+
+    // Counting sort of the vertices by rank (see FarSubdivisionTables::GetMaskRanking)
+    int counts[11] = { 0,0,0,0,0,0,0,0,0,0,0 };
+    for (int v=0; v<level.nverts; ++v)
+        ++counts[order[v]+1];
+    for (int i=0; i<10; ++i)
+        counts[i+1] += counts[i];
+    for (int v=0; v<level.nverts; ++v)
+        order[v] = counts[order[v]]++;
+}
+
+template <class U> void
+FarTopologyMeshFactory<U>::refineLevel( Level const & parent, std::vector<int> const & order,
+                                        Level & child ) const {
+
+    bool loop = _topology.scheme==FarTopologyDescriptor::k_Loop;
+
+    int nfaces = parent.GetNumFaces(),
+        nedges = parent.GetNumEdges(),
+        edgeOffset = loop ? 0 : nfaces,     // first edge-vertex
+        vertOffset = edgeOffset + nedges;   // first vertex-vertex
+
+    child.Clear();
+    child.nverts = vertOffset + parent.nverts;
+
+    // Catmark and Bilinear split a face into a quad per vertex, Loop splits
+    // a triangle into 4 triangles (see Hbr<scheme>Subdivision<T>::Refine)
+    int nchildren = loop ? 4*nfaces : parent.GetNumHedges(),
+        nsides = loop ? 3 : 4;
+
+    child.faceOffsets.resize(nchildren+1);
+    for (int i=0; i<=nchildren; ++i)
+        child.faceOffsets[i] = i*nsides;
+
+    child.hedgeVerts.resize(nchildren*nsides);
+    child.hedgeFaces.resize(nchildren*nsides);
+    child.hedgeSharpness.assign(nchildren*nsides, 0.0f);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(getThreadCount()) if(getThreadCount()>1)
+#endif
+    for (int i=0; i<nchildren*nsides; ++i)
+        child.hedgeFaces[i] = i/nsides;
+
+    // the children of a face do not depend on the other faces
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(getThreadCount()) if(getThreadCount()>1)
+#endif
+    for (int f=0; f<nfaces; ++f) {
+
+        int first = parent.faceOffsets[f],
+            nv = parent.faceOffsets[f+1]-first;
+
+        for (int i=0; i<nv; ++i) {
+
+            int h = first+i,
+                prev = parent.GetPrev(h),
+                vchild = vertOffset + order[parent.hedgeVerts[h]],
+                echild = edgeOffset + parent.hedgeEdges[h],
+                eprevchild = edgeOffset + parent.hedgeEdges[prev];
+
+            float esharp = subdivideSharpness(parent.edgeSharpness[parent.hedgeEdges[h]]),
+                  eprevsharp = subdivideSharpness(parent.edgeSharpness[parent.hedgeEdges[prev]]);
+
+            if (loop) {
+                int * verts = &child.hedgeVerts[3*(4*f+i)];
+                float * sharpness = &child.hedgeSharpness[3*(4*f+i)];
+                verts[i] = vchild;
+                verts[(i+1)%3] = echild;
+                verts[(i+2)%3] = eprevchild;
+                sharpness[i] = esharp;
+                sharpness[(i+2)%3] = eprevsharp;
+
+                // middle triangle
+                child.hedgeVerts[3*(4*f+3)+(i+2)%3] = echild;
+            } else {
+                // the child quad of the vertex i of a quad is rotated so that
+                // the vertex-vertex is at position i
+                int rot = nv==4 ? i : 0;
+                int * verts = &child.hedgeVerts[4*h];
+                float * sharpness = &child.hedgeSharpness[4*h];
+                verts[rot] = vchild;
+                verts[(rot+1)%4] = echild;
+                verts[(rot+2)%4] = f;
+                verts[(rot+3)%4] = eprevchild;
+                sharpness[rot] = esharp;
+                sharpness[(rot+3)%4] = eprevsharp;
+            }
+        }
+    }
+
+    child.vertSharpness.assign(child.nverts, 0.0f);
+    for (int v=0; v<parent.nverts; ++v)
+        if (parent.vertSharpness[v] > 0.0f)
+            child.vertSharpness[vertOffset+order[v]] = subdivideSharpness(parent.vertSharpness[v]);
+}
+
+template <class U>
+    template <class Type> Type *
+FarTopologyMeshFactory<U>::growTable( FarTable<Type> & table, int level, int size ) {
+
+    // the markers of the previous levels are offsets : they remain valid
+    // when the table is reallocated
+    int offset = table.GetSize();
+    table.Resize(offset+size);
+    Type * data = table[level-1];
+    table.SetMarker(level, data+size);
+    return data;
+}
+
+template <class U> void
+FarTopologyMeshFactory<U>::appendFaceVertices( FarSubdivisionTables<U> * tables,
+                                               FarTable<int> & F_ITa, FarTable<unsigned int> & F_IT,
+                                               int level, Level const & parent, int parentOffset ) const {
+
+    // "For each vertex, gather all the vertices from the parent face."
+    int nfaces = parent.GetNumFaces(),
+        nhedges = parent.GetNumHedges();
+
+    tables->_batches[level-1].kernelF = nfaces;
+
+    int * ITa = growTable(F_ITa, level, 2*nfaces);
+    unsigned int * IT = growTable(F_IT, level, nhedges);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(getThreadCount()) if(getThreadCount()>1)
+#endif
+    for (int f=0; f<nfaces; ++f) {
+        ITa[2*f+0] = parent.faceOffsets[f];
+        ITa[2*f+1] = parent.faceOffsets[f+1]-parent.faceOffsets[f];
+    }
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(getThreadCount()) if(getThreadCount()>1)
+#endif
+    for (int h=0; h<nhedges; ++h)
+        IT[h] = parentOffset + parent.hedgeVerts[h];
+}
+
+template <class U> void
+FarTopologyMeshFactory<U>::appendVertexVertices( FarSubdivisionTables<U> * tables, int level,
+                                                 Level const & parent, int parentOffset, int childOffset,
+                                                 std::vector<unsigned char> const & masks,
+                                                 std::vector<int> const & order, bool catmark ) const {
+
+    typename FarSubdivisionTables<U>::VertexKernelBatch * batch = & (tables->_batches[level-1]);
+
+    int nverts = parent.nverts,
+        stride = catmark ? 2 : 1;
+
+    // Rows of the tables in the order of the vertex-vertices
+    std::vector<int> vertices(nverts), offsets(nverts+1, 0), ranks(nverts);
+    for (int v=0; v<nverts; ++v)
+        vertices[order[v]] = v;
+
+    for (int i=0; i<nverts; ++i) {
+        int v = vertices[i];
+        unsigned char m0 = masks[2*v], m1 = masks[2*v+1];
+        offsets[i+1] = offsets[i];
+        if (m0<=k_Dart or m1<=k_Dart)
+            offsets[i+1] += stride * parent.GetNumRingHedges(v);
+    }
+
+    int * V_ITa = growTable(tables->_V_ITa, level, 5*nverts);
+    unsigned int * V_IT = growTable(tables->_V_IT, level, offsets[nverts]);
+    float * V_W = growTable(tables->_V_W, level, nverts);
+    unsigned char * V_R = growTable(tables->_V_R, level, nverts);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(getThreadCount()) if(getThreadCount()>1)
+#endif
+    for (int i=0; i<nverts; ++i) {
+
+        int v = vertices[i], npasses;
+        unsigned char vmasks[2] = { masks[2*v], masks[2*v+1] };
+        float weights[2];
+
+        // see FarCatmarkSubdivisionTablesFactory<T,U>::Create
+        if (vmasks[0] != vmasks[1] and (
+            not (vmasks[0]==k_Smooth and vmasks[1]==k_Dart))) {
+            weights[1] = computeFractionalMask(parent, v);
+            weights[0] = 1.0f - weights[1];
+            npasses = 2;
+        } else {
+            weights[0] = 1.0f;
+            weights[1] = 0.0f;
+            npasses = 1;
+        }
+
+        int rank = FarSubdivisionTables<U>::GetMaskRanking(vmasks[0], vmasks[1]);
+
+        int offset = offsets[i];
+
+        V_ITa[5*i+0] = offset;
+        V_ITa[5*i+1] = 0;
+        V_ITa[5*i+2] = parentOffset + v;
+        V_ITa[5*i+3] = -1;
+        V_ITa[5*i+4] = -1;
+
+        for (int p=0; p<npasses; ++p)
+            switch (vmasks[p]) {
+                case k_Smooth :
+                case k_Dart : {
+                    for (int j=parent.vertOffsets[v]; j<parent.vertOffsets[v+1]; ++j) {
+                        int h = parent.vertHedges[j];
+
+                        V_ITa[5*i+1]++;
+
+                        V_IT[offset++] = parentOffset + parent.GetDestVertex(h);
+
+                        if (catmark)
+                            V_IT[offset++] = childOffset + parent.hedgeFaces[h];
+                    }
+                    break;
+                }
+                case k_Crease : {
+                    int eidx[2] = { -1, -1 }, count = 0;
+                    for (int j=0; j<parent.GetNumVertEdges(v) and count<2; ++j) {
+                        int e = parent.GetVertEdge(v, j);
+                        if (isSharp(parent.edgeSharpness[e], p==1))
+                            eidx[count++] = parent.GetOtherVertex(e, v);
+                    }
+                    assert(V_ITa[5*i+3]==-1 and V_ITa[5*i+4]==-1);
+                    assert(eidx[0]!=-1 and eidx[1]!=-1);
+                    V_ITa[5*i+3] = parentOffset + eidx[0];
+                    V_ITa[5*i+4] = parentOffset + eidx[1];
+                    break;
+                }
+                case k_Corner :
+                    if (V_ITa[5*i+1]==0)
+                        V_ITa[5*i+1] = -1;
+
+                default : break;
+            }
+
+        if (rank>7)
+            V_W[i] = 0.0;
+        else
+            V_W[i] = weights[0];
+
+        V_R[i] = FarSubdivisionTables<U>::GetVertexRule(rank);
+
+        ranks[i] = rank;
+    }
+
+    batch->InitVertexKernels( nverts, 0 );
+    for (int i=0; i<nverts; ++i)
+        batch->AddVertex( i, ranks[i] );
+
+    if (nverts>0) {
+        batch->kernelB.second++;
+        batch->kernelA1.second++;
+        batch->kernelA2.second++;
+    }
+}
+
+template <class U> void
+FarTopologyMeshFactory<U>::appendCatmarkTables( FarCatmarkSubdivisionTables<U> * tables, int level,
+                                                Level const & parent, int parentOffset,
+                                                std::vector<unsigned char> const & masks,
+                                                std::vector<int> const & order ) const {
+
+    int childOffset = parentOffset + parent.nverts,
+        nedges = parent.GetNumEdges();
+
+    appendFaceVertices(tables, tables->_F_ITa, tables->_F_IT, level, parent, parentOffset);
+
+    // Edge vertices : see FarCatmarkSubdivisionTablesFactory<T,U>::Create
+    tables->_batches[level-1].kernelE = nedges;
+
+    int * E_IT = growTable(tables->_E_IT, level, 4*nedges);
+    float * E_W = growTable(tables->_E_W, level, 2*nedges);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(getThreadCount()) if(getThreadCount()>1)
+#endif
+    for (int e=0; e<nedges; ++e) {
+
+        int h = parent.edgeHedges[e],
+            opposite = parent.hedgeOpposites[h];
+
+        float esharp = parent.edgeSharpness[e];
+
+        E_IT[4*e+0] = parentOffset + parent.hedgeVerts[h];
+        E_IT[4*e+1] = parentOffset + parent.GetDestVertex(h);
+
+        float faceWeight=0.5f, vertWeight=0.5f;
+
+        if (opposite>=0 && esharp <= 1.0f) {
+
+            int lf = parent.hedgeFaces[h],
+                rf = parent.hedgeFaces[opposite];
+
+            bool ltri = parent.faceOffsets[lf+1]-parent.faceOffsets[lf]==3,
+                 rtri = parent.faceOffsets[rf+1]-parent.faceOffsets[rf]==3;
+
+            float leftWeight = ( _topology.smoothTriangles && ltri) ? 0.470f : 0.25f,
+                  rightWeight = ( _topology.smoothTriangles && rtri) ? 0.470f : 0.25f;
+
+            faceWeight = 0.5f * (leftWeight + rightWeight);
+            vertWeight = 0.5f * (1.0f - 2.0f * faceWeight);
+
+            faceWeight *= (1.0f - esharp);
+
+            vertWeight = 0.5f * esharp + (1.0f - esharp) * vertWeight;
+
+            E_IT[4*e+2] = childOffset + lf;
+            E_IT[4*e+3] = childOffset + rf;
+        } else {
+            E_IT[4*e+2] = -1;
+            E_IT[4*e+3] = -1;
+        }
+        E_W[2*e+0] = vertWeight;
+        E_W[2*e+1] = faceWeight;
+    }
+
+    appendVertexVertices(tables, level, parent, parentOffset, childOffset, masks, order, true);
+}
+
+template <class U> void
+FarTopologyMeshFactory<U>::appendLoopTables( FarLoopSubdivisionTables<U> * tables, int level,
+                                             Level const & parent, int parentOffset,
+                                             std::vector<unsigned char> const & masks,
+                                             std::vector<int> const & order ) const {
+
+    int nedges = parent.GetNumEdges();
+
+    // Edge vertices : see FarLoopSubdivisionTablesFactory<T,U>::Create
+    tables->_batches[level-1].kernelE = nedges;
+
+    int * E_IT = growTable(tables->_E_IT, level, 4*nedges);
+    float * E_W = growTable(tables->_E_W, level, 2*nedges);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(getThreadCount()) if(getThreadCount()>1)
+#endif
+    for (int e=0; e<nedges; ++e) {
+
+        int h = parent.edgeHedges[e],
+            opposite = parent.hedgeOpposites[h];
+
+        float esharp = parent.edgeSharpness[e],
+              endPtWeight = 0.5f,
+              oppPtWeight = 0.5f;
+
+        E_IT[4*e+0] = parentOffset + parent.hedgeVerts[h];
+        E_IT[4*e+1] = parentOffset + parent.GetDestVertex(h);
+
+        if (opposite>=0 && esharp <= 1.0f) {
+            endPtWeight = 0.375f + esharp * (0.5f - 0.375f);
+            oppPtWeight = 0.125f * (1 - esharp);
+
+            E_IT[4*e+2] = parentOffset + parent.GetDestVertex(parent.GetNext(h));
+            E_IT[4*e+3] = parentOffset + parent.GetDestVertex(parent.GetNext(opposite));
+        } else {
+            E_IT[4*e+2] = -1;
+            E_IT[4*e+3] = -1;
+        }
+        E_W[2*e+0] = endPtWeight;
+        E_W[2*e+1] = oppPtWeight;
+    }
+
+    appendVertexVertices(tables, level, parent, parentOffset, parentOffset+parent.nverts,
+                         masks, order, false);
+}
+
+template <class U> void
+FarTopologyMeshFactory<U>::appendBilinearTables( FarBilinearSubdivisionTables<U> * tables, int level,
+                                                 Level const & parent, int parentOffset,
+                                                 std::vector<int> const & order ) const {
+
+    typename FarSubdivisionTables<U>::VertexKernelBatch * batch = & (tables->_batches[level-1]);
+
+    appendFaceVertices(tables, tables->_F_ITa, tables->_F_IT, level, parent, parentOffset);
+
+    // "Average the end-points of the parent edge"
+    int nedges = parent.GetNumEdges();
+    batch->kernelE = nedges;
+
+    int * E_IT = growTable(tables->_E_IT, level, 2*nedges);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(getThreadCount()) if(getThreadCount()>1)
+#endif
+    for (int e=0; e<nedges; ++e) {
+        int h = parent.edgeHedges[e];
+        E_IT[2*e+0] = parentOffset + parent.hedgeVerts[h];
+        E_IT[2*e+1] = parentOffset + parent.GetDestVertex(h);
+    }
+
+    // "Pass down the parent vertex"
+    int * V_ITa = growTable(tables->_V_ITa, level, parent.nverts);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(getThreadCount()) if(getThreadCount()>1)
+#endif
+    for (int v=0; v<parent.nverts; ++v)
+        V_ITa[order[v]] = parentOffset + v;
+
+    batch->kernelB.first = 0;
+    batch->kernelB.second = parent.nverts;
+}
+
+template <class U> FarMesh<U> *
+FarTopologyMeshFactory<U>::Create( ) {
+
+    // Note : we cannot create a Far rep of level 0 (coarse mesh)
+    if (GetMaxLevel()<1)
+        return 0;
+
+    Level levels[2],
+        * parent = &levels[0],
+        * child = &levels[1];
+
+    if (not initCoarseLevel(*parent))
+        return 0;
+
+    FarMesh<U> * result = new FarMesh<U>();
+
+    FarSubdivisionTables<U> * tables = 0;
+    switch (_topology.scheme) {
+        case FarTopologyDescriptor::k_Bilinear :
+            tables = new FarBilinearSubdivisionTables<U>(result, _maxlevel); break;
+        case FarTopologyDescriptor::k_Catmark :
+            tables = new FarCatmarkSubdivisionTables<U>(result, _maxlevel); break;
+        case FarTopologyDescriptor::k_Loop :
+            tables = new FarLoopSubdivisionTables<U>(result, _maxlevel); break;
+    }
+    assert(tables);
+    result->_subdivisionTables = tables;
+    tables->_numCoarseVertices = parent->nverts;
+
+    result->_faceverts.resize(_maxlevel+1);
+
+    std::vector<unsigned char> masks;
+    std::vector<int> order;
+
+    int parentOffset = 0;
+    for (int level=1; level<=_maxlevel; ++level) {
+
+        computeVertexOrder(*parent, masks, order);
+
+        // pointer to the first vertex corresponding to this level
+        tables->_vertsOffsets[level] = parentOffset + parent->nverts;
+
+        switch (_topology.scheme) {
+            case FarTopologyDescriptor::k_Bilinear :
+                appendBilinearTables(static_cast<FarBilinearSubdivisionTables<U> *>(tables),
+                                     level, *parent, parentOffset, order); break;
+            case FarTopologyDescriptor::k_Catmark :
+                appendCatmarkTables(static_cast<FarCatmarkSubdivisionTables<U> *>(tables),
+                                    level, *parent, parentOffset, masks, order); break;
+            case FarTopologyDescriptor::k_Loop :
+                appendLoopTables(static_cast<FarLoopSubdivisionTables<U> *>(tables),
+                                 level, *parent, parentOffset, masks, order); break;
+        }
+
+        refineLevel(*parent, order, *child);
+
+        parentOffset += parent->nverts;
+
+        std::vector<int> & faceverts = result->_faceverts[level];
+        faceverts.resize(child->GetNumHedges());
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(getThreadCount()) if(getThreadCount()>1)
+#endif
+        for (int h=0; h<child->GetNumHedges(); ++h)
+            faceverts[h] = parentOffset + child->hedgeVerts[h];
+
+        // the topology of the last level is not subdivided
+        if (level<_maxlevel and not buildEdges(*child)) {
+            assert(0);
+            delete result;
+            return 0;
+        }
+        std::swap(parent, child);
+    }
+
+    result->_vertices.resize(parentOffset + parent->nverts);
+
+    return result;
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_TOPOLOGY_MESH_FACTORY_H */
@@ -61,6 +61,7 @@
 #include "../version.h"
 
 #include "../far/table.h"
+#include "../far/kernelInstrumentation.h"
 
 #include <assert.h>
 #include <utility>
@@ -155,6 +156,7 @@ public:
 
     private:
         template <class X, class Y> friend class FarVertexEditTablesFactory;
+        template <class X> friend class FarMeshSerializer;
         friend class FarDispatcher<U>;
 
         FarTable<unsigned int>    _vertIndices;  // absolute vertex index array for edits
@@ -171,6 +173,7 @@ public:
 
 private:
     template <class X, class Y> friend class FarVertexEditTablesFactory;
+    template <class X> friend class FarMeshSerializer;
     friend class FarDispatcher<U>;
 
     // Compute-kernel that applies the edits
@@ -223,6 +226,7 @@ FarVertexEditTables<U>::Apply( int level, FarDispatcher<U> const * dispatch, voi
 
     assert(this->_mesh and level>0);
 
+    FarKernelScope<U> scope(dispatch, clientdata, this->_mesh->GetSubdivisionTables(), FarKernelLaunch::k_VertexEdits, level, 0, 0, 0);
     dispatch->ApplyVertexEdits(this->_mesh, 0, level, clientdata);
 }
 
@@ -64,6 +64,9 @@ namespace OPENSUBDIV_VERSION {
 
 typedef void (*HbrMemStatFunction)(unsigned long bytes);
 
+// Returns the index of the calling thread (see HbrAllocator::SetThreadArenas)
+typedef int (*HbrThreadIndexFunction)();
+
 /**
  * HbrAllocator - derived from UtBlockAllocator.h, but embedded in
  * libhbrep.
@@ -91,21 +94,56 @@ public:
 
     void SetMemStatsDecrement(void (*decrement)(unsigned long bytes)) { m_decrement = decrement; }
 
+    /// Gives each of numArenas threads its own blocks and free list, so that
+    /// the threads allocate and deallocate objects concurrently without
+    /// locking. threadIndex returns the index of the calling thread, in
+    /// [0, numArenas) ; the objects allocated so far belong to the arena 0.
+    /// Must not be called while objects are allocated. The memory of the
+    /// blocks allocated by the arenas is not added to the memory statistic
+    /// (see GetArenaMemory) and the memory stats routines are called
+    /// concurrently.
+    void SetThreadArenas(int numArenas, HbrThreadIndexFunction threadIndex);
+
+    /// Returns the memory of the blocks allocated by the arenas
+    size_t GetArenaMemory() const;
+
 private:
+    // Blocks and free list of a thread
+    struct Arena {
+        Arena() : blocks(0), nblocks(0), blockCapacity(0), freecount(0), freelist(0), memory(0) { }
+
+        T** blocks;
+
+        // Number of actually allocated blocks
+        int nblocks;
+
+        // Size of the blocks array (which is NOT the number of actually
+        // allocated blocks)
+        int blockCapacity;
+
+        int freecount;
+        T * freelist;
+
+        // Memory of the blocks allocated in arena mode
+        size_t memory;
+
+        // (keeps the arenas of different threads on different cache lines)
+        char padding[64];
+    };
+
+    Arena & getArena() {
+        return m_numArenas > 1 ? m_arenas[m_threadIndex()] : m_arenas[0];
+    }
+
     size_t *m_memorystat;
     const int m_blocksize;
     int m_elemsize;
-    T** m_blocks;
-
-    // Number of actually allocated blocks
-    int m_nblocks;
-
-    // Size of the m_blocks array (which is NOT the number of actually
-    // allocated blocks)
-    int m_blockCapacity;
 
-    int m_freecount;
-    T * m_freelist;
+    // The arenas (m_arena unless SetThreadArenas was called)
+    Arena m_arena;
+    Arena * m_arenas;
+    int m_numArenas;
+    HbrThreadIndexFunction m_threadIndex;
 
     // Memory statistics tracking routines
     HbrMemStatFunction m_increment;
@@ -114,40 +152,73 @@ private:
 
 template <typename T>
 HbrAllocator<T>::HbrAllocator(size_t *memorystat, int blocksize, void (*increment)(unsigned long bytes), void (*decrement)(unsigned long bytes), size_t elemsize)
-    : m_memorystat(memorystat), m_blocksize(blocksize), m_elemsize((int)elemsize), m_blocks(0), m_nblocks(0), m_blockCapacity(0), m_freecount(0), m_increment(increment), m_decrement(decrement) {
+    : m_memorystat(memorystat), m_blocksize(blocksize), m_elemsize((int)elemsize), m_arenas(&m_arena), m_numArenas(1), m_threadIndex(0), m_increment(increment), m_decrement(decrement) {
 }
 
 template <typename T>
 HbrAllocator<T>::~HbrAllocator() {
     Clear();
+    if (m_arenas != &m_arena) {
+        delete[] m_arenas;
+    }
 }
 
 template <typename T>
 void HbrAllocator<T>::Clear() {
-    for (int i = 0; i < m_nblocks; ++i) {
-        // Run the destructors (placement)
-        T* blockptr = m_blocks[i];
-        T* startblock = blockptr;
-        for (int j = 0; j < m_blocksize; ++j) {
-            blockptr->~T();
-            blockptr = (T*) ((char*) blockptr + m_elemsize);
+    for (int a = 0; a < m_numArenas; ++a) {
+        Arena & arena = m_arenas[a];
+        for (int i = 0; i < arena.nblocks; ++i) {
+            // Run the destructors (placement)
+            T* blockptr = arena.blocks[i];
+            T* startblock = blockptr;
+            for (int j = 0; j < m_blocksize; ++j) {
+                blockptr->~T();
+                blockptr = (T*) ((char*) blockptr + m_elemsize);
+            }
+            free(startblock);
+            if (m_decrement) m_decrement(m_blocksize * m_elemsize);
+            *m_memorystat -= m_blocksize * m_elemsize;
+        }
+        // (the memory of the blocks of the arenas was not added to the stat)
+        *m_memorystat += arena.memory;
+        free(arena.blocks);
+        arena = Arena();
+    }
+}
+
+template <typename T>
+void
+HbrAllocator<T>::SetThreadArenas(int numArenas, HbrThreadIndexFunction threadIndex) {
+    assert(numArenas >= m_numArenas and threadIndex);
+    if (numArenas > m_numArenas) {
+        Arena * arenas = new Arena[numArenas];
+        for (int i = 0; i < m_numArenas; ++i) {
+            arenas[i] = m_arenas[i];
+        }
+        if (m_arenas != &m_arena) {
+            delete[] m_arenas;
         }
-        free(startblock);
-        if (m_decrement) m_decrement(m_blocksize * m_elemsize);
-        *m_memorystat -= m_blocksize * m_elemsize;
+        m_arenas = arenas;
+        m_numArenas = numArenas;
     }
-    free(m_blocks);
-    m_blocks = 0;
-    m_nblocks = 0;
-    m_blockCapacity = 0;
-    m_freecount = 0;
-    m_freelist = NULL;
+    m_threadIndex = threadIndex;
+}
+
+template <typename T>
+size_t
+HbrAllocator<T>::GetArenaMemory() const {
+    size_t memory = 0;
+    for (int i = 0; i < m_numArenas; ++i) {
+        memory += m_arenas[i].memory;
+    }
+    return memory;
 }
 
 template <typename T>
 T*
 HbrAllocator<T>::Allocate() {
-    if (!m_freecount) {
+    Arena & arena = getArena();
+    if (!arena.freecount) {
 
         // Allocate a new block
         T* block = (T*) malloc(m_blocksize * m_elemsize);
@@ -158,7 +229,11 @@ HbrAllocator<T>::Allocate() {
             blockptr = (T*) ((char*) blockptr + m_elemsize);
         }
         if (m_increment) m_increment(m_blocksize * m_elemsize);
-        *m_memorystat += m_blocksize * m_elemsize;
+        if (m_numArenas > 1) {
+            arena.memory += m_blocksize * m_elemsize;
+        } else {
+            *m_memorystat += m_blocksize * m_elemsize;
+        }
 
         // Put the block's entries on the free list
         blockptr = block;
@@ -168,32 +243,35 @@ HbrAllocator<T>::Allocate() {
             blockptr = next;
         }
         blockptr->GetNext() = 0;
-        m_freelist = block;
+        arena.freelist = block;
 
         // Keep track of the newly allocated block
-        if (m_nblocks + 1 >= m_blockCapacity) {
-            m_blockCapacity = m_blockCapacity * 2;
-            if (m_blockCapacity < 1) m_blockCapacity = 1;
-            m_blocks = (T**) realloc(m_blocks, m_blockCapacity * sizeof(T*));
+        if (arena.nblocks + 1 >= arena.blockCapacity) {
+            arena.blockCapacity = arena.blockCapacity * 2;
+            if (arena.blockCapacity < 1) arena.blockCapacity = 1;
+            arena.blocks = (T**) realloc(arena.blocks, arena.blockCapacity * sizeof(T*));
         }
-        m_blocks[m_nblocks] = block;
-        m_nblocks++;
-        m_freecount += m_blocksize;
+        arena.blocks[arena.nblocks] = block;
+        arena.nblocks++;
+        arena.freecount += m_blocksize;
     }
-    T* obj = m_freelist;
-    m_freelist = obj->GetNext();
+    T* obj = arena.freelist;
+    arena.freelist = obj->GetNext();
     obj->GetNext() = 0;
-    m_freecount--;
+    arena.freecount--;
     return obj;
 }
 
 template <typename T>
 void
 HbrAllocator<T>::Deallocate(T * obj) {
+    // (the object goes to the free list of the calling thread, whichever
+    // arena allocated it)
+    Arena & arena = getArena();
     assert(!obj->GetNext());
-    obj->GetNext() = m_freelist;
-    m_freelist = obj;
-    m_freecount++;
+    obj->GetNext() = arena.freelist;
+    arena.freelist = obj;
+    arena.freecount++;
 }
 
 } // end namespace OPENSUBDIV_VERSION
@@ -176,7 +176,11 @@ public:
     void PrintStats(std::ostream& out);
 
     // Returns memory statistics
-    size_t GetMemStats() const { return m_memory; }
+    size_t GetMemStats() const {
+        return m_memory + m_faceAllocator.GetArenaMemory() +
+            m_vertexAllocator.GetArenaMemory() +
+            m_faceChildrenAllocator.GetArenaMemory();
+    }
 
     // Interpolate boundary management
     enum InterpolateBoundaryMethod {
@@ -211,7 +215,12 @@ public:
         if (!m_transientMode) {
             assert(vertex);
             if (!vertex->IsCollected()) {
-                gcVertices.push_back(vertex); vertex->SetCollected();
+                if (m_idShards) {
+                    m_idShards[m_threadIndex()].gcVertices.push_back(vertex);
+                } else {
+                    gcVertices.push_back(vertex);
+                }
+                vertex->SetCollected();
             }
         }
     }
@@ -285,6 +294,58 @@ public:
         m_faceChildrenAllocator.Deallocate(facechildren);
     }
 
+    // Lets numThreads threads create vertices and faces concurrently :
+    // each thread allocates from its own arenas (see
+    // HbrAllocator::SetThreadArenas) and assigns vertex IDs from its own
+    // shard of k_VertexIDShardSize IDs, so that NewVertex() does not lock
+    // the mutex. threadIndex returns the index of the calling thread, in
+    // [0, numThreads). The vertex IDs are not recycled anymore and may
+    // leave gaps. HbrFace::Refine may then be called concurrently only on
+    // faces which share no vertices ; faces sharing vertices or edges are
+    // refined concurrently with RefineConcurrently. Must not be called
+    // while vertices or faces are created ; GarbageCollect, DeleteFace,
+    // DeleteVertex and the transient mode are not concurrent.
+    void SetThreadArenas(int numThreads, HbrThreadIndexFunction threadIndex);
+
+    enum { k_VertexIDShardSize = 256 };
+
+    // Stages of the concurrent refinement of faces (see RefineConcurrently)
+    enum RefineStage {
+        k_RefineFaceVertices,   // vertices at the center of the faces
+        k_RefineEdgeVertices,   // vertices on the edges
+        k_RefineVertexVertices, // vertices at the vertices
+        k_RefineChildFaces      // child faces
+    };
+
+    // Runs a stage of the refinement of a face, from one of the threads
+    // set up by SetThreadArenas. All the faces of one depth (sharing
+    // vertices and edges or not) are refined concurrently by running each
+    // stage on all of them before starting the next stage, once the faces
+    // of the lower depths are refined. Each child vertex is created by a
+    // single face : the edges belong to their face of lowest ID and the
+    // vertices to the face of their incident edge. The child faces are
+    // created while the face holds a lock on each of its vertices, which
+    // serializes the faces sharing child vertices. The mesh must not have
+    // hierarchical edits. If firstID is not negative, the vertices (or
+    // child faces) created by the stage take the consecutive IDs from
+    // firstID, reserved with ReserveIDs : the IDs then only depend on the
+    // order of the faces, not on the threads.
+    void RefineConcurrently(HbrFace<T>* face, RefineStage stage, int firstID = -1);
+
+    // Returns the number of vertices (or child faces) which a stage of
+    // RefineConcurrently creates for a face which is not refined yet
+    int GetRefineStageCount(HbrFace<T>* face, RefineStage stage) const;
+
+    // Reserves count consecutive vertex IDs (or face IDs for
+    // k_RefineChildFaces) for RefineConcurrently and returns the first one.
+    // Must not be called while vertices or faces are created.
+    int ReserveIDs(RefineStage stage, int count);
+
+    // Returns true if SetThreadArenas was called
+    bool HasThreadArenas() const { return m_idShards != 0; }
+
+    enum { k_VertexLocksPerThread = 64 };
+
 private:
 #ifdef PRMAN
         // This code is intended to be shared with PRman which provides its own 
@@ -295,6 +356,55 @@ private:
 
     mutable Mutex m_mutex;
 
+    // Vertex IDs reserved by a thread (see SetThreadArenas), which all
+    // belong to the vertex set vset
+    struct VertexIDShard {
+        VertexIDShard() : next(0), end(0), vset(0), reservedNext(0), reservedEnd(0),
+            reservedVset(0), reservedVsetIndex(-1) { }
+
+        int next, end;
+        HbrVertex<T>** vset;
+
+        // IDs given to the vertices or faces created by the current stage
+        // of RefineConcurrently (see ReserveIDs)
+        int reservedNext, reservedEnd;
+
+        // Vertex set of the last reserved vertex ID (the array of the vertex
+        // sets may be grown by other threads : it is read with the mutex)
+        HbrVertex<T>** reservedVset;
+        int reservedVsetIndex;
+
+        // Vertices which may be garbage collected (see gcVertices)
+        std::vector<HbrVertex<T>*> gcVertices;
+
+        // (keeps the shards of different threads on different cache lines)
+        char padding[64];
+    };
+
+    // Returns the vertex set of an ID, allocating the sets up to it if
+    // needed (the mutex must be locked)
+    HbrVertex<T>** getVertexSet(int id);
+
+    // Grows the faces array to hold the face ID id (the mutex must be
+    // locked when faces are created concurrently)
+    void growFaces(int id);
+
+    // Creates a vertex in the slot of its ID in the vertex set
+    HbrVertex<T>* newVertex(int id, const T &data, HbrVertex<T>** vset);
+
+    // Creates a vertex with an ID of the shard of the calling thread
+    HbrVertex<T>* newShardedVertex(const T *data);
+
+    // Returns true if the child vertex of an edge (or of a vertex) of face
+    // is created by face in RefineConcurrently
+    static bool ownsEdge(HbrFace<T>* face, HbrHalfedge<T>* edge) {
+        HbrHalfedge<T>* opposite = edge->GetOpposite();
+        return !opposite || face->GetID() < opposite->GetFace()->GetID();
+    }
+    static bool ownsVertex(HbrFace<T>* face, HbrVertex<T>* vertex) {
+        return vertex->GetIncidentEdge()->GetFace() == face;
+    }
+
     // Subdivision method used in this mesh
     HbrSubdivision<T>* subdivision;
 
@@ -391,6 +501,17 @@ private:
     // Faces which are transient
     std::vector<HbrFace<T>*> m_transientFaces;
 
+    // Per-thread vertex ID shards (0 unless SetThreadArenas was called)
+    VertexIDShard* m_idShards;
+
+    // Locks of the vertices of the faces refined concurrently, picked by
+    // vertex ID (see RefineConcurrently)
+    Mutex* m_vertexLocks;
+    int m_numVertexLocks;
+
+    int m_numThreads;
+    HbrThreadIndexFunction m_threadIndex;
+
 };
 
 } // end namespace OPENSUBDIV_VERSION
@@ -440,7 +561,9 @@ HbrMesh<T>::HbrMesh(HbrSubdivision<T>* s, int _fvarcount, const int *_fvarindice
       m_numCoarseFaces(-1),
       hasVertexEdits(0),
       hasCreaseEdits(0),
-      m_transientMode(false) {
+      m_transientMode(false),
+      m_idShards(0), m_vertexLocks(0), m_numVertexLocks(0),
+      m_numThreads(0), m_threadIndex(0) {
 }
 
 template <class T>
@@ -483,16 +606,144 @@ HbrMesh<T>::~HbrMesh() {
              hierarchicalEdits.begin(); hi != hierarchicalEdits.end(); ++hi) {
         delete *hi;
     }
+    delete[] m_idShards;
+    delete[] m_vertexLocks;
 }
 
 template <class T>
-HbrVertex<T>*
-HbrMesh<T>::NewVertex(int id, const T &data) {
-    HbrVertex<T>* v = 0;
+void
+HbrMesh<T>::SetThreadArenas(int numThreads, HbrThreadIndexFunction threadIndex) {
+    assert(numThreads > 0 and threadIndex and not m_idShards);
+    m_faceAllocator.SetThreadArenas(numThreads, threadIndex);
+    m_vertexAllocator.SetThreadArenas(numThreads, threadIndex);
+    m_faceChildrenAllocator.SetThreadArenas(numThreads, threadIndex);
+    m_idShards = new VertexIDShard[numThreads];
+    m_numVertexLocks = numThreads * k_VertexLocksPerThread;
+    m_vertexLocks = new Mutex[m_numVertexLocks];
+    m_numThreads = numThreads;
+    m_threadIndex = threadIndex;
+}
 
-    int arrayindex = id / vsetsize;
-    int vertindex = id % vsetsize;
+template <class T>
+void
+HbrMesh<T>::RefineConcurrently(HbrFace<T>* face, RefineStage stage, int firstID) {
+    assert(m_idShards && hierarchicalEdits.empty());
+
+    VertexIDShard* shard = 0;
+    if (firstID >= 0) {
+        shard = &m_idShards[m_threadIndex()];
+        shard->reservedNext = firstID;
+        shard->reservedEnd = firstID + GetRefineStageCount(face, stage);
+    }
+
+    int nv = face->GetNumVertices();
+    switch (stage) {
+        case k_RefineFaceVertices:
+            if (subdivision->HasFaceVertices()) {
+                face->Subdivide();
+            }
+            break;
+        case k_RefineEdgeVertices:
+            for (int i = 0; i < nv; ++i) {
+                HbrHalfedge<T>* edge = face->GetEdge(i);
+                if (ownsEdge(face, edge)) {
+                    edge->Subdivide();
+                }
+            }
+            break;
+        case k_RefineVertexVertices:
+            for (int i = 0; i < nv; ++i) {
+                HbrVertex<T>* vertex = face->GetVertex(i);
+                if (ownsVertex(face, vertex)) {
+                    vertex->Subdivide();
+                }
+            }
+            break;
+        case k_RefineChildFaces: {
+            // Lock the vertices in increasing order of their locks
+            int locks[4];
+            std::vector<int> extralocks;
+            int* facelocks = locks;
+            if (nv > 4) {
+                extralocks.resize(nv);
+                facelocks = &extralocks[0];
+            }
+            for (int i = 0; i < nv; ++i) {
+                facelocks[i] = face->GetVertex(i)->GetID() % m_numVertexLocks;
+            }
+            std::sort(facelocks, facelocks + nv);
+            int nlocks = (int)(std::unique(facelocks, facelocks + nv) - facelocks);
+            for (int i = 0; i < nlocks; ++i) {
+                m_vertexLocks[facelocks[i]].Lock();
+            }
+            face->Refine();
+            for (int i = nlocks - 1; i >= 0; --i) {
+                m_vertexLocks[facelocks[i]].Unlock();
+            }
+            break;
+        }
+    }
+
+    if (shard) {
+        // All the reserved IDs must be used, or the IDs would leave gaps
+        assert(shard->reservedNext == shard->reservedEnd);
+        shard->reservedNext = shard->reservedEnd = 0;
+    }
+}
+
+template <class T>
+int
+HbrMesh<T>::GetRefineStageCount(HbrFace<T>* face, RefineStage stage) const {
+    int nv = face->GetNumVertices(), count = 0;
+    switch (stage) {
+        case k_RefineFaceVertices:
+            count = subdivision->HasFaceVertices() ? 1 : 0;
+            break;
+        case k_RefineEdgeVertices:
+            for (int i = 0; i < nv; ++i) {
+                if (ownsEdge(face, face->GetEdge(i))) ++count;
+            }
+            break;
+        case k_RefineVertexVertices:
+            for (int i = 0; i < nv; ++i) {
+                if (ownsVertex(face, face->GetVertex(i))) ++count;
+            }
+            break;
+        case k_RefineChildFaces:
+            count = subdivision->GetFaceChildrenCount(nv);
+            break;
+    }
+    return count;
+}
+
+template <class T>
+int
+HbrMesh<T>::ReserveIDs(RefineStage stage, int count) {
     m_mutex.Lock();
+    int first;
+    if (stage == k_RefineChildFaces) {
+        // (the faces array is grown beforehand, so that the faces of the
+        // stage can be read while others are created)
+        first = maxFaceID;
+        maxFaceID += count;
+        if (count) {
+            growFaces(maxFaceID - 1);
+        }
+    } else {
+        first = maxVertexID;
+        maxVertexID += count;
+        if (count) {
+            getVertexSet(maxVertexID - 1);
+        }
+    }
+    m_mutex.Unlock();
+    return first;
+}
+
+template <class T>
+HbrVertex<T>**
+HbrMesh<T>::getVertexSet(int id) {
+    int arrayindex = id / vsetsize;
     HbrVertex<T>** vset = 0;
     if (arrayindex >= nvsets) {
         HbrVertex<T>*** nvertices = new HbrVertex<T>**[arrayindex + 1];
@@ -513,9 +764,60 @@ HbrMesh<T>::NewVertex(int id, const T &data) {
         vertices = nvertices;
     }
     vset = vertices[arrayindex];
+    return vset;
+}
+
+template <class T>
+void
+HbrMesh<T>::growFaces(int id) {
+    if (nfaces > id) {
+        return;
+    }
+    int nnfaces = nfaces;
+    while (nnfaces <= id) {
+        nnfaces *= 2;
+        if (nnfaces < 1) nnfaces = 1;
+    }
+    HbrFace<T>** newfaces = new HbrFace<T>*[nnfaces];
+    if (s_memStatsIncrement) {
+        s_memStatsIncrement(nnfaces * sizeof(HbrFace<T>*));
+    }
+    m_memory += nnfaces * sizeof(HbrFace<T>*);
+    if (faces) {
+        for (int i = 0; i < nfaces; ++i) {
+            newfaces[i] = faces[i];
+        }
+        if (s_memStatsDecrement) {
+            s_memStatsDecrement(nfaces * sizeof(HbrFace<T>*));
+        }
+        m_memory -= nfaces * sizeof(HbrFace<T>*);
+        delete[] faces;
+    }
+    for (int i = nfaces; i < nnfaces; ++i) {
+        newfaces[i] = 0;
+    }
+    faces = newfaces;
+    nfaces = nnfaces;
+}
+
+template <class T>
+HbrVertex<T>*
+HbrMesh<T>::NewVertex(int id, const T &data) {
+    m_mutex.Lock();
+    HbrVertex<T>** vset = getVertexSet(id);
+    if (id >= maxVertexID) {
+        maxVertexID = id + 1;
+    }
     m_mutex.Unlock();
 
-    v = vset[vertindex];
+    return newVertex(id, data, vset);
+}
+
+template <class T>
+HbrVertex<T>*
+HbrMesh<T>::newVertex(int id, const T &data, HbrVertex<T>** vset) {
+    int vertindex = id % vsetsize;
+    HbrVertex<T>* v = vset[vertindex];
     if (v) {
         v->Destroy();
     } else {
@@ -524,10 +826,6 @@ HbrMesh<T>::NewVertex(int id, const T &data) {
     v->Initialize(id, data, GetTotalFVarWidth());
     vset[vertindex] = v;
 
-    if (id >= maxVertexID) {
-        maxVertexID = id + 1;
-    }
-
     // Newly created vertices are always candidates for garbage
     // collection, until they get "owned" by someone who
     // IncrementsUsage on the vertex.
@@ -535,14 +833,57 @@ HbrMesh<T>::NewVertex(int id, const T &data) {
 
     // If mesh is in transient mode, add vertex to transient list
     if (m_transientMode) {
+        m_mutex.Lock();
         m_transientVertices.push_back(v);
+        m_mutex.Unlock();
     }
     return v;
 }
 
+template <class T>
+HbrVertex<T>*
+HbrMesh<T>::newShardedVertex(const T *data) {
+    VertexIDShard & shard = m_idShards[m_threadIndex()];
+    int id;
+    HbrVertex<T>** vset;
+    if (shard.reservedNext != shard.reservedEnd) {
+        // (ReserveIDs allocated the vertex set)
+        id = shard.reservedNext++;
+        if (id / vsetsize != shard.reservedVsetIndex) {
+            m_mutex.Lock();
+            shard.reservedVset = vertices[id / vsetsize];
+            m_mutex.Unlock();
+            shard.reservedVsetIndex = id / vsetsize;
+        }
+        vset = shard.reservedVset;
+    } else {
+        if (shard.next == shard.end) {
+            // Reserve the next IDs (the shards do not straddle vertex sets)
+            m_mutex.Lock();
+            shard.next = maxVertexID;
+            shard.end = std::min(maxVertexID + (int)k_VertexIDShardSize,
+                                 (maxVertexID / vsetsize + 1) * vsetsize);
+            shard.vset = getVertexSet(shard.next);
+            maxVertexID = shard.end;
+            m_mutex.Unlock();
+        }
+        id = shard.next++;
+        vset = shard.vset;
+    }
+    if (data) {
+        return newVertex(id, *data, vset);
+    }
+    T iddata(id);
+    iddata.Clear();
+    return newVertex(id, iddata, vset);
+}
+
 template <class T>
 HbrVertex<T>*
 HbrMesh<T>::NewVertex(const T &data) {
+    if (m_idShards) {
+        return newShardedVertex(&data);
+    }
     // Pick an ID - either the maximum vertex ID or a recycled ID if
     // we can
     int id = maxVertexID;
@@ -559,6 +900,9 @@ HbrMesh<T>::NewVertex(const T &data) {
 template <class T>
 HbrVertex<T>*
 HbrMesh<T>::NewVertex() {
+    if (m_idShards) {
+        return newShardedVertex(0);
+    }
     // Pick an ID - either the maximum vertex ID or a recycled ID if
     // we can
     int id = maxVertexID;
@@ -653,51 +997,49 @@ template <class T>
 HbrFace<T>*
 HbrMesh<T>::NewFace(int nv, HbrVertex<T> **vtx, HbrFace<T>* parent, int childindex) {
     HbrFace<T> *f = 0;
-    // Resize if needed
-    if (nfaces <= maxFaceID) {
-        int nnfaces = nfaces;
-        while (nnfaces <= maxFaceID) {
-            nnfaces *= 2;
-            if (nnfaces < 1) nnfaces = 1;
-        }
-        HbrFace<T>** newfaces = new HbrFace<T>*[nnfaces];
-        if (s_memStatsIncrement) {
-            s_memStatsIncrement(nnfaces * sizeof(HbrFace<T>*));
-        }
-        m_memory += nnfaces * sizeof(HbrFace<T>*);
-        if (faces) {
-            for (int i = 0; i < nfaces; ++i) {
-                newfaces[i] = faces[i];
-            }
-            if (s_memStatsDecrement) {
-                s_memStatsDecrement(nfaces * sizeof(HbrFace<T>*));
-            }
-            m_memory -= nfaces * sizeof(HbrFace<T>*);
-            delete[] faces;
-        }
-        for (int i = nfaces; i < nnfaces; ++i) {
-            newfaces[i] = 0;
-        }
-        faces = newfaces;
-        nfaces = nnfaces;
+    // Faces created concurrently (see SetThreadArenas) are allocated
+    // beforehand : the lock only protects the faces array
+    HbrFace<T> *newface = 0;
+    VertexIDShard *shard = 0;
+    if (m_idShards) {
+        newface = m_faceAllocator.Allocate();
+        shard = &m_idShards[m_threadIndex()];
+        m_mutex.Lock();
     }
-    f = faces[maxFaceID];
-    if (f) {
-        f->Destroy();
-    } else {
-        f = m_faceAllocator.Allocate();
+    // (IDs reserved by RefineConcurrently are already counted by maxFaceID)
+    bool reserved = shard && shard->reservedNext != shard->reservedEnd;
+    int id = reserved ? shard->reservedNext++ : maxFaceID;
+    // Resize if needed
+    growFaces(id);
+    f = faces[id];
+    bool recycled = (f != 0);
+    if (!recycled) {
+        f = newface ? newface : m_faceAllocator.Allocate();
+        newface = 0;
     }
-    f->Initialize(this, parent, childindex, maxFaceID, parent ? parent->GetUniformIndex() : 0, nv, vtx, totalfvarwidth, parent ? parent->GetDepth() + 1 : 0);
-    if (parent) {
-        f->SetPtexIndex(parent->GetPtexIndex());
+    faces[id] = f;
+    if (!reserved) {
+        maxFaceID++;
     }
-    faces[maxFaceID] = f;
-    maxFaceID++;
 
     // If mesh is in transient mode, add face to transient list
     if (m_transientMode) {
         m_transientFaces.push_back(f);
     }
+    if (m_idShards) {
+        m_mutex.Unlock();
+        if (newface) {
+            m_faceAllocator.Deallocate(newface);
+        }
+    }
+
+    if (recycled) {
+        f->Destroy();
+    }
+    f->Initialize(this, parent, childindex, id, parent ? parent->GetUniformIndex() : 0, nv, vtx, totalfvarwidth, parent ? parent->GetDepth() + 1 : 0);
+    if (parent) {
+        f->SetPtexIndex(parent->GetPtexIndex());
+    }
     return f;
 }
 
@@ -955,6 +1297,13 @@ HbrMesh<T>::PrintStats(std::ostream &out) {
 template <class T>
 void
 HbrMesh<T>::GarbageCollect() {
+    // Gather the vertices collected by the threads
+    for (int i = 0; i < m_numThreads; ++i) {
+        std::vector<HbrVertex<T>*> &shardvertices = m_idShards[i].gcVertices;
+        gcVertices.insert(gcVertices.end(), shardvertices.begin(), shardvertices.end());
+        shardvertices.clear();
+    }
+
     if (gcVertices.empty()) return;
 
     static const size_t gcthreshold = 4096;
@@ -1054,6 +1403,10 @@ HbrMesh<T>::FreeTransientData() {
             break;
         }
     }
+    // The IDs left in the shards may now be reassigned
+    for (i = 0; i < m_numThreads; ++i) {
+        m_idShards[i].next = m_idShards[i].end = 0;
+    }
     m_mutex.Unlock();
 }
 
@@ -103,6 +103,10 @@ public:
     virtual HbrVertex<T>* Subdivide(HbrMesh<T>* mesh, HbrHalfedge<T>* edge) = 0;
     virtual HbrVertex<T>* Subdivide(HbrMesh<T>* mesh, HbrVertex<T>* vertex) = 0;
 
+    // Returns true if the refinement creates a vertex at the center of
+    // the faces (ie. if faces may be subdivided)
+    virtual bool HasFaceVertices() const { return true; }
+
     // Returns true if the vertex is extraordinary in the subdivision scheme
     virtual bool VertexIsExtraordinary(HbrMesh<T> const * /* mesh */, HbrVertex<T>* /* vertex */) { return false; }
 
@@ -247,6 +247,14 @@ OsdCLKernelDispatcher::ApplyCatmarkEdgeVerticesKernel(
     CL_CHECK_ERROR(ciErrNum, "edge kernel %d\n", ciErrNum);
 }
 
+void
+OsdCLKernelDispatcher::ApplyCatmarkVertexVerticesKernel(
+    FarMesh<OsdVertex> * mesh, int offset, int level,
+    int start, int end, void * clientdata) const {
+
+    ApplyCatmarkVertexVerticesMultiPass(mesh, offset, level, clientdata);
+}
+
 void
 OsdCLKernelDispatcher::ApplyCatmarkVertexVerticesKernelB(
     FarMesh<OsdVertex> * mesh, int offset, int level,
@@ -361,6 +369,14 @@ OsdCLKernelDispatcher::ApplyLoopEdgeVerticesKernel(
     CL_CHECK_ERROR(ciErrNum, "edge kernel %d\n", ciErrNum);
 }
 
+void
+OsdCLKernelDispatcher::ApplyLoopVertexVerticesKernel(
+    FarMesh<OsdVertex> * mesh, int offset, int level,
+    int start, int end, void * clientdata) const {
+
+    ApplyLoopVertexVerticesMultiPass(mesh, offset, level, clientdata);
+}
+
 void
 OsdCLKernelDispatcher::ApplyLoopVertexVerticesKernelB(
     FarMesh<OsdVertex> * mesh, int offset, int level,
@@ -98,6 +98,11 @@ protected:
         FarMesh<OsdVertex> * mesh, int offset, int level,
         int start, int end, void * clientdata) const;
 
+    // forwards to the multi-pass "A" / "B" kernels
+    virtual void ApplyCatmarkVertexVerticesKernel(
+        FarMesh<OsdVertex> * mesh, int offset, int level,
+        int start, int end, void * clientdata) const;
+
     virtual void ApplyCatmarkVertexVerticesKernelB(
         FarMesh<OsdVertex> * mesh, int offset, int level,
         int start, int end, void * clientdata) const;
@@ -111,6 +116,11 @@ protected:
         FarMesh<OsdVertex> * mesh, int offset, int level,
         int start, int end, void * clientdata) const;
 
+    // forwards to the multi-pass "A" / "B" kernels
+    virtual void ApplyLoopVertexVerticesKernel(
+        FarMesh<OsdVertex> * mesh, int offset, int level,
+        int start, int end, void * clientdata) const;
+
     virtual void ApplyLoopVertexVerticesKernelB(
         FarMesh<OsdVertex> * mesh, int offset, int level,
         int start, int end, void * clientdata) const;
@@ -74,6 +74,7 @@ template <class T> class FarMesh;
             E_W,
             F_IT,
             F_ITa,
+            V_R,
             TABLE_MAX }; }
 
 class OsdComputeContext : OsdNonCopyable<OsdComputeContext> {
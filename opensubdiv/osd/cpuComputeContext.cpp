@@ -59,65 +59,252 @@
 #include "../far/dispatcher.h"
 #include "../far/catmarkSubdivisionTables.h"
 #include "../far/bilinearSubdivisionTables.h"
+#include "../far/dependencyTablesFactory.h"
 
 #include "../osd/cpuComputeContext.h"
 #include "../osd/cpuKernel.h"
 #include "../osd/vertexDescriptor.h"
 #include "../osd/error.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
 OsdCpuComputeContext::OsdCpuComputeContext(FarMesh<OsdVertex> *farMesh)
-    : OsdComputeContext(farMesh) {
+    : OsdComputeContext(farMesh), _vdesc(0, 0) {
 
     _tables = farMesh->GetSubdivisionTables();
     _editTables = farMesh->GetVertexEdit();
-    _vdesc = 0;
+    _vertexStencils = 0;
+    _varyingStencils = 0;
+    _fvarTables = farMesh->GetFVarTables();
+    _dependencies = FarDependencyTablesFactory<OsdVertex>::Create(farMesh);
     _currentVertexBuffer = 0;
     _currentVaryingBuffer = 0;
+    _currentFVarBuffer = 0;
+    _fvarPrecision = OSD_PRECISION_FLOAT;
+    _doubleAccumulation = false;
+    _hasTableCopy = false;
+
+    memset(_tableCopies, 0, sizeof(_tableCopies));
+
+    if (_dependencies)
+        _dependencies->ReserveDirtyVertices(&_dirtyVertices);
+
+    buildSchedule();
 }
 
 OsdCpuComputeContext::~OsdCpuComputeContext() {
 
-    if (_vdesc) delete _vdesc;
-}
-
-const void *
-OsdCpuComputeContext::GetTablePtr(int tableIndex, int level) const {
-
-    if (tableIndex == Table::E_IT) {
-        return _tables->Get_E_IT()[level];
-    } else if (tableIndex == Table::E_W) {
-        return _tables->Get_E_W()[level];
-    } else if (tableIndex == Table::V_ITa) {
-        return _tables->Get_V_ITa()[level];
-    } else if (tableIndex == Table::V_IT) {
-        return _tables->Get_V_IT()[level];
-    } else if (tableIndex == Table::V_W) {
-        return _tables->Get_V_W()[level];
-    } else {
-        const FarCatmarkSubdivisionTables<OsdVertex> * ccTables =
-            dynamic_cast<const FarCatmarkSubdivisionTables<OsdVertex>*>(_tables);
-        const FarBilinearSubdivisionTables<OsdVertex> * bTables =
-            dynamic_cast<const FarBilinearSubdivisionTables<OsdVertex>*>(_tables);
-
-        if (tableIndex == Table::F_IT) {
-            if (ccTables) return ccTables->Get_F_IT()[level];
-            else if (bTables) return bTables->Get_F_IT()[level];
-        } else if (tableIndex == Table::F_ITa) {
-            if (ccTables) return ccTables->Get_F_ITa()[level];
-            else if (bTables) return bTables->Get_F_ITa()[level];
+    // a pending refinement still reads the tables
+    OsdTaskWorker::Wait(&_asyncJob);
+
+    delete _dependencies;
+
+    for (int i=0; i<Table::TABLE_MAX; ++i)
+        free(_tableCopies[i].dst);
+}
+
+void
+OsdCpuComputeContext::buildSchedule() {
+
+    typedef FarSubdivisionTables<OsdVertex> Tables;
+
+    FarCatmarkSubdivisionTables<OsdVertex> const * ccTables =
+        _tables->GetScheme() == Tables::k_Catmark ?
+        static_cast<FarCatmarkSubdivisionTables<OsdVertex> const *>(_tables) : 0;
+    FarBilinearSubdivisionTables<OsdVertex> const * bTables =
+        _tables->GetScheme() == Tables::k_Bilinear ?
+        static_cast<FarBilinearSubdivisionTables<OsdVertex> const *>(_tables) : 0;
+
+    // the kernels of level i read the tables at index i-1
+    int maxlevel = _tables->GetMaxLevel();
+
+    _tablePtrs.assign((maxlevel-1)*Table::TABLE_MAX, (void const *)0);
+    for (int i=0; i<maxlevel-1; ++i) {
+        void const ** ptrs = &_tablePtrs[i*Table::TABLE_MAX];
+        ptrs[Table::E_IT] = _tables->Get_E_IT()[i];
+        ptrs[Table::E_W] = _tables->Get_E_W()[i];
+        ptrs[Table::V_ITa] = _tables->Get_V_ITa()[i];
+        ptrs[Table::V_IT] = _tables->Get_V_IT()[i];
+        ptrs[Table::V_W] = _tables->Get_V_W()[i];
+        ptrs[Table::V_R] = _tables->Get_V_R()[i];
+        if (ccTables) {
+            ptrs[Table::F_IT] = ccTables->Get_F_IT()[i];
+            ptrs[Table::F_ITa] = ccTables->Get_F_ITa()[i];
+        } else if (bTables) {
+            ptrs[Table::F_IT] = bTables->Get_F_IT()[i];
+            ptrs[Table::F_ITa] = bTables->Get_F_ITa()[i];
         }
     }
-    OsdError(OSD_INTERNAL_CODING_ERROR);
-    return 0;
+
+    // same kernels and ranges as FarDispatcher::Refine
+    _schedule.clear();
+    for (int level=1; level<maxlevel; ++level) {
+
+        KernelLaunch launch;
+        launch.level = level;
+        launch.tables = &_tablePtrs[(level-1)*Table::TABLE_MAX];
+
+        int offset = _tables->GetFirstVertexOffset(level),
+            nfaces = _tables->GetNumFaceVertices(level),
+            nedges = _tables->GetNumEdgeVertices(level),
+            nverts = _tables->GetNumVertexVertices(level);
+
+        if (nfaces > 0 and _tables->GetScheme() != Tables::k_Loop) {
+            launch.kernel = KernelLaunch::k_FaceVertices;
+            launch.offset = offset;
+            launch.start = 0;
+            launch.end = nfaces;
+            _schedule.push_back(launch);
+        }
+        offset += nfaces;
+
+        if (nedges > 0) {
+            launch.kernel = bTables ? KernelLaunch::k_BilinearEdgeVertices :
+                                      KernelLaunch::k_EdgeVertices;
+            launch.offset = offset;
+            launch.start = 0;
+            launch.end = nedges;
+            _schedule.push_back(launch);
+        }
+        offset += nedges;
+
+        if (nverts > 0) {
+            // (the "B" batch of the bilinear tables spans all the vertices)
+            launch.kernel = ccTables ? KernelLaunch::k_VertexVertices :
+                            bTables ? KernelLaunch::k_BilinearVertexVertices :
+                                      KernelLaunch::k_LoopVertexVertices;
+            launch.offset = offset;
+            launch.start = 0;
+            launch.end = nverts;
+            _schedule.push_back(launch);
+        }
+
+        if (_editTables) {
+            launch.kernel = KernelLaunch::k_VertexEdits;
+            launch.offset = launch.start = launch.end = 0;
+            _schedule.push_back(launch);
+        }
+    }
+}
+
+template <class T> void
+OsdCpuComputeContext::allocateTableCopy(int tableIndex, FarTable<T> const &table) {
+
+    if (table.IsEmpty())
+        return;
+
+    // malloc does not touch the pages of large allocations
+    TableCopy & copy = _tableCopies[tableIndex];
+    copy.src = reinterpret_cast<char const *>(table[0]);
+    copy.dst = static_cast<char *>(malloc(table.GetMemoryUsed()));
+    copy.elementSize = sizeof(T);
+}
+
+bool
+OsdCpuComputeContext::AllocateTableCopy() {
+
+    if (_hasTableCopy)
+        return false;
+
+    typedef FarSubdivisionTables<OsdVertex> Tables;
+
+    allocateTableCopy(Table::E_IT, _tables->Get_E_IT());
+    allocateTableCopy(Table::E_W, _tables->Get_E_W());
+    allocateTableCopy(Table::V_ITa, _tables->Get_V_ITa());
+    allocateTableCopy(Table::V_IT, _tables->Get_V_IT());
+    allocateTableCopy(Table::V_W, _tables->Get_V_W());
+    allocateTableCopy(Table::V_R, _tables->Get_V_R());
+    if (_tables->GetScheme() == Tables::k_Catmark) {
+        FarCatmarkSubdivisionTables<OsdVertex> const * ccTables =
+            static_cast<FarCatmarkSubdivisionTables<OsdVertex> const *>(_tables);
+        allocateTableCopy(Table::F_IT, ccTables->Get_F_IT());
+        allocateTableCopy(Table::F_ITa, ccTables->Get_F_ITa());
+    } else if (_tables->GetScheme() == Tables::k_Bilinear) {
+        FarBilinearSubdivisionTables<OsdVertex> const * bTables =
+            static_cast<FarBilinearSubdivisionTables<OsdVertex> const *>(_tables);
+        allocateTableCopy(Table::F_IT, bTables->Get_F_IT());
+        allocateTableCopy(Table::F_ITa, bTables->Get_F_ITa());
+    }
+
+    // points the tables of each level (and so the schedule) to the copy
+    for (int i=0; i<(int)_tablePtrs.size(); ++i) {
+        TableCopy const & copy = _tableCopies[i%Table::TABLE_MAX];
+        if (copy.dst and _tablePtrs[i])
+            _tablePtrs[i] = copy.dst +
+                (static_cast<char const *>(_tablePtrs[i]) - copy.src);
+    }
+
+    _hasTableCopy = true;
+    return true;
+}
+
+bool
+OsdCpuComputeContext::HasTableCopy() const {
+
+    return _hasTableCopy;
+}
+
+void
+OsdCpuComputeContext::copyTableElements(int tableIndex,
+                                        KernelLaunch const &launch,
+                                        int first, int count) {
+
+    TableCopy const & copy = _tableCopies[tableIndex];
+    assert(copy.dst);
+
+    size_t offset = (static_cast<char const *>(launch.tables[tableIndex]) - copy.dst) +
+                    size_t(first) * copy.elementSize;
+    memcpy(copy.dst + offset, copy.src + offset, size_t(count) * copy.elementSize);
+}
+
+void
+OsdCpuComputeContext::CopyTableRows(KernelLaunch const &launch, int i) {
+
+    assert(_hasTableCopy);
+
+    // the rows read by the kernels, see cpuKernelCommon.h
+    int const *ITa = 0;
+    switch (launch.kernel) {
+        case KernelLaunch::k_FaceVertices:
+            copyTableElements(Table::F_ITa, launch, 2*i, 2);
+            ITa = static_cast<int const *>(launch.tables[Table::F_ITa]);
+            copyTableElements(Table::F_IT, launch, ITa[2*i], ITa[2*i+1]);
+            break;
+        case KernelLaunch::k_EdgeVertices:
+            copyTableElements(Table::E_IT, launch, 4*i, 4);
+            copyTableElements(Table::E_W, launch, 2*i, 2);
+            break;
+        case KernelLaunch::k_BilinearEdgeVertices:
+            copyTableElements(Table::E_IT, launch, 2*i, 2);
+            break;
+        case KernelLaunch::k_VertexVertices:
+        case KernelLaunch::k_LoopVertexVertices:
+            copyTableElements(Table::V_ITa, launch, 5*i, 5);
+            // (the valence of the vertices without smooth rule can be negative)
+            ITa = static_cast<int const *>(launch.tables[Table::V_ITa]);
+            if (ITa[5*i+1] > 0)
+                copyTableElements(Table::V_IT, launch, ITa[5*i],
+                    launch.kernel == KernelLaunch::k_VertexVertices ?
+                        2*ITa[5*i+1] : ITa[5*i+1]);
+            copyTableElements(Table::V_W, launch, i, 1);
+            copyTableElements(Table::V_R, launch, i, 1);
+            break;
+        case KernelLaunch::k_BilinearVertexVertices:
+            copyTableElements(Table::V_ITa, launch, i, 1);
+            break;
+        case KernelLaunch::k_VertexEdits:
+            break;
+    }
 }
 
-OsdVertexDescriptor *
+OsdVertexDescriptor const *
 OsdCpuComputeContext::GetVertexDescriptor() const {
 
-    return _vdesc;
+    return &_vdesc;
 }
 
 int
@@ -136,18 +323,80 @@ OsdCpuComputeContext::GetEditTable(int tableIndex) const {
     return 0;
 }
 
-float *
+void *
 OsdCpuComputeContext::GetCurrentVertexBuffer() const {
 
     return _currentVertexBuffer;
 }
 
-float *
+void *
 OsdCpuComputeContext::GetCurrentVaryingBuffer() const {
 
     return _currentVaryingBuffer;
 }
 
+void
+OsdCpuComputeContext::SetDoubleAccumulation(bool doubleAccumulation) {
+
+    _doubleAccumulation = doubleAccumulation;
+}
+
+bool
+OsdCpuComputeContext::GetDoubleAccumulation() const {
+
+    return _doubleAccumulation;
+}
+
+void
+OsdCpuComputeContext::SetStencilTables(FarStencilTables const *vertexStencils,
+                                       FarStencilTables const *varyingStencils) {
+
+    _vertexStencils = vertexStencils;
+    _varyingStencils = varyingStencils;
+}
+
+FarStencilTables const *
+OsdCpuComputeContext::GetVertexStencilTables() const {
+
+    return _vertexStencils;
+}
+
+FarStencilTables const *
+OsdCpuComputeContext::GetVaryingStencilTables() const {
+
+    return _varyingStencils;
+}
+
+FarFVarTables const *
+OsdCpuComputeContext::GetFVarTables() const {
+
+    return _fvarTables;
+}
+
+void *
+OsdCpuComputeContext::GetCurrentFVarBuffer() const {
+
+    return _currentFVarBuffer;
+}
+
+OsdPrecision
+OsdCpuComputeContext::GetFVarPrecision() const {
+
+    return _fvarPrecision;
+}
+
+FarDirtyVertices const *
+OsdCpuComputeContext::UpdateDirtyVertices(int const *coarseVertices,
+                                          int numVertices) {
+
+    if (not _dependencies)
+        return 0;
+
+    _dependencies->GetDirtyVertices(coarseVertices, numVertices,
+                                    &_dirtyVertices);
+    return &_dirtyVertices;
+}
+
 OsdCpuComputeContext *
 OsdCpuComputeContext::Create(FarMesh<OsdVertex> *farmesh) {
 
@@ -60,65 +60,307 @@
 #include "../version.h"
 
 #include "../far/table.h"
+#include "../far/dependencyTables.h"
+#include "../far/fvarTables.h"
+#include "../far/stencilTables.h"
 #include "../far/subdivisionTables.h"
 #include "../far/vertexEditTables.h"
 #include "../osd/computeContext.h"
+#include "../osd/error.h"
+#include "../osd/taskScheduler.h"
 #include "../osd/vertexDescriptor.h"
 
+#include <vector>
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
-struct OsdVertexDescriptor;
-
+/// \brief CPU compute context.
+///
+/// The context holds the subdivision tables and the kernel schedule of a
+/// FarMesh, along with the buffers bound by the CPU and OMP compute
+/// controllers. Binding and refining buffers makes no heap allocation : the
+/// bound state is stored in the context, which is created ahead of time
+/// along with the dependency tables of the dirty vertices (see
+/// UpdateDirtyVertices). A
+/// context is bound by one refinement at a time : threads refining the same
+/// FarMesh concurrently must each use their own context.
+///
+/// Asynchronous compute controllers run the refinements of the context with
+/// its job (see GetAsyncJob) : the context waits for its pending refinement
+/// before being destroyed.
+///
 class OsdCpuComputeContext : public OsdComputeContext {
 public:
+    /// \brief A kernel launch of the refinement schedule of the context.
+    ///
+    /// The context precomputes the kernels applied by a full Refine, level by
+    /// level, along with the tables read by each kernel : the dispatchers run
+    /// the schedule without virtual calls, RTTI or table lookups.
+    struct KernelLaunch {
+        enum Kernel {
+            k_FaceVertices=0,          ///< OsdCpuComputeFace
+            k_EdgeVertices,            ///< OsdCpuComputeEdge
+            k_BilinearEdgeVertices,    ///< OsdCpuComputeBilinearEdge
+            k_VertexVertices,          ///< OsdCpuComputeVertex
+            k_LoopVertexVertices,      ///< OsdCpuComputeLoopVertex
+            k_BilinearVertexVertices,  ///< OsdCpuComputeBilinearVertex
+            k_VertexEdits              ///< hierarchical edits of the level
+        };
+
+        Kernel kernel;
+        int level, offset, start, end;
+        void const * const * tables; ///< the tables of the level (see Table)
+
+        /// Returns the kernel reported to the FarKernelInstrumentation
+        FarKernelLaunch::Kernel GetFarKernel() const {
+            switch (kernel) {
+                case k_FaceVertices : return FarKernelLaunch::k_FaceVertices;
+                case k_EdgeVertices :
+                case k_BilinearEdgeVertices : return FarKernelLaunch::k_EdgeVertices;
+                case k_VertexEdits : return FarKernelLaunch::k_VertexEdits;
+                default : return FarKernelLaunch::k_VertexVertices;
+            }
+        }
+    };
+
     static OsdCpuComputeContext * Create(FarMesh<OsdVertex> *farmesh);
 
     virtual ~OsdCpuComputeContext();
 
+    /// Binds the buffers to refine. The vertices of the buffers can hold
+    /// numSamples interleaved samples (see OsdVertexDescriptor). The buffers
+    /// hold floats or doubles, both buffers with the same scalar type.
+    /// Returns false (and binds nothing) if the vertex elements can not be
+    /// split in numSamples samples.
     template<class VERTEX_BUFFER, class VARYING_BUFFER>
-    void Bind(VERTEX_BUFFER *vertex, VARYING_BUFFER *varying) {
-
-        _currentVertexBuffer = vertex ? vertex->BindCpuBuffer() : 0;
-        _currentVaryingBuffer = varying ? varying->BindCpuBuffer() : 0;
+    bool Bind(VERTEX_BUFFER *vertex, VARYING_BUFFER *varying,
+              int numSamples=1) {
 
         int numVertexElements = vertex ? vertex->GetNumElements() : 0;
         int numVaryingElements = varying ? varying->GetNumElements() : 0;
-        _vdesc = new OsdVertexDescriptor(numVertexElements, numVaryingElements);
+
+        return Bind(vertex, varying,
+             OsdVertexBufferDescriptor(0, numVertexElements, numVertexElements),
+             OsdVertexBufferDescriptor(0, numVaryingElements, numVaryingElements),
+             numSamples);
+    }
+
+    /// Binds the elements of the buffers described by vertexDesc and
+    /// varyingDesc : only these elements are refined, the other elements of
+    /// the vertices are left untouched.
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    bool Bind(VERTEX_BUFFER *vertex, VARYING_BUFFER *varying,
+              OsdVertexBufferDescriptor const &vertexDesc,
+              OsdVertexBufferDescriptor const &varyingDesc,
+              int numSamples=1) {
+
+        // the edits of a sample are applied numVertexElements/numSamples
+        // elements apart : a truncated width would edit the wrong elements
+        if (numSamples <= 0 or vertexDesc.length % numSamples != 0) {
+            OsdError(OSD_INTERNAL_CODING_ERROR,
+                     "Cannot split %d vertex elements in %d samples\n",
+                     vertexDesc.length, numSamples);
+            Unbind();
+            return false;
+        }
+
+        OsdPrecision vertexPrecision = OSD_PRECISION_FLOAT,
+                     varyingPrecision = OSD_PRECISION_FLOAT;
+
+        _currentVertexBuffer = vertex ?
+            bindBuffer(vertex->BindCpuBuffer() + vertexDesc.offset,
+                       &vertexPrecision) : 0;
+        _currentVaryingBuffer = varying ?
+            bindBuffer(varying->BindCpuBuffer() + varyingDesc.offset,
+                       &varyingPrecision) : 0;
+
+        assert(not vertex or not varying or vertexPrecision == varyingPrecision);
+        OsdPrecision precision = vertex ? vertexPrecision : varyingPrecision;
+        if (precision == OSD_PRECISION_FLOAT and _doubleAccumulation)
+            precision = OSD_PRECISION_MIXED;
+
+        assert(not vertex or vertexDesc.IsValid());
+        assert(not varying or varyingDesc.IsValid());
+        _vdesc = OsdVertexDescriptor(
+            vertex ? vertexDesc : OsdVertexBufferDescriptor(),
+            varying ? varyingDesc : OsdVertexBufferDescriptor(),
+            numSamples, precision);
+        return true;
     }
 
     void Unbind() {
         _currentVertexBuffer = 0;
         _currentVaryingBuffer = 0;
 
-        delete _vdesc;
-        _vdesc = 0;
+        _vdesc = OsdVertexDescriptor(0, 0);
+    }
+
+    /// Binds the face-varying buffer to refine : the buffer holds the
+    /// GetFVarTables()->GetNumCorners() corners of all the levels, each made
+    /// of GetTotalFVarWidth() floats or doubles (see FarFVarTables).
+    template<class FVAR_BUFFER>
+    void BindFVar(FVAR_BUFFER *fvar) {
+
+        assert(_fvarTables and fvar);
+        assert(fvar->GetNumElements() == _fvarTables->GetTotalFVarWidth() and
+               fvar->GetNumVertices() >= _fvarTables->GetNumCorners());
+
+        _currentFVarBuffer = bindBuffer(fvar->BindCpuBuffer(), &_fvarPrecision);
+        if (_fvarPrecision == OSD_PRECISION_FLOAT and _doubleAccumulation)
+            _fvarPrecision = OSD_PRECISION_MIXED;
+    }
+
+    void UnbindFVar() {
+        _currentFVarBuffer = 0;
     }
 
-    const void * GetTablePtr(int tableIndex, int level) const;
+    const void * GetTablePtr(int tableIndex, int level) const {
+        assert(tableIndex>=0 and tableIndex<Table::TABLE_MAX and
+               level>=0 and level<(int)_tablePtrs.size()/Table::TABLE_MAX);
+        return _tablePtrs[level*Table::TABLE_MAX+tableIndex];
+    }
+
+    /// Returns the kernels applied by a full Refine of the subdivision tables,
+    /// in order
+    std::vector<KernelLaunch> const & GetSchedule() const {
+        return _schedule;
+    }
+
+    /// Allocates a copy of the subdivision tables read by the schedule, which
+    /// the kernels read instead of the tables of the FarMesh. The copy is not
+    /// initialized : CopyTableRows copies the rows of each kernel launch, so
+    /// that on NUMA systems the pages of the copy are first touched (and
+    /// placed) by the threads that read them (see
+    /// OsdOmpComputeController::FirstTouch). Returns false if the tables are
+    /// already copied.
+    bool AllocateTableCopy();
 
-    OsdVertexDescriptor * GetVertexDescriptor() const;
+    /// Returns true if the kernels read a copy of the tables
+    bool HasTableCopy() const;
+
+    /// Copies the rows of the tables read by vertex i of a kernel launch of
+    /// the schedule to the table copy
+    void CopyTableRows(KernelLaunch const &launch, int i);
+
+    /// Returns the descriptor of the bound buffers
+    OsdVertexDescriptor const * GetVertexDescriptor() const;
 
     int GetNumEditTables() const;
 
     const FarVertexEditTables<OsdVertex>::VertexEditBatch *
         GetEditTable(int tableIndex) const;
 
-    float * GetCurrentVertexBuffer() const;
+    /// Returns the bound vertex buffer : an array of floats or doubles,
+    /// depending on the precision of the vertex descriptor.
+    void * GetCurrentVertexBuffer() const;
+
+    void * GetCurrentVaryingBuffer() const;
 
-    float * GetCurrentVaryingBuffer() const;
+    /// Accumulates the refined vertices of float buffers in double precision
+    /// (OSD_PRECISION_MIXED) : the float buffers bound afterwards are refined
+    /// with fewer rounding errors, at some cost in speed. Double buffers are
+    /// always refined in double precision.
+    void SetDoubleAccumulation(bool doubleAccumulation);
+
+    bool GetDoubleAccumulation() const;
+
+    /// Sets optional stencil tables (not owned by the context) : when vertex
+    /// stencils are set, Refine computes the vertices covered by the stencils
+    /// directly from the coarse vertices in a single pass instead of applying
+    /// the subdivision tables level by level. Varying data is only
+    /// interpolated if varying stencils are also set.
+    void SetStencilTables(FarStencilTables const *vertexStencils,
+                          FarStencilTables const *varyingStencils=0);
+
+    FarStencilTables const * GetVertexStencilTables() const;
+
+    FarStencilTables const * GetVaryingStencilTables() const;
+
+    /// Returns the face-varying tables of the mesh (0 if the FarMesh was
+    /// created without face-varying data)
+    FarFVarTables const * GetFVarTables() const;
+
+    /// Returns the bound face-varying buffer
+    void * GetCurrentFVarBuffer() const;
+
+    /// Returns the precision of the bound face-varying buffer
+    OsdPrecision GetFVarPrecision() const;
+
+    /// Returns the job running the asynchronous refinements of the context
+    OsdTaskWorker::Job * GetAsyncJob() { return &_asyncJob; }
+
+    /// Returns the refined vertices that depend on a set of modified coarse
+    /// vertices. The dependency tables of the mesh and the memory of the
+    /// result are allocated when the context is created. Returns 0 if the
+    /// mesh has hierarchical edits, which cannot be applied to a subset of
+    /// the vertices.
+    FarDirtyVertices const * UpdateDirtyVertices(int const *coarseVertices,
+                                                 int numVertices);
 
 protected:
     explicit OsdCpuComputeContext(FarMesh<OsdVertex> *farMesh);
 
+private:
+    // Gathers the tables of each level and the kernel launches of a Refine
+    void buildSchedule();
+
+    // Allocates the copy of a table, see AllocateTableCopy
+    template <class T>
+    void allocateTableCopy(int tableIndex, FarTable<T> const &table);
+
+    // Copies count elements of the table from element first of the table of
+    // the launch
+    void copyTableElements(int tableIndex, KernelLaunch const &launch,
+                           int first, int count);
+
+    static void * bindBuffer(float *buffer, OsdPrecision *precision) {
+        *precision = OSD_PRECISION_FLOAT;
+        return buffer;
+    }
+
+    static void * bindBuffer(double *buffer, OsdPrecision *precision) {
+        *precision = OSD_PRECISION_DOUBLE;
+        return buffer;
+    }
+
 private:
     // XXX: shared pointer with farmesh?
     FarSubdivisionTables<OsdVertex> const *_tables;
     FarVertexEditTables<OsdVertex> const *_editTables;
 
-    float *_currentVertexBuffer, *_currentVaryingBuffer;
+    std::vector<void const *> _tablePtrs; // Table::TABLE_MAX pointers per level
+
+    std::vector<KernelLaunch> _schedule;
+
+    // copy of the tables read by the kernels (see AllocateTableCopy)
+    struct TableCopy {
+        char const *src;
+        char *dst;
+        int elementSize;
+    };
+
+    TableCopy _tableCopies[Table::TABLE_MAX];
+    bool _hasTableCopy;
+
+    FarStencilTables const *_vertexStencils,
+                           *_varyingStencils;
+
+    FarFVarTables const *_fvarTables;
+
+    FarDependencyTables *_dependencies;
+
+    FarDirtyVertices _dirtyVertices;
+
+    void *_currentVertexBuffer, *_currentVaryingBuffer, *_currentFVarBuffer;
+
+    OsdPrecision _fvarPrecision;
+
+    bool _doubleAccumulation;
+
+    OsdVertexDescriptor _vdesc; // descriptor of the bound buffers
 
-    OsdVertexDescriptor *_vdesc;
+    OsdTaskWorker::Job _asyncJob;
 };
 
 }  // end namespace OPENSUBDIV_VERSION
@@ -62,15 +62,74 @@
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
+static void
+refineJob(void *data) {
 
-OsdCpuComputeController::OsdCpuComputeController() {
+    OsdCpuComputeContext *context = static_cast<OsdCpuComputeContext*>(data);
+
+    OsdCpuKernelDispatcher::GetInstance()->Refine(context->GetFarMesh(),
+                                                  context);
+    context->Unbind();
+}
+
+static void
+refineFVarJob(void *data) {
+
+    OsdCpuComputeContext *context = static_cast<OsdCpuComputeContext*>(data);
+
+    OsdCpuKernelDispatcher::GetInstance()->RefineFVar(context);
+    context->UnbindFVar();
+}
+
+OsdCpuComputeController::OsdCpuComputeController(bool asynchronous) {
+
+    _worker = asynchronous ? new OsdTaskWorker() : 0;
 }
 
 OsdCpuComputeController::~OsdCpuComputeController() {
+
+    // completes the pending refinements
+    delete _worker;
+}
+
+void
+OsdCpuComputeController::refine(OsdCpuComputeContext *context) {
+
+    if (_worker) {
+        OsdTaskWorker::Job *job = context->GetAsyncJob();
+        job->function = refineJob;
+        job->data = context;
+        _worker->Submit(job);
+    } else {
+        refineJob(context);
+    }
+}
+
+void
+OsdCpuComputeController::refineFVar(OsdCpuComputeContext *context) {
+
+    if (_worker) {
+        OsdTaskWorker::Job *job = context->GetAsyncJob();
+        job->function = refineFVarJob;
+        job->data = context;
+        _worker->Submit(job);
+    } else {
+        refineFVarJob(context);
+    }
 }
 
 void
 OsdCpuComputeController::Synchronize() {
+
+    if (_worker)
+        _worker->WaitAll();
+}
+
+void
+OsdCpuComputeController::Synchronize(OsdCpuComputeContext *context) {
+
+    // the context can be pending in the worker of another controller
+    OsdTaskWorker::Wait(context->GetAsyncJob());
 }
 
 }  // end namespace OPENSUBDIV_VERSION
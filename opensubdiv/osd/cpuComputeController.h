@@ -61,6 +61,7 @@
 
 #include "../osd/cpuComputeContext.h"
 #include "../osd/cpuDispatcher.h"
+#include "../osd/taskScheduler.h"
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
@@ -69,12 +70,20 @@ namespace OPENSUBDIV_VERSION {
 /// OsdCpuComputeController is a compute controller class to launch
 /// single threaded CPU subdivision kernels. It requires
 /// OsdCpuVertexBufferInterface as arguments of Refine function.
+/// Refining makes no heap allocation (see OsdCpuComputeContext).
+///
+/// An asynchronous controller queues the refinements to a background thread
+/// and returns immediately : the buffers must not be accessed until the
+/// refinement completes (see Synchronize). Refining a context waits for its
+/// previous refinement, so that a context can be refined with a second
+/// (double-buffered) vertex buffer while the first one is in use.
 class OsdCpuComputeController {
 public:
     typedef OsdCpuComputeContext ComputeContext;
 
     /// Constructor.
-    OsdCpuComputeController();
+    /// asynchronous queues the refinements to a background thread.
+    explicit OsdCpuComputeController(bool asynchronous=false);
 
     /// Destructor.
     ~OsdCpuComputeController();
@@ -89,10 +98,9 @@ public:
                 VERTEX_BUFFER *vertexBuffer,
                 VARYING_BUFFER *varyingBuffer) {
 
+        Synchronize(context);
         context->Bind(vertexBuffer, varyingBuffer);
-        OsdCpuKernelDispatcher::GetInstance()->Refine(context->GetFarMesh(),
-                                                      context);
-        context->Unbind();
+        refine(context);
     }
 
     template<class VERTEX_BUFFER>
@@ -100,7 +108,146 @@ public:
         Refine(context, vertexBuffer, (VERTEX_BUFFER*)0);
     }
 
+    /// Launch subdivision kernels on the elements of the vertex buffers
+    /// described by vertexDesc and varyingDesc (ex. the positions of a
+    /// buffer interleaving positions, normals and colors) : the elements are
+    /// refined in place and the other elements are left untouched.
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                OsdVertexBufferDescriptor const &vertexDesc,
+                VERTEX_BUFFER *vertexBuffer,
+                OsdVertexBufferDescriptor const &varyingDesc,
+                VARYING_BUFFER *varyingBuffer) {
+
+        Synchronize(context);
+        context->Bind(vertexBuffer, varyingBuffer, vertexDesc, varyingDesc);
+        refine(context);
+    }
+
+    template<class VERTEX_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                OsdVertexBufferDescriptor const &vertexDesc,
+                VERTEX_BUFFER *vertexBuffer) {
+        Refine(context, vertexDesc, vertexBuffer,
+               OsdVertexBufferDescriptor(), (VERTEX_BUFFER*)0);
+    }
+
+    /// Launch subdivision kernels on buffers holding numSamples interleaved
+    /// samples of each vertex (ex. motion blur time samples) : every sample
+    /// is refined in a single traversal of the subdivision tables. Each
+    /// vertex of vertexBuffer is made of numSamples consecutive runs of
+    /// GetNumElements()/numSamples elements, one per sample. Nothing is
+    /// refined, and an OSD_INTERNAL_CODING_ERROR is reported, if
+    /// GetNumElements() is not a multiple of numSamples.
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void RefineSamples(OsdCpuComputeContext *context, int numSamples,
+                       VERTEX_BUFFER *vertexBuffer,
+                       VARYING_BUFFER *varyingBuffer) {
+
+        Synchronize(context);
+        if (context->Bind(vertexBuffer, varyingBuffer, numSamples))
+            refine(context);
+    }
+
+    template<class VERTEX_BUFFER>
+    void RefineSamples(OsdCpuComputeContext *context, int numSamples,
+                       VERTEX_BUFFER *vertexBuffer) {
+        RefineSamples(context, numSamples, vertexBuffer, (VERTEX_BUFFER*)0);
+    }
+
+    /// Launch subdivision kernels on the refined vertices that depend on a
+    /// set of modified coarse vertices only. The other refined vertices of
+    /// the buffers are left untouched, so they must hold the results of a
+    /// previous Refine : the results are then identical to a full Refine.
+    /// Meshes with hierarchical edits or stencil tables are fully refined.
+    /// The dirty vertices are refined on the calling thread, even by an
+    /// asynchronous controller.
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                int const *dirtyVertices, int numDirtyVertices,
+                VERTEX_BUFFER *vertexBuffer,
+                VARYING_BUFFER *varyingBuffer) {
+
+        Synchronize(context);
+
+        FarDirtyVertices const *dirty = context->GetVertexStencilTables() ? 0 :
+            context->UpdateDirtyVertices(dirtyVertices, numDirtyVertices);
+
+        if (not dirty) {
+            Refine(context, vertexBuffer, varyingBuffer);
+            return;
+        }
+
+        context->Bind(vertexBuffer, varyingBuffer);
+        OsdCpuKernelDispatcher::GetInstance()->Refine(context->GetFarMesh(),
+                                                      dirty, context);
+        context->Unbind();
+    }
+
+    template<class VERTEX_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                int const *dirtyVertices, int numDirtyVertices,
+                VERTEX_BUFFER *vertexBuffer) {
+        Refine(context, dirtyVertices, numDirtyVertices, vertexBuffer,
+               (VERTEX_BUFFER*)0);
+    }
+
+    /// Launch subdivision kernels on a batch of meshes : contexts[i] is
+    /// refined with vertexBuffers[i] and varyingBuffers[i] (varyingBuffers
+    /// can be NULL). Each context and buffer can only appear once per batch.
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void RefineBatch(OsdCpuComputeContext **contexts,
+                     VERTEX_BUFFER **vertexBuffers,
+                     VARYING_BUFFER **varyingBuffers,
+                     int count) {
+
+        for (int i=0; i<count; ++i) {
+            Synchronize(contexts[i]);
+            contexts[i]->Bind(vertexBuffers[i],
+                              varyingBuffers ? varyingBuffers[i] : 0);
+            refine(contexts[i]);
+        }
+    }
+
+    template<class VERTEX_BUFFER>
+    void RefineBatch(OsdCpuComputeContext **contexts,
+                     VERTEX_BUFFER **vertexBuffers, int count) {
+        RefineBatch(contexts, vertexBuffers, (VERTEX_BUFFER**)0, count);
+    }
+
+    /// Launch the face-varying subdivision kernels on fvarBuffer : the
+    /// corners of the coarse faces (level 0) are refined into the corners of
+    /// the faces of every level, see FarFVarTables for the layout of the
+    /// buffer. Updating the coarse data (ex. animated UVs) only requires a new
+    /// RefineFVar. Does nothing if the mesh has no face-varying tables.
+    template<class FVAR_BUFFER>
+    void RefineFVar(OsdCpuComputeContext *context, FVAR_BUFFER *fvarBuffer) {
+
+        if (not context->GetFVarTables())
+            return;
+
+        Synchronize(context);
+        context->BindFVar(fvarBuffer);
+        refineFVar(context);
+    }
+
+    /// Waits until all running subdivision kernels finish.
     void Synchronize();
+
+    /// Waits until the refinement of a context completes.
+    void Synchronize(OsdCpuComputeContext *context);
+
+private:
+    OsdCpuComputeController(const OsdCpuComputeController &);
+    OsdCpuComputeController & operator = (const OsdCpuComputeController &);
+
+    // Refines the bound buffers of the context, then unbinds them
+    void refine(OsdCpuComputeContext *context);
+
+    // Refines the bound face-varying buffer of the context, then unbinds it
+    void refineFVar(OsdCpuComputeContext *context);
+
+    OsdTaskWorker * _worker; // runs the refinements (asynchronous controller)
 };
 
 }  // end namespace OPENSUBDIV_VERSION
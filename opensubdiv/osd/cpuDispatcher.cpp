@@ -65,6 +65,43 @@
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
+// Applies the hierarchical edits of a level to the bound vertex buffer
+static void
+applyVertexEdits(OsdCpuComputeContext *context, int level) {
+
+    int numEdits = context->GetNumEditTables();
+
+    for (int i = 0; i < numEdits; ++i) {
+
+        const FarVertexEditTables<OsdVertex>::VertexEditBatch * edit =
+            context->GetEditTable(i);
+        assert(edit);
+
+        const FarTable<unsigned int> &primvarIndices = edit->GetVertexIndices();
+        const FarTable<float> &editValues = edit->GetValues();
+
+        // XXX: how about edits for varying...?
+
+        if (edit->GetOperation() == FarVertexEdit::Add) {
+            OsdCpuEditVertexAdd(context->GetVertexDescriptor(),
+                                context->GetCurrentVertexBuffer(),
+                                edit->GetPrimvarIndex(),
+                                edit->GetPrimvarWidth(),
+                                primvarIndices.GetNumElements(level-1),
+                                (const int*)primvarIndices[level-1],
+                                (const float*)editValues[level-1]);
+        } else if (edit->GetOperation() == FarVertexEdit::Set) {
+            OsdCpuEditVertexSet(context->GetVertexDescriptor(),
+                                context->GetCurrentVertexBuffer(),
+                                edit->GetPrimvarIndex(),
+                                edit->GetPrimvarWidth(),
+                                primvarIndices.GetNumElements(level-1),
+                                (const int*)primvarIndices[level-1],
+                                (const float*)editValues[level-1]);
+        }
+    }
+}
+
 OsdCpuKernelDispatcher::OsdCpuKernelDispatcher() {
 }
 
@@ -76,7 +113,161 @@ void
 OsdCpuKernelDispatcher::Refine(FarMesh<OsdVertex> * mesh,
                                OsdCpuComputeContext *context) const {
 
-    FarDispatcher<OsdVertex>::Refine(mesh, /*maxlevel =*/ -1, context);
+    if (context->GetVertexStencilTables()) {
+        ApplyStencilTables(context);
+        return;
+    }
+
+    ApplySchedule(mesh, context);
+}
+
+void
+OsdCpuKernelDispatcher::Refine(FarMesh<OsdVertex> * mesh,
+                               FarDirtyVertices const * dirty,
+                               OsdCpuComputeContext *context) const {
+
+    FarDispatcher<OsdVertex>::RefineDirty(mesh, dirty, context);
+}
+
+void
+OsdCpuKernelDispatcher::ApplySchedule(FarMesh<OsdVertex> * mesh,
+                                      OsdCpuComputeContext *context) const {
+
+    OsdVertexDescriptor const *vdesc = context->GetVertexDescriptor();
+    void *vertex = context->GetCurrentVertexBuffer(),
+         *varying = context->GetCurrentVaryingBuffer();
+
+    std::vector<OsdCpuComputeContext::KernelLaunch> const & schedule =
+        context->GetSchedule();
+
+    FarSubdivisionTables<OsdVertex> const * subdivisionTables =
+        mesh->GetSubdivisionTables();
+
+    for (int i=0; i<(int)schedule.size(); ++i) {
+
+        OsdCpuComputeContext::KernelLaunch const & launch = schedule[i];
+        void const * const * tables = launch.tables;
+
+        FarKernelScope<OsdVertex> scope(this, context, subdivisionTables,
+            launch.GetFarKernel(), launch.level, launch.offset,
+            launch.start, launch.end);
+
+        switch (launch.kernel) {
+            case OsdCpuComputeContext::KernelLaunch::k_FaceVertices:
+                OsdCpuComputeFace(
+                    vdesc, vertex, varying,
+                    (const int*)tables[Table::F_IT],
+                    (const int*)tables[Table::F_ITa],
+                    launch.offset, launch.start, launch.end);
+                break;
+            case OsdCpuComputeContext::KernelLaunch::k_EdgeVertices:
+                OsdCpuComputeEdge(
+                    vdesc, vertex, varying,
+                    (const int*)tables[Table::E_IT],
+                    (const float*)tables[Table::E_W],
+                    launch.offset, launch.start, launch.end);
+                break;
+            case OsdCpuComputeContext::KernelLaunch::k_BilinearEdgeVertices:
+                OsdCpuComputeBilinearEdge(
+                    vdesc, vertex, varying,
+                    (const int*)tables[Table::E_IT],
+                    launch.offset, launch.start, launch.end);
+                break;
+            case OsdCpuComputeContext::KernelLaunch::k_VertexVertices:
+                OsdCpuComputeVertex(
+                    vdesc, vertex, varying,
+                    (const int*)tables[Table::V_ITa],
+                    (const int*)tables[Table::V_IT],
+                    (const float*)tables[Table::V_W],
+                    (const unsigned char*)tables[Table::V_R],
+                    launch.offset, launch.start, launch.end);
+                break;
+            case OsdCpuComputeContext::KernelLaunch::k_LoopVertexVertices:
+                OsdCpuComputeLoopVertex(
+                    vdesc, vertex, varying,
+                    (const int*)tables[Table::V_ITa],
+                    (const int*)tables[Table::V_IT],
+                    (const float*)tables[Table::V_W],
+                    (const unsigned char*)tables[Table::V_R],
+                    launch.offset, launch.start, launch.end);
+                break;
+            case OsdCpuComputeContext::KernelLaunch::k_BilinearVertexVertices:
+                OsdCpuComputeBilinearVertex(
+                    vdesc, vertex, varying,
+                    (const int*)tables[Table::V_ITa],
+                    launch.offset, launch.start, launch.end);
+                break;
+            case OsdCpuComputeContext::KernelLaunch::k_VertexEdits:
+                applyVertexEdits(context, launch.level);
+                break;
+        }
+    }
+}
+
+void
+OsdCpuKernelDispatcher::ApplyStencilTables(OsdCpuComputeContext *context) const {
+
+    const OsdVertexDescriptor *vdesc = context->GetVertexDescriptor();
+
+    FarStencilTables const *stencils = context->GetVertexStencilTables();
+    if (context->GetCurrentVertexBuffer() and stencils->GetNumStencils() > 0) {
+        OsdCpuComputeStencils(
+            context->GetCurrentVertexBuffer(), vdesc->numVertexElements,
+            vdesc->vertexStride, vdesc->precision,
+            &stencils->GetSizes()[0], &stencils->GetOffsets()[0],
+            &stencils->GetControlIndices()[0], &stencils->GetWeights()[0],
+            stencils->GetFirstVertexOffset(), 0, stencils->GetNumStencils());
+    }
+
+    stencils = context->GetVaryingStencilTables();
+    if (context->GetCurrentVaryingBuffer() and stencils and
+        stencils->GetNumStencils() > 0) {
+        OsdCpuComputeStencils(
+            context->GetCurrentVaryingBuffer(), vdesc->numVaryingElements,
+            vdesc->varyingStride, vdesc->precision,
+            &stencils->GetSizes()[0], &stencils->GetOffsets()[0],
+            &stencils->GetControlIndices()[0], &stencils->GetWeights()[0],
+            stencils->GetFirstVertexOffset(), 0, stencils->GetNumStencils());
+    }
+}
+
+void
+OsdCpuKernelDispatcher::RefineFVar(OsdCpuComputeContext *context) const {
+
+    FarFVarTables const *tables = context->GetFVarTables();
+    char *buffer = (char *)context->GetCurrentFVarBuffer();
+    if (not tables or not buffer)
+        return;
+
+    // Each data item of the corners is refined with its own tables, since
+    // the seams of the items can differ
+    OsdPrecision precision = context->GetFVarPrecision();
+    int scalarSize = OsdGetScalarSize(precision);
+
+    for (int level=1; level<=tables->GetMaxLevel(); ++level) {
+        for (int item=0; item<tables->GetFVarCount(); ++item) {
+            FarStencilTables const *stencils = tables->GetTables(level, item);
+            if (stencils->GetNumStencils() == 0)
+                continue;
+            OsdCpuComputeStencils(
+                buffer + tables->GetFVarOffsets()[item]*scalarSize,
+                tables->GetFVarWidths()[item], tables->GetTotalFVarWidth(),
+                precision,
+                &stencils->GetSizes()[0], &stencils->GetOffsets()[0],
+                &stencils->GetControlIndices()[0], &stencils->GetWeights()[0],
+                stencils->GetFirstVertexOffset(), 0, stencils->GetNumStencils());
+        }
+    }
+}
+
+size_t
+OsdCpuKernelDispatcher::GetVertexSize(void * clientdata) const {
+
+    OsdVertexDescriptor const *vdesc =
+        static_cast<OsdCpuComputeContext*>(clientdata)->GetVertexDescriptor();
+
+    return (vdesc->numVertexElements + vdesc->numVaryingElements) *
+           OsdGetScalarSize(vdesc->precision);
 }
 
 OsdCpuKernelDispatcher *
@@ -175,7 +366,7 @@ OsdCpuKernelDispatcher::ApplyCatmarkEdgeVerticesKernel(
 }
 
 void
-OsdCpuKernelDispatcher::ApplyCatmarkVertexVerticesKernelB(
+OsdCpuKernelDispatcher::ApplyCatmarkVertexVerticesKernel(
     FarMesh<OsdVertex> * mesh, int offset, int level,
     int start, int end, void * clientdata) const {
 
@@ -183,34 +374,17 @@ OsdCpuKernelDispatcher::ApplyCatmarkVertexVerticesKernelB(
         static_cast<OsdCpuComputeContext*>(clientdata);
     assert(context);
 
-    OsdCpuComputeVertexB(
+    OsdCpuComputeVertex(
         context->GetVertexDescriptor(),
         context->GetCurrentVertexBuffer(),
         context->GetCurrentVaryingBuffer(),
         (const int*)context->GetTablePtr(Table::V_ITa, level-1),
         (const int*)context->GetTablePtr(Table::V_IT, level-1),
         (const float*)context->GetTablePtr(Table::V_W, level-1),
+        (const unsigned char*)context->GetTablePtr(Table::V_R, level-1),
         offset, start, end);
 }
 
-void
-OsdCpuKernelDispatcher::ApplyCatmarkVertexVerticesKernelA(
-    FarMesh<OsdVertex> * mesh, int offset, bool pass, int level,
-    int start, int end, void * clientdata) const {
-
-    OsdCpuComputeContext * context =
-        static_cast<OsdCpuComputeContext*>(clientdata);
-    assert(context);
-
-    OsdCpuComputeVertexA(
-        context->GetVertexDescriptor(),
-        context->GetCurrentVertexBuffer(),
-        context->GetCurrentVaryingBuffer(),
-        (const int*)context->GetTablePtr(Table::V_ITa, level-1),
-        (const float*)context->GetTablePtr(Table::V_W, level-1),
-        offset, start, end, pass);
-}
-
 void
 OsdCpuKernelDispatcher::ApplyLoopEdgeVerticesKernel(
     FarMesh<OsdVertex> * mesh, int offset, int level,
@@ -230,7 +404,7 @@ OsdCpuKernelDispatcher::ApplyLoopEdgeVerticesKernel(
 }
 
 void
-OsdCpuKernelDispatcher::ApplyLoopVertexVerticesKernelB(
+OsdCpuKernelDispatcher::ApplyLoopVertexVerticesKernel(
     FarMesh<OsdVertex> * mesh, int offset, int level,
     int start, int end, void * clientdata) const {
 
@@ -238,34 +412,17 @@ OsdCpuKernelDispatcher::ApplyLoopVertexVerticesKernelB(
         static_cast<OsdCpuComputeContext*>(clientdata);
     assert(context);
 
-    OsdCpuComputeLoopVertexB(
+    OsdCpuComputeLoopVertex(
         context->GetVertexDescriptor(),
         context->GetCurrentVertexBuffer(),
         context->GetCurrentVaryingBuffer(),
         (const int*)context->GetTablePtr(Table::V_ITa, level-1),
         (const int*)context->GetTablePtr(Table::V_IT, level-1),
         (const float*)context->GetTablePtr(Table::V_W, level-1),
+        (const unsigned char*)context->GetTablePtr(Table::V_R, level-1),
         offset, start, end);
 }
 
-void
-OsdCpuKernelDispatcher::ApplyLoopVertexVerticesKernelA(
-    FarMesh<OsdVertex> * mesh, int offset, bool pass, int level,
-    int start, int end, void * clientdata) const {
-
-    OsdCpuComputeContext * context =
-        static_cast<OsdCpuComputeContext*>(clientdata);
-    assert(context);
-
-    OsdCpuComputeVertexA(
-        context->GetVertexDescriptor(),
-        context->GetCurrentVertexBuffer(),
-        context->GetCurrentVaryingBuffer(),
-        (const int*)context->GetTablePtr(Table::V_ITa, level-1),
-        (const float*)context->GetTablePtr(Table::V_W, level-1),
-        offset, start, end, pass);
-}
-
 void
 OsdCpuKernelDispatcher::ApplyVertexEdits(
     FarMesh<OsdVertex> *mesh, int offset, int level, void *clientdata) const {
@@ -274,37 +431,7 @@ OsdCpuKernelDispatcher::ApplyVertexEdits(
         static_cast<OsdCpuComputeContext*>(clientdata);
     assert(context);
 
-    int numEdits = context->GetNumEditTables();
-
-    for (int i = 0; i < numEdits; ++i) {
-
-        const FarVertexEditTables<OsdVertex>::VertexEditBatch * edit =
-            context->GetEditTable(i);
-        assert(edit);
-
-        const FarTable<unsigned int> &primvarIndices = edit->GetVertexIndices();
-        const FarTable<float> &editValues = edit->GetValues();
-
-        // XXX: how about edits for varying...?
-
-        if (edit->GetOperation() == FarVertexEdit::Add) {
-            OsdCpuEditVertexAdd(context->GetVertexDescriptor(),
-                                context->GetCurrentVertexBuffer(),
-                                edit->GetPrimvarIndex(),
-                                edit->GetPrimvarWidth(),
-                                primvarIndices.GetNumElements(level-1),
-                                (const int*)primvarIndices[level-1],
-                                (const float*)editValues[level-1]);
-        } else if (edit->GetOperation() == FarVertexEdit::Set) {
-            OsdCpuEditVertexSet(context->GetVertexDescriptor(),
-                                context->GetCurrentVertexBuffer(),
-                                edit->GetPrimvarIndex(),
-                                edit->GetPrimvarWidth(),
-                                primvarIndices.GetNumElements(level-1),
-                                (const int*)primvarIndices[level-1],
-                                (const float*)editValues[level-1]);
-        }
-    }
+    applyVertexEdits(context, level);
 }
 
 }  // end namespace OPENSUBDIV_VERSION
@@ -75,9 +75,24 @@ public:
 
     void Refine(FarMesh<OsdVertex> * mesh, OsdCpuComputeContext *context) const;
 
+    void Refine(FarMesh<OsdVertex> * mesh, FarDirtyVertices const * dirty,
+                OsdCpuComputeContext *context) const;
+
+    /// Refines the face-varying buffer bound to the context, level by level
+    void RefineFVar(OsdCpuComputeContext *context) const;
+
     static OsdCpuKernelDispatcher * GetInstance();
 
 protected:
+    // Computes the vertices covered by the stencil tables of the context
+    void ApplyStencilTables(OsdCpuComputeContext *context) const;
+
+    // Runs the kernel launches precomputed by the context (see
+    // OsdCpuComputeContext::GetSchedule)
+    void ApplySchedule(FarMesh<OsdVertex> * mesh, OsdCpuComputeContext *context) const;
+
+    virtual size_t GetVertexSize(void * clientdata) const;
+
     virtual void ApplyBilinearFaceVerticesKernel(
         FarMesh<OsdVertex> * mesh, int offset, int level,
         int start, int end, void * clientdata) const;
@@ -99,27 +114,19 @@ protected:
         FarMesh<OsdVertex> * mesh, int offset, int level,
         int start, int end, void * clientdata) const;
 
-    virtual void ApplyCatmarkVertexVerticesKernelB(
+    virtual void ApplyCatmarkVertexVerticesKernel(
         FarMesh<OsdVertex> * mesh, int offset, int level,
         int start, int end, void * clientdata) const;
 
-    virtual void ApplyCatmarkVertexVerticesKernelA(
-        FarMesh<OsdVertex> * mesh, int offset, bool pass, int level,
-        int start, int end, void * clientdata) const;
-
 
     virtual void ApplyLoopEdgeVerticesKernel(
         FarMesh<OsdVertex> * mesh, int offset, int level,
         int start, int end, void * clientdata) const;
 
-    virtual void ApplyLoopVertexVerticesKernelB(
+    virtual void ApplyLoopVertexVerticesKernel(
         FarMesh<OsdVertex> * mesh, int offset, int level,
         int start, int end, void * clientdata) const;
 
-    virtual void ApplyLoopVertexVerticesKernelA(
-        FarMesh<OsdVertex> * mesh, int offset, bool pass, int level,
-        int start, int end, void * clientdata) const;
-
     virtual void ApplyVertexEdits(
         FarMesh<OsdVertex> *mesh, int offset, int level,
         void * clientdata) const;
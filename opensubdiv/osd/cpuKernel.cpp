@@ -56,210 +56,461 @@
 //
 
 #include "../osd/cpuKernel.h"
+#include "../osd/cpuKernelCommon.h"
 #include "../osd/vertexDescriptor.h"
 
 #include <math.h>
 
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
-void OsdCpuComputeFace(
-    const OsdVertexDescriptor *vdesc, float * vertex, float * varying,
-    const int *F_IT, const int *F_ITa, int offset, int start, int end) {
+static size_t
+getLastLevelCacheSize() {
+
+    long size = 0;
+#if defined(_SC_LEVEL3_CACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE)
+    size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (size <= 0)
+        size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+    // assume a common last level cache size when the system doesn't tell
+    return size > 0 ? size_t(size) : size_t(8*1024*1024);
+}
 
-    for (int i = start; i < end; i++) {
-        int h = F_ITa[2*i];
-        int n = F_ITa[2*i+1];
+// Selected on first use (see selectDefaults)
+static size_t g_nonTemporalStoreThreshold = 0;
 
-        float weight = 1.0f/n;
+static void selectDefaults();
 
-        // XXX: should use local vertex struct variable instead of
-        // accumulating directly into global memory.
-        int dstIndex = offset + i;
-        vdesc->Clear(vertex, varying, dstIndex);
+void OsdCpuSetNonTemporalStoreThreshold(size_t bytes) {
+    selectDefaults();
+    g_nonTemporalStoreThreshold = bytes;
+}
 
-        for (int j = 0; j < n; ++j) {
-            int index = F_IT[h+j];
-            vdesc->AddWithWeight(vertex, dstIndex, index, weight);
-            vdesc->AddVaryingWithWeight(varying, dstIndex, index, weight);
-        }
-    }
+size_t OsdCpuGetNonTemporalStoreThreshold() {
+    selectDefaults();
+    return g_nonTemporalStoreThreshold;
 }
 
-void OsdCpuComputeEdge(
-    const OsdVertexDescriptor *vdesc, float *vertex, float *varying,
-    const int *E_IT, const float *E_W, int offset, int start, int end) {
+template <int NUM_ELEMENTS, class T, class ACC> static OSD_CPU_INLINE void
+computeFace(const OsdVertexDescriptor *vdesc,
+            void *vertexBuffer, void *varyingBuffer,
+            const int *F_IT, const int *F_ITa, int offset, int start, int end,
+            bool nonTemporal) {
 
-    for (int i = start; i < end; i++) {
-        int eidx0 = E_IT[4*i+0];
-        int eidx1 = E_IT[4*i+1];
-        int eidx2 = E_IT[4*i+2];
-        int eidx3 = E_IT[4*i+3];
+    T *vertex = static_cast<T *>(vertexBuffer);
+    T *varying = static_cast<T *>(varyingBuffer);
 
-        float vertWeight = E_W[i*2+0];
+    for (int i = start; i < end; i++)
+        OsdCpuComputeFaceVertex<NUM_ELEMENTS, T, ACC>(vdesc, vertex, varying,
+                                                      F_IT, F_ITa, offset, i, nonTemporal);
 
-        int dstIndex = offset + i;
-        vdesc->Clear(vertex, varying, dstIndex);
+    if (nonTemporal)
+        OsdCpuStoreFence();
+}
 
-        vdesc->AddWithWeight(vertex, dstIndex, eidx0, vertWeight);
-        vdesc->AddWithWeight(vertex, dstIndex, eidx1, vertWeight);
+template <int NUM_ELEMENTS, class T, class ACC> static OSD_CPU_INLINE void
+computeEdge(const OsdVertexDescriptor *vdesc,
+            void *vertexBuffer, void *varyingBuffer,
+            const int *E_IT, const float *E_W, int offset, int start, int end,
+            bool nonTemporal) {
 
-        if (eidx2 != -1) {
-            float faceWeight = E_W[i*2+1];
+    T *vertex = static_cast<T *>(vertexBuffer);
+    T *varying = static_cast<T *>(varyingBuffer);
 
-            vdesc->AddWithWeight(vertex, dstIndex, eidx2, faceWeight);
-            vdesc->AddWithWeight(vertex, dstIndex, eidx3, faceWeight);
-        }
+    for (int i = start; i < end; i++)
+        OsdCpuComputeEdgeVertex<NUM_ELEMENTS, T, ACC>(vdesc, vertex, varying,
+                                                      E_IT, E_W, offset, i, nonTemporal);
 
-        vdesc->AddVaryingWithWeight(varying, dstIndex, eidx0, 0.5f);
-        vdesc->AddVaryingWithWeight(varying, dstIndex, eidx1, 0.5f);
-    }
+    if (nonTemporal)
+        OsdCpuStoreFence();
 }
 
-void OsdCpuComputeVertexA(
-    const OsdVertexDescriptor *vdesc, float *vertex, float *varying,
-    const int *V_ITa, const float *V_W,
-    int offset, int start, int end, int pass) {
-
-    for (int i = start; i < end; i++) {
-        int n     = V_ITa[5*i+1];
-        int p     = V_ITa[5*i+2];
-        int eidx0 = V_ITa[5*i+3];
-        int eidx1 = V_ITa[5*i+4];
-
-        float weight = (pass == 1) ? V_W[i] : 1.0f - V_W[i];
-
-        // In the case of fractional weight, the weight must be inverted since
-        // the value is shared with the k_Smooth kernel (statistically the
-        // k_Smooth kernel runs much more often than this one)
-        if (weight > 0.0f && weight < 1.0f && n > 0)
-            weight = 1.0f - weight;
-
-        int dstIndex = offset + i;
-        if (not pass)
-            vdesc->Clear(vertex, varying, dstIndex);
-
-        if (eidx0 == -1 || (pass == 0 && (n == -1))) {
-            vdesc->AddWithWeight(vertex, dstIndex, p, weight);
-        } else {
-            vdesc->AddWithWeight(vertex, dstIndex, p, weight * 0.75f);
-            vdesc->AddWithWeight(vertex, dstIndex, eidx0, weight * 0.125f);
-            vdesc->AddWithWeight(vertex, dstIndex, eidx1, weight * 0.125f);
-        }
-
-        if (not pass)
-            vdesc->AddVaryingWithWeight(varying, dstIndex, p, 1.0f);
-    }
+template <int NUM_ELEMENTS, class T, class ACC> static OSD_CPU_INLINE void
+computeVertex(const OsdVertexDescriptor *vdesc,
+              void *vertexBuffer, void *varyingBuffer,
+              const int *V_ITa, const int *V_IT, const float *V_W,
+              const unsigned char *V_R, int offset, int start, int end,
+              bool nonTemporal) {
+
+    T *vertex = static_cast<T *>(vertexBuffer);
+    T *varying = static_cast<T *>(varyingBuffer);
+
+    for (int i = start; i < end; i++)
+        OsdCpuComputeVertexVertex<NUM_ELEMENTS, T, ACC>(vdesc, vertex, varying,
+                                                        V_ITa, V_IT, V_W, V_R, offset, i, nonTemporal);
+
+    if (nonTemporal)
+        OsdCpuStoreFence();
 }
 
-void OsdCpuComputeVertexB(
-    const OsdVertexDescriptor *vdesc, float *vertex, float *varying,
-    const int *V_ITa, const int *V_IT, const float *V_W,
-    int offset, int start, int end) {
+template <int NUM_ELEMENTS, class T, class ACC> static OSD_CPU_INLINE void
+computeLoopVertex(const OsdVertexDescriptor *vdesc,
+                  void *vertexBuffer, void *varyingBuffer,
+                  const int *V_ITa, const int *V_IT, const float *V_W,
+                  const unsigned char *V_R, int offset, int start, int end,
+                  bool nonTemporal) {
 
-    for (int i = start; i < end; i++) {
-        int h = V_ITa[5*i];
-        int n = V_ITa[5*i+1];
-        int p = V_ITa[5*i+2];
+    T *vertex = static_cast<T *>(vertexBuffer);
+    T *varying = static_cast<T *>(varyingBuffer);
 
-        float weight = V_W[i];
-        float wp = 1.0f/static_cast<float>(n*n);
-        float wv = (n-2.0f) * n * wp;
+    for (int i = start; i < end; i++)
+        OsdCpuComputeLoopVertexVertex<NUM_ELEMENTS, T, ACC>(vdesc, vertex, varying,
+                                                            V_ITa, V_IT, V_W, V_R, offset, i, nonTemporal);
 
-        int dstIndex = offset + i;
-        vdesc->Clear(vertex, varying, dstIndex);
+    if (nonTemporal)
+        OsdCpuStoreFence();
+}
 
-        vdesc->AddWithWeight(vertex, dstIndex, p, weight * wv);
+template <int NUM_ELEMENTS, class T, class ACC> static OSD_CPU_INLINE void
+computeBilinearEdge(const OsdVertexDescriptor *vdesc,
+                    void *vertexBuffer, void *varyingBuffer,
+                    const int *E_IT, int offset, int start, int end,
+                    bool nonTemporal) {
 
-        for (int j = 0; j < n; ++j) {
-            vdesc->AddWithWeight(vertex, dstIndex, V_IT[h+j*2], weight * wp);
-            vdesc->AddWithWeight(vertex, dstIndex, V_IT[h+j*2+1], weight * wp);
-        }
-        vdesc->AddVaryingWithWeight(varying, dstIndex, p, 1.0f);
-    }
+    T *vertex = static_cast<T *>(vertexBuffer);
+    T *varying = static_cast<T *>(varyingBuffer);
+
+    for (int i = start; i < end; i++)
+        OsdCpuComputeBilinearEdgeVertex<NUM_ELEMENTS, T, ACC>(vdesc, vertex, varying,
+                                                              E_IT, offset, i, nonTemporal);
+
+    if (nonTemporal)
+        OsdCpuStoreFence();
 }
 
-void OsdCpuComputeLoopVertexB(
-    const OsdVertexDescriptor *vdesc, float *vertex, float *varying,
-    const int *V_ITa, const int *V_IT, const float *V_W,
-    int offset, int start, int end) {
+template <int NUM_ELEMENTS, class T, class ACC> static OSD_CPU_INLINE void
+computeBilinearVertex(const OsdVertexDescriptor *vdesc,
+                      void *vertexBuffer, void *varyingBuffer,
+                      const int *V_ITa, int offset, int start, int end,
+                      bool nonTemporal) {
 
-    for (int i = start; i < end; i++) {
-        int h = V_ITa[5*i];
-        int n = V_ITa[5*i+1];
-        int p = V_ITa[5*i+2];
+    T *vertex = static_cast<T *>(vertexBuffer);
+    T *varying = static_cast<T *>(varyingBuffer);
 
-        float weight = V_W[i];
-        float wp = 1.0f/static_cast<float>(n);
-        float beta = 0.25f * cosf(static_cast<float>(M_PI) * 2.0f * wp) + 0.375f;
-        beta = beta * beta;
-        beta = (0.625f - beta) * wp;
+    for (int i = start; i < end; i++)
+        OsdCpuComputeBilinearVertexVertex<NUM_ELEMENTS, T, ACC>(vdesc, vertex, varying,
+                                                                V_ITa, offset, i, nonTemporal);
 
-        int dstIndex = offset + i;
-        vdesc->Clear(vertex, varying, dstIndex);
+    if (nonTemporal)
+        OsdCpuStoreFence();
+}
 
-        vdesc->AddWithWeight(vertex, dstIndex, p, weight * (1.0f - (beta * n)));
+template <int NUM_ELEMENTS, class T, class ACC> static OSD_CPU_INLINE void
+computeStencils(void *data, int numElements, int stride,
+                const int *sizes, const int *offsets,
+                const int *indices, const float *weights,
+                int offset, int start, int end, bool nonTemporal) {
 
-        for (int j = 0; j < n; ++j)
-            vdesc->AddWithWeight(vertex, dstIndex, V_IT[h+j], weight * beta);
+    T *buffer = static_cast<T *>(data);
 
-        vdesc->AddVaryingWithWeight(varying, dstIndex, p, 1.0f);
+    for (int i = start; i < end; i++)
+        OsdCpuComputeStencilVertex<NUM_ELEMENTS, T, ACC>(buffer, numElements, stride, sizes, offsets,
+                                                         indices, weights, offset, i, nonTemporal);
+
+    if (nonTemporal)
+        OsdCpuStoreFence();
+}
+
+// Defines the kernel entry points of an instruction set and their table
+// NAME : ATTRIBUTES are the function attributes of the entry points, in which
+// the rules are compiled.
+#define OSD_CPU_DEFINE_KERNELS(NAME, ATTRIBUTES)                                                 \
+                                                                                                  \
+ATTRIBUTES void NAME##Face(                                                                       \
+    const OsdVertexDescriptor *vdesc, void *vertex, void *varying,                                \
+    const int *F_IT, const int *F_ITa, int offset, int start, int end, bool nonTemporal) {        \
+                                                                                                  \
+    OSD_CPU_DISPATCH(vdesc->precision, vdesc->numVertexElements, computeFace,                     \
+        (vdesc, vertex, varying, F_IT, F_ITa, offset, start, end, nonTemporal));                  \
+}                                                                                                 \
+                                                                                                  \
+ATTRIBUTES void NAME##Edge(                                                                       \
+    const OsdVertexDescriptor *vdesc, void *vertex, void *varying,                                \
+    const int *E_IT, const float *E_W, int offset, int start, int end, bool nonTemporal) {        \
+                                                                                                  \
+    OSD_CPU_DISPATCH(vdesc->precision, vdesc->numVertexElements, computeEdge,                     \
+        (vdesc, vertex, varying, E_IT, E_W, offset, start, end, nonTemporal));                    \
+}                                                                                                 \
+                                                                                                  \
+ATTRIBUTES void NAME##Vertex(                                                                     \
+    const OsdVertexDescriptor *vdesc, void *vertex, void *varying,                                \
+    const int *V_ITa, const int *V_IT, const float *V_W,                                          \
+    const unsigned char *V_R, int offset, int start, int end, bool nonTemporal) {                 \
+                                                                                                  \
+    OSD_CPU_DISPATCH(vdesc->precision, vdesc->numVertexElements, computeVertex,                   \
+        (vdesc, vertex, varying, V_ITa, V_IT, V_W, V_R, offset, start, end, nonTemporal));        \
+}                                                                                                 \
+                                                                                                  \
+ATTRIBUTES void NAME##LoopVertex(                                                                 \
+    const OsdVertexDescriptor *vdesc, void *vertex, void *varying,                                \
+    const int *V_ITa, const int *V_IT, const float *V_W,                                          \
+    const unsigned char *V_R, int offset, int start, int end, bool nonTemporal) {                 \
+                                                                                                  \
+    OSD_CPU_DISPATCH(vdesc->precision, vdesc->numVertexElements, computeLoopVertex,               \
+        (vdesc, vertex, varying, V_ITa, V_IT, V_W, V_R, offset, start, end, nonTemporal));        \
+}                                                                                                 \
+                                                                                                  \
+ATTRIBUTES void NAME##BilinearEdge(                                                               \
+    const OsdVertexDescriptor *vdesc, void *vertex, void *varying,                                \
+    const int *E_IT, int offset, int start, int end, bool nonTemporal) {                          \
+                                                                                                  \
+    OSD_CPU_DISPATCH(vdesc->precision, vdesc->numVertexElements, computeBilinearEdge,             \
+        (vdesc, vertex, varying, E_IT, offset, start, end, nonTemporal));                         \
+}                                                                                                 \
+                                                                                                  \
+ATTRIBUTES void NAME##BilinearVertex(                                                             \
+    const OsdVertexDescriptor *vdesc, void *vertex, void *varying,                                \
+    const int *V_ITa, int offset, int start, int end, bool nonTemporal) {                         \
+                                                                                                  \
+    OSD_CPU_DISPATCH(vdesc->precision, vdesc->numVertexElements, computeBilinearVertex,           \
+        (vdesc, vertex, varying, V_ITa, offset, start, end, nonTemporal));                        \
+}                                                                                                 \
+                                                                                                  \
+ATTRIBUTES void NAME##Stencils(                                                                   \
+    void *buffer, int numElements, int stride, OsdPrecision precision,                            \
+    const int *sizes, const int *offsets, const int *indices, const float *weights,               \
+    int offset, int start, int end, bool nonTemporal) {                                           \
+                                                                                                  \
+    OSD_CPU_DISPATCH(precision, numElements, computeStencils,                                     \
+        (buffer, numElements, stride, sizes, offsets, indices, weights,                           \
+         offset, start, end, nonTemporal));                                                       \
+}                                                                                                 \
+                                                                                                  \
+static const OsdCpuKernels NAME = {                                                               \
+    NAME##Face, NAME##Edge, NAME##Vertex, NAME##LoopVertex,                                       \
+    NAME##BilinearEdge, NAME##BilinearVertex, NAME##Stencils                                      \
+};
+
+// The kernels do not contract their accumulations into FMA instructions
+// (implied by AVX-512, or by the build flags), which would round them
+// differently from one instruction set to the other.
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#define OSD_CPU_NO_CONTRACT
+#elif defined(__GNUC__)
+#define OSD_CPU_NO_CONTRACT __attribute__((optimize("fp-contract=off")))
+#else
+#define OSD_CPU_NO_CONTRACT
+#endif
+
+OSD_CPU_DEFINE_KERNELS(g_defaultKernels, static OSD_CPU_NO_CONTRACT)
+
+#ifdef OSD_CPU_HAS_TARGET_ATTRIBUTE
+OSD_CPU_DEFINE_KERNELS(g_avx2Kernels, static OSD_CPU_NO_CONTRACT __attribute__((target("avx2"))))
+OSD_CPU_DEFINE_KERNELS(g_avx512Kernels, static OSD_CPU_NO_CONTRACT __attribute__((target("avx512f"))))
+#endif
+
+// Returns true if the processor (and the operating system) support 'isa'
+static bool
+isSupported(OsdCpuInstructionSet isa) {
+
+    switch (isa) {
+        case OSD_CPU_ISA_DEFAULT : return true;
+#ifdef OSD_CPU_HAS_TARGET_ATTRIBUTE
+        // cpuid and xgetbv (the AVX registers must be saved by the system)
+        case OSD_CPU_ISA_AVX2    : return __builtin_cpu_supports("avx2");
+        case OSD_CPU_ISA_AVX512  : return __builtin_cpu_supports("avx512f");
+#endif
+        default : return false;
     }
 }
 
-void OsdCpuComputeBilinearEdge(
-    const OsdVertexDescriptor *vdesc, float *vertex, float *varying,
-    const int *E_IT, int offset, int start, int end) {
+static OsdCpuInstructionSet g_instructionSet = OSD_CPU_ISA_DEFAULT;
 
-    for (int i = start; i < end; i++) {
-        int eidx0 = E_IT[2*i+0];
-        int eidx1 = E_IT[2*i+1];
+static OsdCpuKernels const * g_kernels = &g_defaultKernels;
 
-        int dstIndex = offset + i;
-        vdesc->Clear(vertex, varying, dstIndex);
+static bool
+selectInstructionSet(OsdCpuInstructionSet isa) {
 
-        vdesc->AddWithWeight(vertex, dstIndex, eidx0, 0.5f);
-        vdesc->AddWithWeight(vertex, dstIndex, eidx1, 0.5f);
+    if (not isSupported(isa))
+        return false;
 
-        vdesc->AddVaryingWithWeight(varying, dstIndex, eidx0, 0.5f);
-        vdesc->AddVaryingWithWeight(varying, dstIndex, eidx1, 0.5f);
+    switch (isa) {
+#ifdef OSD_CPU_HAS_TARGET_ATTRIBUTE
+        case OSD_CPU_ISA_AVX2   : g_kernels = &g_avx2Kernels; break;
+        case OSD_CPU_ISA_AVX512 : g_kernels = &g_avx512Kernels; break;
+#endif
+        default : g_kernels = &g_defaultKernels; break;
     }
+    g_instructionSet = isa;
+    return true;
+}
+
+// Selects the widest instruction set supported and the size of the last
+// level cache as the non-temporal store threshold
+static void
+initDefaults() {
+
+    g_nonTemporalStoreThreshold = getLastLevelCacheSize();
+
+    if (not selectInstructionSet(OSD_CPU_ISA_AVX512))
+        selectInstructionSet(OSD_CPU_ISA_AVX2);
+}
+
+// The defaults are selected once, by the first thread calling the kernels or
+// the settings functions, rather than by a static initializer : the kernels
+// can be called from static initializers of the clients.
+#if defined(_WIN32)
+static INIT_ONCE g_defaultsOnce = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK
+initDefaultsOnce(PINIT_ONCE, PVOID, PVOID *) {
+    initDefaults();
+    return TRUE;
+}
+
+static void
+selectDefaults() {
+    InitOnceExecuteOnce(&g_defaultsOnce, initDefaultsOnce, NULL, NULL);
+}
+#else
+static pthread_once_t g_defaultsOnce = PTHREAD_ONCE_INIT;
+
+static void
+selectDefaults() {
+    pthread_once(&g_defaultsOnce, initDefaults);
+}
+#endif
+
+bool OsdCpuSetInstructionSet(OsdCpuInstructionSet isa) {
+    selectDefaults();
+    return selectInstructionSet(isa);
+}
+
+OsdCpuInstructionSet OsdCpuGetInstructionSet() {
+    selectDefaults();
+    return g_instructionSet;
+}
+
+OsdCpuKernels const & OsdCpuGetKernels() {
+    selectDefaults();
+    return *g_kernels;
+}
+
+void OsdCpuComputeFace(
+    const OsdVertexDescriptor *vdesc, void *vertex, void *varying,
+    const int *F_IT, const int *F_ITa, int offset, int start, int end) {
+
+    OsdCpuKernels const & kernels = OsdCpuGetKernels();
+    kernels.computeFace(vdesc, vertex, varying, F_IT, F_ITa, offset, start, end,
+                        OsdCpuUseNonTemporalStores(vdesc, end-start));
+}
+
+void OsdCpuComputeEdge(
+    const OsdVertexDescriptor *vdesc, void *vertex, void *varying,
+    const int *E_IT, const float *E_W, int offset, int start, int end) {
+
+    OsdCpuKernels const & kernels = OsdCpuGetKernels();
+    kernels.computeEdge(vdesc, vertex, varying, E_IT, E_W, offset, start, end,
+                        OsdCpuUseNonTemporalStores(vdesc, end-start));
+}
+
+void OsdCpuComputeVertex(
+    const OsdVertexDescriptor *vdesc, void *vertex, void *varying,
+    const int *V_ITa, const int *V_IT, const float *V_W,
+    const unsigned char *V_R, int offset, int start, int end) {
+
+    OsdCpuKernels const & kernels = OsdCpuGetKernels();
+    kernels.computeVertex(vdesc, vertex, varying, V_ITa, V_IT, V_W, V_R, offset, start, end,
+                          OsdCpuUseNonTemporalStores(vdesc, end-start));
+}
+
+void OsdCpuComputeLoopVertex(
+    const OsdVertexDescriptor *vdesc, void *vertex, void *varying,
+    const int *V_ITa, const int *V_IT, const float *V_W,
+    const unsigned char *V_R, int offset, int start, int end) {
+
+    OsdCpuKernels const & kernels = OsdCpuGetKernels();
+    kernels.computeLoopVertex(vdesc, vertex, varying, V_ITa, V_IT, V_W, V_R, offset, start, end,
+                              OsdCpuUseNonTemporalStores(vdesc, end-start));
+}
+
+void OsdCpuComputeBilinearEdge(
+    const OsdVertexDescriptor *vdesc, void *vertex, void *varying,
+    const int *E_IT, int offset, int start, int end) {
+
+    OsdCpuKernels const & kernels = OsdCpuGetKernels();
+    kernels.computeBilinearEdge(vdesc, vertex, varying, E_IT, offset, start, end,
+                                OsdCpuUseNonTemporalStores(vdesc, end-start));
 }
 
 void OsdCpuComputeBilinearVertex(
-    const OsdVertexDescriptor *vdesc, float *vertex, float *varying,
+    const OsdVertexDescriptor *vdesc, void *vertex, void *varying,
     const int *V_ITa, int offset, int start, int end) {
 
-    for (int i = start; i < end; i++) {
-        int p = V_ITa[i];
+    OsdCpuKernels const & kernels = OsdCpuGetKernels();
+    kernels.computeBilinearVertex(vdesc, vertex, varying, V_ITa, offset, start, end,
+                                  OsdCpuUseNonTemporalStores(vdesc, end-start));
+}
+
+void OsdCpuComputeStencils(
+    void *buffer, int numElements, int stride, OsdPrecision precision,
+    const int *sizes, const int *offsets,
+    const int *indices, const float *weights,
+    int offset, int start, int end) {
+
+    OsdCpuKernels const & kernels = OsdCpuGetKernels();
+    kernels.computeStencils(buffer, numElements, stride, precision,
+                            sizes, offsets, indices, weights, offset, start, end,
+                            OsdCpuUseNonTemporalStores(end-start, numElements,
+                                                       OsdGetScalarSize(precision)));
+}
+
+template <class T> static void
+editVertexAdd(const OsdVertexDescriptor *vdesc, T *vertex,
+              int primVarOffset, int primVarWidth, int vertexCount,
+              const int *editIndices, const float *editValues) {
+
+    for (int i = 0; i < vertexCount; i++) {
+        vdesc->ApplyVertexEditAdd(vertex, primVarOffset, primVarWidth,
+                                  editIndices[i], &editValues[i*primVarWidth]);
+    }
+}
 
-        int dstIndex = offset + i;
-        vdesc->Clear(vertex, varying, dstIndex);
+template <class T> static void
+editVertexSet(const OsdVertexDescriptor *vdesc, T *vertex,
+              int primVarOffset, int primVarWidth, int vertexCount,
+              const int *editIndices, const float *editValues) {
 
-        vdesc->AddWithWeight(vertex, dstIndex, p, 1.0f);
-        vdesc->AddVaryingWithWeight(varying, dstIndex, p, 1.0f);
+    for (int i = 0; i < vertexCount; i++) {
+        vdesc->ApplyVertexEditSet(vertex, primVarOffset, primVarWidth,
+                                  editIndices[i], &editValues[i*primVarWidth]);
     }
 }
 
 void OsdCpuEditVertexAdd(
-    const OsdVertexDescriptor *vdesc, float *vertex,
+    const OsdVertexDescriptor *vdesc, void *vertex,
     int primVarOffset, int primVarWidth, int vertexCount,
     const int *editIndices, const float *editValues) {
 
-    for (int i = 0; i < vertexCount; i++) {
-        vdesc->ApplyVertexEditAdd(vertex, primVarOffset, primVarWidth,
-                                  editIndices[i], &editValues[i*primVarWidth]);
+    if (vdesc->precision == OSD_PRECISION_DOUBLE) {
+        editVertexAdd(vdesc, static_cast<double *>(vertex), primVarOffset,
+                      primVarWidth, vertexCount, editIndices, editValues);
+    } else {
+        editVertexAdd(vdesc, static_cast<float *>(vertex), primVarOffset,
+                      primVarWidth, vertexCount, editIndices, editValues);
     }
 }
 
 void OsdCpuEditVertexSet(
-    const OsdVertexDescriptor *vdesc, float *vertex,
+    const OsdVertexDescriptor *vdesc, void *vertex,
     int primVarOffset, int primVarWidth, int vertexCount,
     const int *editIndices, const float *editValues) {
 
-    for (int i = 0; i < vertexCount; i++) {
-        vdesc->ApplyVertexEditSet(vertex, primVarOffset, primVarWidth,
-                                  editIndices[i], &editValues[i*primVarWidth]);
+    if (vdesc->precision == OSD_PRECISION_DOUBLE) {
+        editVertexSet(vdesc, static_cast<double *>(vertex), primVarOffset,
+                      primVarWidth, vertexCount, editIndices, editValues);
+    } else {
+        editVertexSet(vdesc, static_cast<float *>(vertex), primVarOffset,
+                      primVarWidth, vertexCount, editIndices, editValues);
     }
 }
 
@@ -60,55 +60,84 @@
 
 #include "../version.h"
 
+#include "../osd/vertexDescriptor.h"
+
+#include <stddef.h>
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
-struct OsdVertexDescriptor;
-
 void OsdCpuComputeFace(const OsdVertexDescriptor *vdesc,
-                       float * vertex, float * varying,
+                       void *vertex, void *varying,
                        const int *F_IT, const int *F_ITa,
                        int offset, int start, int end);
 
 void OsdCpuComputeEdge(const OsdVertexDescriptor *vdesc,
-                       float *vertex, float * varying,
+                       void *vertex, void *varying,
                        const int *E_IT, const float *E_ITa,
                        int offset, int start, int end);
 
-void OsdCpuComputeVertexA(const OsdVertexDescriptor *vdesc,
-                          float *vertex, float * varying,
-                          const int *V_ITa, const float *V_IT,
-                          int offset, int start, int end, int pass);
+void OsdCpuComputeVertex(const OsdVertexDescriptor *vdesc,
+                         void *vertex, void *varying,
+                         const int *V_ITa, const int *V_IT, const float *V_W,
+                         const unsigned char *V_R,
+                         int offset, int start, int end);
 
-void OsdCpuComputeVertexB(const OsdVertexDescriptor *vdesc,
-                          float *vertex, float * varying,
-                          const int *V_ITa, const int *V_IT, const float *V_W,
-                          int offset, int start, int end);
-
-void OsdCpuComputeLoopVertexB(const OsdVertexDescriptor *vdesc,
-                              float *vertex, float * varying,
-                              const int *V_ITa, const int *V_IT,
-                              const float *V_W,
-                              int offset, int start, int end);
+void OsdCpuComputeLoopVertex(const OsdVertexDescriptor *vdesc,
+                             void *vertex, void *varying,
+                             const int *V_ITa, const int *V_IT,
+                             const float *V_W, const unsigned char *V_R,
+                             int offset, int start, int end);
 
 void OsdCpuComputeBilinearEdge(const OsdVertexDescriptor *vdesc,
-                               float *vertex, float * varying,
+                               void *vertex, void *varying,
                                const int *E_IT,
                                int offset, int start, int end);
 
 void OsdCpuComputeBilinearVertex(const OsdVertexDescriptor *vdesc,
-                                 float *vertex, float * varying,
+                                 void *vertex, void *varying,
                                  const int *V_ITa,
                                  int offset, int start, int end);
 
-void OsdCpuEditVertexAdd(const OsdVertexDescriptor *vdesc, float *vertex,
+void OsdCpuComputeStencils(void *buffer, int numElements, int stride,
+                           OsdPrecision precision,
+                           const int *sizes, const int *offsets,
+                           const int *indices, const float *weights,
+                           int offset, int start, int end);
+
+void OsdCpuEditVertexAdd(const OsdVertexDescriptor *vdesc, void *vertex,
                          int primVarOffset, int primVarWidth, int count,
                          const int *editIndices, const float *editValues);
 
-void OsdCpuEditVertexSet(const OsdVertexDescriptor *vdesc, float *vertex,
+void OsdCpuEditVertexSet(const OsdVertexDescriptor *vdesc, void *vertex,
                          int primVarOffset, int primVarWidth, int count,
                          const int *editIndices, const float *editValues);
 
+// Kernel batches writing more than 'bytes' of vertex data use non-temporal
+// stores. Defaults to the size of the last level cache.
+//
+// The kernel settings (the threshold and the instruction set below) are
+// global and are not synchronized with the kernels : they must not be
+// changed while a refinement is in flight on any thread (including the
+// asynchronous refinements of the task and OMP controllers).
+void OsdCpuSetNonTemporalStoreThreshold(size_t bytes);
+
+size_t OsdCpuGetNonTemporalStoreThreshold();
+
+// Instruction sets the CPU and OMP kernels are compiled for. All of them
+// compute bitwise identical vertices.
+enum OsdCpuInstructionSet {
+    OSD_CPU_ISA_DEFAULT, // the instruction set of the library build
+    OSD_CPU_ISA_AVX2,
+    OSD_CPU_ISA_AVX512
+};
+
+// Selects the kernels compiled for 'isa' : returns false (and leaves the
+// kernels unchanged) if the processor or the build does not support it.
+// Defaults to the widest instruction set supported.
+bool OsdCpuSetInstructionSet(OsdCpuInstructionSet isa);
+
+OsdCpuInstructionSet OsdCpuGetInstructionSet();
 
 }  // end namespace OPENSUBDIV_VERSION
 using namespace OPENSUBDIV_VERSION;
@@ -0,0 +1,622 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+
+#ifndef OSD_CPU_KERNEL_COMMON_H
+#define OSD_CPU_KERNEL_COMMON_H
+
+#include "../version.h"
+
+#include "../far/subdivisionTables.h"
+#include "../osd/cpuKernel.h"
+#include "../osd/vertex.h"
+#include "../osd/vertexDescriptor.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OSD_CPU_HAS_STREAMING_STORES
+#endif
+
+// GCC and clang compile the kernel entry points for several x86 instruction
+// sets with the target attribute : the rules must be inlined in the entry
+// points to be compiled for these instruction sets too.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define OSD_CPU_HAS_TARGET_ATTRIBUTE
+#define OSD_CPU_INLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define OSD_CPU_INLINE __forceinline
+#else
+#define OSD_CPU_INLINE inline
+#endif
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+//
+// Per-vertex subdivision rules shared by the CPU and OMP kernels.
+//
+// The rules are templated on the scalar type T of the buffers, on the type
+// ACC their vertices are accumulated in (see OsdPrecision) and on the number
+// of vertex elements : the kernels dispatch the most common primvar widths
+// (including positions interleaved with 2 to 4 motion samples) to
+// specializations where the element loops have a compile-time trip count and accumulate into a local
+// vertex, which lets the compiler unroll and vectorize them. NUM_ELEMENTS=0 is
+// the generic fallback that uses the width from the vertex descriptor.
+//
+// The rules are always inlined in the kernel entry points of cpuKernel.cpp,
+// which are compiled once per instruction set (see OsdCpuKernels) : the
+// element loops are vectorized for each of them and the widest one supported
+// by the processor is selected at run time.
+//
+// Every rule accumulates its output vertex (and varying) locally and writes
+// it to the buffer exactly once. Kernel batches writing more data than the
+// last level cache (see OsdCpuSetNonTemporalStoreThreshold) write their
+// vertices with non-temporal stores, so that the finest level does not evict
+// the coarser levels it reads from the cache.
+//
+
+// Expands to a switch calling FUNC<N, T, ACC> ARGS for each of the
+// specialized vertex widths and FUNC<0, T, ACC> ARGS for any other width.
+#define OSD_CPU_DISPATCH_NUM_ELEMENTS(numElements, FUNC, T, ACC, ARGS) \
+    switch (numElements) {                                             \
+        case 3  : FUNC<3,  T, ACC> ARGS; break;                        \
+        case 4  : FUNC<4,  T, ACC> ARGS; break;                        \
+        case 6  : FUNC<6,  T, ACC> ARGS; break;                        \
+        case 8  : FUNC<8,  T, ACC> ARGS; break;                        \
+        case 9  : FUNC<9,  T, ACC> ARGS; break;                        \
+        case 12 : FUNC<12, T, ACC> ARGS; break;                        \
+        case 16 : FUNC<16, T, ACC> ARGS; break;                        \
+        default : FUNC<0,  T, ACC> ARGS; break;                        \
+    }
+
+// Expands to OSD_CPU_DISPATCH_NUM_ELEMENTS with the scalar and accumulation
+// types of the precision.
+#define OSD_CPU_DISPATCH(precision, numElements, FUNC, ARGS)                          \
+    switch (precision) {                                                              \
+        case OSD_PRECISION_DOUBLE :                                                   \
+            OSD_CPU_DISPATCH_NUM_ELEMENTS(numElements, FUNC, double, double, ARGS);   \
+            break;                                                                    \
+        case OSD_PRECISION_MIXED :                                                    \
+            OSD_CPU_DISPATCH_NUM_ELEMENTS(numElements, FUNC, float, double, ARGS);    \
+            break;                                                                    \
+        default :                                                                     \
+            OSD_CPU_DISPATCH_NUM_ELEMENTS(numElements, FUNC, float, float, ARGS);     \
+            break;                                                                    \
+    }
+
+// Kernel entry points compiled for one instruction set : they compute the
+// vertices [start, end) of a kernel batch, with non-temporal stores if
+// 'nonTemporal' (see OsdCpuUseNonTemporalStores).
+struct OsdCpuKernels {
+
+    void (*computeFace)(const OsdVertexDescriptor *vdesc, void *vertex, void *varying,
+                        const int *F_IT, const int *F_ITa,
+                        int offset, int start, int end, bool nonTemporal);
+
+    void (*computeEdge)(const OsdVertexDescriptor *vdesc, void *vertex, void *varying,
+                        const int *E_IT, const float *E_W,
+                        int offset, int start, int end, bool nonTemporal);
+
+    void (*computeVertex)(const OsdVertexDescriptor *vdesc, void *vertex, void *varying,
+                          const int *V_ITa, const int *V_IT, const float *V_W,
+                          const unsigned char *V_R,
+                          int offset, int start, int end, bool nonTemporal);
+
+    void (*computeLoopVertex)(const OsdVertexDescriptor *vdesc, void *vertex, void *varying,
+                              const int *V_ITa, const int *V_IT, const float *V_W,
+                              const unsigned char *V_R,
+                              int offset, int start, int end, bool nonTemporal);
+
+    void (*computeBilinearEdge)(const OsdVertexDescriptor *vdesc, void *vertex, void *varying,
+                                const int *E_IT,
+                                int offset, int start, int end, bool nonTemporal);
+
+    void (*computeBilinearVertex)(const OsdVertexDescriptor *vdesc, void *vertex, void *varying,
+                                  const int *V_ITa,
+                                  int offset, int start, int end, bool nonTemporal);
+
+    void (*computeStencils)(void *buffer, int numElements, int stride,
+                            OsdPrecision precision,
+                            const int *sizes, const int *offsets,
+                            const int *indices, const float *weights,
+                            int offset, int start, int end, bool nonTemporal);
+};
+
+// Returns the kernels of the selected instruction set (see
+// OsdCpuSetInstructionSet)
+OsdCpuKernels const & OsdCpuGetKernels();
+
+// Largest width accumulated locally by the generic accumulator : wider
+// vertices are accumulated in place in the destination buffer, with the
+// precision of the buffer.
+#define OSD_CPU_MAX_LOCAL_ELEMENTS 64
+
+// Returns true if a kernel batch writing numVertices vertices should use
+// non-temporal stores
+inline bool
+OsdCpuUseNonTemporalStores(int numVertices, int numElements, int scalarSize) {
+#ifdef OSD_CPU_HAS_STREAMING_STORES
+    return numVertices > 0 and
+        size_t(numVertices) * size_t(numElements) * size_t(scalarSize) >
+        OsdCpuGetNonTemporalStoreThreshold();
+#else
+    return false;
+#endif
+}
+
+inline bool
+OsdCpuUseNonTemporalStores(const OsdVertexDescriptor *vdesc, int numVertices) {
+    return OsdCpuUseNonTemporalStores(numVertices,
+        vdesc->numVertexElements + vdesc->numVaryingElements,
+        OsdGetScalarSize(vdesc->precision));
+}
+
+// Converts n scalars to the type of the buffer and writes them bypassing
+// the caches
+template <class T, class ACC> OSD_CPU_INLINE void
+OsdCpuStreamStore(T *dst, const ACC *src, int n) {
+#ifdef OSD_CPU_HAS_STREAMING_STORES
+    const int numWords = sizeof(T) / sizeof(int);
+    int *words = reinterpret_cast<int *>(dst);
+    for (int i = 0; i < n; ++i) {
+        T value = static_cast<T>(src[i]);
+        int bits[sizeof(T) / sizeof(int)];
+        memcpy(bits, &value, sizeof(T));
+        for (int j = 0; j < numWords; ++j)
+            _mm_stream_si32(words + i*numWords + j, bits[j]);
+    }
+#else
+    for (int i = 0; i < n; ++i)
+        dst[i] = static_cast<T>(src[i]);
+#endif
+}
+
+inline float
+OsdCpuCos(float x) {
+    return cosf(x);
+}
+
+inline double
+OsdCpuCos(double x) {
+    return cos(x);
+}
+
+// Orders the non-temporal stores of the calling thread before any later
+// store : must be called by each thread at the end of a streaming batch.
+inline void
+OsdCpuStoreFence() {
+#ifdef OSD_CPU_HAS_STREAMING_STORES
+    _mm_sfence();
+#endif
+}
+
+// Vertex accumulator : accumulates the vertex 'index' of a buffer of T in a
+// local array of ACC and writes it once in Store(). The vertices of the
+// buffer are 'stride' elements apart.
+template <int NUM_ELEMENTS, class T, class ACC> class OsdCpuVertexAccumulator {
+public:
+    OsdCpuVertexAccumulator(T *buffer, int index, int /* numElements */,
+                            int stride, bool nonTemporal) :
+        _dst(buffer + index*stride), _stride(stride),
+        _nonTemporal(nonTemporal) { }
+
+    OSD_CPU_INLINE void Clear() {
+        for (int i = 0; i < NUM_ELEMENTS; ++i)
+            _data[i] = ACC(0);
+    }
+
+    OSD_CPU_INLINE void AddWithWeight(const T *buffer, int index, ACC weight) {
+        const T *src = buffer + index*_stride;
+        for (int i = 0; i < NUM_ELEMENTS; ++i)
+            _data[i] += src[i] * weight;
+    }
+
+    OSD_CPU_INLINE void Store() {
+        if (_nonTemporal) {
+            OsdCpuStreamStore(_dst, _data, NUM_ELEMENTS);
+        } else {
+            for (int i = 0; i < NUM_ELEMENTS; ++i)
+                _dst[i] = static_cast<T>(_data[i]);
+        }
+    }
+
+private:
+    ACC _data[NUM_ELEMENTS];
+    T *_dst;
+    int _stride;
+    bool _nonTemporal;
+};
+
+// Generic width : the width comes from the descriptor and the buffer may be
+// null (no varying data).
+template <class T, class ACC> class OsdCpuVertexAccumulator<0, T, ACC> {
+public:
+    OsdCpuVertexAccumulator(T *buffer, int index, int numElements,
+                            int stride, bool nonTemporal) :
+        _dst(buffer ? buffer + index*stride : 0),
+        _numElements(buffer ? numElements : 0),
+        _stride(stride),
+        _local(_numElements <= OSD_CPU_MAX_LOCAL_ELEMENTS),
+        _nonTemporal(nonTemporal) { }
+
+    OSD_CPU_INLINE void Clear() {
+        if (_local) {
+            for (int i = 0; i < _numElements; ++i)
+                _data[i] = ACC(0);
+        } else {
+            for (int i = 0; i < _numElements; ++i)
+                _dst[i] = T(0);
+        }
+    }
+
+    OSD_CPU_INLINE void AddWithWeight(const T *buffer, int index, ACC weight) {
+        const T *src = buffer + index*_stride;
+        if (_local) {
+            for (int i = 0; i < _numElements; ++i)
+                _data[i] += src[i] * weight;
+        } else {
+            for (int i = 0; i < _numElements; ++i)
+                _dst[i] = static_cast<T>(_dst[i] + src[i] * weight);
+        }
+    }
+
+    OSD_CPU_INLINE void Store() {
+        if (not _local) {
+            return;
+        } else if (_nonTemporal) {
+            OsdCpuStreamStore(_dst, _data, _numElements);
+        } else {
+            for (int i = 0; i < _numElements; ++i)
+                _dst[i] = static_cast<T>(_data[i]);
+        }
+    }
+
+private:
+    ACC _data[OSD_CPU_MAX_LOCAL_ELEMENTS];
+    T *_dst;
+    int _numElements,
+        _stride;
+    bool _local,
+         _nonTemporal;
+};
+
+template <int NUM_ELEMENTS, class T, class ACC> OSD_CPU_INLINE void
+OsdCpuComputeFaceVertex(const OsdVertexDescriptor *vdesc,
+                        T *vertex, T *varying,
+                        const int *F_IT, const int *F_ITa,
+                        int offset, int i, bool nonTemporal) {
+
+    const int numElements = NUM_ELEMENTS ? NUM_ELEMENTS : vdesc->numVertexElements;
+
+    int h = F_ITa[2*i];
+    int n = F_ITa[2*i+1];
+
+    ACC weight = ACC(1)/n;
+
+    int dstIndex = offset + i;
+
+    OsdCpuVertexAccumulator<NUM_ELEMENTS, T, ACC> dst(vertex, dstIndex, numElements,
+                                                      vdesc->vertexStride, nonTemporal);
+    OsdCpuVertexAccumulator<0, T, ACC> dstVarying(varying, dstIndex, vdesc->numVaryingElements,
+                                                  vdesc->varyingStride, nonTemporal);
+    dst.Clear();
+    dstVarying.Clear();
+
+    for (int j = 0; j < n; ++j) {
+        int index = F_IT[h+j];
+        dst.AddWithWeight(vertex, index, weight);
+        dstVarying.AddWithWeight(varying, index, weight);
+    }
+    dst.Store();
+    dstVarying.Store();
+}
+
+template <int NUM_ELEMENTS, class T, class ACC> OSD_CPU_INLINE void
+OsdCpuComputeEdgeVertex(const OsdVertexDescriptor *vdesc,
+                        T *vertex, T *varying,
+                        const int *E_IT, const float *E_W,
+                        int offset, int i, bool nonTemporal) {
+
+    const int numElements = NUM_ELEMENTS ? NUM_ELEMENTS : vdesc->numVertexElements;
+
+    int eidx0 = E_IT[4*i+0];
+    int eidx1 = E_IT[4*i+1];
+    int eidx2 = E_IT[4*i+2];
+    int eidx3 = E_IT[4*i+3];
+
+    ACC vertWeight = E_W[i*2+0];
+
+    int dstIndex = offset + i;
+
+    OsdCpuVertexAccumulator<NUM_ELEMENTS, T, ACC> dst(vertex, dstIndex, numElements,
+                                                      vdesc->vertexStride, nonTemporal);
+    dst.Clear();
+
+    dst.AddWithWeight(vertex, eidx0, vertWeight);
+    dst.AddWithWeight(vertex, eidx1, vertWeight);
+
+    if (eidx2 != -1) {
+        ACC faceWeight = E_W[i*2+1];
+
+        dst.AddWithWeight(vertex, eidx2, faceWeight);
+        dst.AddWithWeight(vertex, eidx3, faceWeight);
+    }
+    dst.Store();
+
+    OsdCpuVertexAccumulator<0, T, ACC> dstVarying(varying, dstIndex, vdesc->numVaryingElements,
+                                                  vdesc->varyingStride, nonTemporal);
+    dstVarying.Clear();
+    dstVarying.AddWithWeight(varying, eidx0, ACC(0.5));
+    dstVarying.AddWithWeight(varying, eidx1, ACC(0.5));
+    dstVarying.Store();
+}
+
+// Accumulates the k_Crease / k_Corner part of the rule of a vertex-vertex
+// (see FarSubdivisionTables<U>::VertexRule)
+template <int NUM_ELEMENTS, class T, class ACC> OSD_CPU_INLINE void
+OsdCpuAddSharpVertexRule(OsdCpuVertexAccumulator<NUM_ELEMENTS, T, ACC> &dst,
+                         const T *vertex, unsigned char rule, ACC weight,
+                         int p, int eidx0, int eidx1) {
+
+    typedef FarSubdivisionTables<OsdVertex> Tables;
+
+    switch (rule) {
+        case Tables::k_RuleSmoothCorner :
+            dst.AddWithWeight(vertex, p, ACC(1) - weight);
+            break;
+        case Tables::k_RuleSmoothCrease : {
+            ACC w = ACC(1) - weight;
+            dst.AddWithWeight(vertex, p, w * ACC(0.75));
+            dst.AddWithWeight(vertex, eidx0, w * ACC(0.125));
+            dst.AddWithWeight(vertex, eidx1, w * ACC(0.125));
+        } break;
+        case Tables::k_RuleCreaseCorner :
+            dst.AddWithWeight(vertex, p, ACC(1) - weight);
+            dst.AddWithWeight(vertex, p, weight * ACC(0.75));
+            dst.AddWithWeight(vertex, eidx0, weight * ACC(0.125));
+            dst.AddWithWeight(vertex, eidx1, weight * ACC(0.125));
+            break;
+        case Tables::k_RuleCorner :
+            dst.AddWithWeight(vertex, p, ACC(1));
+            break;
+        case Tables::k_RuleCrease :
+            dst.AddWithWeight(vertex, p, ACC(0.75));
+            dst.AddWithWeight(vertex, eidx0, ACC(0.125));
+            dst.AddWithWeight(vertex, eidx1, ACC(0.125));
+            break;
+        default : break;
+    }
+}
+
+// Copies the varying data of the parent vertex p
+template <class T, class ACC> OSD_CPU_INLINE void
+OsdCpuCopyVaryingVertex(const OsdVertexDescriptor *vdesc, T *varying,
+                        int dstIndex, int p, bool nonTemporal) {
+
+    OsdCpuVertexAccumulator<0, T, ACC> dstVarying(varying, dstIndex, vdesc->numVaryingElements,
+                                                  vdesc->varyingStride, nonTemporal);
+    dstVarying.Clear();
+    dstVarying.AddWithWeight(varying, p, ACC(1));
+    dstVarying.Store();
+}
+
+// Fused Catmark vertex-vertex : applies the rule of the vertex in a single
+// pass, with the same sequence of operations as the "B" and "A" kernels.
+template <int NUM_ELEMENTS, class T, class ACC> OSD_CPU_INLINE void
+OsdCpuComputeVertexVertex(const OsdVertexDescriptor *vdesc,
+                          T *vertex, T *varying,
+                          const int *V_ITa, const int *V_IT, const float *V_W,
+                          const unsigned char *V_R, int offset, int i,
+                          bool nonTemporal) {
+
+    const int numElements = NUM_ELEMENTS ? NUM_ELEMENTS : vdesc->numVertexElements;
+
+    int h     = V_ITa[5*i];
+    int n     = V_ITa[5*i+1];
+    int p     = V_ITa[5*i+2];
+    int eidx0 = V_ITa[5*i+3];
+    int eidx1 = V_ITa[5*i+4];
+
+    unsigned char rule = V_R[i];
+    ACC weight = V_W[i];
+
+    int dstIndex = offset + i;
+
+    OsdCpuVertexAccumulator<NUM_ELEMENTS, T, ACC> dst(vertex, dstIndex, numElements,
+                                                      vdesc->vertexStride, nonTemporal);
+    dst.Clear();
+
+    if (rule <= FarSubdivisionTables<OsdVertex>::k_RuleSmoothCrease) {
+        ACC wp = ACC(1)/static_cast<ACC>(n*n);
+        ACC wv = (n-ACC(2)) * n * wp;
+
+        dst.AddWithWeight(vertex, p, weight * wv);
+
+        for (int j = 0; j < n; ++j) {
+            dst.AddWithWeight(vertex, V_IT[h+j*2], weight * wp);
+            dst.AddWithWeight(vertex, V_IT[h+j*2+1], weight * wp);
+        }
+    }
+
+    OsdCpuAddSharpVertexRule<NUM_ELEMENTS, T, ACC>(dst, vertex, rule, weight, p, eidx0, eidx1);
+    dst.Store();
+
+    OsdCpuCopyVaryingVertex<T, ACC>(vdesc, varying, dstIndex, p, nonTemporal);
+}
+
+// Fused Loop vertex-vertex
+template <int NUM_ELEMENTS, class T, class ACC> OSD_CPU_INLINE void
+OsdCpuComputeLoopVertexVertex(const OsdVertexDescriptor *vdesc,
+                              T *vertex, T *varying,
+                              const int *V_ITa, const int *V_IT, const float *V_W,
+                              const unsigned char *V_R, int offset, int i,
+                              bool nonTemporal) {
+
+    const int numElements = NUM_ELEMENTS ? NUM_ELEMENTS : vdesc->numVertexElements;
+
+    int h     = V_ITa[5*i];
+    int n     = V_ITa[5*i+1];
+    int p     = V_ITa[5*i+2];
+    int eidx0 = V_ITa[5*i+3];
+    int eidx1 = V_ITa[5*i+4];
+
+    unsigned char rule = V_R[i];
+    ACC weight = V_W[i];
+
+    int dstIndex = offset + i;
+
+    OsdCpuVertexAccumulator<NUM_ELEMENTS, T, ACC> dst(vertex, dstIndex, numElements,
+                                                      vdesc->vertexStride, nonTemporal);
+    dst.Clear();
+
+    if (rule <= FarSubdivisionTables<OsdVertex>::k_RuleSmoothCrease) {
+        ACC wp = ACC(1)/static_cast<ACC>(n);
+        ACC beta = ACC(0.25) * OsdCpuCos(static_cast<ACC>(M_PI) * ACC(2) * wp) + ACC(0.375);
+        beta = beta * beta;
+        beta = (ACC(0.625) - beta) * wp;
+
+        dst.AddWithWeight(vertex, p, weight * (ACC(1) - (beta * n)));
+
+        for (int j = 0; j < n; ++j)
+            dst.AddWithWeight(vertex, V_IT[h+j], weight * beta);
+    }
+
+    OsdCpuAddSharpVertexRule<NUM_ELEMENTS, T, ACC>(dst, vertex, rule, weight, p, eidx0, eidx1);
+    dst.Store();
+
+    OsdCpuCopyVaryingVertex<T, ACC>(vdesc, varying, dstIndex, p, nonTemporal);
+}
+
+template <int NUM_ELEMENTS, class T, class ACC> OSD_CPU_INLINE void
+OsdCpuComputeBilinearEdgeVertex(const OsdVertexDescriptor *vdesc,
+                                T *vertex, T *varying,
+                                const int *E_IT, int offset, int i,
+                                bool nonTemporal) {
+
+    const int numElements = NUM_ELEMENTS ? NUM_ELEMENTS : vdesc->numVertexElements;
+
+    int eidx0 = E_IT[2*i+0];
+    int eidx1 = E_IT[2*i+1];
+
+    int dstIndex = offset + i;
+
+    OsdCpuVertexAccumulator<NUM_ELEMENTS, T, ACC> dst(vertex, dstIndex, numElements,
+                                                      vdesc->vertexStride, nonTemporal);
+    dst.Clear();
+
+    dst.AddWithWeight(vertex, eidx0, ACC(0.5));
+    dst.AddWithWeight(vertex, eidx1, ACC(0.5));
+    dst.Store();
+
+    OsdCpuVertexAccumulator<0, T, ACC> dstVarying(varying, dstIndex, vdesc->numVaryingElements,
+                                                  vdesc->varyingStride, nonTemporal);
+    dstVarying.Clear();
+    dstVarying.AddWithWeight(varying, eidx0, ACC(0.5));
+    dstVarying.AddWithWeight(varying, eidx1, ACC(0.5));
+    dstVarying.Store();
+}
+
+template <int NUM_ELEMENTS, class T, class ACC> OSD_CPU_INLINE void
+OsdCpuComputeBilinearVertexVertex(const OsdVertexDescriptor *vdesc,
+                                  T *vertex, T *varying,
+                                  const int *V_ITa, int offset, int i,
+                                  bool nonTemporal) {
+
+    const int numElements = NUM_ELEMENTS ? NUM_ELEMENTS : vdesc->numVertexElements;
+
+    int p = V_ITa[i];
+
+    int dstIndex = offset + i;
+
+    OsdCpuVertexAccumulator<NUM_ELEMENTS, T, ACC> dst(vertex, dstIndex, numElements,
+                                                      vdesc->vertexStride, nonTemporal);
+    dst.Clear();
+
+    dst.AddWithWeight(vertex, p, ACC(1));
+    dst.Store();
+
+    OsdCpuCopyVaryingVertex<T, ACC>(vdesc, varying, dstIndex, p, nonTemporal);
+}
+
+template <int NUM_ELEMENTS, class T, class ACC> OSD_CPU_INLINE void
+OsdCpuComputeStencilVertex(T *buffer, int numElements, int stride,
+                           const int *sizes, const int *offsets,
+                           const int *indices, const float *weights,
+                           int offset, int i, bool nonTemporal) {
+
+    numElements = NUM_ELEMENTS ? NUM_ELEMENTS : numElements;
+
+    OsdCpuVertexAccumulator<NUM_ELEMENTS, T, ACC> dst(buffer, offset+i, numElements,
+                                                      stride, nonTemporal);
+    dst.Clear();
+
+    const int *index = indices + offsets[i];
+    const float *weight = weights + offsets[i];
+
+    for (int j = 0; j < sizes[i]; ++j)
+        dst.AddWithWeight(buffer, index[j], weight[j]);
+    dst.Store();
+}
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // OSD_CPU_KERNEL_COMMON_H
@@ -57,54 +57,157 @@
 
 #include "../osd/cpuVertexBuffer.h"
 
+#include <stdlib.h>
 #include <string.h>
 
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
-OsdCpuVertexBuffer::OsdCpuVertexBuffer(int numElements, int numVertices)
+// Allocates size bytes aligned on 'alignment' (a power of two multiple of
+// sizeof(void*)). Returns NULL if error.
+static void *
+alignedAlloc(size_t size, size_t alignment) {
+
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    void *ptr = NULL;
+    if (posix_memalign(&ptr, alignment, size) != 0)
+        return NULL;
+    return ptr;
+#endif
+}
+
+static void
+alignedFree(void *ptr) {
+
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+template <class T>
+OsdCpuScalarVertexBuffer<T>::OsdCpuScalarVertexBuffer(int numElements, int numDataElements,
+                                                       int numVertices, T *buffer, bool owner)
     : _numElements(numElements),
+      _numDataElements(numDataElements),
       _numVertices(numVertices),
-      _cpuBuffer(NULL) {
+      _cpuBuffer(buffer),
+      _owner(owner) {
+}
+
+template <class T>
+OsdCpuScalarVertexBuffer<T>::~OsdCpuScalarVertexBuffer() {
+
+    if (_owner)
+        alignedFree(_cpuBuffer);
+}
+
+template <class T> OsdCpuScalarVertexBuffer<T> *
+OsdCpuScalarVertexBuffer<T>::Create(int numElements, int numVertices, int flags) {
+
+    if (numElements <= 0 or numVertices < 0)
+        return NULL;
 
-    _cpuBuffer = new float[numElements * numVertices];
+    int numPaddedElements = numElements;
+    if (flags & k_PadVertices) {
+        int simdElements = k_SimdWidth / sizeof(T);
+        numPaddedElements = (numElements + simdElements - 1) / simdElements * simdElements;
+    }
+
+    size_t size = size_t(numPaddedElements) * size_t(numVertices) * sizeof(T),
+           alignment = k_Alignment;
+
+    if (flags & k_HugePages) {
+        // whole pages, so that the last page of the buffer is not shared
+        // with other allocations
+        alignment = k_HugePageSize;
+        size = (size + alignment - 1) / alignment * alignment;
+    }
+
+    T *buffer = (T *)alignedAlloc(size ? size : alignment, alignment);
+    if (not buffer)
+        return NULL;
+
+#ifdef MADV_HUGEPAGE
+    if (flags & k_HugePages)
+        madvise(buffer, size, MADV_HUGEPAGE);
+#endif
+
+    return new OsdCpuScalarVertexBuffer<T>(numPaddedElements, numElements,
+                                           numVertices, buffer, true);
 }
 
-OsdCpuVertexBuffer::~OsdCpuVertexBuffer() {
+template <class T> OsdCpuScalarVertexBuffer<T> *
+OsdCpuScalarVertexBuffer<T>::Wrap(T *buffer, int numElements, int numVertices) {
+
+    if (not buffer or numElements <= 0 or numVertices < 0)
+        return NULL;
 
-    delete[] _cpuBuffer;
+    return new OsdCpuScalarVertexBuffer<T>(numElements, numElements,
+                                           numVertices, buffer, false);
 }
 
-OsdCpuVertexBuffer *
-OsdCpuVertexBuffer::Create(int numElements, int numVertices) {
+template <class T> void
+OsdCpuScalarVertexBuffer<T>::UpdateData(const T *src, int numVertices) {
 
-    return new OsdCpuVertexBuffer(numElements, numVertices);
+    if (src != _cpuBuffer)
+        UpdateData(src, numVertices, _numDataElements);
 }
 
-void
-OsdCpuVertexBuffer::UpdateData(const float *src, int numVertices) {
+template <class T> void
+OsdCpuScalarVertexBuffer<T>::UpdateData(const T *src, int numVertices, int srcNumElements) {
 
-    memcpy(_cpuBuffer, src, GetNumElements() * numVertices * sizeof(float));
+    if (srcNumElements == _numElements) {
+        memcpy(_cpuBuffer, src, _numElements * numVertices * sizeof(T));
+        return;
+    }
+
+    int numElements = srcNumElements < _numElements ? srcNumElements : _numElements;
+
+    T *dst = _cpuBuffer;
+    for (int i = 0; i < numVertices; ++i, src += srcNumElements, dst += _numElements) {
+        memcpy(dst, src, numElements * sizeof(T));
+        for (int j = numElements; j < _numElements; ++j)
+            dst[j] = T(0);
+    }
 }
 
-int
-OsdCpuVertexBuffer::GetNumElements() const {
+template <class T> int
+OsdCpuScalarVertexBuffer<T>::GetNumElements() const {
 
     return _numElements;
 }
 
-int
-OsdCpuVertexBuffer::GetNumVertices() const {
+template <class T> int
+OsdCpuScalarVertexBuffer<T>::GetNumVertices() const {
 
     return _numVertices;
 }
 
-float*
-OsdCpuVertexBuffer::BindCpuBuffer() {
+template <class T> bool
+OsdCpuScalarVertexBuffer<T>::IsOwner() const {
+
+    return _owner;
+}
+
+template <class T> T *
+OsdCpuScalarVertexBuffer<T>::BindCpuBuffer() {
 
     return _cpuBuffer;
 }
 
+template class OsdCpuScalarVertexBuffer<float>;
+template class OsdCpuScalarVertexBuffer<double>;
+
 }  // end namespace OPENSUBDIV_VERSION
 }  // end namespace OpenSubdiv
 
@@ -59,23 +59,69 @@
 
 #include "../version.h"
 
+#include "../osd/nonCopyable.h"
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
 /// \brief Concrete vertex buffer class for cpu subvision.
 /// OsdCpuVertexBuffer implements OsdCudaVertexBufferInterface. An instance
 /// of this buffer class can be passed to OsdCpuComputeController
-class OsdCpuVertexBuffer {
+///
+/// The buffer is templated on the scalar type of its elements :
+/// OsdCpuVertexBuffer holds floats and OsdCpuDoubleVertexBuffer holds doubles,
+/// which the CPU kernels refine in double precision.
+///
+/// The buffers created by Create() are aligned on k_Alignment bytes (or on
+/// huge pages, see AllocationFlags). Wrap() creates a buffer on memory owned
+/// by the client, which the controllers then refine in place.
+template <class T>
+class OsdCpuScalarVertexBuffer : OsdNonCopyable< OsdCpuScalarVertexBuffer<T> > {
 public:
+    enum {
+        k_Alignment    = 64,            ///< alignment of the allocated buffers
+        k_SimdWidth    = 16,            ///< vertex stride multiple (bytes) of k_PadVertices
+        k_HugePageSize = 2*1024*1024    ///< huge page size of k_HugePages
+    };
+
+    /// Allocation flags of Create()
+    enum AllocationFlags {
+        k_PadVertices = 1, ///< pads the vertices to a multiple of k_SimdWidth bytes :
+                           ///< GetNumElements() returns the padded width and the
+                           ///< padding elements are refined as zeros.
+        k_HugePages   = 2  ///< aligns the buffer on huge pages and asks the system
+                           ///< to back it with them (transparent huge pages on Linux,
+                           ///< ignored elsewhere).
+    };
+
     /// Creator. Returns NULL if error.
-    static OsdCpuVertexBuffer * Create(int numElements, int numVertices);
+    static OsdCpuScalarVertexBuffer * Create(int numElements, int numVertices,
+                                             int flags=0);
+
+    /// Creates a buffer refining the numVertices vertices of numElements
+    /// elements at 'buffer' in place. The buffer does not take the ownership
+    /// of the memory, which must outlive it. Returns NULL if error.
+    ///
+    /// numElements is the distance between the vertices : to refine some of
+    /// the elements of interleaved client vertices, wrap the whole vertices
+    /// and select the elements with the OsdVertexBufferDescriptor arguments
+    /// of the controllers (or of OsdCpuComputeContext::Bind).
+    static OsdCpuScalarVertexBuffer * Wrap(T *buffer, int numElements, int numVertices);
 
     /// Destructor.
-    ~OsdCpuVertexBuffer();
+    ~OsdCpuScalarVertexBuffer();
 
     /// This method is meant to be used in client code in order to provide
-    /// coarse vertices data to Osd.
-    void UpdateData(const float *src, int numVertices);
+    /// coarse vertices data to Osd. The vertices of 'src' are the numElements
+    /// elements given to Create() apart (ie. not padded, see k_PadVertices) ;
+    /// the copy is skipped if 'src' is the buffer itself (ex. coarse vertices
+    /// written directly in a wrapped buffer).
+    void UpdateData(const T *src, int numVertices);
+
+    /// Copies coarse vertices of srcNumElements elements (ex. unpadded
+    /// vertices to a padded buffer). The elements past srcNumElements are
+    /// cleared.
+    void UpdateData(const T *src, int numVertices, int srcNumElements);
 
     /// Returns how many elements defined in this vertex buffer.
     int GetNumElements() const;
@@ -83,19 +129,28 @@ public:
     /// Returns how many vertices allocated in this vertex buffer.
     int GetNumVertices() const;
 
+    /// Returns true if the buffer owns its memory (ie. was not wrapped)
+    bool IsOwner() const;
+
     /// Returns the address of CPU buffer
-    float * BindCpuBuffer();
+    T * BindCpuBuffer();
 
 protected:
     /// Constructor.
-    OsdCpuVertexBuffer(int numElements, int numVertices);
+    OsdCpuScalarVertexBuffer(int numElements, int numDataElements,
+                             int numVertices, T *buffer, bool owner);
 
 private:
     int _numElements;
+    int _numDataElements;   // elements of the client vertices (not padded)
     int _numVertices;
-    float *_cpuBuffer;
+    T *_cpuBuffer;
+    bool _owner;
 };
 
+typedef OsdCpuScalarVertexBuffer<float> OsdCpuVertexBuffer;
+
+typedef OsdCpuScalarVertexBuffer<double> OsdCpuDoubleVertexBuffer;
 
 }  // end namespace OPENSUBDIV_VERSION
 using namespace OPENSUBDIV_VERSION;
@@ -241,6 +241,14 @@ OsdCudaKernelDispatcher::ApplyCatmarkEdgeVerticesKernel(
         offset, start, end);
 }
 
+void
+OsdCudaKernelDispatcher::ApplyCatmarkVertexVerticesKernel(
+    FarMesh<OsdVertex> * mesh, int offset, int level,
+    int start, int end, void * clientdata) const {
+
+    ApplyCatmarkVertexVerticesMultiPass(mesh, offset, level, clientdata);
+}
+
 void
 OsdCudaKernelDispatcher::ApplyCatmarkVertexVerticesKernelB(
     FarMesh<OsdVertex> * mesh, int offset, int level,
@@ -316,6 +324,14 @@ OsdCudaKernelDispatcher::ApplyLoopEdgeVerticesKernel(
         offset, start, end);
 }
 
+void
+OsdCudaKernelDispatcher::ApplyLoopVertexVerticesKernel(
+    FarMesh<OsdVertex> * mesh, int offset, int level,
+    int start, int end, void * clientdata) const {
+
+    ApplyLoopVertexVerticesMultiPass(mesh, offset, level, clientdata);
+}
+
 void
 OsdCudaKernelDispatcher::ApplyLoopVertexVerticesKernelB(
     FarMesh<OsdVertex> * mesh, int offset, int level,
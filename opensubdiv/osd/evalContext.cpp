@@ -0,0 +1,849 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+
+#include "../osd/evalContext.h"
+#include "../osd/error.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+// Ring position of the 4 corners of the patch face, for each patch type
+// (see FarPatchTablesFactory::getOneRing)
+static const int cornerCVs[5][4] = { { 5, 6, 10, 9 },   // regular
+                                     { 1, 2,  6, 5 },   // boundary
+                                     { 1, 2,  5, 4 },   // corner
+                                     { 0, 1,  2, 3 },   // gregory
+                                     { 0, 1,  2, 3 } }; // boundary gregory
+
+static const float PI = 3.14159265358979f;
+
+OsdEvalContext::OsdEvalContext(FarPatchTables const *patchTables) :
+    _patchTables(patchTables), _valenceStride(2*patchTables->GetMaxValence()+1) {
+
+    FarPatchTables::QuadOffsetTable const & quadOffsets =
+        patchTables->GetQuadOffsetTable();
+
+    unsigned int const * gregoryOffsets = quadOffsets.empty() ? 0 : &quadOffsets[0],
+                       * boundaryGregoryOffsets = gregoryOffsets ?
+                           gregoryOffsets + patchTables->GetFullGregoryPatches().GetSize() : 0;
+
+    addPatches(patchTables->GetFullRegularPatches(),
+               FarPatchTables::GetRegularPatchRingsize(),
+               patchTables->GetFullRegularPtexCoordinates(), kRegular, 0);
+
+    addPatches(patchTables->GetFullBoundaryPatches(),
+               FarPatchTables::GetBoundaryPatchRingsize(),
+               patchTables->GetFullBoundaryPtexCoordinates(), kBoundary, 0);
+
+    addPatches(patchTables->GetFullCornerPatches(),
+               FarPatchTables::GetCornerPatchRingsize(),
+               patchTables->GetFullCornerPtexCoordinates(), kCorner, 0);
+
+    addPatches(patchTables->GetFullGregoryPatches(),
+               FarPatchTables::GetGregoryPatchRingsize(),
+               patchTables->GetFullGregoryPtexCoordinates(), kGregory,
+               gregoryOffsets);
+
+    addPatches(patchTables->GetFullBoundaryGregoryPatches(),
+               FarPatchTables::GetGregoryPatchRingsize(),
+               patchTables->GetFullBoundaryGregoryPtexCoordinates(), kBoundaryGregory,
+               boundaryGregoryOffsets);
+
+    // Transition patches only differ from full patches in the way they are
+    // tessellated : their limit surface is evaluated the same way.
+    for (unsigned char pattern=0; pattern<5; ++pattern) {
+
+        addPatches(patchTables->GetTransitionRegularPatches(pattern),
+                   FarPatchTables::GetRegularPatchRingsize(),
+                   patchTables->GetTransitionRegularPtexCoordinates(pattern), kRegular, 0);
+
+        for (unsigned char rot=0; rot<4; ++rot) {
+
+            addPatches(patchTables->GetTransitionBoundaryPatches(pattern, rot),
+                       FarPatchTables::GetBoundaryPatchRingsize(),
+                       patchTables->GetTransitionBoundaryPtexCoordinates(pattern, rot), kBoundary, 0);
+
+            addPatches(patchTables->GetTransitionCornerPatches(pattern, rot),
+                       FarPatchTables::GetCornerPatchRingsize(),
+                       patchTables->GetTransitionCornerPtexCoordinates(pattern, rot), kCorner, 0);
+        }
+    }
+
+    // Sort the patches by ptex face (stable counting sort)
+    int numFaces = 0;
+    for (int i=0; i<(int)_patches.size(); ++i)
+        if (_patches[i].face >= numFaces)
+            numFaces = _patches[i].face+1;
+
+    _faceOffsets.assign(numFaces+1, 0);
+    for (int i=0; i<(int)_patches.size(); ++i)
+        ++_faceOffsets[_patches[i].face+1];
+
+    for (int i=0; i<numFaces; ++i)
+        _faceOffsets[i+1] += _faceOffsets[i];
+
+    std::vector<int> cursors(_faceOffsets.begin(), _faceOffsets.end()-1);
+
+    std::vector<Patch> sorted(_patches.size());
+    for (int i=0; i<(int)_patches.size(); ++i)
+        sorted[cursors[_patches[i].face]++] = _patches[i];
+
+    _patches.swap(sorted);
+}
+
+OsdEvalContext::~OsdEvalContext() {
+}
+
+void
+OsdEvalContext::addPatches(FarPatchTables::PTable const & ptable, int ringsize,
+                           FarPatchTables::PtexCoordinateTable const & ptexCoords,
+                           PatchType type, unsigned int const * quadOffsets) {
+
+    if (ptable.IsEmpty())
+        return;
+
+    FarTableMarkers const & markers = ptable.GetMarkers();
+
+    for (int level=0, index=0; level<(int)markers.size()-1; ++level) {
+
+        int npatches = ptable.GetNumElements(level) / ringsize;
+
+        for (int i=0; i<npatches; ++i, ++index) {
+
+            int const * ptex = &ptexCoords[2*index];
+
+            Patch patch;
+            patch.cvs = ptable[0] + index*ringsize;
+            patch.quadOffsets = quadOffsets ? quadOffsets + index*4 : 0;
+            patch.face = ptex[0] >> 3;
+            patch.u = (unsigned short)((ptex[1] >> 16) & 0xffff);
+            patch.v = (unsigned short)(ptex[1] & 0xffff);
+            // sub-faces of non-quad coarse faces start one level down
+            patch.depth = (unsigned char)(level - (ptex[0] & 1));
+            patch.rotation = (unsigned char)((ptex[0] >> 1) & 0x3);
+            patch.type = (unsigned char)type;
+
+            _patches.push_back(patch);
+        }
+    }
+}
+
+OsdEvalContext::Patch const *
+OsdEvalContext::FindPatch(int face, float u, float v) const {
+
+    if (face<0 or face>=GetNumPtexFaces())
+        return 0;
+
+    u = u<0.0f ? 0.0f : (u>1.0f ? 1.0f : u);
+    v = v<0.0f ? 0.0f : (v>1.0f ? 1.0f : v);
+
+    for (int i=_faceOffsets[face]; i<_faceOffsets[face+1]; ++i) {
+
+        Patch const & patch = _patches[i];
+
+        float scale = (float)(1 << patch.depth),
+              pu = u*scale - patch.u,
+              pv = v*scale - patch.v;
+
+        if (pu>=0.0f and pu<=1.0f and pv>=0.0f and pv<=1.0f)
+            return &patch;
+    }
+    return 0;
+}
+
+// Cubic uniform B-spline basis functions and their derivatives
+static void
+getBSplineWeights(float t, float *B, float *D) {
+
+    float t2 = t*t, t3 = t2*t, s = 1.0f-t;
+
+    B[0] = s*s*s / 6.0f;
+    B[1] = (3.0f*t3 - 6.0f*t2 + 4.0f) / 6.0f;
+    B[2] = (-3.0f*t3 + 3.0f*t2 + 3.0f*t + 1.0f) / 6.0f;
+    B[3] = t3 / 6.0f;
+
+    D[0] = -0.5f*s*s;
+    D[1] = 1.5f*t2 - 2.0f*t;
+    D[2] = -1.5f*t2 + t + 0.5f;
+    D[3] = 0.5f*t2;
+}
+
+// Cubic Bernstein basis functions and their derivatives
+static void
+getBezierWeights(float t, float *B, float *D) {
+
+    float s = 1.0f-t;
+
+    B[0] = s*s*s;
+    B[1] = 3.0f*s*s*t;
+    B[2] = 3.0f*s*t*t;
+    B[3] = t*t*t;
+
+    D[0] = -3.0f*s*s;
+    D[1] = 3.0f*s*s - 6.0f*s*t;
+    D[2] = 6.0f*s*t - 3.0f*t*t;
+    D[3] = 3.0f*t*t;
+}
+
+// Folds the weights of a phantom row (or column) of control vertices, which
+// are extrapolated as P = 2*P1 - P2, into the 2 rows the points are mirrored
+// from.
+static void
+foldPhantom(float *w, int phantom, int p1, int p2) {
+
+    w[p1] += 2.0f*w[phantom];
+    w[p2] -= w[phantom];
+    w[phantom] = 0.0f;
+}
+
+// Computes the weights of the control vertices of B-spline patches at the
+// patch coordinates (s,t). Boundary and corner patches are evaluated as
+// regular patches with phantom control vertices mirrored across the
+// boundary edges.
+static void
+getBSplinePatchWeights(int type, float s, float t, float *w, float *ws, float *wt) {
+
+    float Bs[4], Ds[4], Bt[4], Dt[4];
+    getBSplineWeights(s, Bs, Ds);
+    getBSplineWeights(t, Bt, Dt);
+
+    float gw[16], gws[16], gwt[16];
+    for (int row=0; row<4; ++row) {
+        for (int col=0; col<4; ++col) {
+            gw [4*row+col] = Bt[row]*Bs[col];
+            gws[4*row+col] = Bt[row]*Ds[col];
+            gwt[4*row+col] = Dt[row]*Bs[col];
+        }
+    }
+
+    if (type==OsdEvalContext::kRegular) {
+        for (int i=0; i<16; ++i) {
+            w[i] = gw[i]; ws[i] = gws[i]; wt[i] = gwt[i];
+        }
+        return;
+    }
+
+    // boundary edge along the first row of the 4x4 grid
+    for (int col=0; col<4; ++col) {
+        foldPhantom(gw,  col, 4+col, 8+col);
+        foldPhantom(gws, col, 4+col, 8+col);
+        foldPhantom(gwt, col, 4+col, 8+col);
+    }
+
+    if (type==OsdEvalContext::kBoundary) {
+        // 3x4 ring of control vertices
+        for (int i=0; i<12; ++i) {
+            w[i] = gw[4+i]; ws[i] = gws[4+i]; wt[i] = gwt[4+i];
+        }
+        return;
+    }
+
+    // corner : second boundary edge along the last column of the grid
+    for (int row=1; row<4; ++row) {
+        foldPhantom(gw,  4*row+3, 4*row+2, 4*row+1);
+        foldPhantom(gws, 4*row+3, 4*row+2, 4*row+1);
+        foldPhantom(gwt, 4*row+3, 4*row+2, 4*row+1);
+    }
+
+    // 3x3 ring of control vertices
+    for (int row=0; row<3; ++row) {
+        for (int col=0; col<3; ++col) {
+            w [3*row+col] = gw [4*(row+1)+col];
+            ws[3*row+col] = gws[4*(row+1)+col];
+            wt[3*row+col] = gwt[4*(row+1)+col];
+        }
+    }
+}
+
+// Computes the weights of the 20 control points of a Gregory patch at the
+// patch coordinates (s,t). The control points are ordered per corner
+// vertex : P, Ep, Em, Fp, Fm (see glslPatchCommon.glsl).
+static void
+getGregoryPatchWeights(float s, float t, float *w, float *ws, float *wt) {
+
+    float Bs[4], Ds[4], Bt[4], Dt[4];
+    getBezierWeights(s, Bs, Ds);
+    getBezierWeights(t, Bt, Dt);
+
+    // control points of the Bezier grid on the boundary of the patch
+    static const int boundaryPoints[12][2] = { { 0,  0 }, { 1,  1 }, { 2,  7 },
+                                               { 3,  5 }, { 4,  2 }, { 7,  6 },
+                                               { 8, 16 }, {11, 12 }, {12, 15 },
+                                               {13, 17 }, {14, 11 }, {15, 10 } };
+
+    // interior points of the Bezier grid : each is a rational blend of 2
+    // face points q = (a*X + b*Y) / (a+b), where a and b are linear in s and t
+    // (grid index, X, Y, a = a0 + as*s, b = b0 + bt*t)
+    static const int interiorPoints[4][7] = { {  5,  3,  4, 0,  1, 0,  1 },
+                                              {  6,  9,  8, 1, -1, 0,  1 },
+                                              {  9, 19, 18, 0,  1, 1, -1 },
+                                              { 10, 13, 14, 1, -1, 1, -1 } };
+
+    for (int i=0; i<20; ++i)
+        w[i] = ws[i] = wt[i] = 0.0f;
+
+    for (int i=0; i<12; ++i) {
+        int row = boundaryPoints[i][0] / 4,
+            col = boundaryPoints[i][0] % 4,
+            p = boundaryPoints[i][1];
+        w [p] = Bt[row]*Bs[col];
+        ws[p] = Bt[row]*Ds[col];
+        wt[p] = Dt[row]*Bs[col];
+    }
+
+    for (int i=0; i<4; ++i) {
+        int const * ip = interiorPoints[i];
+
+        int row = ip[0] / 4,
+            col = ip[0] % 4,
+            X = ip[1],
+            Y = ip[2];
+
+        float a = ip[3] + ip[4]*s,
+              b = ip[5] + ip[6]*t,
+              d = a+b,
+              gs = 0.0f,
+              gt = 0.0f;
+
+        if (d==0.0f) {
+            d = 1.0f;
+        } else {
+            // derivatives of the rational blend : dq = (X-Y)*(b*da - a*db)/d^2
+            gs =  b*ip[4] / (d*d);
+            gt = -a*ip[6] / (d*d);
+        }
+
+        float W  = Bt[row]*Bs[col],
+              Ws = Bt[row]*Ds[col],
+              Wt = Dt[row]*Bs[col];
+
+        w [X] += W*a/d;
+        w [Y] += W*b/d;
+        ws[X] += Ws*a/d + W*gs;
+        ws[Y] += Ws*b/d - W*gs;
+        wt[X] += Wt*a/d + W*gt;
+        wt[Y] += Wt*b/d - W*gt;
+    }
+}
+
+// Scales the tangent vector of a regular vertex of given valence into the
+// Gregory edge points (see the 'ef' table in glslPatchCommon.glsl)
+static float
+getGregoryEdgeFactor(int valence) {
+
+    float c = cosf(2.0f*PI/valence),
+          lambda = (5.0f + c + cosf(PI/valence)*sqrtf(18.0f + 2.0f*c)) / 16.0f;
+    return 1.0f / (valence*lambda);
+}
+
+static inline void
+clear(float *dst, int n) {
+    for (int i=0; i<n; ++i)
+        dst[i] = 0.0f;
+}
+
+static inline void
+addWithWeight(float *dst, float const *src, float weight, int n) {
+    for (int i=0; i<n; ++i)
+        dst[i] += weight*src[i];
+}
+
+// Limit point and tangent points of a corner vertex of a Gregory patch
+struct GregoryVertex {
+    int valence;         // signed valence (negative on boundaries)
+    int zerothNeighbor;  // first boundary neighbor
+    int const * ring;    // entry in the vertex valence table
+    float const * org;   // control vertex data
+    float * pos,         // limit point
+          * e0,          // tangent points
+          * e1;
+};
+
+// Gregory patch vertex stage (see Patches.TessVertexBoundaryGregory)
+static void
+computeGregoryVertex(GregoryVertex & gv, int vid, int const * valenceTable, int stride,
+                     float const * vertex, int vertexStride, int numElements, float * f) {
+
+    int const * ring = valenceTable + vid*stride;
+
+    int valence = ring[0],
+        n = abs(valence);
+
+    float const * pos = vertex + vid*vertexStride;
+
+    gv.valence = valence;
+    gv.ring = ring+1;
+    gv.org = pos;
+
+    clear(gv.pos, numElements);
+    clear(gv.e0, numElements);
+    clear(gv.e1, numElements);
+
+    int boundaryEdgeNeighbors[2] = { vid, vid },
+        currNeighbor = 0,
+        ibefore = 0,
+        zerothNeighbor = 0;
+
+    float ef = getGregoryEdgeFactor(n);
+
+    for (int i=0; i<n; ++i) {
+
+        int ip = (i+1)%n;
+
+        int idx_neighbor = gv.ring[2*i],
+            idx_diagonal = gv.ring[2*i+1],
+            idx_neighbor_p = gv.ring[2*ip];
+
+        if (valenceTable[idx_neighbor*stride] < 0) {
+            boundaryEdgeNeighbors[currNeighbor++] = idx_neighbor;
+            if (currNeighbor==1) {
+                ibefore = i;
+                zerothNeighbor = i;
+            } else if (i-ibefore==1) {
+                std::swap(boundaryEdgeNeighbors[0], boundaryEdgeNeighbors[1]);
+                zerothNeighbor = i;
+            }
+        }
+
+        // f[i] = (pos*n + (neighbor_p + neighbor)*2 + diagonal) / (n+5)
+        clear(f, numElements);
+        addWithWeight(f, pos, (float)n, numElements);
+        addWithWeight(f, vertex + idx_neighbor*vertexStride, 2.0f, numElements);
+        addWithWeight(f, vertex + idx_neighbor_p*vertexStride, 2.0f, numElements);
+        addWithWeight(f, vertex + idx_diagonal*vertexStride, 1.0f, numElements);
+
+        float invw = 1.0f / (n+5.0f);
+
+        addWithWeight(gv.pos, f, invw/n, numElements);
+
+        // e = 0.5*(f[i] + f[i-1]) : f[i] contributes to e[i] and e[i+1]
+        float theta = 2.0f*PI*i/n,
+              thetap = 2.0f*PI*ip/n;
+        addWithWeight(gv.e0, f, 0.5f*ef*invw*(cosf(theta) + cosf(thetap)), numElements);
+        addWithWeight(gv.e1, f, 0.5f*ef*invw*(sinf(theta) + sinf(thetap)), numElements);
+    }
+
+    if (currNeighbor==1)
+        boundaryEdgeNeighbors[1] = boundaryEdgeNeighbors[0];
+
+    gv.zerothNeighbor = zerothNeighbor;
+
+    if (valence < 0) {
+
+        float const * b0 = vertex + boundaryEdgeNeighbors[0]*vertexStride,
+                    * b1 = vertex + boundaryEdgeNeighbors[1]*vertexStride;
+
+        clear(gv.pos, numElements);
+        if (n > 2) {
+            addWithWeight(gv.pos, b0, 1.0f/6.0f, numElements);
+            addWithWeight(gv.pos, b1, 1.0f/6.0f, numElements);
+            addWithWeight(gv.pos, pos, 4.0f/6.0f, numElements);
+        } else {
+            addWithWeight(gv.pos, pos, 1.0f, numElements);
+        }
+
+        clear(gv.e0, numElements);
+        addWithWeight(gv.e0, b0, 1.0f/6.0f, numElements);
+        addWithWeight(gv.e0, b1, -1.0f/6.0f, numElements);
+
+        float k = (float)(n-1),   // number of faces
+              c = cosf(PI/k),
+              s = sinf(PI/k),
+              gamma = -(4.0f*s) / (3.0f*k+c),
+              alpha_0k = -((1.0f+2.0f*c)*sqrtf(1.0f+c)) / ((3.0f*k+c)*sqrtf(1.0f-c)),
+              beta_0 = s / (3.0f*k+c);
+
+        clear(gv.e1, numElements);
+        addWithWeight(gv.e1, pos, gamma/3.0f, numElements);
+        addWithWeight(gv.e1, b0, alpha_0k/3.0f, numElements);
+        addWithWeight(gv.e1, b1, alpha_0k/3.0f, numElements);
+        addWithWeight(gv.e1, vertex + abs(gv.ring[2*zerothNeighbor+1])*vertexStride,
+                      beta_0/3.0f, numElements);
+
+        for (int x=1; x<n-1; ++x) {
+
+            int curri = (x+zerothNeighbor)%n;
+
+            float alpha = (4.0f*sinf((PI*x)/k)) / (3.0f*k+c),
+                  beta = (sinf((PI*x)/k) + sinf((PI*(x+1))/k)) / (3.0f*k+c);
+
+            addWithWeight(gv.e1, vertex + abs(gv.ring[2*curri])*vertexStride,
+                          alpha/3.0f, numElements);
+            addWithWeight(gv.e1, vertex + gv.ring[2*curri+1]*vertexStride,
+                          beta/3.0f, numElements);
+        }
+    }
+}
+
+// Adds weight * r[i] to dst, where r is the cross-boundary tangent term
+// r[i] = (neighbor[i+1] - neighbor[i-1])/3 + (diagonal[i] - diagonal[i-1])/6
+static void
+addGregoryR(float * dst, GregoryVertex const & gv, int i, float weight,
+            float const * vertex, int vertexStride, int numElements) {
+
+    int n = abs(gv.valence),
+        ip = (i+1)%n,
+        im = (i+n-1)%n;
+
+    addWithWeight(dst, vertex + gv.ring[2*ip]*vertexStride, weight/3.0f, numElements);
+    addWithWeight(dst, vertex + gv.ring[2*im]*vertexStride, -weight/3.0f, numElements);
+    addWithWeight(dst, vertex + gv.ring[2*i+1]*vertexStride, weight/6.0f, numElements);
+    addWithWeight(dst, vertex + gv.ring[2*im+1]*vertexStride, -weight/6.0f, numElements);
+}
+
+// Edge point of a Gregory vertex along its neighbor j
+static void
+computeGregoryEdgePoint(float * dst, GregoryVertex const & gv, int j, int numElements) {
+
+    int n = abs(gv.valence);
+
+    float theta;
+    if (gv.valence < -2) {
+        j = (n + j - gv.zerothNeighbor) % n;
+        theta = (PI*j) / (n-1);
+    } else {
+        theta = (2.0f*PI*j) / n;
+    }
+
+    clear(dst, numElements);
+    addWithWeight(dst, gv.pos, 1.0f, numElements);
+    addWithWeight(dst, gv.e0, cosf(theta), numElements);
+    addWithWeight(dst, gv.e1, sinf(theta), numElements);
+}
+
+// Computes the 20 control points of a Gregory patch (see
+// Patches.TessControlBoundaryGregory) :
+//
+// "Approximating Subdivision Surfaces with Gregory Patches for Hardware
+//  Tessellation" Loop, Schaefer, Ni, Castano (ACM ToG Siggraph Asia 2009)
+//
+static void
+computeGregoryPoints(OsdEvalContext::Patch const & patch,
+                     int const * valenceTable, int stride,
+                     float const * vertex, int vertexStride, int numElements,
+                     float * scratch) {
+
+    float * points = scratch,
+          * tmp = scratch + 20*numElements,
+          * Em_ip = tmp + numElements,
+          * Ep_im = Em_ip + numElements;
+
+    GregoryVertex gv[4];
+    for (int i=0; i<4; ++i) {
+        gv[i].pos = points + 5*i*numElements;
+        gv[i].e0 = Ep_im + (2*i+1)*numElements;
+        gv[i].e1 = Ep_im + (2*i+2)*numElements;
+        computeGregoryVertex(gv[i], patch.cvs[i], valenceTable, stride,
+                             vertex, vertexStride, numElements, tmp);
+    }
+
+    for (int i=0; i<4; ++i) {
+
+        int ip = (i+1)%4,
+            im = (i+3)%4;
+
+        int start   =  patch.quadOffsets[i]        & 0xff,
+            prev    = (patch.quadOffsets[i] >> 8)  & 0xff,
+            prev_p  = (patch.quadOffsets[ip] >> 8) & 0xff,
+            start_m =  patch.quadOffsets[im]       & 0xff;
+
+        int valence = gv[i].valence,
+            n = abs(gv[i].valence),
+            np = abs(gv[ip].valence),
+            nm = abs(gv[im].valence);
+
+        float const * pos = gv[i].pos;
+
+        float * Ep = points + (5*i+1)*numElements,
+              * Em = points + (5*i+2)*numElements,
+              * Fp = points + (5*i+3)*numElements,
+              * Fm = points + (5*i+4)*numElements;
+
+        computeGregoryEdgePoint(Em_ip, gv[ip], prev_p, numElements);
+        computeGregoryEdgePoint(Ep_im, gv[im], start_m, numElements);
+
+        clear(Ep, numElements);
+        clear(Em, numElements);
+        clear(Fp, numElements);
+        clear(Fm, numElements);
+
+        if (valence < 0)
+            n = (n-1)*2;
+        if (gv[im].valence < 0)
+            nm = (nm-1)*2;
+        if (gv[ip].valence < 0)
+            np = (np-1)*2;
+
+        if (valence > 2 or valence < -2) {
+
+            computeGregoryEdgePoint(Ep, gv[i], start, numElements);
+            computeGregoryEdgePoint(Em, gv[i], prev, numElements);
+
+            float cn = cosf(2.0f*PI/n),
+                  cp = cosf(2.0f*PI/np),
+                  cm = cosf(2.0f*PI/nm),
+                  s2 = 2.0f*cn;
+
+            bool fpOnly = valence < -2 and gv[im].valence < 0,
+                 fmOnly = valence < -2 and gv[ip].valence < 0 and not fpOnly;
+
+            if (not fmOnly) {
+                // Fp = (cp*pos + s1*Ep + s2*Em_ip + r[start]) / 3
+                float s1 = 3.0f - 2.0f*cn - cp;
+                addWithWeight(Fp, pos, cp/3.0f, numElements);
+                addWithWeight(Fp, Ep, s1/3.0f, numElements);
+                addWithWeight(Fp, Em_ip, s2/3.0f, numElements);
+                addGregoryR(Fp, gv[i], start, 1.0f/3.0f, vertex, vertexStride, numElements);
+            }
+
+            if (not fpOnly) {
+                // Fm = (cm*pos + s1*Em + s2*Ep_im - r[prev]) / 3
+                float s1 = 3.0f - 2.0f*cn - cm;
+                addWithWeight(Fm, pos, cm/3.0f, numElements);
+                addWithWeight(Fm, Em, s1/3.0f, numElements);
+                addWithWeight(Fm, Ep_im, s2/3.0f, numElements);
+                addGregoryR(Fm, gv[i], prev, -1.0f/3.0f, vertex, vertexStride, numElements);
+            }
+
+            if (fpOnly)
+                addWithWeight(Fm, Fp, 1.0f, numElements);
+            if (fmOnly)
+                addWithWeight(Fp, Fm, 1.0f, numElements);
+
+        } else if (valence == -2) {
+
+            addWithWeight(Ep, gv[i].org, 2.0f/3.0f, numElements);
+            addWithWeight(Ep, gv[ip].org, 1.0f/3.0f, numElements);
+
+            addWithWeight(Em, gv[i].org, 2.0f/3.0f, numElements);
+            addWithWeight(Em, gv[im].org, 1.0f/3.0f, numElements);
+
+            addWithWeight(Fp, gv[i].org, 4.0f/9.0f, numElements);
+            addWithWeight(Fp, gv[(i+2)%4].org, 1.0f/9.0f, numElements);
+            addWithWeight(Fp, gv[ip].org, 2.0f/9.0f, numElements);
+            addWithWeight(Fp, gv[im].org, 2.0f/9.0f, numElements);
+            addWithWeight(Fm, Fp, 1.0f, numElements);
+        }
+    }
+}
+
+int
+OsdEvalContext::EvalLimitSamples(OsdVertexDescriptor const & vdesc,
+                                 float const *vertex, float const *varying,
+                                 int numSamples, OsdEvalCoords const *coords,
+                                 float *outVertex, float *outDu, float *outDv,
+                                 float *outVarying) const {
+
+    // the evaluation reads floats : double buffers are not supported
+    if (vdesc.precision==OSD_PRECISION_DOUBLE) {
+        OsdError(OSD_INTERNAL_CODING_ERROR,
+                 "OsdEvalContext::EvalLimitSamples : double precision vertex data is not supported\n");
+        return 0;
+    }
+
+    int numElements = vertex ? vdesc.numVertexElements : 0,
+        numVaryingElements = (varying and outVarying) ? vdesc.numVaryingElements : 0;
+
+    int const * valenceTable = _patchTables->GetVertexValenceTable().empty() ?
+        0 : &_patchTables->GetVertexValenceTable()[0];
+
+    int numEvaluated = 0;
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+#pragma omp parallel reduction(+:numEvaluated)
+#endif
+    {
+        // Gregory patch control points, tangent points and temporaries
+        std::vector<float> scratch((20 + 3 + 8)*numElements + 1);
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+#pragma omp for
+#endif
+        for (int i=0; i<numSamples; ++i) {
+
+            float * P  = outVertex ? outVertex + i*numElements : 0,
+                  * Pu = outDu ? outDu + i*numElements : 0,
+                  * Pv = outDv ? outDv + i*numElements : 0,
+                  * Vy = outVarying ? outVarying + i*vdesc.numVaryingElements : 0;
+
+            if (P)  clear(P, numElements);
+            if (Pu) clear(Pu, numElements);
+            if (Pv) clear(Pv, numElements);
+            if (Vy) clear(Vy, vdesc.numVaryingElements);
+
+            OsdEvalCoords const & coord = coords[i];
+
+            Patch const * patch = FindPatch(coord.face, coord.u, coord.v);
+            if (not patch or (patch->type>=kGregory and not valenceTable))
+                continue;
+
+            // local coordinates of the sample in the patch
+            float scale = (float)(1 << patch->depth),
+                  u = coord.u<0.0f ? 0.0f : (coord.u>1.0f ? 1.0f : coord.u),
+                  v = coord.v<0.0f ? 0.0f : (coord.v>1.0f ? 1.0f : coord.v),
+                  a = u*scale - patch->u,
+                  b = v*scale - patch->v;
+
+            // undo the ptex rotation of the patch : (a,b) -> (s,t), and
+            // express the derivatives along (a,b) from the ones along (s,t)
+            float s, t, dsa, dta, dsb, dtb;
+            switch (patch->rotation) {
+                case 0 : s = a;      t = b;      dsa= 1; dta= 0; dsb= 0; dtb= 1; break;
+                case 1 : s = b;      t = 1.0f-a; dsa= 0; dta=-1; dsb= 1; dtb= 0; break;
+                case 2 : s = 1.0f-a; t = 1.0f-b; dsa=-1; dta= 0; dsb= 0; dtb=-1; break;
+                default: s = 1.0f-b; t = a;      dsa= 0; dta= 1; dsb=-1; dtb= 0; break;
+            }
+
+            float w[20], ws[20], wt[20];
+            float const * src[20];
+            int ncvs;
+
+            if (patch->type < kGregory) {
+                ncvs = patch->type==kRegular ? 16 : (patch->type==kBoundary ? 12 : 9);
+                getBSplinePatchWeights(patch->type, s, t, w, ws, wt);
+                for (int k=0; k<ncvs; ++k)
+                    src[k] = vertex + patch->cvs[k]*vdesc.vertexStride;
+            } else {
+                ncvs = 20;
+                getGregoryPatchWeights(s, t, w, ws, wt);
+                if (numElements>0)
+                    computeGregoryPoints(*patch, valenceTable, _valenceStride,
+                                         vertex, vdesc.vertexStride, numElements, &scratch[0]);
+                for (int k=0; k<ncvs; ++k)
+                    src[k] = &scratch[0] + k*numElements;
+            }
+
+            for (int k=0; k<ncvs and numElements>0; ++k) {
+
+                float wu = scale*(dsa*ws[k] + dta*wt[k]),
+                      wv = scale*(dsb*ws[k] + dtb*wt[k]);
+
+                if (P)  addWithWeight(P, src[k], w[k], numElements);
+                if (Pu) addWithWeight(Pu, src[k], wu, numElements);
+                if (Pv) addWithWeight(Pv, src[k], wv, numElements);
+            }
+
+            // varying data is interpolated bilinearly across the patch face
+            if (numVaryingElements) {
+                int const * corners = cornerCVs[patch->type];
+                float bw[4] = { (1.0f-s)*(1.0f-t), s*(1.0f-t), s*t, (1.0f-s)*t };
+                for (int k=0; k<4; ++k)
+                    addWithWeight(Vy, varying + patch->cvs[corners[k]]*vdesc.varyingStride,
+                                  bw[k], numVaryingElements);
+            }
+
+            ++numEvaluated;
+        }
+    }
+    return numEvaluated;
+}
+
+// True if the ptex coordinates of a patch table have been generated
+static bool
+hasPtexCoordinates(FarPatchTables::PTable const & ptable, int ringsize,
+                   FarPatchTables::PtexCoordinateTable const & ptexCoords) {
+
+    return (int)ptexCoords.size() == 2*(ptable.GetSize()/ringsize);
+}
+
+OsdEvalContext *
+OsdEvalContext::Create(FarMesh<OsdVertex> const *farmesh) {
+
+    FarPatchTables const * patchTables = farmesh ? farmesh->GetPatchTables() : 0;
+    if (not patchTables)
+        return 0;
+
+    // ptex coordinates are required to locate the patches of each face
+    bool hasPtex =
+        hasPtexCoordinates(patchTables->GetFullRegularPatches(), 16,
+                           patchTables->GetFullRegularPtexCoordinates()) and
+        hasPtexCoordinates(patchTables->GetFullBoundaryPatches(), 12,
+                           patchTables->GetFullBoundaryPtexCoordinates()) and
+        hasPtexCoordinates(patchTables->GetFullCornerPatches(), 9,
+                           patchTables->GetFullCornerPtexCoordinates()) and
+        hasPtexCoordinates(patchTables->GetFullGregoryPatches(), 4,
+                           patchTables->GetFullGregoryPtexCoordinates()) and
+        hasPtexCoordinates(patchTables->GetFullBoundaryGregoryPatches(), 4,
+                           patchTables->GetFullBoundaryGregoryPtexCoordinates());
+
+    for (unsigned char pattern=0; pattern<5 and hasPtex; ++pattern) {
+
+        hasPtex = hasPtexCoordinates(patchTables->GetTransitionRegularPatches(pattern), 16,
+                                     patchTables->GetTransitionRegularPtexCoordinates(pattern));
+
+        for (unsigned char rot=0; rot<4 and hasPtex; ++rot) {
+            hasPtex =
+                hasPtexCoordinates(patchTables->GetTransitionBoundaryPatches(pattern, rot), 12,
+                                   patchTables->GetTransitionBoundaryPtexCoordinates(pattern, rot)) and
+                hasPtexCoordinates(patchTables->GetTransitionCornerPatches(pattern, rot), 9,
+                                   patchTables->GetTransitionCornerPtexCoordinates(pattern, rot));
+        }
+    }
+
+    if (not hasPtex)
+        return 0;
+
+    return new OsdEvalContext(patchTables);
+}
+
+}  // end namespace OPENSUBDIV_VERSION
+}  // end namespace OpenSubdiv
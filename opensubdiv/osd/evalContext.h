@@ -59,12 +59,139 @@
 
 #include "../version.h"
 
+#include "../far/mesh.h"
+#include "../far/patchTables.h"
+#include "../osd/nonCopyable.h"
+#include "../osd/vertex.h"
+#include "../osd/vertexDescriptor.h"
+
+#include <vector>
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
-class OsdEvalContext {
+/// \brief Location of a limit surface sample : a ptex face index and the
+/// parametric (u,v) coordinates of the sample within that face.
+struct OsdEvalCoords {
+
+    OsdEvalCoords() : face(0), u(0.0f), v(0.0f) { }
+
+    OsdEvalCoords(int iface, float iu, float iv) : face(iface), u(iu), v(iv) { }
+
+    int face;   // ptex face index
+    float u, v; // local face coordinates in [0,1]
+};
+
+/// \brief CPU limit surface evaluation context
+///
+/// OsdEvalContext evaluates the limit surface of a feature adaptive FarMesh
+/// directly from its patch tables, without requiring any uniform refinement.
+/// The FarMesh must have been created adaptively with ptex coordinates, and
+/// the vertex data passed to the evaluation functions must contain all the
+/// vertices of the FarMesh, refined with one of the compute controllers.
+///
+/// Regular, boundary, corner and transition patches are evaluated as bicubic
+/// B-splines, and patches around extraordinary vertices as Gregory patches.
+/// Vertex data is interpolated with the limit basis, varying data bilinearly
+/// across the patch.
+///
+class OsdEvalContext : OsdNonCopyable<OsdEvalContext> {
 public:
 
+    /// Creates an evaluation context for the patches of an adaptive FarMesh.
+    /// Returns NULL if the mesh has no patch tables or no ptex coordinates.
+    /// The FarMesh is not owned and must outlive the context.
+    static OsdEvalContext * Create(FarMesh<OsdVertex> const *farmesh);
+
+    ~OsdEvalContext();
+
+    /// Returns the number of ptex faces covered by the patches
+    int GetNumPtexFaces() const { return (int)_faceOffsets.size()-1; }
+
+    /// Evaluates the limit surface at a batch of sample locations.
+    ///
+    /// @param vdesc       Layout of the vertex and varying primvars : the
+    ///                    control vertices are vertexStride (resp.
+    ///                    varyingStride) elements apart. Double precision
+    ///                    data is not supported.
+    /// @param vertex      Vertex primvar data of all the FarMesh vertices,
+    ///                    pointing to the first evaluated element of the
+    ///                    first vertex (ie. offset into an interleaved buffer)
+    /// @param varying     Varying primvar data (optional, same as vertex)
+    /// @param numSamples  Number of samples in the batch
+    /// @param coords      Sample locations
+    /// @param outVertex   Limit vertex primvars (numVertexElements per sample)
+    /// @param outDu       Limit first derivatives along u (optional)
+    /// @param outDv       Limit first derivatives along v (optional)
+    /// @param outVarying  Interpolated varying primvars (optional)
+    ///
+    /// @return The number of samples evaluated successfully : samples with
+    ///         an invalid face index, or falling in a hole of the patch
+    ///         tables, are set to zero and not counted. Returns 0 with an
+    ///         OsdError for double precision data.
+    ///
+    int EvalLimitSamples(OsdVertexDescriptor const & vdesc,
+                         float const *vertex, float const *varying,
+                         int numSamples, OsdEvalCoords const *coords,
+                         float *outVertex, float *outDu=0, float *outDv=0,
+                         float *outVarying=0) const;
+
+    /// Evaluates the limit surface at a batch of sample locations, reading
+    /// the primvar data from the CPU side of vertex buffers.
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    int EvalLimitSamples(VERTEX_BUFFER *vertexBuffer, VARYING_BUFFER *varyingBuffer,
+                         int numSamples, OsdEvalCoords const *coords,
+                         float *outVertex, float *outDu=0, float *outDv=0,
+                         float *outVarying=0) const {
+
+        OsdVertexDescriptor vdesc(vertexBuffer ? vertexBuffer->GetNumElements() : 0,
+                                  varyingBuffer ? varyingBuffer->GetNumElements() : 0);
+
+        return EvalLimitSamples(vdesc,
+                                vertexBuffer ? vertexBuffer->BindCpuBuffer() : 0,
+                                varyingBuffer ? varyingBuffer->BindCpuBuffer() : 0,
+                                numSamples, coords, outVertex, outDu, outDv, outVarying);
+    }
+
+    /// Patch types supported by the evaluator
+    enum PatchType {
+        kRegular = 0,
+        kBoundary,
+        kCorner,
+        kGregory,
+        kBoundaryGregory
+    };
+
+    /// \brief Descriptor of a single patch of the adaptive mesh
+    struct Patch {
+        unsigned int const * cvs;         // control vertex indices
+        unsigned int const * quadOffsets; // Gregory patch quad offsets
+        int face;                         // ptex face index
+        unsigned short u, v;              // sub-face offset in the ptex face
+        unsigned char depth;              // ptex sub-face depth
+        unsigned char rotation;           // ptex rotation of the patch
+        unsigned char type;               // PatchType
+    };
+
+    /// Returns the patch containing the location (u,v) of a ptex face, or
+    /// NULL if no patch covers that location.
+    Patch const * FindPatch(int face, float u, float v) const;
+
+protected:
+    explicit OsdEvalContext(FarPatchTables const *patchTables);
+
+private:
+    void addPatches(FarPatchTables::PTable const & ptable, int ringsize,
+                    FarPatchTables::PtexCoordinateTable const & ptexCoords,
+                    PatchType type, unsigned int const * quadOffsets);
+
+    FarPatchTables const * _patchTables;
+
+    std::vector<Patch> _patches;    // patches sorted by ptex face
+
+    std::vector<int> _faceOffsets;  // offset of the first patch of each face
+
+    int _valenceStride;             // stride of the vertex valence table
 };
 
 } // end namespace OPENSUBDIV_VERSION
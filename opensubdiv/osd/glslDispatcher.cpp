@@ -175,6 +175,14 @@ OsdGLSLComputeKernelDispatcher::ApplyCatmarkEdgeVerticesKernel(
         offset, start, end);
 }
 
+void
+OsdGLSLComputeKernelDispatcher::ApplyCatmarkVertexVerticesKernel(
+    FarMesh<OsdVertex> * mesh, int offset, int level,
+    int start, int end, void * clientdata) const {
+
+    ApplyCatmarkVertexVerticesMultiPass(mesh, offset, level, clientdata);
+}
+
 void
 OsdGLSLComputeKernelDispatcher::ApplyCatmarkVertexVerticesKernelB(
     FarMesh<OsdVertex> * mesh, int offset, int level,
@@ -229,6 +237,14 @@ OsdGLSLComputeKernelDispatcher::ApplyLoopEdgeVerticesKernel(
         offset, start, end);
 }
 
+void
+OsdGLSLComputeKernelDispatcher::ApplyLoopVertexVerticesKernel(
+    FarMesh<OsdVertex> * mesh, int offset, int level,
+    int start, int end, void * clientdata) const {
+
+    ApplyLoopVertexVerticesMultiPass(mesh, offset, level, clientdata);
+}
+
 void
 OsdGLSLComputeKernelDispatcher::ApplyLoopVertexVerticesKernelB(
     FarMesh<OsdVertex> * mesh, int offset, int level,
@@ -195,6 +195,14 @@ OsdGLSLTransformFeedbackKernelDispatcher::ApplyCatmarkEdgeVerticesKernel(
         offset, start, end);
 }
 
+void
+OsdGLSLTransformFeedbackKernelDispatcher::ApplyCatmarkVertexVerticesKernel(
+    FarMesh<OsdVertex> * mesh, int offset, int level,
+    int start, int end, void * clientdata) const {
+
+    ApplyCatmarkVertexVerticesMultiPass(mesh, offset, level, clientdata);
+}
+
 void
 OsdGLSLTransformFeedbackKernelDispatcher::ApplyCatmarkVertexVerticesKernelB(
     FarMesh<OsdVertex> * mesh, int offset, int level,
@@ -261,6 +269,14 @@ OsdGLSLTransformFeedbackKernelDispatcher::ApplyLoopEdgeVerticesKernel(
         offset, start, end);
 }
 
+void
+OsdGLSLTransformFeedbackKernelDispatcher::ApplyLoopVertexVerticesKernel(
+    FarMesh<OsdVertex> * mesh, int offset, int level,
+    int start, int end, void * clientdata) const {
+
+    ApplyLoopVertexVerticesMultiPass(mesh, offset, level, clientdata);
+}
+
 void
 OsdGLSLTransformFeedbackKernelDispatcher::ApplyLoopVertexVerticesKernelB(
     FarMesh<OsdVertex> * mesh, int offset, int level,
@@ -58,6 +58,7 @@
 #include "../osd/cpuComputeContext.h"
 #include "../osd/ompComputeController.h"
 #include "../osd/ompDispatcher.h"
+#include "../osd/cpuDispatcher.h"
 
 #ifdef OPENSUBDIV_HAS_OPENMP
     #include <omp.h>
@@ -66,15 +67,148 @@
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
+static void
+refineJob(void *data) {
 
-OsdOmpComputeController::OsdOmpComputeController(int numThreads) {
+    OsdCpuComputeContext *context = static_cast<OsdCpuComputeContext*>(data);
+
+    OsdOmpKernelDispatcher::GetInstance()->Refine(context->GetFarMesh(),
+                                                  context);
+    context->Unbind();
+}
+
+static void
+refineFVarJob(void *data) {
+
+    OsdCpuComputeContext *context = static_cast<OsdCpuComputeContext*>(data);
+
+    OsdOmpKernelDispatcher::GetInstance()->RefineFVar(context);
+    context->UnbindFVar();
+}
+
+static void
+firstTouchJob(void *data) {
+
+    OsdCpuComputeContext *context = static_cast<OsdCpuComputeContext*>(data);
+
+    OsdOmpKernelDispatcher::GetInstance()->FirstTouch(context);
+    context->Unbind();
+}
+
+static void
+setNumThreadsJob(void *data) {
+
+    omp_set_num_threads(*static_cast<int*>(data));
+}
+
+OsdOmpComputeController::OsdOmpComputeController(int numThreads,
+                                                 int batchGrainSize,
+                                                 bool asynchronous) {
 
     _numThreads = (numThreads == -1) ? omp_get_num_procs() : numThreads;
+    _batchGrainSize = batchGrainSize;
+    _worker = 0;
+
+    if (asynchronous) {
+        // the number of threads is a setting of the thread launching the
+        // kernels : set it once on the worker thread
+        _worker = new OsdTaskWorker();
+        _initJob.function = setNumThreadsJob;
+        _initJob.data = &_numThreads;
+        _worker->Submit(&_initJob);
+    }
+}
+
+OsdOmpComputeController::~OsdOmpComputeController() {
+
+    // completes the pending refinements
+    delete _worker;
+}
+
+void
+OsdOmpComputeController::refine(OsdCpuComputeContext *context) {
+
+    if (_worker) {
+        OsdTaskWorker::Job *job = context->GetAsyncJob();
+        job->function = refineJob;
+        job->data = context;
+        _worker->Submit(job);
+    } else {
+        omp_set_num_threads(_numThreads);
+        refineJob(context);
+    }
+}
+
+void
+OsdOmpComputeController::refineFVar(OsdCpuComputeContext *context) {
+
+    if (_worker) {
+        OsdTaskWorker::Job *job = context->GetAsyncJob();
+        job->function = refineFVarJob;
+        job->data = context;
+        _worker->Submit(job);
+    } else {
+        omp_set_num_threads(_numThreads);
+        refineFVarJob(context);
+    }
+}
+
+void
+OsdOmpComputeController::firstTouch(OsdCpuComputeContext *context) {
+
+    // the threads of the worker refine the context : they touch its memory
+    if (_worker) {
+        OsdTaskWorker::Job *job = context->GetAsyncJob();
+        job->function = firstTouchJob;
+        job->data = context;
+        _worker->Submit(job);
+    } else {
+        omp_set_num_threads(_numThreads);
+        firstTouchJob(context);
+    }
+}
+
+void
+OsdOmpComputeController::refineBatch(OsdCpuComputeContext **contexts,
+                                     int count) {
+
+    omp_set_num_threads(_numThreads);
+
+    OsdOmpKernelDispatcher const *ompDispatcher =
+        OsdOmpKernelDispatcher::GetInstance();
+    OsdCpuKernelDispatcher const *cpuDispatcher =
+        OsdCpuKernelDispatcher::GetInstance();
+
+    int minVertices = _batchGrainSize * _numThreads;
+
+    // large meshes split their kernels across the threads
+    for (int i = 0; i < count; ++i) {
+        FarMesh<OsdVertex> *mesh = contexts[i]->GetFarMesh();
+        if (mesh->GetNumVertices() >= minVertices)
+            ompDispatcher->Refine(mesh, contexts[i]);
+    }
+
+    // small meshes are refined by a single thread each
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < count; ++i) {
+        FarMesh<OsdVertex> *mesh = contexts[i]->GetFarMesh();
+        if (mesh->GetNumVertices() < minVertices)
+            cpuDispatcher->Refine(mesh, contexts[i]);
+    }
 }
 
 void
 OsdOmpComputeController::Synchronize() {
-    // XXX: 
+
+    if (_worker)
+        _worker->WaitAll();
+}
+
+void
+OsdOmpComputeController::Synchronize(OsdCpuComputeContext *context) {
+
+    // the context can be pending in the worker of another controller
+    OsdTaskWorker::Wait(context->GetAsyncJob());
 }
 
 }  // end namespace OPENSUBDIV_VERSION
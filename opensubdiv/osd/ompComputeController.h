@@ -61,6 +61,7 @@
 
 #include "../osd/cpuComputeContext.h"
 #include "../osd/ompDispatcher.h"
+#include "../osd/taskScheduler.h"
 
 #ifdef OPENSUBDIV_HAS_OPENMP
     #include <omp.h>
@@ -73,6 +74,10 @@ namespace OPENSUBDIV_VERSION {
 /// OsdOmpComputeController is a compute controller class to launch
 /// OpenMP threaded subdivision kernels. It requires OsdCpuVertexBufferInterface
 /// as arguments of Refine function.
+/// Refining makes no heap allocation (see OsdCpuComputeContext).
+///
+/// An asynchronous controller queues the refinements to a background thread
+/// which launches the OpenMP kernels, see OsdCpuComputeController.
 class OsdOmpComputeController {
 public:
     typedef OsdCpuComputeContext ComputeContext;
@@ -80,7 +85,15 @@ public:
     /// Constructor.
     /// numThreads specifies how many threads to be used in openmp parallel
     /// execution. numThreads=-1 means to use available number of processors.
-    explicit OsdOmpComputeController(int numThreads=-1);
+    /// batchGrainSize is the number of vertices per thread below which
+    /// RefineBatch refines a mesh on a single thread (see RefineBatch).
+    /// asynchronous queues the refinements to a background thread.
+    explicit OsdOmpComputeController(int numThreads=-1,
+                                     int batchGrainSize=1024,
+                                     bool asynchronous=false);
+
+    /// Destructor.
+    ~OsdOmpComputeController();
 
     /// Launch subdivision kernels and apply to given vertex buffers.
     /// vertexBuffer will be interpolated with vertex interpolation and
@@ -92,12 +105,9 @@ public:
                 VERTEX_BUFFER *vertexBuffer,
                 VARYING_BUFFER *varyingBuffer) {
 
-        omp_set_num_threads(_numThreads);
-
+        Synchronize(context);
         context->Bind(vertexBuffer, varyingBuffer);
-        OsdOmpKernelDispatcher::GetInstance()->Refine(context->GetFarMesh(),
-                                                      context);
-        context->Unbind();
+        refine(context);
     }
 
     template<class VERTEX_BUFFER>
@@ -105,11 +115,162 @@ public:
         Refine(context, vertexBuffer, (VERTEX_BUFFER*)0);
     }
 
+    /// Launch subdivision kernels on the elements of the vertex buffers
+    /// described by vertexDesc and varyingDesc (ex. the positions of a
+    /// buffer interleaving positions, normals and colors) : the elements are
+    /// refined in place and the other elements are left untouched.
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                OsdVertexBufferDescriptor const &vertexDesc,
+                VERTEX_BUFFER *vertexBuffer,
+                OsdVertexBufferDescriptor const &varyingDesc,
+                VARYING_BUFFER *varyingBuffer) {
+
+        Synchronize(context);
+        context->Bind(vertexBuffer, varyingBuffer, vertexDesc, varyingDesc);
+        refine(context);
+    }
+
+    template<class VERTEX_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                OsdVertexBufferDescriptor const &vertexDesc,
+                VERTEX_BUFFER *vertexBuffer) {
+        Refine(context, vertexDesc, vertexBuffer,
+               OsdVertexBufferDescriptor(), (VERTEX_BUFFER*)0);
+    }
+
+    /// Launch subdivision kernels on buffers holding numSamples interleaved
+    /// samples of each vertex (ex. motion blur time samples) : every sample
+    /// is refined in a single traversal of the subdivision tables. Each
+    /// vertex of vertexBuffer is made of numSamples consecutive runs of
+    /// GetNumElements()/numSamples elements, one per sample. Nothing is
+    /// refined, and an OSD_INTERNAL_CODING_ERROR is reported, if
+    /// GetNumElements() is not a multiple of numSamples.
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void RefineSamples(OsdCpuComputeContext *context, int numSamples,
+                       VERTEX_BUFFER *vertexBuffer,
+                       VARYING_BUFFER *varyingBuffer) {
+
+        Synchronize(context);
+        if (context->Bind(vertexBuffer, varyingBuffer, numSamples))
+            refine(context);
+    }
+
+    template<class VERTEX_BUFFER>
+    void RefineSamples(OsdCpuComputeContext *context, int numSamples,
+                       VERTEX_BUFFER *vertexBuffer) {
+        RefineSamples(context, numSamples, vertexBuffer, (VERTEX_BUFFER*)0);
+    }
+
+    /// Launch subdivision kernels on a batch of meshes : contexts[i] is
+    /// refined with vertexBuffers[i] and varyingBuffers[i] (varyingBuffers
+    /// can be NULL). Each context and buffer can only appear once per batch.
+    ///
+    /// Meshes with at least batchGrainSize vertices per thread are refined
+    /// one after the other, with each kernel split across the threads. The
+    /// smaller meshes are then refined in parallel, each one by a single
+    /// thread, so that batches of many small meshes keep all the threads
+    /// busy instead of synchronizing them after every kernel. An
+    /// asynchronous controller queues the meshes one after the other.
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void RefineBatch(OsdCpuComputeContext **contexts,
+                     VERTEX_BUFFER **vertexBuffers,
+                     VARYING_BUFFER **varyingBuffers,
+                     int count) {
+
+        if (_worker) {
+            for (int i=0; i<count; ++i)
+                Refine(contexts[i], vertexBuffers[i],
+                       varyingBuffers ? varyingBuffers[i] : 0);
+            return;
+        }
+
+        // buffers are bound from the calling thread
+        for (int i=0; i<count; ++i) {
+            Synchronize(contexts[i]);
+            contexts[i]->Bind(vertexBuffers[i],
+                              varyingBuffers ? varyingBuffers[i] : 0);
+        }
+
+        refineBatch(contexts, count);
+
+        for (int i=0; i<count; ++i)
+            contexts[i]->Unbind();
+    }
+
+    template<class VERTEX_BUFFER>
+    void RefineBatch(OsdCpuComputeContext **contexts,
+                     VERTEX_BUFFER **vertexBuffers, int count) {
+        RefineBatch(contexts, vertexBuffers, (VERTEX_BUFFER**)0, count);
+    }
+
+    /// Launch the face-varying subdivision kernels on fvarBuffer : the
+    /// corners of the coarse faces (level 0) are refined into the corners of
+    /// the faces of every level, see FarFVarTables for the layout of the
+    /// buffer. Updating the coarse data (ex. animated UVs) only requires a new
+    /// RefineFVar. Does nothing if the mesh has no face-varying tables.
+    template<class FVAR_BUFFER>
+    void RefineFVar(OsdCpuComputeContext *context, FVAR_BUFFER *fvarBuffer) {
+
+        if (not context->GetFVarTables())
+            return;
+
+        Synchronize(context);
+        context->BindFVar(fvarBuffer);
+        refineFVar(context);
+    }
+
+    /// Places the memory read and written when refining a context on NUMA
+    /// systems : the subdivision tables of the context are copied (see
+    /// OsdCpuComputeContext::AllocateTableCopy) and the refined vertices of
+    /// the buffers are cleared by the threads that refine them, with the
+    /// partitioning of the kernels, so that each thread reads and writes the
+    /// memory of its node. The pages are placed on their first touch : the
+    /// buffers must not have been refined (or cleared) before. The coarse
+    /// vertices are left untouched.
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void FirstTouch(OsdCpuComputeContext *context,
+                    VERTEX_BUFFER *vertexBuffer,
+                    VARYING_BUFFER *varyingBuffer) {
+
+        Synchronize(context);
+        context->Bind(vertexBuffer, varyingBuffer);
+        firstTouch(context);
+    }
+
+    template<class VERTEX_BUFFER>
+    void FirstTouch(OsdCpuComputeContext *context, VERTEX_BUFFER *vertexBuffer) {
+        FirstTouch(context, vertexBuffer, (VERTEX_BUFFER*)0);
+    }
+
     /// Waits until all running subdivision kernels finish.
     void Synchronize();
 
+    /// Waits until the refinement of a context completes.
+    void Synchronize(OsdCpuComputeContext *context);
+
 private:
+    OsdOmpComputeController(const OsdOmpComputeController &);
+    OsdOmpComputeController & operator = (const OsdOmpComputeController &);
+
+    // Refines the bound buffers of the context, then unbinds them
+    void refine(OsdCpuComputeContext *context);
+
+    // Refines the bound face-varying buffer of the context, then unbinds it
+    void refineFVar(OsdCpuComputeContext *context);
+
+    // Touches the memory of the bound buffers of the context, then unbinds them
+    void firstTouch(OsdCpuComputeContext *context);
+
+    // Refines a batch of bound contexts
+    void refineBatch(OsdCpuComputeContext **contexts, int count);
+
     int _numThreads;
+    int _batchGrainSize;
+
+    OsdTaskWorker * _worker; // runs the refinements (asynchronous controller)
+
+    OsdTaskWorker::Job _initJob; // sets the number of threads of the worker
 };
 
 }  // end namespace OPENSUBDIV_VERSION
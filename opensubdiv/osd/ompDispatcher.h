@@ -76,9 +76,28 @@ public:
 
     void Refine(FarMesh<OsdVertex> * mesh, OsdCpuComputeContext *context) const;
 
+    /// Refines the face-varying buffer bound to the context, level by level
+    void RefineFVar(OsdCpuComputeContext *context) const;
+
+    /// Copies the tables of the context (see
+    /// OsdCpuComputeContext::AllocateTableCopy) and clears the refined
+    /// vertices of the bound buffers with the threads and the static
+    /// partitioning of the kernels : on NUMA systems, the memory each thread
+    /// reads and writes when refining is placed on its node.
+    void FirstTouch(OsdCpuComputeContext *context) const;
+
     static OsdOmpKernelDispatcher * GetInstance();
 
 protected:
+    // Computes the vertices covered by the stencil tables of the context
+    void ApplyStencilTables(OsdCpuComputeContext *context) const;
+
+    // Runs the kernel launches precomputed by the context (see
+    // OsdCpuComputeContext::GetSchedule)
+    void ApplySchedule(FarMesh<OsdVertex> * mesh, OsdCpuComputeContext *context) const;
+
+    virtual size_t GetVertexSize(void * clientdata) const;
+
     virtual void ApplyBilinearFaceVerticesKernel(
         FarMesh<OsdVertex> * mesh, int offset, int level,
         int start, int end, void * clientdata) const;
@@ -100,27 +119,19 @@ protected:
         FarMesh<OsdVertex> * mesh, int offset, int level,
         int start, int end, void * clientdata) const;
 
-    virtual void ApplyCatmarkVertexVerticesKernelB(
+    virtual void ApplyCatmarkVertexVerticesKernel(
         FarMesh<OsdVertex> * mesh, int offset, int level,
         int start, int end, void * clientdata) const;
 
-    virtual void ApplyCatmarkVertexVerticesKernelA(
-        FarMesh<OsdVertex> * mesh, int offset, bool pass, int level,
-        int start, int end, void * clientdata) const;
-
 
     virtual void ApplyLoopEdgeVerticesKernel(
         FarMesh<OsdVertex> * mesh, int offset, int level,
         int start, int end, void * clientdata) const;
 
-    virtual void ApplyLoopVertexVerticesKernelB(
+    virtual void ApplyLoopVertexVerticesKernel(
         FarMesh<OsdVertex> * mesh, int offset, int level,
         int start, int end, void * clientdata) const;
 
-    virtual void ApplyLoopVertexVerticesKernelA(
-        FarMesh<OsdVertex> * mesh, int offset, bool pass, int level,
-        int start, int end, void * clientdata) const;
-
     virtual void ApplyVertexEdits(
         FarMesh<OsdVertex> *mesh, int offset, int level,
         void * clientdata) const;
@@ -56,6 +56,7 @@
 //
 
 #include "../osd/ompKernel.h"
+#include "../osd/cpuKernelCommon.h"
 #include "../osd/vertexDescriptor.h"
 
 #include <math.h>
@@ -64,195 +65,152 @@
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
+// Returns the vertices [threadStart, threadEnd) of [start, end) computed by
+// the calling thread of a parallel region : the kernels partition their
+// vertices like schedule(static), so that the memory placed by
+// OsdOmpKernelDispatcher::FirstTouch is read and written by the threads that
+// touched it first. Each thread computes its vertices with the CPU kernels of
+// the selected instruction set (see OsdCpuSetInstructionSet).
+static void
+getThreadRange(int start, int end, int *threadStart, int *threadEnd) {
+
+    int numThreads = omp_get_num_threads(),
+        thread = omp_get_thread_num();
+
+    int size = (end - start) / numThreads,
+        extra = (end - start) % numThreads;
+
+    // the first 'extra' threads compute one more vertex
+    if (thread < extra) {
+        ++size;
+        extra = 0;
+    }
+    *threadStart = start + thread*size + extra;
+    *threadEnd = *threadStart + size;
+}
+
 void OsdOmpComputeFace(
-    const OsdVertexDescriptor *vdesc, float * vertex, float * varying,
+    const OsdVertexDescriptor *vdesc, void *vertex, void *varying,
     const int *F_IT, const int *F_ITa, int offset, int start, int end) {
 
-#pragma omp parallel for
-    for (int i = start; i < end; i++) {
-        int h = F_ITa[2*i];
-        int n = F_ITa[2*i+1];
-
-        float weight = 1.0f/n;
-
-        // XXX: should use local vertex struct variable instead of
-        // accumulating directly into global memory.
-        int dstIndex = offset + i;
-        vdesc->Clear(vertex, varying, dstIndex);
-
-        for (int j = 0; j < n; ++j) {
-            int index = F_IT[h+j];
-            vdesc->AddWithWeight(vertex, dstIndex, index, weight);
-            vdesc->AddVaryingWithWeight(varying, dstIndex, index, weight);
-        }
+    OsdCpuKernels const & kernels = OsdCpuGetKernels();
+    bool nonTemporal = OsdCpuUseNonTemporalStores(vdesc, end-start);
+
+#pragma omp parallel
+    {
+        int threadStart, threadEnd;
+        getThreadRange(start, end, &threadStart, &threadEnd);
+        kernels.computeFace(vdesc, vertex, varying, F_IT, F_ITa, offset,
+                            threadStart, threadEnd, nonTemporal);
     }
 }
 
 void OsdOmpComputeEdge(
-    const OsdVertexDescriptor *vdesc, float *vertex, float *varying,
+    const OsdVertexDescriptor *vdesc, void *vertex, void *varying,
     const int *E_IT, const float *E_W, int offset, int start, int end) {
 
-#pragma omp parallel for
-    for (int i = start; i < end; i++) {
-        int eidx0 = E_IT[4*i+0];
-        int eidx1 = E_IT[4*i+1];
-        int eidx2 = E_IT[4*i+2];
-        int eidx3 = E_IT[4*i+3];
-
-        float vertWeight = E_W[i*2+0];
+    OsdCpuKernels const & kernels = OsdCpuGetKernels();
+    bool nonTemporal = OsdCpuUseNonTemporalStores(vdesc, end-start);
 
-        int dstIndex = offset + i;
-        vdesc->Clear(vertex, varying, dstIndex);
-
-        vdesc->AddWithWeight(vertex, dstIndex, eidx0, vertWeight);
-        vdesc->AddWithWeight(vertex, dstIndex, eidx1, vertWeight);
-
-        if (eidx2 != -1) {
-            float faceWeight = E_W[i*2+1];
-
-            vdesc->AddWithWeight(vertex, dstIndex, eidx2, faceWeight);
-            vdesc->AddWithWeight(vertex, dstIndex, eidx3, faceWeight);
-        }
-
-        vdesc->AddVaryingWithWeight(varying, dstIndex, eidx0, 0.5f);
-        vdesc->AddVaryingWithWeight(varying, dstIndex, eidx1, 0.5f);
+#pragma omp parallel
+    {
+        int threadStart, threadEnd;
+        getThreadRange(start, end, &threadStart, &threadEnd);
+        kernels.computeEdge(vdesc, vertex, varying, E_IT, E_W, offset,
+                            threadStart, threadEnd, nonTemporal);
     }
 }
 
-void OsdOmpComputeVertexA(
-    const OsdVertexDescriptor *vdesc, float *vertex, float *varying,
-    const int *V_ITa, const float *V_W,
-    int offset, int start, int end, int pass) {
-
-#pragma omp parallel for
-    for (int i = start; i < end; i++) {
-        int n     = V_ITa[5*i+1];
-        int p     = V_ITa[5*i+2];
-        int eidx0 = V_ITa[5*i+3];
-        int eidx1 = V_ITa[5*i+4];
-
-        float weight = (pass == 1) ? V_W[i] : 1.0f - V_W[i];
-
-        // In the case of fractional weight, the weight must be inverted since
-        // the value is shared with the k_Smooth kernel (statistically the
-        // k_Smooth kernel runs much more often than this one)
-        if (weight > 0.0f && weight < 1.0f && n > 0)
-            weight = 1.0f - weight;
-
-        int dstIndex = offset + i;
-        if (not pass)
-            vdesc->Clear(vertex, varying, dstIndex);
-
-        if (eidx0 == -1 || (pass == 0 && (n == -1))) {
-            vdesc->AddWithWeight(vertex, dstIndex, p, weight);
-        } else {
-            vdesc->AddWithWeight(vertex, dstIndex, p, weight * 0.75f);
-            vdesc->AddWithWeight(vertex, dstIndex, eidx0, weight * 0.125f);
-            vdesc->AddWithWeight(vertex, dstIndex, eidx1, weight * 0.125f);
-        }
-
-        if (not pass)
-            vdesc->AddVaryingWithWeight(varying, dstIndex, p, 1.0f);
-    }
-}
-
-void OsdOmpComputeVertexB(
-    const OsdVertexDescriptor *vdesc, float *vertex, float *varying,
+void OsdOmpComputeVertex(
+    const OsdVertexDescriptor *vdesc, void *vertex, void *varying,
     const int *V_ITa, const int *V_IT, const float *V_W,
-    int offset, int start, int end) {
-
-#pragma omp parallel for
-    for (int i = start; i < end; i++) {
-        int h = V_ITa[5*i];
-        int n = V_ITa[5*i+1];
-        int p = V_ITa[5*i+2];
-
-        float weight = V_W[i];
-        float wp = 1.0f/static_cast<float>(n*n);
-        float wv = (n-2.0f) * n * wp;
-
-        int dstIndex = offset + i;
-        vdesc->Clear(vertex, varying, dstIndex);
+    const unsigned char *V_R, int offset, int start, int end) {
 
-        vdesc->AddWithWeight(vertex, dstIndex, p, weight * wv);
+    OsdCpuKernels const & kernels = OsdCpuGetKernels();
+    bool nonTemporal = OsdCpuUseNonTemporalStores(vdesc, end-start);
 
-        for (int j = 0; j < n; ++j) {
-            vdesc->AddWithWeight(vertex, dstIndex, V_IT[h+j*2], weight * wp);
-            vdesc->AddWithWeight(vertex, dstIndex, V_IT[h+j*2+1], weight * wp);
-        }
-        vdesc->AddVaryingWithWeight(varying, dstIndex, p, 1.0f);
+#pragma omp parallel
+    {
+        int threadStart, threadEnd;
+        getThreadRange(start, end, &threadStart, &threadEnd);
+        kernels.computeVertex(vdesc, vertex, varying, V_ITa, V_IT, V_W, V_R, offset,
+                              threadStart, threadEnd, nonTemporal);
     }
 }
 
-void OsdOmpComputeLoopVertexB(
-    const OsdVertexDescriptor *vdesc, float *vertex, float *varying,
+void OsdOmpComputeLoopVertex(
+    const OsdVertexDescriptor *vdesc, void *vertex, void *varying,
     const int *V_ITa, const int *V_IT, const float *V_W,
-    int offset, int start, int end) {
-
-#pragma omp parallel for
-    for (int i = start; i < end; i++) {
-        int h = V_ITa[5*i];
-        int n = V_ITa[5*i+1];
-        int p = V_ITa[5*i+2];
-
-        float weight = V_W[i];
-        float wp = 1.0f/static_cast<float>(n);
-        float beta = 0.25f * cosf(static_cast<float>(M_PI) * 2.0f * wp) + 0.375f;
-        beta = beta * beta;
-        beta = (0.625f - beta) * wp;
-
-        int dstIndex = offset + i;
-        vdesc->Clear(vertex, varying, dstIndex);
-
-        vdesc->AddWithWeight(vertex, dstIndex, p, weight * (1.0f - (beta * n)));
+    const unsigned char *V_R, int offset, int start, int end) {
 
-        for (int j = 0; j < n; ++j)
-            vdesc->AddWithWeight(vertex, dstIndex, V_IT[h+j], weight * beta);
+    OsdCpuKernels const & kernels = OsdCpuGetKernels();
+    bool nonTemporal = OsdCpuUseNonTemporalStores(vdesc, end-start);
 
-        vdesc->AddVaryingWithWeight(varying, dstIndex, p, 1.0f);
+#pragma omp parallel
+    {
+        int threadStart, threadEnd;
+        getThreadRange(start, end, &threadStart, &threadEnd);
+        kernels.computeLoopVertex(vdesc, vertex, varying, V_ITa, V_IT, V_W, V_R, offset,
+                                  threadStart, threadEnd, nonTemporal);
     }
 }
 
 void OsdOmpComputeBilinearEdge(
-    const OsdVertexDescriptor *vdesc, float *vertex, float *varying,
+    const OsdVertexDescriptor *vdesc, void *vertex, void *varying,
     const int *E_IT, int offset, int start, int end) {
 
-#pragma omp parallel for
-    for (int i = start; i < end; i++) {
-        int eidx0 = E_IT[2*i+0];
-        int eidx1 = E_IT[2*i+1];
-
-        int dstIndex = offset + i;
-        vdesc->Clear(vertex, varying, dstIndex);
+    OsdCpuKernels const & kernels = OsdCpuGetKernels();
+    bool nonTemporal = OsdCpuUseNonTemporalStores(vdesc, end-start);
 
-        vdesc->AddWithWeight(vertex, dstIndex, eidx0, 0.5f);
-        vdesc->AddWithWeight(vertex, dstIndex, eidx1, 0.5f);
-
-        vdesc->AddVaryingWithWeight(varying, dstIndex, eidx0, 0.5f);
-        vdesc->AddVaryingWithWeight(varying, dstIndex, eidx1, 0.5f);
+#pragma omp parallel
+    {
+        int threadStart, threadEnd;
+        getThreadRange(start, end, &threadStart, &threadEnd);
+        kernels.computeBilinearEdge(vdesc, vertex, varying, E_IT, offset,
+                                    threadStart, threadEnd, nonTemporal);
     }
 }
 
 void OsdOmpComputeBilinearVertex(
-    const OsdVertexDescriptor *vdesc, float *vertex, float *varying,
+    const OsdVertexDescriptor *vdesc, void *vertex, void *varying,
     const int *V_ITa, int offset, int start, int end) {
 
-#pragma omp parallel for
-    for (int i = start; i < end; i++) {
-        int p = V_ITa[i];
+    OsdCpuKernels const & kernels = OsdCpuGetKernels();
+    bool nonTemporal = OsdCpuUseNonTemporalStores(vdesc, end-start);
+
+#pragma omp parallel
+    {
+        int threadStart, threadEnd;
+        getThreadRange(start, end, &threadStart, &threadEnd);
+        kernels.computeBilinearVertex(vdesc, vertex, varying, V_ITa, offset,
+                                      threadStart, threadEnd, nonTemporal);
+    }
+}
 
-        int dstIndex = offset + i;
-        vdesc->Clear(vertex, varying, dstIndex);
+void OsdOmpComputeStencils(
+    void *buffer, int numElements, int stride, OsdPrecision precision,
+    const int *sizes, const int *offsets,
+    const int *indices, const float *weights,
+    int offset, int start, int end) {
 
-        vdesc->AddWithWeight(vertex, dstIndex, p, 1.0f);
-        vdesc->AddVaryingWithWeight(varying, dstIndex, p, 1.0f);
+    OsdCpuKernels const & kernels = OsdCpuGetKernels();
+    bool nonTemporal = OsdCpuUseNonTemporalStores(end-start, numElements,
+                                                  OsdGetScalarSize(precision));
+
+#pragma omp parallel
+    {
+        int threadStart, threadEnd;
+        getThreadRange(start, end, &threadStart, &threadEnd);
+        kernels.computeStencils(buffer, numElements, stride, precision,
+                                sizes, offsets, indices, weights, offset,
+                                threadStart, threadEnd, nonTemporal);
     }
 }
 
-void OsdOmpEditVertexAdd(
-    const OsdVertexDescriptor *vdesc, float *vertex,
-    int primVarOffset, int primVarWidth, int vertexCount,
-    const int *editIndices, const float *editValues) {
+template <class T> static void
+editVertexAdd(const OsdVertexDescriptor *vdesc, T *vertex,
+              int primVarOffset, int primVarWidth, int vertexCount,
+              const int *editIndices, const float *editValues) {
 
 #pragma omp parallel for
     for (int i = 0; i < vertexCount; i++) {
@@ -261,10 +219,10 @@ void OsdOmpEditVertexAdd(
     }
 }
 
-void OsdOmpEditVertexSet(
-    const OsdVertexDescriptor *vdesc, float *vertex,
-    int primVarOffset, int primVarWidth, int vertexCount,
-    const int *editIndices, const float *editValues) {
+template <class T> static void
+editVertexSet(const OsdVertexDescriptor *vdesc, T *vertex,
+              int primVarOffset, int primVarWidth, int vertexCount,
+              const int *editIndices, const float *editValues) {
 
 #pragma omp parallel for
     for (int i = 0; i < vertexCount; i++) {
@@ -273,6 +231,33 @@ void OsdOmpEditVertexSet(
     }
 }
 
+void OsdOmpEditVertexAdd(
+    const OsdVertexDescriptor *vdesc, void *vertex,
+    int primVarOffset, int primVarWidth, int vertexCount,
+    const int *editIndices, const float *editValues) {
+
+    if (vdesc->precision == OSD_PRECISION_DOUBLE) {
+        editVertexAdd(vdesc, static_cast<double *>(vertex), primVarOffset,
+                      primVarWidth, vertexCount, editIndices, editValues);
+    } else {
+        editVertexAdd(vdesc, static_cast<float *>(vertex), primVarOffset,
+                      primVarWidth, vertexCount, editIndices, editValues);
+    }
+}
+
+void OsdOmpEditVertexSet(
+    const OsdVertexDescriptor *vdesc, void *vertex,
+    int primVarOffset, int primVarWidth, int vertexCount,
+    const int *editIndices, const float *editValues) {
+
+    if (vdesc->precision == OSD_PRECISION_DOUBLE) {
+        editVertexSet(vdesc, static_cast<double *>(vertex), primVarOffset,
+                      primVarWidth, vertexCount, editIndices, editValues);
+    } else {
+        editVertexSet(vdesc, static_cast<float *>(vertex), primVarOffset,
+                      primVarWidth, vertexCount, editIndices, editValues);
+    }
+}
 
 }  // end namespace OPENSUBDIV_VERSION
 }  // end namespace OpenSubdiv
@@ -59,52 +59,54 @@
 
 #include "../version.h"
 
+#include "../osd/vertexDescriptor.h"
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
-struct OsdVertexDescriptor;
-
 void OsdOmpComputeFace(const OsdVertexDescriptor *vdesc,
-                       float * vertex, float * varying,
+                       void *vertex, void *varying,
                        const int *F_IT, const int *F_ITa,
                        int offset, int start, int end);
 
 void OsdOmpComputeEdge(const OsdVertexDescriptor *vdesc,
-                       float *vertex, float * varying,
+                       void *vertex, void *varying,
                        const int *E_IT, const float *E_ITa,
                        int offset, int start, int end);
 
-void OsdOmpComputeVertexA(const OsdVertexDescriptor *vdesc,
-                          float *vertex, float * varying,
-                          const int *V_ITa, const float *V_IT,
-                          int offset, int start, int end, int pass);
+void OsdOmpComputeVertex(const OsdVertexDescriptor *vdesc,
+                         void *vertex, void *varying,
+                         const int *V_ITa, const int *V_IT, const float *V_W,
+                         const unsigned char *V_R,
+                         int offset, int start, int end);
 
-void OsdOmpComputeVertexB(const OsdVertexDescriptor *vdesc,
-                          float *vertex, float * varying,
-                          const int *V_ITa, const int *V_IT, const float *V_W,
-                          int offset, int start, int end);
-
-void OsdOmpComputeLoopVertexB(const OsdVertexDescriptor *vdesc,
-                              float *vertex, float * varying,
-                              const int *V_ITa, const int *V_IT,
-                              const float *V_W,
-                              int offset, int start, int end);
+void OsdOmpComputeLoopVertex(const OsdVertexDescriptor *vdesc,
+                             void *vertex, void *varying,
+                             const int *V_ITa, const int *V_IT,
+                             const float *V_W, const unsigned char *V_R,
+                             int offset, int start, int end);
 
 void OsdOmpComputeBilinearEdge(const OsdVertexDescriptor *vdesc,
-                               float *vertex, float * varying,
+                               void *vertex, void *varying,
                                const int *E_IT,
                                int offset, int start, int end);
 
 void OsdOmpComputeBilinearVertex(const OsdVertexDescriptor *vdesc,
-                                 float *vertex, float * varying,
+                                 void *vertex, void *varying,
                                  const int *V_ITa,
                                  int offset, int start, int end);
 
-void OsdOmpEditVertexAdd(const OsdVertexDescriptor *vdesc, float *vertex,
+void OsdOmpComputeStencils(void *buffer, int numElements, int stride,
+                           OsdPrecision precision,
+                           const int *sizes, const int *offsets,
+                           const int *indices, const float *weights,
+                           int offset, int start, int end);
+
+void OsdOmpEditVertexAdd(const OsdVertexDescriptor *vdesc, void *vertex,
                          int primVarOffset, int primVarWidth, int count,
                          const int *editIndices, const float *editValues);
 
-void OsdOmpEditVertexSet(const OsdVertexDescriptor *vdesc, float *vertex,
+void OsdOmpEditVertexSet(const OsdVertexDescriptor *vdesc, void *vertex,
                          int primVarOffset, int primVarWidth, int count,
                          const int *editIndices, const float *editValues);
 
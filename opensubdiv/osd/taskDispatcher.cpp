@@ -0,0 +1,437 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+
+#include "../osd/taskDispatcher.h"
+#include "../osd/taskScheduler.h"
+#include "../osd/cpuKernel.h"
+#include "../osd/cpuKernelCommon.h"
+#include "../osd/cpuComputeContext.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+// Arguments of a kernel batch shared by all the tasks of the batch
+struct OsdTaskKernelArgs {
+    const OsdVertexDescriptor * vdesc;
+    void * vertex,
+         * varying;
+    const void * table0,
+               * table1,
+               * table2,
+               * table3;
+    int offset;
+    bool nonTemporal;
+};
+
+// The non-temporal stores are selected once for the whole batch [start, end) :
+// the tasks of the batch are too small to select them on their own.
+static void
+initKernelArgs(OsdTaskKernelArgs *args, OsdCpuComputeContext *context,
+               int offset, int start, int end) {
+
+    args->vdesc = context->GetVertexDescriptor();
+    args->vertex = context->GetCurrentVertexBuffer();
+    args->varying = context->GetCurrentVaryingBuffer();
+    args->table0 = args->table1 = args->table2 = args->table3 = 0;
+    args->offset = offset;
+    args->nonTemporal = OsdCpuUseNonTemporalStores(args->vdesc, end-start);
+}
+
+static void
+computeFaceTask(void *data, int start, int end) {
+
+    const OsdTaskKernelArgs * args = static_cast<const OsdTaskKernelArgs*>(data);
+    OsdCpuGetKernels().computeFace(
+        args->vdesc, args->vertex, args->varying,
+        (const int*)args->table0, (const int*)args->table1,
+        args->offset, start, end, args->nonTemporal);
+}
+
+static void
+computeEdgeTask(void *data, int start, int end) {
+
+    const OsdTaskKernelArgs * args = static_cast<const OsdTaskKernelArgs*>(data);
+    OsdCpuGetKernels().computeEdge(
+        args->vdesc, args->vertex, args->varying,
+        (const int*)args->table0, (const float*)args->table1,
+        args->offset, start, end, args->nonTemporal);
+}
+
+static void
+computeVertexTask(void *data, int start, int end) {
+
+    const OsdTaskKernelArgs * args = static_cast<const OsdTaskKernelArgs*>(data);
+    OsdCpuGetKernels().computeVertex(
+        args->vdesc, args->vertex, args->varying,
+        (const int*)args->table0, (const int*)args->table1,
+        (const float*)args->table2, (const unsigned char*)args->table3,
+        args->offset, start, end, args->nonTemporal);
+}
+
+static void
+computeLoopVertexTask(void *data, int start, int end) {
+
+    const OsdTaskKernelArgs * args = static_cast<const OsdTaskKernelArgs*>(data);
+    OsdCpuGetKernels().computeLoopVertex(
+        args->vdesc, args->vertex, args->varying,
+        (const int*)args->table0, (const int*)args->table1,
+        (const float*)args->table2, (const unsigned char*)args->table3,
+        args->offset, start, end, args->nonTemporal);
+}
+
+static void
+computeBilinearEdgeTask(void *data, int start, int end) {
+
+    const OsdTaskKernelArgs * args = static_cast<const OsdTaskKernelArgs*>(data);
+    OsdCpuGetKernels().computeBilinearEdge(
+        args->vdesc, args->vertex, args->varying,
+        (const int*)args->table0,
+        args->offset, start, end, args->nonTemporal);
+}
+
+static void
+computeBilinearVertexTask(void *data, int start, int end) {
+
+    const OsdTaskKernelArgs * args = static_cast<const OsdTaskKernelArgs*>(data);
+    OsdCpuGetKernels().computeBilinearVertex(
+        args->vdesc, args->vertex, args->varying,
+        (const int*)args->table0,
+        args->offset, start, end, args->nonTemporal);
+}
+
+// Arguments of a stencil batch
+struct OsdTaskStencilArgs {
+    void * buffer;
+    int numElements,
+        stride;
+    OsdPrecision precision;
+    FarStencilTables const * stencils;
+    bool nonTemporal;
+};
+
+static void
+computeStencilsTask(void *data, int start, int end) {
+
+    const OsdTaskStencilArgs * args =
+        static_cast<const OsdTaskStencilArgs*>(data);
+    FarStencilTables const * stencils = args->stencils;
+
+    OsdCpuGetKernels().computeStencils(
+        args->buffer, args->numElements, args->stride, args->precision,
+        &stencils->GetSizes()[0], &stencils->GetOffsets()[0],
+        &stencils->GetControlIndices()[0], &stencils->GetWeights()[0],
+        stencils->GetFirstVertexOffset(), start, end, args->nonTemporal);
+}
+
+OsdTaskKernelDispatcher::OsdTaskKernelDispatcher(OsdTaskScheduler *scheduler,
+                                                 int grainSize) :
+    _scheduler(scheduler), _grainSize(grainSize) {
+
+    assert(scheduler);
+}
+
+OsdTaskKernelDispatcher::~OsdTaskKernelDispatcher() {
+}
+
+void
+OsdTaskKernelDispatcher::Refine(FarMesh<OsdVertex> * mesh,
+                                OsdCpuComputeContext *context) const {
+
+    if (context->GetVertexStencilTables()) {
+        ApplyStencilTables(context);
+        return;
+    }
+
+    FarDispatcher<OsdVertex>::Refine(mesh, /*maxlevel =*/ -1, context);
+}
+
+void
+OsdTaskKernelDispatcher::ApplyStencilTables(OsdCpuComputeContext *context) const {
+
+    const OsdVertexDescriptor *vdesc = context->GetVertexDescriptor();
+
+    OsdTaskStencilArgs args;
+
+    FarStencilTables const *stencils = context->GetVertexStencilTables();
+    if (context->GetCurrentVertexBuffer() and stencils->GetNumStencils() > 0) {
+        args.buffer = context->GetCurrentVertexBuffer();
+        args.numElements = vdesc->numVertexElements;
+        args.stride = vdesc->vertexStride;
+        args.precision = vdesc->precision;
+        args.stencils = stencils;
+        args.nonTemporal = OsdCpuUseNonTemporalStores(
+            stencils->GetNumStencils(), args.numElements,
+            OsdGetScalarSize(args.precision));
+        _scheduler->ParallelFor(0, stencils->GetNumStencils(), _grainSize,
+                                computeStencilsTask, &args);
+    }
+
+    stencils = context->GetVaryingStencilTables();
+    if (context->GetCurrentVaryingBuffer() and stencils and
+        stencils->GetNumStencils() > 0) {
+        args.buffer = context->GetCurrentVaryingBuffer();
+        args.numElements = vdesc->numVaryingElements;
+        args.stride = vdesc->varyingStride;
+        args.precision = vdesc->precision;
+        args.stencils = stencils;
+        args.nonTemporal = OsdCpuUseNonTemporalStores(
+            stencils->GetNumStencils(), args.numElements,
+            OsdGetScalarSize(args.precision));
+        _scheduler->ParallelFor(0, stencils->GetNumStencils(), _grainSize,
+                                computeStencilsTask, &args);
+    }
+}
+
+size_t
+OsdTaskKernelDispatcher::GetVertexSize(void * clientdata) const {
+
+    OsdVertexDescriptor const *vdesc =
+        static_cast<OsdCpuComputeContext*>(clientdata)->GetVertexDescriptor();
+
+    return (vdesc->numVertexElements + vdesc->numVaryingElements) *
+           OsdGetScalarSize(vdesc->precision);
+}
+
+void
+OsdTaskKernelDispatcher::ApplyBilinearFaceVerticesKernel(
+    FarMesh<OsdVertex> * mesh, int offset, int level,
+    int start, int end, void * clientdata) const {
+
+    OsdCpuComputeContext * context =
+        static_cast<OsdCpuComputeContext*>(clientdata);
+    assert(context);
+
+    OsdTaskKernelArgs args;
+    initKernelArgs(&args, context, offset, start, end);
+    args.table0 = context->GetTablePtr(Table::F_IT, level-1);
+    args.table1 = context->GetTablePtr(Table::F_ITa, level-1);
+
+    _scheduler->ParallelFor(start, end, _grainSize, computeFaceTask, &args);
+}
+
+void
+OsdTaskKernelDispatcher::ApplyBilinearEdgeVerticesKernel(
+    FarMesh<OsdVertex> * mesh, int offset, int level,
+    int start, int end, void * clientdata) const {
+
+    OsdCpuComputeContext * context =
+        static_cast<OsdCpuComputeContext*>(clientdata);
+    assert(context);
+
+    OsdTaskKernelArgs args;
+    initKernelArgs(&args, context, offset, start, end);
+    args.table0 = context->GetTablePtr(Table::E_IT, level-1);
+
+    _scheduler->ParallelFor(start, end, _grainSize,
+                            computeBilinearEdgeTask, &args);
+}
+
+void
+OsdTaskKernelDispatcher::ApplyBilinearVertexVerticesKernel(
+    FarMesh<OsdVertex> * mesh, int offset, int level,
+    int start, int end, void * clientdata) const {
+
+    OsdCpuComputeContext * context =
+        static_cast<OsdCpuComputeContext*>(clientdata);
+    assert(context);
+
+    OsdTaskKernelArgs args;
+    initKernelArgs(&args, context, offset, start, end);
+    args.table0 = context->GetTablePtr(Table::V_ITa, level-1);
+
+    _scheduler->ParallelFor(start, end, _grainSize,
+                            computeBilinearVertexTask, &args);
+}
+
+void
+OsdTaskKernelDispatcher::ApplyCatmarkFaceVerticesKernel(
+    FarMesh<OsdVertex> * mesh, int offset, int level,
+    int start, int end, void * clientdata) const {
+
+    OsdCpuComputeContext * context =
+        static_cast<OsdCpuComputeContext*>(clientdata);
+    assert(context);
+
+    OsdTaskKernelArgs args;
+    initKernelArgs(&args, context, offset, start, end);
+    args.table0 = context->GetTablePtr(Table::F_IT, level-1);
+    args.table1 = context->GetTablePtr(Table::F_ITa, level-1);
+
+    _scheduler->ParallelFor(start, end, _grainSize, computeFaceTask, &args);
+}
+
+void
+OsdTaskKernelDispatcher::ApplyCatmarkEdgeVerticesKernel(
+    FarMesh<OsdVertex> * mesh, int offset, int level,
+    int start, int end, void * clientdata) const {
+
+    OsdCpuComputeContext * context =
+        static_cast<OsdCpuComputeContext*>(clientdata);
+    assert(context);
+
+    OsdTaskKernelArgs args;
+    initKernelArgs(&args, context, offset, start, end);
+    args.table0 = context->GetTablePtr(Table::E_IT, level-1);
+    args.table1 = context->GetTablePtr(Table::E_W, level-1);
+
+    _scheduler->ParallelFor(start, end, _grainSize, computeEdgeTask, &args);
+}
+
+void
+OsdTaskKernelDispatcher::ApplyCatmarkVertexVerticesKernel(
+    FarMesh<OsdVertex> * mesh, int offset, int level,
+    int start, int end, void * clientdata) const {
+
+    OsdCpuComputeContext * context =
+        static_cast<OsdCpuComputeContext*>(clientdata);
+    assert(context);
+
+    OsdTaskKernelArgs args;
+    initKernelArgs(&args, context, offset, start, end);
+    args.table0 = context->GetTablePtr(Table::V_ITa, level-1);
+    args.table1 = context->GetTablePtr(Table::V_IT, level-1);
+    args.table2 = context->GetTablePtr(Table::V_W, level-1);
+    args.table3 = context->GetTablePtr(Table::V_R, level-1);
+
+    _scheduler->ParallelFor(start, end, _grainSize,
+                            computeVertexTask, &args);
+}
+
+void
+OsdTaskKernelDispatcher::ApplyLoopEdgeVerticesKernel(
+    FarMesh<OsdVertex> * mesh, int offset, int level,
+    int start, int end, void * clientdata) const {
+
+    OsdCpuComputeContext * context =
+        static_cast<OsdCpuComputeContext*>(clientdata);
+    assert(context);
+
+    OsdTaskKernelArgs args;
+    initKernelArgs(&args, context, offset, start, end);
+    args.table0 = context->GetTablePtr(Table::E_IT, level-1);
+    args.table1 = context->GetTablePtr(Table::E_W, level-1);
+
+    _scheduler->ParallelFor(start, end, _grainSize, computeEdgeTask, &args);
+}
+
+void
+OsdTaskKernelDispatcher::ApplyLoopVertexVerticesKernel(
+    FarMesh<OsdVertex> * mesh, int offset, int level,
+    int start, int end, void * clientdata) const {
+
+    OsdCpuComputeContext * context =
+        static_cast<OsdCpuComputeContext*>(clientdata);
+    assert(context);
+
+    OsdTaskKernelArgs args;
+    initKernelArgs(&args, context, offset, start, end);
+    args.table0 = context->GetTablePtr(Table::V_ITa, level-1);
+    args.table1 = context->GetTablePtr(Table::V_IT, level-1);
+    args.table2 = context->GetTablePtr(Table::V_W, level-1);
+    args.table3 = context->GetTablePtr(Table::V_R, level-1);
+
+    _scheduler->ParallelFor(start, end, _grainSize,
+                            computeLoopVertexTask, &args);
+}
+
+void
+OsdTaskKernelDispatcher::ApplyVertexEdits(
+    FarMesh<OsdVertex> *mesh, int offset, int level, void *clientdata) const {
+
+    OsdCpuComputeContext * context =
+        static_cast<OsdCpuComputeContext*>(clientdata);
+    assert(context);
+
+    // Edits of a batch may target the same vertex several times : they are
+    // applied serially, in order, as the CPU dispatcher does.
+    int numEdits = context->GetNumEditTables();
+
+    for (int i = 0; i < numEdits; ++i) {
+
+        const FarVertexEditTables<OsdVertex>::VertexEditBatch * edit =
+            context->GetEditTable(i);
+        assert(edit);
+
+        const FarTable<unsigned int> &primvarIndices = edit->GetVertexIndices();
+        const FarTable<float> &editValues = edit->GetValues();
+
+        if (edit->GetOperation() == FarVertexEdit::Add) {
+            OsdCpuEditVertexAdd(context->GetVertexDescriptor(),
+                                context->GetCurrentVertexBuffer(),
+                                edit->GetPrimvarIndex(),
+                                edit->GetPrimvarWidth(),
+                                primvarIndices.GetNumElements(level-1),
+                                (const int*)primvarIndices[level-1],
+                                (const float*)editValues[level-1]);
+        } else if (edit->GetOperation() == FarVertexEdit::Set) {
+            OsdCpuEditVertexSet(context->GetVertexDescriptor(),
+                                context->GetCurrentVertexBuffer(),
+                                edit->GetPrimvarIndex(),
+                                edit->GetPrimvarWidth(),
+                                primvarIndices.GetNumElements(level-1),
+                                (const int*)primvarIndices[level-1],
+                                (const float*)editValues[level-1]);
+        }
+    }
+}
+
+}  // end namespace OPENSUBDIV_VERSION
+
+}  // end namespace OpenSubdiv
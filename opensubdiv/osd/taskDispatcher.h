@@ -0,0 +1,146 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef OSD_TASK_DISPATCHER_H
+#define OSD_TASK_DISPATCHER_H
+
+#include "../version.h"
+
+#include "../osd/vertex.h"
+#include "../far/dispatcher.h"
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+class OsdCpuComputeContext;
+class OsdTaskScheduler;
+
+/// \brief Kernel dispatcher running the CPU kernels as parallel tasks.
+///
+/// Every kernel batch [start, end) is split into chunks of at most
+/// grainSize vertices which are executed with the CPU kernels by an
+/// OsdTaskScheduler. Each refined vertex only depends on the vertices of
+/// the previous passes, so the results do not depend on the chunking and
+/// are identical to the single threaded CPU dispatcher.
+class OsdTaskKernelDispatcher : public FarDispatcher<OsdVertex>
+{
+public:
+    OsdTaskKernelDispatcher(OsdTaskScheduler *scheduler, int grainSize);
+
+    virtual ~OsdTaskKernelDispatcher();
+
+    void Refine(FarMesh<OsdVertex> * mesh, OsdCpuComputeContext *context) const;
+
+    OsdTaskScheduler * GetScheduler() const { return _scheduler; }
+
+    int GetGrainSize() const { return _grainSize; }
+
+protected:
+    // Computes the vertices covered by the stencil tables of the context
+    void ApplyStencilTables(OsdCpuComputeContext *context) const;
+
+    virtual size_t GetVertexSize(void * clientdata) const;
+
+    virtual void ApplyBilinearFaceVerticesKernel(
+        FarMesh<OsdVertex> * mesh, int offset, int level,
+        int start, int end, void * clientdata) const;
+
+    virtual void ApplyBilinearEdgeVerticesKernel(
+        FarMesh<OsdVertex> * mesh, int offset, int level,
+        int start, int end, void * clientdata) const;
+
+    virtual void ApplyBilinearVertexVerticesKernel(
+        FarMesh<OsdVertex> * mesh, int offset, int level,
+        int start, int end, void * clientdata) const;
+
+
+    virtual void ApplyCatmarkFaceVerticesKernel(
+        FarMesh<OsdVertex> * mesh, int offset, int level,
+        int start, int end, void * clientdata) const;
+
+    virtual void ApplyCatmarkEdgeVerticesKernel(
+        FarMesh<OsdVertex> * mesh, int offset, int level,
+        int start, int end, void * clientdata) const;
+
+    virtual void ApplyCatmarkVertexVerticesKernel(
+        FarMesh<OsdVertex> * mesh, int offset, int level,
+        int start, int end, void * clientdata) const;
+
+
+    virtual void ApplyLoopEdgeVerticesKernel(
+        FarMesh<OsdVertex> * mesh, int offset, int level,
+        int start, int end, void * clientdata) const;
+
+    virtual void ApplyLoopVertexVerticesKernel(
+        FarMesh<OsdVertex> * mesh, int offset, int level,
+        int start, int end, void * clientdata) const;
+
+    virtual void ApplyVertexEdits(
+        FarMesh<OsdVertex> *mesh, int offset, int level,
+        void * clientdata) const;
+
+private:
+    OsdTaskScheduler * _scheduler;
+
+    int _grainSize;
+};
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* OSD_TASK_DISPATCHER_H */
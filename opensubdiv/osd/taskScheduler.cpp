@@ -0,0 +1,641 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+
+#include "../osd/taskScheduler.h"
+
+#include <cassert>
+#include <deque>
+#include <vector>
+
+#if defined(_WIN32)
+    #include <windows.h>
+    #include <process.h>
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+// Minimal threading primitives : the pool only needs a mutex, a condition
+// variable, an atomic counter, thread creation and a thread local worker index.
+#if defined(_WIN32)
+
+typedef CRITICAL_SECTION   PoolMutex;
+typedef CONDITION_VARIABLE PoolCondition;
+typedef HANDLE             PoolThread;
+typedef DWORD              PoolThreadKey;
+typedef volatile LONG      PoolCounter;
+
+static void initMutex(PoolMutex *m)     { InitializeCriticalSection(m); }
+static void destroyMutex(PoolMutex *m)  { DeleteCriticalSection(m); }
+static void lockMutex(PoolMutex *m)     { EnterCriticalSection(m); }
+static void unlockMutex(PoolMutex *m)   { LeaveCriticalSection(m); }
+
+static void initCondition(PoolCondition *c) { InitializeConditionVariable(c); }
+static void destroyCondition(PoolCondition *) { }
+static void waitCondition(PoolCondition *c, PoolMutex *m) {
+    SleepConditionVariableCS(c, m, INFINITE);
+}
+static void signalCondition(PoolCondition *c) {
+    WakeConditionVariable(c);
+}
+static void broadcastCondition(PoolCondition *c) {
+    WakeAllConditionVariable(c);
+}
+
+// returns the new value (full memory barrier)
+static long atomicAdd(PoolCounter *c, long n) { return InterlockedExchangeAdd(c, n) + n; }
+
+static void createKey(PoolThreadKey *k)  { *k = TlsAlloc(); }
+static void deleteKey(PoolThreadKey k)   { TlsFree(k); }
+static void setKey(PoolThreadKey k, void *value) { TlsSetValue(k, value); }
+static void *getKey(PoolThreadKey k)     { return TlsGetValue(k); }
+
+#else
+
+typedef pthread_mutex_t PoolMutex;
+typedef pthread_cond_t  PoolCondition;
+typedef pthread_t       PoolThread;
+typedef pthread_key_t   PoolThreadKey;
+typedef volatile long   PoolCounter;
+
+static void initMutex(PoolMutex *m)     { pthread_mutex_init(m, NULL); }
+static void destroyMutex(PoolMutex *m)  { pthread_mutex_destroy(m); }
+static void lockMutex(PoolMutex *m)     { pthread_mutex_lock(m); }
+static void unlockMutex(PoolMutex *m)   { pthread_mutex_unlock(m); }
+
+static void initCondition(PoolCondition *c) { pthread_cond_init(c, NULL); }
+static void destroyCondition(PoolCondition *c) { pthread_cond_destroy(c); }
+static void waitCondition(PoolCondition *c, PoolMutex *m) {
+    pthread_cond_wait(c, m);
+}
+static void signalCondition(PoolCondition *c) {
+    pthread_cond_signal(c);
+}
+static void broadcastCondition(PoolCondition *c) {
+    pthread_cond_broadcast(c);
+}
+
+// returns the new value (full memory barrier)
+static long atomicAdd(PoolCounter *c, long n) { return __sync_add_and_fetch(c, n); }
+
+static void createKey(PoolThreadKey *k)  { pthread_key_create(k, NULL); }
+static void deleteKey(PoolThreadKey k)   { pthread_key_delete(k); }
+static void setKey(PoolThreadKey k, void *value) { pthread_setspecific(k, value); }
+static void *getKey(PoolThreadKey k)     { return pthread_getspecific(k); }
+
+#endif
+
+static long atomicLoad(PoolCounter *c) { return atomicAdd(c, 0); }
+
+struct OsdTaskThreadPool::Pool {
+
+    // A ParallelFor call : 'remaining' counts the indices left to process
+    struct Job {
+        TaskFunction function;
+        void * data;
+        int grainSize;
+        PoolCounter remaining;
+    };
+
+    struct Task {
+        Job * job;
+        int start,
+            end;
+    };
+
+    struct Worker {
+        Pool * pool;
+        int index;
+    };
+
+    // A deque and its own lock : the owner pushes and pops tasks at the back,
+    // other threads steal them from the front
+    struct TaskQueue {
+        PoolMutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    // The mutex only guards the idle threads going to sleep and being woken
+    // up : the deques are locked separately, so that pushing or stealing a
+    // task does not serialize all the threads.
+    PoolMutex mutex;
+    PoolCondition condition;
+    PoolThreadKey workerKey;
+
+    // one deque per worker thread, the last one is shared by the threads
+    // calling ParallelFor that do not belong to the pool
+    std::vector<TaskQueue> queues;
+
+    std::vector<Worker> workers;
+    std::vector<PoolThread> threads;
+
+    PoolCounter numQueued, // tasks in all the deques
+                numIdle;   // threads looking for a task under the mutex
+
+    bool stop;
+
+    Pool(int numWorkers);
+
+    ~Pool();
+
+    // Returns the deque of the calling thread
+    int GetQueueIndex() const;
+
+    // Pops a task from the calling thread deque or steals one from another
+    // deque.
+    bool PopTask(int queueIndex, Task *task);
+
+    // Pushes a task to the deque of the calling thread and wakes up one idle
+    // thread, if any.
+    void PushTask(int queueIndex, Task const & task);
+
+    // Waits until a task is available (returns true) or until there is no
+    // reason to wait anymore : the pool stops, or 'job' is complete.
+    bool WaitTask(int queueIndex, Task *task, Job * job);
+
+    // Splits the task down to the grain size, pushing the upper halves to
+    // the deque of the calling thread, and executes the remaining chunk.
+    void Execute(int queueIndex, Task task);
+
+    void WorkerLoop(int queueIndex);
+
+#if defined(_WIN32)
+    static unsigned __stdcall WorkerMain(void *arg);
+#else
+    static void *WorkerMain(void *arg);
+#endif
+};
+
+OsdTaskThreadPool::Pool::Pool(int numWorkers) :
+    queues(numWorkers+1), workers(numWorkers), threads(numWorkers),
+    numQueued(0), numIdle(0), stop(false) {
+
+    initMutex(&mutex);
+    initCondition(&condition);
+    createKey(&workerKey);
+
+    for (int i = 0; i < (int)queues.size(); ++i)
+        initMutex(&queues[i].mutex);
+
+    for (int i = 0; i < numWorkers; ++i) {
+        workers[i].pool = this;
+        workers[i].index = i;
+#if defined(_WIN32)
+        threads[i] = (HANDLE)_beginthreadex(NULL, 0, WorkerMain, &workers[i],
+                                            0, NULL);
+#else
+        pthread_create(&threads[i], NULL, WorkerMain, &workers[i]);
+#endif
+    }
+}
+
+OsdTaskThreadPool::Pool::~Pool() {
+
+    lockMutex(&mutex);
+    stop = true;
+    broadcastCondition(&condition);
+    unlockMutex(&mutex);
+
+    for (int i = 0; i < (int)threads.size(); ++i) {
+#if defined(_WIN32)
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
+    }
+
+    for (int i = 0; i < (int)queues.size(); ++i)
+        destroyMutex(&queues[i].mutex);
+
+    deleteKey(workerKey);
+    destroyCondition(&condition);
+    destroyMutex(&mutex);
+}
+
+#if defined(_WIN32)
+unsigned __stdcall
+#else
+void *
+#endif
+OsdTaskThreadPool::Pool::WorkerMain(void *arg) {
+
+    Worker * worker = static_cast<Worker*>(arg);
+    setKey(worker->pool->workerKey, worker);
+    worker->pool->WorkerLoop(worker->index);
+    return 0;
+}
+
+int
+OsdTaskThreadPool::Pool::GetQueueIndex() const {
+
+    Worker const * worker = static_cast<Worker const *>(getKey(workerKey));
+    return worker ? worker->index : (int)queues.size()-1;
+}
+
+bool
+OsdTaskThreadPool::Pool::PopTask(int queueIndex, Task *task) {
+
+    if (atomicLoad(&numQueued) == 0)
+        return false;
+
+    // most recent task of our own deque first (best cache locality)
+    TaskQueue & own = queues[queueIndex];
+    lockMutex(&own.mutex);
+    bool found = not own.tasks.empty();
+    if (found) {
+        *task = own.tasks.back();
+        own.tasks.pop_back();
+    }
+    unlockMutex(&own.mutex);
+
+    // otherwise steal the oldest (largest) task of another deque
+    int numQueues = (int)queues.size();
+    for (int i = 1; i < numQueues and not found; ++i) {
+        TaskQueue & victim = queues[(queueIndex+i) % numQueues];
+        lockMutex(&victim.mutex);
+        found = not victim.tasks.empty();
+        if (found) {
+            *task = victim.tasks.front();
+            victim.tasks.pop_front();
+        }
+        unlockMutex(&victim.mutex);
+    }
+
+    if (found)
+        atomicAdd(&numQueued, -1);
+    return found;
+}
+
+void
+OsdTaskThreadPool::Pool::PushTask(int queueIndex, Task const & task) {
+
+    TaskQueue & own = queues[queueIndex];
+    lockMutex(&own.mutex);
+    own.tasks.push_back(task);
+    unlockMutex(&own.mutex);
+
+    // the idle threads count themselves before looking for a task (see
+    // WaitTask) : either they find this task, or they are counted here and
+    // one of them is woken up (the mutex is held until they wait)
+    atomicAdd(&numQueued, 1);
+    if (atomicLoad(&numIdle) > 0) {
+        lockMutex(&mutex);
+        signalCondition(&condition);
+        unlockMutex(&mutex);
+    }
+}
+
+bool
+OsdTaskThreadPool::Pool::WaitTask(int queueIndex, Task *task, Job * job) {
+
+    lockMutex(&mutex);
+    atomicAdd(&numIdle, 1);
+
+    bool found = PopTask(queueIndex, task);
+    if (not found and not stop and not (job and atomicLoad(&job->remaining) == 0))
+        waitCondition(&condition, &mutex);
+
+    atomicAdd(&numIdle, -1);
+    unlockMutex(&mutex);
+    return found;
+}
+
+void
+OsdTaskThreadPool::Pool::Execute(int queueIndex, Task task) {
+
+    Job * job = task.job;
+
+    while (task.end - task.start > job->grainSize) {
+
+        Task upper = task;
+        upper.start = task.start + (task.end - task.start)/2;
+        task.end = upper.start;
+
+        PushTask(queueIndex, upper);
+    }
+
+    job->function(job->data, task.start, task.end);
+
+    // the thread calling ParallelFor may wait for the completion of the job
+    // (the job is not accessed anymore once it is complete)
+    if (atomicAdd(&job->remaining, -(task.end - task.start)) == 0 and
+        atomicLoad(&numIdle) > 0) {
+        lockMutex(&mutex);
+        broadcastCondition(&condition);
+        unlockMutex(&mutex);
+    }
+}
+
+void
+OsdTaskThreadPool::Pool::WorkerLoop(int queueIndex) {
+
+    for (;;) {
+        Task task;
+        if (PopTask(queueIndex, &task) or WaitTask(queueIndex, &task, 0)) {
+            Execute(queueIndex, task);
+        } else {
+            lockMutex(&mutex);
+            bool done = stop;
+            unlockMutex(&mutex);
+            if (done)
+                break;
+        }
+    }
+}
+
+OsdTaskThreadPool::OsdTaskThreadPool(int numThreads) {
+
+    _numThreads = (numThreads == -1) ? GetNumProcessors() : numThreads;
+    if (_numThreads < 1)
+        _numThreads = 1;
+
+    // the thread calling ParallelFor is the last worker
+    _pool = new Pool(_numThreads-1);
+}
+
+OsdTaskThreadPool::~OsdTaskThreadPool() {
+
+    delete _pool;
+}
+
+void
+OsdTaskThreadPool::ParallelFor(int start, int end, int grainSize,
+                               TaskFunction function, void *data) {
+
+    if (end <= start)
+        return;
+
+    if (grainSize < 1)
+        grainSize = 1;
+
+    if (_numThreads == 1 or end - start <= grainSize) {
+        function(data, start, end);
+        return;
+    }
+
+    Pool::Job job;
+    job.function = function;
+    job.data = data;
+    job.grainSize = grainSize;
+    job.remaining = end - start;
+
+    Pool::Task task;
+    task.job = &job;
+    task.start = start;
+    task.end = end;
+
+    int queueIndex = _pool->GetQueueIndex();
+
+    _pool->Execute(queueIndex, task);
+
+    // help with pending tasks (ours or not) until the job is complete
+    while (atomicLoad(&job.remaining) > 0) {
+        if (_pool->PopTask(queueIndex, &task) or
+            _pool->WaitTask(queueIndex, &task, &job))
+            _pool->Execute(queueIndex, task);
+    }
+}
+
+struct OsdTaskWorker::Job::State {
+
+    PoolMutex mutex;
+    PoolCondition condition;
+
+    OsdTaskWorker * worker; // worker running the job until it completes
+};
+
+OsdTaskWorker::Job::Job() : function(0), data(0), next(0) {
+
+    _state = new State;
+    _state->worker = 0;
+    initMutex(&_state->mutex);
+    initCondition(&_state->condition);
+}
+
+OsdTaskWorker::Job::~Job() {
+
+    destroyCondition(&_state->condition);
+    destroyMutex(&_state->mutex);
+    delete _state;
+}
+
+struct OsdTaskWorker::Queue {
+
+    PoolMutex mutex;
+    PoolCondition condition;
+    PoolThread thread;
+
+    Job * first,  // jobs waiting for the worker thread
+        * last;
+
+    int numPending; // jobs submitted and not completed
+
+    bool stop;
+
+    void WorkerLoop();
+
+#if defined(_WIN32)
+    static unsigned __stdcall WorkerMain(void *arg);
+#else
+    static void *WorkerMain(void *arg);
+#endif
+};
+
+#if defined(_WIN32)
+unsigned __stdcall
+#else
+void *
+#endif
+OsdTaskWorker::Queue::WorkerMain(void *arg) {
+
+    static_cast<Queue*>(arg)->WorkerLoop();
+    return 0;
+}
+
+void
+OsdTaskWorker::Queue::WorkerLoop() {
+
+    lockMutex(&mutex);
+    for (;;) {
+        if (first) {
+            Job * job = first;
+            first = job->next;
+            if (not first)
+                last = 0;
+            unlockMutex(&mutex);
+
+            job->function(job->data);
+
+            // the job can be destroyed as soon as it is marked complete :
+            // it is not accessed anymore afterwards
+            Job::State * state = job->_state;
+            lockMutex(&state->mutex);
+            state->worker = 0;
+            broadcastCondition(&state->condition);
+            unlockMutex(&state->mutex);
+
+            lockMutex(&mutex);
+            --numPending;
+            broadcastCondition(&condition);
+        } else if (stop) {
+            break;
+        } else {
+            waitCondition(&condition, &mutex);
+        }
+    }
+    unlockMutex(&mutex);
+}
+
+OsdTaskWorker::OsdTaskWorker() {
+
+    _queue = new Queue;
+    _queue->first = _queue->last = 0;
+    _queue->numPending = 0;
+    _queue->stop = false;
+
+    initMutex(&_queue->mutex);
+    initCondition(&_queue->condition);
+
+#if defined(_WIN32)
+    _queue->thread = (HANDLE)_beginthreadex(NULL, 0, Queue::WorkerMain,
+                                            _queue, 0, NULL);
+#else
+    pthread_create(&_queue->thread, NULL, Queue::WorkerMain, _queue);
+#endif
+}
+
+OsdTaskWorker::~OsdTaskWorker() {
+
+    // the worker thread completes the queued jobs before stopping
+    lockMutex(&_queue->mutex);
+    _queue->stop = true;
+    broadcastCondition(&_queue->condition);
+    unlockMutex(&_queue->mutex);
+
+#if defined(_WIN32)
+    WaitForSingleObject(_queue->thread, INFINITE);
+    CloseHandle(_queue->thread);
+#else
+    pthread_join(_queue->thread, NULL);
+#endif
+
+    destroyCondition(&_queue->condition);
+    destroyMutex(&_queue->mutex);
+
+    delete _queue;
+}
+
+void
+OsdTaskWorker::Submit(Job *job) {
+
+    assert(job and job->function);
+
+    lockMutex(&job->_state->mutex);
+    assert(not job->_state->worker);
+    job->_state->worker = this;
+    unlockMutex(&job->_state->mutex);
+
+    lockMutex(&_queue->mutex);
+    job->next = 0;
+    if (_queue->last)
+        _queue->last->next = job;
+    else
+        _queue->first = job;
+    _queue->last = job;
+    ++_queue->numPending;
+    broadcastCondition(&_queue->condition);
+    unlockMutex(&_queue->mutex);
+}
+
+void
+OsdTaskWorker::Wait(Job const *job) {
+
+    Job::State * state = job->_state;
+    lockMutex(&state->mutex);
+    while (state->worker)
+        waitCondition(&state->condition, &state->mutex);
+    unlockMutex(&state->mutex);
+}
+
+void
+OsdTaskWorker::WaitAll() {
+
+    lockMutex(&_queue->mutex);
+    while (_queue->numPending > 0)
+        waitCondition(&_queue->condition, &_queue->mutex);
+    unlockMutex(&_queue->mutex);
+}
+
+int
+OsdTaskThreadPool::GetNumProcessors() {
+
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+}  // end namespace OPENSUBDIV_VERSION
+}  // end namespace OpenSubdiv
@@ -0,0 +1,194 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef OSD_TASK_SCHEDULER_H
+#define OSD_TASK_SCHEDULER_H
+
+#include "../version.h"
+
+#include "../osd/nonCopyable.h"
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Interface of the task schedulers driving OsdTaskComputeController.
+///
+/// A scheduler splits an index range into chunks and runs them concurrently.
+/// Applications that already run their own task system (TBB, a job manager
+/// of the host application...) can implement this interface on top of it so
+/// that subdivision shares the same worker threads instead of
+/// oversubscribing the machine with a second pool.
+///
+/// Implementations must allow ParallelFor to be called from inside a running
+/// task (nested parallelism) : the calling thread is expected to keep
+/// executing tasks while it waits for its own range to complete.
+///
+class OsdTaskScheduler {
+public:
+    /// Function executed for every chunk [start, end) of a range
+    typedef void (*TaskFunction)(void *data, int start, int end);
+
+    virtual ~OsdTaskScheduler() {}
+
+    /// Calls function on disjoint chunks covering [start, end), chunks
+    /// being at most grainSize long. Returns once every chunk has completed.
+    virtual void ParallelFor(int start, int end, int grainSize,
+                             TaskFunction function, void *data) = 0;
+};
+
+/// \brief Default work-stealing thread pool.
+///
+/// Every worker owns a deque of tasks : ranges are split in halves, the
+/// upper half being pushed to the deque of the executing thread and the
+/// lower half executed right away. Workers pop their own tasks from the
+/// back of their deque and steal from the front of the other deques when
+/// they run out of work.
+///
+/// The thread calling ParallelFor participates in the computation and helps
+/// with pending tasks until its range is complete, which makes nested calls
+/// (ParallelFor from inside a task) deadlock free.
+///
+class OsdTaskThreadPool : public OsdTaskScheduler,
+                          OsdNonCopyable<OsdTaskThreadPool> {
+public:
+    /// Constructor.
+    /// numThreads is the number of threads executing tasks, including the
+    /// thread calling ParallelFor. numThreads=-1 means to use the available
+    /// number of processors.
+    explicit OsdTaskThreadPool(int numThreads=-1);
+
+    /// Destructor : waits for the worker threads to exit.
+    virtual ~OsdTaskThreadPool();
+
+    /// Returns the number of threads executing tasks
+    int GetNumThreads() const { return _numThreads; }
+
+    virtual void ParallelFor(int start, int end, int grainSize,
+                             TaskFunction function, void *data);
+
+    /// Returns the number of processors available
+    static int GetNumProcessors();
+
+private:
+    struct Pool;
+
+    Pool * _pool;
+
+    int _numThreads;
+};
+
+/// \brief Background thread running jobs one after the other.
+///
+/// Jobs are executed by a single worker thread, in submission order. The jobs
+/// are owned by the caller and must remain valid until they complete : the
+/// worker does not allocate any memory once created. A job can only be
+/// submitted again once it has completed.
+///
+class OsdTaskWorker : OsdNonCopyable<OsdTaskWorker> {
+public:
+    /// A job executed by the worker. The worker running a pending job is
+    /// guarded by a lock of the job : waiting for a job does not require to
+    /// know which worker it was submitted to.
+    struct Job : OsdNonCopyable<Job> {
+        typedef void (*Function)(void *data);
+
+        /// Constructor : allocates the lock of the job
+        Job();
+
+        ~Job();
+
+        Function function;      ///< function executed by the worker thread
+        void * data;            ///< argument of the function
+
+        Job * next;             ///< next job of the queue (set by the worker)
+
+    private:
+        friend class OsdTaskWorker;
+
+        struct State;
+
+        State * _state;
+    };
+
+    /// Constructor : starts the worker thread.
+    OsdTaskWorker();
+
+    /// Destructor : completes the pending jobs and waits for the worker
+    /// thread to exit.
+    ~OsdTaskWorker();
+
+    /// Queues a job and returns immediately.
+    void Submit(Job *job);
+
+    /// Waits until a job completes, whichever worker it was submitted to.
+    /// Returns immediately if the job is not pending.
+    static void Wait(Job const *job);
+
+    /// Waits until all the submitted jobs complete.
+    void WaitAll();
+
+private:
+    struct Queue;
+
+    Queue * _queue;
+};
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // OSD_TASK_SCHEDULER_H
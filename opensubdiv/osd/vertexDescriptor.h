@@ -61,52 +61,130 @@
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
+/// Scalar types of the buffers being refined and of the kernel accumulations
+enum OsdPrecision {
+    OSD_PRECISION_FLOAT,   ///< float buffers, float accumulations
+    OSD_PRECISION_DOUBLE,  ///< double buffers, double accumulations
+    OSD_PRECISION_MIXED    ///< float buffers, double accumulations
+};
+
+/// Returns the size of the scalars of the buffers refined with a precision
+inline int OsdGetScalarSize(OsdPrecision precision) {
+    return precision == OSD_PRECISION_DOUBLE ? (int)sizeof(double) : (int)sizeof(float);
+}
+
+/// Elements of a vertex buffer to refine : 'length' elements starting at
+/// element 'offset' of each vertex, consecutive vertices being 'stride'
+/// elements apart. Refines a subset of the primvars of an interleaved buffer
+/// in place.
+struct OsdVertexBufferDescriptor {
+
+    OsdVertexBufferDescriptor() : offset(0), length(0), stride(0) { }
+
+    OsdVertexBufferDescriptor(int o, int l, int s)
+        : offset(o), length(l), stride(s) { }
+
+    /// Returns true if the elements fit in the vertices
+    bool IsValid() const {
+        return offset >= 0 and length >= 0 and offset + length <= stride;
+    }
+
+    int offset;
+    int length;
+    int stride;
+};
+
+/// Layout of the vertices of the buffers being refined. The vertex elements
+/// can hold numSamples interleaved samples of the same vertex (ex. motion
+/// blur time samples) : each sample is numVertexElements/numSamples wide
+/// and the hierarchical edits are applied to every sample. The buffers hold
+/// floats or doubles, as set by the precision.
+///
+/// The buffers point to the first refined element of the first vertex : the
+/// refined elements of consecutive vertices are vertexStride (resp.
+/// varyingStride) elements apart. The primvar offsets of the edits are
+/// relative to the first refined element and the edits of the elements that
+/// are not refined are ignored.
 struct OsdVertexDescriptor {
 
-    OsdVertexDescriptor(int numVertexElem, int numVaryingElem)
+    OsdVertexDescriptor(int numVertexElem, int numVaryingElem, int numSamp=1,
+                        OsdPrecision prec=OSD_PRECISION_FLOAT)
         : numVertexElements(numVertexElem),
-        numVaryingElements(numVaryingElem) { }
+        numVaryingElements(numVaryingElem),
+        vertexStride(numVertexElem),
+        varyingStride(numVaryingElem),
+        numSamples(numSamp),
+        precision(prec) { }
+
+    OsdVertexDescriptor(OsdVertexBufferDescriptor const &vertexDesc,
+                        OsdVertexBufferDescriptor const &varyingDesc,
+                        int numSamp=1, OsdPrecision prec=OSD_PRECISION_FLOAT)
+        : numVertexElements(vertexDesc.length),
+        numVaryingElements(varyingDesc.length),
+        vertexStride(vertexDesc.stride),
+        varyingStride(varyingDesc.stride),
+        numSamples(numSamp),
+        precision(prec) { }
 
-    void Clear(float *vertex, float *varying, int index) const {
+    template <class T>
+    void Clear(T *vertex, T *varying, int index) const {
         if (vertex) {
             for (int i = 0; i < numVertexElements; ++i)
-                vertex[index*numVertexElements+i] = 0.0f;
+                vertex[index*vertexStride+i] = T(0);
         }
 
         if (varying) {
             for (int i = 0; i < numVaryingElements; ++i)
-                varying[index*numVaryingElements+i] = 0.0f;
+                varying[index*varyingStride+i] = T(0);
         }
     }
-    void AddWithWeight(float *vertex, int dstIndex, int srcIndex, float weight) const {
-        int d = dstIndex * numVertexElements;
-        int s = srcIndex * numVertexElements;
+    template <class T>
+    void AddWithWeight(T *vertex, int dstIndex, int srcIndex, T weight) const {
+        int d = dstIndex * vertexStride;
+        int s = srcIndex * vertexStride;
         for (int i = 0; i < numVertexElements; ++i)
             vertex[d++] += vertex[s++] * weight;
     }
-    void AddVaryingWithWeight(float *varying, int dstIndex, int srcIndex, float weight) const {
-        int d = dstIndex * numVaryingElements;
-        int s = srcIndex * numVaryingElements;
+    template <class T>
+    void AddVaryingWithWeight(T *varying, int dstIndex, int srcIndex, T weight) const {
+        int d = dstIndex * varyingStride;
+        int s = srcIndex * varyingStride;
         for (int i = 0; i < numVaryingElements; ++i)
             varying[d++] += varying[s++] * weight;
     }
 
-    void ApplyVertexEditAdd(float *vertex, int primVarOffset, int primVarWidth, int editIndex, const float *editValues) const {
-        int d = editIndex * numVertexElements + primVarOffset;
-        for (int i = 0; i < primVarWidth; ++i) {
-            vertex[d++] += editValues[i];
+    template <class T>
+    void ApplyVertexEditAdd(T *vertex, int primVarOffset, int primVarWidth, int editIndex, const float *editValues) const {
+        int sampleElements = numVertexElements / numSamples;
+        if (primVarOffset + primVarWidth > sampleElements)
+            return;
+        for (int s = 0; s < numSamples; ++s) {
+            int d = editIndex * vertexStride + s * sampleElements + primVarOffset;
+            for (int i = 0; i < primVarWidth; ++i) {
+                vertex[d++] += editValues[i];
+            }
         }
     }
 
-    void ApplyVertexEditSet(float *vertex, int primVarOffset, int primVarWidth, int editIndex, const float *editValues) const {
-        int d = editIndex * numVertexElements + primVarOffset;
-        for (int i = 0; i < primVarWidth; ++i) {
-            vertex[d++] = editValues[i];
+    template <class T>
+    void ApplyVertexEditSet(T *vertex, int primVarOffset, int primVarWidth, int editIndex, const float *editValues) const {
+        int sampleElements = numVertexElements / numSamples;
+        if (primVarOffset + primVarWidth > sampleElements)
+            return;
+        for (int s = 0; s < numSamples; ++s) {
+            int d = editIndex * vertexStride + s * sampleElements + primVarOffset;
+            for (int i = 0; i < primVarWidth; ++i) {
+                vertex[d++] = editValues[i];
+            }
         }
     }
 
     int numVertexElements;
     int numVaryingElements;
+    int vertexStride;
+    int varyingStride;
+    int numSamples;
+    OsdPrecision precision;
 };
 
 } // end namespace OPENSUBDIV_VERSION
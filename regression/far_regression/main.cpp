@@ -56,10 +56,46 @@
 //
 
 #include <stdio.h>
+#include <string.h>
 
-#include "../common/mutex.h"
+#ifdef OPENSUBDIV_HAS_OPENMP
+    #include <omp.h>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+// Mutex actually locking, for the meshes refined by several threads (see
+// checkThreadArenas)
+class Mutex {
+public:
+    Mutex() { omp_init_lock(&_lock); }
+
+    ~Mutex() { omp_destroy_lock(&_lock); }
+
+    void Lock() { omp_set_lock(&_lock); }
+
+    void Unlock() { omp_unset_lock(&_lock); }
+
+private:
+    Mutex(Mutex const &);
+    Mutex & operator=(Mutex const &);
+
+    omp_lock_t _lock;
+};
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+#else
+    #include "../common/mutex.h"
+#endif
 
 #include <far/meshFactory.h>
+#include <far/meshSerializer.h>
+#include <far/topologyMeshFactory.h>
+#include <far/stencilTablesFactory.h>
+#include <far/kernelProfiler.h>
 
 #include "../common/shape_utils.h"
 
@@ -159,6 +195,8 @@ typedef OpenSubdiv::HbrVertexOperator<xyzVV> xyzVertexOperator;
 typedef OpenSubdiv::FarMesh<xyzVV>              fMesh;
 typedef OpenSubdiv::FarMeshFactory<xyzVV>       fMeshFactory;
 typedef OpenSubdiv::FarSubdivisionTables<xyzVV> fMeshSubdivision;
+typedef OpenSubdiv::FarMeshSerializer<xyzVV>    fMeshSerializer;
+typedef OpenSubdiv::FarTopologyMeshFactory<xyzVV> fTopologyMeshFactory;
 
 static bool g_debugmode = false;
 static bool g_dumphbr = false;
@@ -325,6 +363,565 @@ bool VertexOnBoundary( xyzvertex const * v ) {
     return false;
 }
 
+//------------------------------------------------------------------------------
+// Returns the number of refined vertices for which the flattened stencils do
+// not match the results of the subdivision tables
+static int checkStencils( fMesh * mesh ) {
+
+    OpenSubdiv::FarStencilTables * stencils =
+        OpenSubdiv::FarStencilTablesFactory<xyzVV>::Create( mesh, false, 1 );
+
+    // hierarchical edits cannot be represented with stencils
+    if (not stencils)
+        return 0;
+
+    std::vector<int> const & sizes = stencils->GetSizes(),
+                           & offsets = stencils->GetOffsets(),
+                           & indices = stencils->GetControlIndices();
+    std::vector<float> const & weights = stencils->GetWeights();
+
+    int count=0;
+    for (int i=0; i<stencils->GetNumStencils(); ++i) {
+
+        xyzVV sv(0.0f, 0.0f, 0.0f);
+        for (int j=offsets[i]; j<(offsets[i]+sizes[i]); ++j)
+            sv.AddWithWeight( mesh->GetVertex(indices[j]), weights[j] );
+
+        int index = stencils->GetFirstVertexOffset()+i;
+        xyzVV & nv = mesh->GetVertex(index);
+
+        float delta[3] = { sv.GetPos()[0] - nv.GetPos()[0],
+                           sv.GetPos()[1] - nv.GetPos()[1],
+                           sv.GetPos()[2] - nv.GetPos()[2] };
+
+        float dist = sqrtf( delta[0]*delta[0]+delta[1]*delta[1]+delta[2]*delta[2]);
+        if ( dist > PRECISION ) {
+            if (not g_debugmode)
+                printf("// Stencil %d fails : dist=%.10f (%.10f %.10f %.10f)"
+                       " (%.10f %.10f %.10f)\n", i, dist, sv.GetPos()[0],
+                                                          sv.GetPos()[1],
+                                                          sv.GetPos()[2],
+                                                          nv.GetPos()[0],
+                                                          nv.GetPos()[1],
+                                                          nv.GetPos()[2] );
+            count++;
+        }
+    }
+
+    delete stencils;
+
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of vertices that differ from the reference mesh when the
+// refined vertices are renumbered with the locality orderings
+static int checkVertexOrderings( xyzmesh * hmesh, int levels,
+                                 fMesh * refmesh, std::vector<int> const & refremap ) {
+
+    fMeshFactory::VertexOrdering orderings[2] = { fMeshFactory::k_OrderParents,
+                                                  fMeshFactory::k_OrderCuthillMcKee };
+    int count=0;
+    for (int i=0; i<2; ++i) {
+
+        fMeshFactory fact( hmesh, levels );
+        fMesh * m = fact.Create( false, false, orderings[i] );
+        m->Subdivide( );
+
+        std::vector<int> const & remap = fact.GetRemappingTable();
+
+        for (int j=0; j<(int)remap.size(); ++j) {
+            if (remap[j]<0)
+                continue;
+
+            float const * pos = m->GetVertex( remap[j] ).GetPos(),
+                        * refpos = refmesh->GetVertex( refremap[j] ).GetPos();
+
+            if (pos[0]!=refpos[0] or pos[1]!=refpos[1] or pos[2]!=refpos[2]) {
+                if (not g_debugmode)
+                    printf("// Vertex ordering %d : vertex %d differs\n", orderings[i], j);
+                count++;
+            }
+        }
+
+        count += checkStencils( m );
+
+        delete m;
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Returns 1 if the tables created with several threads differ from the tables
+// of the reference mesh (compared through their serialization)
+static int checkThreads( char const * msg, fMesh * m, fMesh * refmesh ) {
+
+    std::vector<char> data, refdata;
+    fMeshSerializer::Write( m, data );
+    fMeshSerializer::Write( refmesh, refdata );
+
+    if (data!=refdata) {
+        if (not g_debugmode)
+            printf("// %s : threaded tables differ\n", msg);
+        return 1;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// Profiler recording the outermost kernels launched
+struct KernelRecorder : public OpenSubdiv::FarKernelProfiler {
+
+    KernelRecorder() : depth(0) { }
+
+    virtual void BeginKernel(OpenSubdiv::FarKernelLaunch const & launch) {
+        if (depth++==0)
+            launches.push_back(launch);
+        OpenSubdiv::FarKernelProfiler::BeginKernel(launch);
+    }
+
+    virtual void EndKernel(OpenSubdiv::FarKernelLaunch const & launch) {
+        --depth;
+        OpenSubdiv::FarKernelProfiler::EndKernel(launch);
+    }
+
+    std::vector<OpenSubdiv::FarKernelLaunch> launches;
+    int depth;
+};
+
+//------------------------------------------------------------------------------
+// Returns the number of errors found when instrumenting the refinement of a
+// mesh : the kernels launched must compute the vertices of each level in
+// order, and the profiler must account for all of them
+static int checkInstrumentation( fMesh * m ) {
+
+    using OpenSubdiv::FarKernelLaunch;
+
+    KernelRecorder recorder;
+    OpenSubdiv::FarKernelInstrumentation::Install(&recorder);
+    m->Subdivide( );
+    OpenSubdiv::FarKernelInstrumentation::Install(0);
+
+    fMeshSubdivision const * tables = m->GetSubdivisionTables();
+
+    int count=0, level=0, next=0;
+    for (int i=0; i<(int)recorder.launches.size(); ++i) {
+
+        FarKernelLaunch const & launch = recorder.launches[i];
+        if (launch.kernel==FarKernelLaunch::k_VertexEdits)
+            continue;
+
+        if (launch.level!=level) {
+            if (level>0 and next!=tables->GetFirstVertexOffset(level)+tables->GetNumVertices(level))
+                ++count;
+            level = launch.level;
+            next = tables->GetFirstVertexOffset(level);
+        }
+        if (launch.scheme!=tables->GetScheme() or launch.offset+launch.start!=next or
+            launch.bytes<(launch.end-launch.start)*sizeof(xyzVV))
+            ++count;
+        next = launch.offset+launch.end;
+    }
+    if (next!=m->GetNumVertices() or level!=tables->GetMaxLevel()-1)
+        ++count;
+
+    long vertices=0;
+    for (level=1; level<=recorder.GetMaxLevel(); ++level)
+        for (int kernel=FarKernelLaunch::k_FaceVertices; kernel<=FarKernelLaunch::k_VertexVertices; ++kernel)
+            vertices += recorder.GetCounters(level, (FarKernelLaunch::Kernel)kernel).vertices;
+    if (recorder.depth!=0 or vertices!=m->GetNumVertices()-tables->GetFirstVertexOffset(1))
+        ++count;
+
+    if (count and not g_debugmode)
+        printf("// kernel instrumentation fails\n");
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Exposes the protected members of the subdivision tables of a mesh so that
+// the serialization tests can corrupt them
+struct fMeshSubdivisionAccess : public fMeshSubdivision {
+
+    static std::vector<int> & vertsOffsets( fMesh * m ) {
+        return getTables(m)->*(&fMeshSubdivisionAccess::_vertsOffsets);
+    }
+
+    static int & kernelE( fMesh * m, int level ) {
+        return (getTables(m)->*(&fMeshSubdivisionAccess::_batches))[level-1].kernelE;
+    }
+
+    // Appends an empty level of subdivision : the tables are not resized
+    static void addLevel( fMesh * m ) {
+        vertsOffsets(m).push_back( vertsOffsets(m).back() );
+        (getTables(m)->*(&fMeshSubdivisionAccess::_batches)).push_back( VertexKernelBatch() );
+    }
+
+    static void removeLevel( fMesh * m ) {
+        vertsOffsets(m).pop_back();
+        (getTables(m)->*(&fMeshSubdivisionAccess::_batches)).pop_back();
+    }
+
+private:
+    static fMeshSubdivision * getTables( fMesh * m ) {
+        return const_cast<fMeshSubdivision *>(m->GetSubdivisionTables());
+    }
+};
+
+// Loads a mesh from a copy of 'data' in the word-aligned 'buffer'
+static fMesh * readBuffer( std::vector<char> const & data, std::vector<int> & buffer ) {
+
+    buffer.resize( (data.size()+sizeof(int)-1)/sizeof(int) );
+    memcpy( &buffer[0], &data[0], data.size() );
+    return fMeshSerializer::Read( &buffer[0], data.size() );
+}
+
+// Returns 1 if the serialized mesh is loaded (the data is expected to be
+// rejected)
+static int checkRejected( std::vector<char> const & data, char const * msg ) {
+
+    std::vector<int> buffer;
+    if (fMesh * m = readBuffer( data, buffer )) {
+        printf("// Serialization : corrupted %s accepted\n", msg);
+        delete m;
+        return 1;
+    }
+    return 0;
+}
+
+// Returns 1 if the data loaded in 'buffer' is accepted once the table entry
+// 'entry' (pointing into 'buffer') is set to 'value'
+template <class T> static int
+checkCorruptedEntry( std::vector<int> const & buffer, std::vector<char> data,
+                     T const * entry, T value, char const * msg ) {
+
+    size_t offset = (char const *)entry - (char const *)&buffer[0];
+    assert( offset+sizeof(T)<=data.size() );
+    memcpy( &data[offset], &value, sizeof(T) );
+    return checkRejected( data, msg );
+}
+
+// Returns 1 if the serialization of the mesh is accepted (the mesh is expected
+// to have been corrupted)
+static int checkCorruptedMesh( fMesh * m, char const * msg ) {
+
+    std::vector<char> data;
+    fMeshSerializer::Write( m, data );
+    return checkRejected( data, msg );
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of corrupted serialized meshes accepted by the serializer :
+// out of range vertex indices, table offsets and vertex counts must be rejected
+static int checkCorruptedSerialization( fMesh * refmesh ) {
+
+    int count=0,
+        nverts = refmesh->GetNumVertices();
+
+    std::vector<char> data;
+    fMeshSerializer::Write( refmesh, data );
+
+    std::vector<int> buffer;
+    fMesh * m = readBuffer( data, buffer );
+    if (not m) {
+        printf("// Serialization : cannot read the tables\n");
+        return 1;
+    }
+
+    // the indexing tables of 'm' point into 'buffer' : corrupt their entries
+    fMeshSubdivision const * tables = m->GetSubdivisionTables();
+
+    count += checkCorruptedEntry( buffer, data, tables->Get_E_IT()[0], nverts, "edge-vertex index" );
+
+    if (tables->GetScheme()==fMeshSubdivision::k_Bilinear) {
+        count += checkCorruptedEntry( buffer, data, tables->Get_V_ITa()[0], nverts, "parent vertex index" );
+    } else {
+        int const * V_ITa = tables->Get_V_ITa()[0];
+        count += checkCorruptedEntry( buffer, data, V_ITa+2, nverts, "parent vertex index" );
+        count += checkCorruptedEntry( buffer, data, V_ITa+3, nverts, "crease edge index" );
+
+        count += checkCorruptedEntry( buffer, data, tables->Get_V_IT()[0], (unsigned int)nverts, "vertex-vertex index" );
+
+        for (int i=0; i<tables->GetNumVertexVertices(1); ++i)
+            if (V_ITa[5*i+1]>0) {
+                count += checkCorruptedEntry( buffer, data, V_ITa+5*i, 1<<30, "vertex-vertex offset" );
+                count += checkCorruptedEntry( buffer, data, V_ITa+5*i+1, 1<<30, "vertex-vertex valence" );
+                break;
+            }
+    }
+
+    OpenSubdiv::FarTable<unsigned int> const * F_IT = 0;
+    OpenSubdiv::FarTable<int> const * F_ITa = 0;
+    if (tables->GetScheme()==fMeshSubdivision::k_Catmark) {
+        F_IT = &static_cast<OpenSubdiv::FarCatmarkSubdivisionTables<xyzVV> const *>(tables)->Get_F_IT();
+        F_ITa = &static_cast<OpenSubdiv::FarCatmarkSubdivisionTables<xyzVV> const *>(tables)->Get_F_ITa();
+    } else if (tables->GetScheme()==fMeshSubdivision::k_Bilinear) {
+        F_IT = &static_cast<OpenSubdiv::FarBilinearSubdivisionTables<xyzVV> const *>(tables)->Get_F_IT();
+        F_ITa = &static_cast<OpenSubdiv::FarBilinearSubdivisionTables<xyzVV> const *>(tables)->Get_F_ITa();
+    }
+    if (F_IT) {
+        count += checkCorruptedEntry( buffer, data, (*F_IT)[0], (unsigned int)nverts, "face-vertex index" );
+        count += checkCorruptedEntry( buffer, data, (*F_ITa)[0], -1, "face-vertex offset" );
+    }
+
+    if (m->GetVertexEdit() and m->GetVertexEdit()->GetNumBatches()>0) {
+        OpenSubdiv::FarTable<unsigned int> const & indices = m->GetVertexEdit()->GetBatch(0).GetVertexIndices();
+        count += checkCorruptedEntry( buffer, data, indices[0], (unsigned int)nverts, "edited vertex index" );
+    }
+
+    delete m;
+
+    // the vertex offsets and kernel batches are copied : corrupt the
+    // reference mesh and restore it once serialized
+    std::vector<int> & vertsOffsets = fMeshSubdivisionAccess::vertsOffsets( refmesh );
+    int maxlevel = (int)vertsOffsets.size()-1;
+
+    int offset = vertsOffsets[maxlevel];
+    vertsOffsets[maxlevel] = nverts;
+    count += checkCorruptedMesh( refmesh, "last vertex offset" );
+    vertsOffsets[maxlevel] = offset;
+
+    offset = vertsOffsets[0];
+    vertsOffsets[0] = vertsOffsets[1]+1;
+    count += checkCorruptedMesh( refmesh, "decreasing vertex offsets" );
+    vertsOffsets[0] = offset;
+
+    int nedges = fMeshSubdivisionAccess::kernelE( refmesh, 1 );
+    fMeshSubdivisionAccess::kernelE( refmesh, 1 ) = 1<<30;
+    count += checkCorruptedMesh( refmesh, "edge-vertex kernel range" );
+    fMeshSubdivisionAccess::kernelE( refmesh, 1 ) = nedges;
+
+    // an extra level without vertices : only the table markers are missing
+    fMeshSubdivisionAccess::addLevel( refmesh );
+    count += checkCorruptedMesh( refmesh, "number of table markers" );
+    fMeshSubdivisionAccess::removeLevel( refmesh );
+
+    // the restored mesh must be accepted again
+    data.clear();
+    fMeshSerializer::Write( refmesh, data );
+    if (not (m = readBuffer( data, buffer ))) {
+        printf("// Serialization : restored tables rejected\n");
+        count++;
+    }
+    delete m;
+
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of errors found when writing to a table pointing to
+// external data : the data must be copied into the table, not modified
+static int checkExternalTable( ) {
+
+    int const external[4] = { 0, 1, 2, 3 };
+
+    OpenSubdiv::FarTableMarkers markers(2);
+    markers[0] = 0;
+    markers[1] = 2;
+
+    OpenSubdiv::FarTable<int> table;
+    table.SetExternalData( external, 4, markers );
+
+    table[1][0] = 10;
+
+    int count=0;
+    if (table.IsExternal() or external[2]!=2 or table.GetSize()!=4 or
+        table[0][1]!=1 or table[1][0]!=10 or table[1][1]!=3) {
+        printf("// Serialization : external table data modified\n");
+        count++;
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of errors found when saving a mesh and loading it back :
+// the loaded tables must serialize identically and subdivide the coarse
+// vertices into the same positions as the reference mesh
+static int checkSerialization( fMesh * refmesh, std::vector<int> const & refremap ) {
+
+    static char const * filename = "far_regression_mesh.bin";
+
+    std::vector<char> refdata;
+    fMeshSerializer::Write( refmesh, refdata, &refremap );
+
+    int count=0;
+
+    if (not fMeshSerializer::Write( refmesh, filename, &refremap )) {
+        printf("// Serialization : cannot write %s\n", filename);
+        return 1;
+    }
+
+    for (int map=0; map<2; ++map) {
+
+        std::vector<int> remap;
+        fMesh * m = fMeshSerializer::Read( filename, &remap, map==1 );
+        if (not m) {
+            printf("// Serialization : cannot read %s (map=%d)\n", filename, map);
+            count++;
+            continue;
+        }
+
+        std::vector<char> data;
+        fMeshSerializer::Write( m, data, &remap );
+        if (data!=refdata or remap!=refremap) {
+            if (not g_debugmode)
+                printf("// Serialization : tables differ (map=%d)\n", map);
+            count++;
+        }
+
+        int ncoarse = m->GetSubdivisionTables()->GetNumVertices(0);
+        for (int i=0; i<ncoarse; ++i)
+            m->GetVertex(i) = refmesh->GetVertex(i);
+        m->Subdivide( );
+
+        for (int i=0; i<m->GetNumVertices(); ++i) {
+            float const * pos = m->GetVertex(i).GetPos(),
+                        * refpos = refmesh->GetVertex(i).GetPos();
+
+            if (pos[0]!=refpos[0] or pos[1]!=refpos[1] or pos[2]!=refpos[2]) {
+                if (not g_debugmode)
+                    printf("// Serialization : vertex %d differs (map=%d)\n", i, map);
+                count++;
+            }
+        }
+        delete m;
+    }
+    remove(filename);
+
+    count += checkCorruptedSerialization( refmesh );
+
+    count += checkExternalTable( );
+
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of refined vertices that differ between the mesh created
+// from the HbrMesh of a shape and the mesh created from its face-vertex arrays
+// by FarTopologyMeshFactory : the faces of each level are compared vertex by
+// vertex, since the vertex-vertices of equal rank can be numbered differently
+static int checkTopologyFactory( char const * msg, char const * shapestr, Scheme scheme, int levels ) {
+
+    shape * sh = shape::parseShape( shapestr );
+
+    OpenSubdiv::FarTopologyDescriptor desc;
+
+    switch (scheme) {
+        case kBilinear : desc.scheme = OpenSubdiv::FarTopologyDescriptor::k_Bilinear; break;
+        case kCatmark  : desc.scheme = OpenSubdiv::FarTopologyDescriptor::k_Catmark; break;
+        case kLoop     : desc.scheme = OpenSubdiv::FarTopologyDescriptor::k_Loop; break;
+    }
+
+    desc.numVertices = sh->getNverts();
+    desc.numFaces = sh->getNfaces();
+    desc.numVertsPerFace = &sh->nvertsPerFace[0];
+    desc.faceVertices = &sh->faceverts[0];
+
+    // same defaults and tags as createTopology()
+    desc.interpolateBoundary = OpenSubdiv::FarTopologyDescriptor::k_InterpolateBoundaryEdgeOnly;
+
+    std::vector<int> creaseVerts, cornerVerts;
+    std::vector<float> creaseSharpness, cornerSharpness;
+    for (int i=0; i<(int)sh->tags.size(); ++i) {
+        shape::tag * t = sh->tags[i];
+        int nfloat = (int)t->floatargs.size();
+        if (t->name=="crease") {
+            for (int j=0; j<(int)t->intargs.size()-1; j += 2) {
+                creaseVerts.push_back(t->intargs[j]);
+                creaseVerts.push_back(t->intargs[j+1]);
+                creaseSharpness.push_back((nfloat > 1) ? t->floatargs[j] : t->floatargs[0]);
+            }
+        } else if (t->name=="corner") {
+            for (int j=0; j<(int)t->intargs.size(); ++j) {
+                cornerVerts.push_back(t->intargs[j]);
+                cornerSharpness.push_back((nfloat > 1) ? t->floatargs[j] : t->floatargs[0]);
+            }
+        } else if (t->name=="interpolateboundary" and t->intargs.size()==1) {
+            switch (t->intargs[0]) {
+                case 0 : desc.interpolateBoundary = OpenSubdiv::FarTopologyDescriptor::k_InterpolateBoundaryNone; break;
+                case 1 : desc.interpolateBoundary = OpenSubdiv::FarTopologyDescriptor::k_InterpolateBoundaryEdgeAndCorner; break;
+                case 2 : desc.interpolateBoundary = OpenSubdiv::FarTopologyDescriptor::k_InterpolateBoundaryEdgeOnly; break;
+            }
+        }
+    }
+    desc.numCreases = (int)creaseSharpness.size();
+    if (desc.numCreases) {
+        desc.creaseVertices = &creaseVerts[0];
+        desc.creaseSharpness = &creaseSharpness[0];
+    }
+    desc.numCorners = (int)cornerSharpness.size();
+    if (desc.numCorners) {
+        desc.cornerVertices = &cornerVerts[0];
+        desc.cornerSharpness = &cornerSharpness[0];
+    }
+
+    fTopologyMeshFactory fact( desc, levels );
+    fMesh * m = fact.Create( );
+
+    if (not m) {
+        printf("// Topology factory : cannot create %s\n", msg);
+        delete sh;
+        return 1;
+    }
+
+    xyzmesh * hmesh = simpleHbr<xyzVV>(shapestr, scheme, 0);
+
+    fMeshFactory reffact( hmesh, levels );
+    fMesh * refmesh = reffact.Create( );
+    refmesh->Subdivide( );
+
+    int count=0;
+
+    int ncoarse = refmesh->GetSubdivisionTables()->GetNumVertices(0);
+    for (int i=0; i<ncoarse; ++i)
+        m->GetVertex(i) = refmesh->GetVertex(i);
+    m->Subdivide( );
+
+    if (m->GetNumVertices()!=refmesh->GetNumVertices()) {
+        printf("// Topology factory : %d vertices instead of %d\n", m->GetNumVertices(),
+                                                                   refmesh->GetNumVertices());
+        count++;
+    }
+
+    for (int level=1; level<=levels; ++level) {
+
+        std::vector<int> const & faceverts = m->GetFaceVertices(level),
+                               & reffaceverts = refmesh->GetFaceVertices(level);
+
+        if (faceverts.size()!=reffaceverts.size()) {
+            printf("// Topology factory : level %d has %d face-vertices instead of %d\n",
+                level, (int)faceverts.size(), (int)reffaceverts.size());
+            count++;
+            continue;
+        }
+
+        for (int i=0; i<(int)faceverts.size(); ++i) {
+            float const * pos = m->GetVertex(faceverts[i]).GetPos(),
+                        * refpos = refmesh->GetVertex(reffaceverts[i]).GetPos();
+
+            if (pos[0]!=refpos[0] or pos[1]!=refpos[1] or pos[2]!=refpos[2]) {
+                if (not g_debugmode)
+                    printf("// Topology factory : level %d face-vertex %d differs\n", level, i);
+                count++;
+            }
+        }
+    }
+
+    count += checkStencils( m );
+
+    fTopologyMeshFactory threadfact( desc, levels );
+    threadfact.SetNumThreads( 4 );
+    fMesh * threadmesh = threadfact.Create( );
+    count += checkThreads( "Topology factory", threadmesh, m );
+    delete threadmesh;
+
+    delete sh;
+    delete hmesh;
+    delete refmesh;
+    delete m;
+
+    return count;
+}
+
 //------------------------------------------------------------------------------
 int checkMesh( char const * msg, xyzmesh * hmesh, int levels, Scheme scheme=kCatmark ) {
 
@@ -393,6 +990,24 @@ int checkMesh( char const * msg, xyzmesh * hmesh, int levels, Scheme scheme=kCat
         }
     }
 
+    count += checkStencils( m );
+
+    count += checkVertexOrderings( hmesh, levels, m, remap );
+
+    count += checkSerialization( m, remap );
+
+    // (the HbrMesh is already refined : compare against a serial re-creation)
+    fMeshFactory serialfact( hmesh, levels ),
+                 threadfact( hmesh, levels );
+    threadfact.SetNumThreads( 4 );
+    fMesh * serialmesh = serialfact.Create( ),
+          * threadmesh = threadfact.Create( );
+    count += checkThreads( "Mesh factory", threadmesh, serialmesh );
+    delete serialmesh;
+    delete threadmesh;
+
+    count += checkInstrumentation( m );
+
     if (deltaCnt[0])
         deltaAvg[0]/=deltaCnt[0];
     if (deltaCnt[1])
@@ -417,6 +1032,424 @@ int checkMesh( char const * msg, xyzmesh * hmesh, int levels, Scheme scheme=kCat
     return count;
 }
 
+//------------------------------------------------------------------------------
+// Returns the number of errors found when saving the patch tables of an
+// adaptive mesh and loading them back
+int checkAdaptiveSerialization( char const * msg, xyzmesh * hmesh, int levels ) {
+
+    if (not g_debugmode)
+        printf("- %s (adaptive serialization)\n", msg);
+
+    int count=0;
+
+    fMeshFactory fact( hmesh, levels, true );
+    fMesh * adaptive = fact.Create( );
+
+    std::vector<char> adaptivedata, data;
+    fMeshSerializer::Write( adaptive, adaptivedata );
+
+    // copy into a word-aligned buffer
+    std::vector<int> buffer( (adaptivedata.size()+sizeof(int)-1)/sizeof(int) );
+    memcpy( &buffer[0], &adaptivedata[0], adaptivedata.size() );
+
+    fMesh * m = fMeshSerializer::Read( &buffer[0], adaptivedata.size() );
+    if (m) {
+        fMeshSerializer::Write( m, data );
+        if (not m->GetPatchTables() or data!=adaptivedata) {
+            if (not g_debugmode)
+                printf("// Serialization : adaptive tables differ\n");
+            count++;
+        }
+    } else {
+        printf("// Serialization : cannot read adaptive tables\n");
+        count++;
+    }
+
+    // truncated data must be rejected
+    if (fMeshSerializer::Read( &buffer[0], adaptivedata.size()/2 )) {
+        printf("// Serialization : truncated data accepted\n");
+        count++;
+    }
+
+    // out of range patch control vertices must be rejected
+    if (m) {
+        OpenSubdiv::FarPatchTables const * patchTables = m->GetPatchTables();
+        OpenSubdiv::FarPatchTables::PTable const * patches[] = {
+            &patchTables->GetFullRegularPatches(),
+            &patchTables->GetFullBoundaryPatches(),
+            &patchTables->GetFullCornerPatches(),
+            &patchTables->GetFullGregoryPatches(),
+            &patchTables->GetFullLoopRegularPatches(),
+            &patchTables->GetFullLoopEndPatches() };
+
+        for (int i=0; i<(int)(sizeof(patches)/sizeof(patches[0])); ++i)
+            if (not patches[i]->IsEmpty()) {
+                count += checkCorruptedEntry( buffer, adaptivedata, (*patches[i])[0],
+                    (unsigned int)m->GetNumVertices(), "patch control vertex" );
+                break;
+            }
+    }
+
+    if (count==0 and not g_debugmode)
+        printf("  success !\n");
+
+    delete m;
+    delete adaptive;
+    delete hmesh;
+
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of errors found in the feature adaptive representation of
+// a Loop mesh : the refined vertices must match Hbr, the patches must cover
+// each coarse triangle exactly once and the control vertices of the regular
+// patches must be connected as described in FarPatchTables
+int checkAdaptiveLoop( char const * msg, xyzmesh * hmesh, int levels ) {
+
+    if (not g_debugmode)
+        printf("- %s (adaptive loop)\n", msg);
+
+    int count=0;
+
+    fMeshFactory fact( hmesh, levels, true );
+    fMesh * m = fact.Create( );
+    m->Subdivide( );
+
+    std::vector<int> const & remap = fact.GetRemappingTable();
+
+    std::vector<xyzvertex *> hverts( m->GetNumVertices(), (xyzvertex *)0 );
+    for (int i=0; i<hmesh->GetNumVertices(); ++i) {
+
+        xyzvertex * hv = hmesh->GetVertex(i);
+        if (remap[hv->GetID()]<0)
+            continue;
+        hverts[ remap[hv->GetID()] ] = hv;
+
+        float const * pos = m->GetVertex( remap[hv->GetID()] ).GetPos(),
+                    * hpos = hv->GetData().GetPos();
+
+        float delta[3] = { pos[0]-hpos[0], pos[1]-hpos[1], pos[2]-hpos[2] };
+        if (sqrtf(delta[0]*delta[0]+delta[1]*delta[1]+delta[2]*delta[2]) > PRECISION) {
+            if (not g_debugmode)
+                printf("// Adaptive loop : vertex %d differs\n", i);
+            count++;
+        }
+    }
+
+    OpenSubdiv::FarPatchTables const * patches = m->GetPatchTables();
+    if (not patches) {
+        printf("// Adaptive loop : no patch tables\n");
+        delete m;
+        delete hmesh;
+        return count+1;
+    }
+
+    OpenSubdiv::FarPatchTables::PTable const & regular = patches->GetFullLoopRegularPatches(),
+                                             & end = patches->GetFullLoopEndPatches();
+
+    int nregular = patches->GetLoopRegularPatchRingsize(),
+        nend = patches->GetLoopEndPatchRingsize();
+
+    // each triangle of level l covers 1/4^l of its coarse triangle
+    double area=0.0;
+    for (int level=0; level<(int)regular.GetMarkers().size()-1; ++level)
+        area += (regular.GetNumElements(level)/nregular +
+                 end.GetNumElements(level)/nend) / pow(4.0, level);
+
+    if (fabs(area-hmesh->GetNumCoarseFaces())>1e-6) {
+        printf("// Adaptive loop : patches cover %f coarse triangles instead of %d\n",
+            area, hmesh->GetNumCoarseFaces());
+        count++;
+    }
+
+    // edges of the lattice of control vertices of a regular patch
+    static int const edges[24][2] = { {0,1}, {2,3}, {3,4}, {5,6}, {6,7}, {7,8},
+                                      {9,10}, {10,11}, {0,2}, {0,3}, {1,3}, {1,4},
+                                      {2,5}, {2,6}, {3,6}, {3,7}, {4,7}, {4,8},
+                                      {5,9}, {6,9}, {6,10}, {7,10}, {7,11}, {8,11} };
+
+    for (int i=0; i<regular.GetSize(); i+=nregular) {
+
+        xyzvertex * cvs[12];
+        for (int j=0; j<nregular; ++j)
+            cvs[j] = hverts[ regular[0][i+j] ];
+
+        // the triangle of the patch is (6, 7, 3)
+        xyzhalfedge * e = cvs[6]->GetEdge(cvs[7]);
+        bool valid = e and e->GetNext()->GetDestVertex()==cvs[3];
+
+        for (int j=0; j<24 and valid; ++j)
+            valid = cvs[edges[j][0]]->GetEdge(cvs[edges[j][1]]) or
+                    cvs[edges[j][1]]->GetEdge(cvs[edges[j][0]]);
+
+        if (not valid) {
+            if (not g_debugmode)
+                printf("// Adaptive loop : regular patch %d is not connected\n", i/nregular);
+            count++;
+        }
+    }
+
+    if (count==0 and not g_debugmode)
+        printf("  %d regular patches, %d end patches, %d vertices\n  success !\n",
+            regular.GetSize()/nregular, end.GetSize()/nend, m->GetNumVertices());
+
+    delete m;
+    delete hmesh;
+
+    return count;
+}
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+//------------------------------------------------------------------------------
+static int getThreadIndex() {
+    return omp_get_thread_num();
+}
+
+// Returns a mesh made of disconnected copies of a shape (the tags of the shape
+// only apply to the first copy)
+static xyzmesh * createCopiesHbr( char const * shapestr, Scheme scheme, int ncopies ) {
+
+    shape * sh = shape::parseShape( shapestr );
+
+    int nverts = sh->getNverts(),
+        nfaces = sh->getNfaces(),
+        nfaceverts = (int)sh->faceverts.size();
+
+    sh->verts.reserve(nverts*3*ncopies);
+    sh->nvertsPerFace.reserve(nfaces*ncopies);
+    sh->faceverts.reserve(nfaceverts*ncopies);
+    for (int copy=1; copy<ncopies; ++copy) {
+        for (int i=0; i<nverts*3; ++i)
+            sh->verts.push_back(sh->verts[i]);
+        for (int i=0; i<nfaces; ++i)
+            sh->nvertsPerFace.push_back(sh->nvertsPerFace[i]);
+        for (int i=0; i<nfaceverts; ++i)
+            sh->faceverts.push_back(sh->faceverts[i] + nverts*copy);
+    }
+
+    xyzmesh * mesh = createMesh<xyzVV>(scheme);
+    createVertices<xyzVV>(sh, mesh, (std::vector<float> *)0);
+    createTopology<xyzVV>(sh, mesh, scheme);
+
+    delete sh;
+    return mesh;
+}
+
+// Refines the copies of a shape level by level, each copy by a single thread
+static void refineCopies( xyzmesh * mesh, int ncopies, int levels, int nthreads ) {
+
+    int ncoarsefaces = mesh->GetNumCoarseFaces();
+
+    for (int level=0; level<levels; ++level) {
+
+        std::vector<std::vector<xyzface *> > copies(ncopies);
+        for (int i=0; i<mesh->GetNumFaces(); ++i) {
+            xyzface * f = mesh->GetFace(i), * root = f;
+            if (f->GetDepth()!=level)
+                continue;
+            while (root->GetParent())
+                root = root->GetParent();
+            copies[root->GetID()*ncopies/ncoarsefaces].push_back(f);
+        }
+
+#pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+        for (int copy=0; copy<ncopies; ++copy)
+            for (int i=0; i<(int)copies[copy].size(); ++i)
+                copies[copy][i]->Refine();
+    }
+}
+
+// Returns the number of vertices of the faces at the given depth differing
+// between two refinements of the same face
+static int compareFaces( xyzface const * f, xyzface const * ref, int levels ) {
+
+    int count=0, nv=f->GetNumVertices();
+    if (f->GetDepth()==levels) {
+        for (int i=0; i<nv; ++i) {
+            float const * pos = f->GetVertex(i)->GetData().GetPos(),
+                        * refpos = ref->GetVertex(i)->GetData().GetPos();
+            if (pos[0]!=refpos[0] or pos[1]!=refpos[1] or pos[2]!=refpos[2])
+                ++count;
+        }
+        return count;
+    }
+
+    int nchildren = f->GetMesh()->GetSubdivision()->GetFaceChildrenCount(nv);
+    for (int i=0; i<nchildren; ++i) {
+        xyzface const * child = f->GetChild(i),
+                      * refchild = ref->GetChild(i);
+        if (not child or not refchild) {
+            if (child!=refchild)
+                ++count;
+            continue;
+        }
+        count += compareFaces( child, refchild, levels );
+    }
+    return count;
+}
+
+// Refines a mesh level by level from several threads, running each stage of
+// HbrMesh::RefineConcurrently on all the faces of a level
+static void refineConcurrently( xyzmesh * mesh, int levels, int nthreads ) {
+
+    for (int level=0; level<levels; ++level) {
+
+        std::vector<xyzface *> faces;
+        for (int i=0; i<mesh->GetNumFaces(); ++i) {
+            xyzface * f = mesh->GetFace(i);
+            if (f->GetDepth()==level)
+                faces.push_back(f);
+        }
+
+        for (int stage=xyzmesh::k_RefineFaceVertices; stage<=xyzmesh::k_RefineChildFaces; ++stage) {
+#pragma omp parallel for num_threads(nthreads) schedule(dynamic, 4)
+            for (int i=0; i<(int)faces.size(); ++i)
+                mesh->RefineConcurrently(faces[i], (xyzmesh::RefineStage)stage);
+        }
+    }
+}
+
+// Returns the number of errors found between a mesh refined from several
+// threads and its serial refinement : the vertex IDs must be unique and the
+// refined vertices must match
+static int compareRefinements( xyzmesh * mesh, xyzmesh * refmesh, int levels ) {
+
+    int count=0;
+
+    std::vector<xyzvertex *> vertices;
+    mesh->GetVertices( std::back_inserter(vertices) );
+    if ((int)vertices.size()!=refmesh->GetNumVertices() or
+        mesh->GetNumFaces()!=refmesh->GetNumFaces())
+        ++count;
+
+    std::vector<int> ids;
+    for (int i=0; i<(int)vertices.size(); ++i) {
+        if (mesh->GetVertex(vertices[i]->GetID())!=vertices[i])
+            ++count;
+        ids.push_back(vertices[i]->GetID());
+    }
+    std::sort(ids.begin(), ids.end());
+    if (std::unique(ids.begin(), ids.end())!=ids.end())
+        ++count;
+
+    for (int i=0; i<mesh->GetNumCoarseFaces(); ++i)
+        count += compareFaces( mesh->GetFace(i), refmesh->GetFace(i), levels );
+
+    if (mesh->GetMemStats()<refmesh->GetMemStats())
+        ++count;
+
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of errors found when refining disconnected copies of a
+// shape concurrently from several threads, with thread arenas
+int checkThreadArenas( char const * msg, char const * shapestr, Scheme scheme, int levels ) {
+
+    int const ncopies = 8,
+              nthreads = 4;
+
+    xyzmesh * mesh = createCopiesHbr( shapestr, scheme, ncopies ),
+            * refmesh = createCopiesHbr( shapestr, scheme, ncopies );
+
+    mesh->SetThreadArenas( nthreads, getThreadIndex );
+
+    refineCopies( mesh, ncopies, levels, nthreads );
+    refineCopies( refmesh, ncopies, levels, 1 );
+
+    int count = compareRefinements( mesh, refmesh, levels );
+
+    if (not g_debugmode)
+        printf("- %s (thread arenas) : %s\n", msg, count ? "failed" : "success !");
+
+    delete mesh;
+    delete refmesh;
+
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of errors found when refining a shape from several
+// threads, including the faces which share vertices and edges (see
+// HbrMesh::RefineConcurrently)
+int checkConcurrentRefine( char const * msg, char const * shapestr, Scheme scheme, int levels ) {
+
+    int const nthreads = 4;
+
+    xyzmesh * mesh = createCopiesHbr( shapestr, scheme, 1 ),
+            * refmesh = createCopiesHbr( shapestr, scheme, 1 );
+
+    mesh->SetThreadArenas( nthreads, getThreadIndex );
+
+    refineConcurrently( mesh, levels, nthreads );
+    refineCopies( refmesh, 1, levels, 1 );
+
+    int count = compareRefinements( mesh, refmesh, levels );
+
+    if (not g_debugmode)
+        printf("- %s (concurrent refine) : %s\n", msg, count ? "failed" : "success !");
+
+    delete mesh;
+    delete refmesh;
+
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of errors found when the mesh factory refines a shape with
+// several threads : the tables must not depend on the number of threads, and
+// the refined vertices must match the vertices of the Hbr mesh
+int checkFactoryThreads( char const * msg, char const * shapestr, Scheme scheme, int levels ) {
+
+    xyzmesh * hmesh2 = createCopiesHbr( shapestr, scheme, 1 ),
+            * hmesh4 = createCopiesHbr( shapestr, scheme, 1 ),
+            * refhmesh = createCopiesHbr( shapestr, scheme, 1 );
+
+    fMeshFactory fact2( hmesh2, levels, false, 2 ),
+                 fact4( hmesh4, levels, false, 4 ),
+                 reffact( refhmesh, levels );
+
+    fMesh * m2 = fact2.Create( ),
+          * m4 = fact4.Create( ),
+          * refm = reffact.Create( );
+
+    int count = checkThreads( "Mesh factory refinement", m4, m2 );
+
+    if (m4->GetNumVertices()!=refm->GetNumVertices() or
+        hmesh4->GetNumFaces()!=refhmesh->GetNumFaces())
+        ++count;
+
+    m4->Subdivide( );
+
+    std::vector<int> const & remap = fact4.GetRemappingTable();
+    for (int i=0; i<hmesh4->GetNumVertices(); ++i) {
+
+        xyzvertex * hv = hmesh4->GetVertex(i);
+        if (not hv->IsConnected() or hv->GetFace()->GetDepth()>levels)
+            continue;
+
+        float const * pos = m4->GetVertex( remap[hv->GetID()] ).GetPos(),
+                    * hpos = hv->GetData().GetPos();
+        float delta[3] = { hpos[0]-pos[0], hpos[1]-pos[1], hpos[2]-pos[2] };
+        if (sqrtf(delta[0]*delta[0]+delta[1]*delta[1]+delta[2]*delta[2]) > PRECISION)
+            ++count;
+    }
+
+    if (not g_debugmode)
+        printf("- %s (mesh factory threads) : %s\n", msg, count ? "failed" : "success !");
+
+    delete m2;
+    delete m4;
+    delete refm;
+    delete hmesh2;
+    delete hmesh4;
+    delete refhmesh;
+
+    return count;
+}
+#endif
+
 //------------------------------------------------------------------------------
 static void parseArgs(int argc, char ** argv) {
     if (argc>1) {
@@ -481,86 +1514,116 @@ int main(int argc, char ** argv) {
 #ifdef test_catmark_edgeonly
 #include "../shapes/catmark_edgeonly.h"
     total += checkMesh( "test_catmark_edgeonly", simpleHbr<xyzVV>(catmark_edgeonly, kCatmark, 0), levels );
+    total += checkTopologyFactory( "test_catmark_edgeonly", catmark_edgeonly, kCatmark, levels );
 #endif
 
 #ifdef test_catmark_edgecorner
 #include "../shapes/catmark_edgecorner.h"
     total += checkMesh( "test_catmark_edgeonly", simpleHbr<xyzVV>(catmark_edgecorner, kCatmark, 0), levels );
+    total += checkTopologyFactory( "test_catmark_edgeonly", catmark_edgecorner, kCatmark, levels );
 #endif
 
 #ifdef test_catmark_pyramid
 #include "../shapes/catmark_pyramid.h"
     total += checkMesh( "test_catmark_pyramid", simpleHbr<xyzVV>(catmark_pyramid, kCatmark, 0), levels );
+    total += checkTopologyFactory( "test_catmark_pyramid", catmark_pyramid, kCatmark, levels );
 #endif
 
 #ifdef test_catmark_pyramid_creases0
 #include "../shapes/catmark_pyramid_creases0.h"
     total += checkMesh( "test_catmark_pyramid_creases0", simpleHbr<xyzVV>(catmark_pyramid_creases0, kCatmark, 0), levels );
+    total += checkTopologyFactory( "test_catmark_pyramid_creases0", catmark_pyramid_creases0, kCatmark, levels );
 #endif
 
 #ifdef test_catmark_pyramid_creases1
 #include "../shapes/catmark_pyramid_creases1.h"
     total += checkMesh( "test_catmark_pyramid_creases1", simpleHbr<xyzVV>(catmark_pyramid_creases1, kCatmark, 0), levels );
+    total += checkTopologyFactory( "test_catmark_pyramid_creases1", catmark_pyramid_creases1, kCatmark, levels );
 #endif
 
 #ifdef test_catmark_cube
 #include "../shapes/catmark_cube.h"
     total += checkMesh( "test_catmark_cube", simpleHbr<xyzVV>(catmark_cube, kCatmark, 0), levels );
+    total += checkTopologyFactory( "test_catmark_cube", catmark_cube, kCatmark, levels );
+#ifdef OPENSUBDIV_HAS_OPENMP
+    total += checkThreadArenas( "test_catmark_cube", catmark_cube, kCatmark, levels );
+    total += checkConcurrentRefine( "test_catmark_cube", catmark_cube, kCatmark, levels );
+    total += checkFactoryThreads( "test_catmark_cube", catmark_cube, kCatmark, levels );
+#endif
 #endif
 
 #ifdef test_catmark_cube_creases0
 #include "../shapes/catmark_cube_creases0.h"
     total += checkMesh( "test_catmark_cube_creases0", simpleHbr<xyzVV>(catmark_cube_creases0, kCatmark, 0), levels );
+    total += checkTopologyFactory( "test_catmark_cube_creases0", catmark_cube_creases0, kCatmark, levels );
 #endif
 
 #ifdef test_catmark_cube_creases1
 #include "../shapes/catmark_cube_creases1.h"
     total += checkMesh( "test_catmark_cube_creases1", simpleHbr<xyzVV>(catmark_cube_creases1, kCatmark, 0), levels );
+    total += checkTopologyFactory( "test_catmark_cube_creases1", catmark_cube_creases1, kCatmark, levels );
+#ifdef OPENSUBDIV_HAS_OPENMP
+    total += checkConcurrentRefine( "test_catmark_cube_creases1", catmark_cube_creases1, kCatmark, levels );
+    total += checkFactoryThreads( "test_catmark_cube_creases1", catmark_cube_creases1, kCatmark, levels );
+#endif
 #endif
 
 #ifdef test_catmark_cube_corner0
 #include "../shapes/catmark_cube_corner0.h"
     total += checkMesh( "test_catmark_cube_corner0", simpleHbr<xyzVV>(catmark_cube_corner0, kCatmark, 0), levels );
+    total += checkTopologyFactory( "test_catmark_cube_corner0", catmark_cube_corner0, kCatmark, levels );
 #endif
 
 #ifdef test_catmark_cube_corner1
 #include "../shapes/catmark_cube_corner1.h"
     total += checkMesh( "test_catmark_cube_corner1", simpleHbr<xyzVV>(catmark_cube_corner1, kCatmark, 0), levels );
+    total += checkTopologyFactory( "test_catmark_cube_corner1", catmark_cube_corner1, kCatmark, levels );
 #endif
 
 #ifdef test_catmark_cube_corner2
 #include "../shapes/catmark_cube_corner2.h"
     total += checkMesh( "test_catmark_cube_corner2", simpleHbr<xyzVV>(catmark_cube_corner2, kCatmark, 0), levels );
+    total += checkTopologyFactory( "test_catmark_cube_corner2", catmark_cube_corner2, kCatmark, levels );
 #endif
 
 #ifdef test_catmark_cube_corner3
 #include "../shapes/catmark_cube_corner3.h"
     total += checkMesh( "test_catmark_cube_corner3", simpleHbr<xyzVV>(catmark_cube_corner3, kCatmark, 0), levels );
+    total += checkTopologyFactory( "test_catmark_cube_corner3", catmark_cube_corner3, kCatmark, levels );
 #endif
 
 #ifdef test_catmark_cube_corner4
 #include "../shapes/catmark_cube_corner4.h"
     total += checkMesh( "test_catmark_cube_corner4", simpleHbr<xyzVV>(catmark_cube_corner4, kCatmark, 0), levels );
+    total += checkTopologyFactory( "test_catmark_cube_corner4", catmark_cube_corner4, kCatmark, levels );
 #endif
 
 #ifdef test_catmark_dart_edgecorner
 #include "../shapes/catmark_dart_edgecorner.h"
     total += checkMesh( "test_catmark_dart_edgecorner", simpleHbr<xyzVV>(catmark_dart_edgecorner, kCatmark, 0), levels );
+    total += checkTopologyFactory( "test_catmark_dart_edgecorner", catmark_dart_edgecorner, kCatmark, levels );
+#ifdef OPENSUBDIV_HAS_OPENMP
+    total += checkConcurrentRefine( "test_catmark_dart_edgecorner", catmark_dart_edgecorner, kCatmark, levels );
+    total += checkFactoryThreads( "test_catmark_dart_edgecorner", catmark_dart_edgecorner, kCatmark, levels );
+#endif
 #endif
 
 #ifdef test_catmark_dart_edgeonly
 #include "../shapes/catmark_dart_edgeonly.h"
     total += checkMesh( "test_catmark_dart_edgeonly", simpleHbr<xyzVV>(catmark_dart_edgeonly, kCatmark, 0), levels );
+    total += checkTopologyFactory( "test_catmark_dart_edgeonly", catmark_dart_edgeonly, kCatmark, levels );
 #endif
 
 #ifdef test_catmark_tent
 #include "../shapes/catmark_tent.h"
     total += checkMesh( "test_catmark_tent", simpleHbr<xyzVV>(catmark_tent, kCatmark, 0), levels );
+    total += checkTopologyFactory( "test_catmark_tent", catmark_tent, kCatmark, levels );
 #endif
 
 #ifdef test_catmark_tent_creases0
 #include "../shapes/catmark_tent_creases0.h"
     total += checkMesh( "test_catmark_tent_creases0", simpleHbr<xyzVV>(catmark_tent_creases0, kCatmark, 0), levels );
+    total += checkTopologyFactory( "test_catmark_tent_creases0", catmark_tent_creases0, kCatmark, levels );
 #endif
 
 #ifdef test_catmark_tent_creases1
@@ -593,41 +1656,58 @@ int main(int argc, char ** argv) {
 #ifdef test_loop_triangle_edgeonly
 #include "../shapes/loop_triangle_edgeonly.h"
     total += checkMesh( "test_loop_triangle_edgeonly", simpleHbr<xyzVV>(loop_triangle_edgeonly, kLoop, 0), levels, kLoop );
+    total += checkTopologyFactory( "test_loop_triangle_edgeonly", loop_triangle_edgeonly, kLoop, levels );
 #endif
 
 #ifdef test_loop_triangle_edgecorner
 #include "../shapes/loop_triangle_edgecorner.h"
     total += checkMesh( "test_loop_triangle_edgecorner", simpleHbr<xyzVV>(loop_triangle_edgecorner, kLoop, 0), levels, kLoop );
+    total += checkTopologyFactory( "test_loop_triangle_edgecorner", loop_triangle_edgecorner, kLoop, levels );
 #endif
 
 #ifdef test_loop_saddle_edgeonly
 #include "../shapes/loop_saddle_edgeonly.h"
     total += checkMesh( "test_loop_saddle_edgeonly", simpleHbr<xyzVV>(loop_saddle_edgeonly, kLoop, 0), levels, kLoop );
+    total += checkTopologyFactory( "test_loop_saddle_edgeonly", loop_saddle_edgeonly, kLoop, levels );
 #endif
 
 #ifdef test_loop_saddle_edgecorner
 #include "../shapes/loop_saddle_edgecorner.h"
     total += checkMesh( "test_loop_saddle_edgecorner", simpleHbr<xyzVV>(loop_saddle_edgecorner, kLoop, 0), levels, kLoop );
+    total += checkTopologyFactory( "test_loop_saddle_edgecorner", loop_saddle_edgecorner, kLoop, levels );
+#ifdef OPENSUBDIV_HAS_OPENMP
+    total += checkConcurrentRefine( "test_loop_saddle_edgecorner", loop_saddle_edgecorner, kLoop, levels );
+    total += checkFactoryThreads( "test_loop_saddle_edgecorner", loop_saddle_edgecorner, kLoop, levels );
+#endif
 #endif
 
 #ifdef test_loop_icosahedron
 #include "../shapes/loop_icosahedron.h"
     total += checkMesh( "test_loop_icosahedron", simpleHbr<xyzVV>(loop_icosahedron, kLoop, 0), levels, kLoop );
+    total += checkTopologyFactory( "test_loop_icosahedron", loop_icosahedron, kLoop, levels );
 #endif
 
 #ifdef test_loop_cube
 #include "../shapes/loop_cube.h"
     total += checkMesh( "test_loop_cube", simpleHbr<xyzVV>(loop_cube, kLoop, 0), levels, kLoop );
+    total += checkTopologyFactory( "test_loop_cube", loop_cube, kLoop, levels );
+#ifdef OPENSUBDIV_HAS_OPENMP
+    total += checkThreadArenas( "test_loop_cube", loop_cube, kLoop, levels );
+    total += checkConcurrentRefine( "test_loop_cube", loop_cube, kLoop, levels );
+    total += checkFactoryThreads( "test_loop_cube", loop_cube, kLoop, levels );
+#endif
 #endif
 
 #ifdef test_loop_cube_creases0
 #include "../shapes/loop_cube_creases0.h"
     total += checkMesh( "test_loop_cube_creases0", simpleHbr<xyzVV>(loop_cube_creases0, kLoop, 0), levels, kLoop );
+    total += checkTopologyFactory( "test_loop_cube_creases0", loop_cube_creases0, kLoop, levels );
 #endif
 
 #ifdef test_loop_cube_creases1
 #include "../shapes/loop_cube_creases1.h"
     total += checkMesh( "test_loop_cube_creases1", simpleHbr<xyzVV>(loop_cube_creases1, kLoop, 0), levels, kLoop );
+    total += checkTopologyFactory( "test_loop_cube_creases1", loop_cube_creases1, kLoop, levels );
 #endif
 
 
@@ -635,6 +1715,30 @@ int main(int argc, char ** argv) {
 #ifdef test_bilinear_cube
 #include "../shapes/bilinear_cube.h"
     total += checkMesh( "test_bilinear_cube", simpleHbr<xyzVV>(bilinear_cube, kBilinear, 0), levels, kBilinear );
+    total += checkTopologyFactory( "test_bilinear_cube", bilinear_cube, kBilinear, levels );
+#ifdef OPENSUBDIV_HAS_OPENMP
+    total += checkThreadArenas( "test_bilinear_cube", bilinear_cube, kBilinear, levels );
+    total += checkConcurrentRefine( "test_bilinear_cube", bilinear_cube, kBilinear, levels );
+    total += checkFactoryThreads( "test_bilinear_cube", bilinear_cube, kBilinear, levels );
+#endif
+#endif
+
+#ifdef test_loop_icosahedron
+    total += checkAdaptiveLoop( "test_loop_icosahedron", simpleHbr<xyzVV>(loop_icosahedron, kLoop, 0), levels );
+#endif
+
+#ifdef test_loop_cube_creases1
+    total += checkAdaptiveLoop( "test_loop_cube_creases1", simpleHbr<xyzVV>(loop_cube_creases1, kLoop, 0), levels );
+    total += checkAdaptiveSerialization( "test_loop_cube_creases1", simpleHbr<xyzVV>(loop_cube_creases1, kLoop, 0), levels );
+#endif
+
+#ifdef test_loop_triangle_edgecorner
+    total += checkAdaptiveLoop( "test_loop_triangle_edgecorner", simpleHbr<xyzVV>(loop_triangle_edgecorner, kLoop, 0), levels );
+#endif
+
+#if defined(test_catmark_cube_creases1) && defined(test_catmark_dart_edgecorner)
+    total += checkAdaptiveSerialization( "test_catmark_cube_creases1", simpleHbr<xyzVV>(catmark_cube_creases1, kCatmark, 0), levels );
+    total += checkAdaptiveSerialization( "test_catmark_dart_edgecorner", simpleHbr<xyzVV>(catmark_dart_edgecorner, kCatmark, 0), levels );
 #endif
 
 
@@ -0,0 +1,436 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+
+// Headless benchmark of the CPU compute controllers : every regression shape
+// (optionally tiled to scale it up) is refined to each level with each
+// controller, reporting the time spent in the FarMeshFactory, the memory of
+// the subdivision tables and the time of a Refine, in CSV or JSON.
+//
+//   osd_benchmark [-l maxlevel] [-r repeats] [-w warmups] [-t tiles]
+//                 [-s shape] [-f csv|json] [-o file]
+
+#if defined(_WIN32)
+    #include <windows.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+
+#include "../common/mutex.h"
+
+#include <far/meshFactory.h>
+#include <far/kernelProfiler.h>
+
+#include <osd/vertex.h>
+#include <osd/cpuVertexBuffer.h>
+#include <osd/cpuComputeContext.h>
+#include <osd/cpuComputeController.h>
+#include <osd/taskComputeController.h>
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+    #include <osd/ompComputeController.h>
+#endif
+
+#include "../../examples/common/stopwatch.h"
+
+#include "init_shapes.h"
+
+typedef OpenSubdiv::HbrMesh<OpenSubdiv::OsdVertex> OsdHbrMesh;
+typedef OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> OsdFarMesh;
+
+//------------------------------------------------------------------------------
+// Benchmark settings (see usage)
+static int g_maxlevel = 4,
+           g_repeats = 10,
+           g_warmups = 2,
+           g_tiles = 1;
+
+static char const * g_shapeFilter = 0;
+
+static char const * g_profile = 0;
+
+static bool g_json = false;
+
+static FILE * g_output = stdout;
+
+//------------------------------------------------------------------------------
+// One measurement : refining a shape to a level with a controller
+struct Result {
+    char const * shape,
+               * controller;
+    Scheme scheme;
+    int level,
+        numCoarseVertices,
+        numVertices,
+        tableMemory;
+    double factoryTime,
+           minRefineTime,
+           avgRefineTime;
+};
+
+static char const * schemeName(Scheme scheme) {
+    switch (scheme) {
+        case kBilinear : return "bilinear";
+        case kLoop     : return "loop";
+        default        : return "catmark";
+    }
+}
+
+static void printHeader() {
+
+    if (g_json)
+        fprintf(g_output, "[\n");
+    else
+        fprintf(g_output, "shape,scheme,tiles,level,coarse_vertices,vertices,"
+                          "table_bytes,factory_ms,controller,repeats,"
+                          "refine_min_ms,refine_avg_ms\n");
+}
+
+static void printResult(Result const & r, bool first) {
+
+    if (g_json) {
+        fprintf(g_output, "%s  { \"shape\" : \"%s\", \"scheme\" : \"%s\", "
+                          "\"tiles\" : %d, \"level\" : %d, "
+                          "\"coarse_vertices\" : %d, \"vertices\" : %d, "
+                          "\"table_bytes\" : %d, \"factory_ms\" : %.4f, "
+                          "\"controller\" : \"%s\", \"repeats\" : %d, "
+                          "\"refine_min_ms\" : %.4f, \"refine_avg_ms\" : %.4f }",
+                first ? "" : ",\n",
+                r.shape, schemeName(r.scheme), g_tiles, r.level,
+                r.numCoarseVertices, r.numVertices, r.tableMemory,
+                r.factoryTime*1000.0, r.controller, g_repeats,
+                r.minRefineTime*1000.0, r.avgRefineTime*1000.0);
+    } else {
+        fprintf(g_output, "%s,%s,%d,%d,%d,%d,%d,%.4f,%s,%d,%.4f,%.4f\n",
+                r.shape, schemeName(r.scheme), g_tiles, r.level,
+                r.numCoarseVertices, r.numVertices, r.tableMemory,
+                r.factoryTime*1000.0, r.controller, g_repeats,
+                r.minRefineTime*1000.0, r.avgRefineTime*1000.0);
+    }
+}
+
+static void printFooter() {
+
+    if (g_json)
+        fprintf(g_output, "\n]\n");
+}
+
+//------------------------------------------------------------------------------
+// Scales a shape up by tiling 'ntiles' copies of it along the x axis : the
+// creases and corners are tiled along with the vertices, the other tags (ex.
+// hierarchical edits, which refer to faces) only apply to the first copy.
+static void tileShape( shape * sh, int ntiles ) {
+
+    if (ntiles<=1)
+        return;
+
+    int nverts = sh->getNverts(),
+        nfaceverts = (int)sh->faceverts.size(),
+        nfaces = sh->getNfaces(),
+        ntags = (int)sh->tags.size();
+
+    float xmin=FLT_MAX, xmax=-FLT_MAX;
+    for (int i=0; i<nverts; ++i) {
+        xmin = std::min(xmin, sh->verts[i*3]);
+        xmax = std::max(xmax, sh->verts[i*3]);
+    }
+    float dx = (xmax-xmin)*1.25f + 1.0f;
+
+    for (int tile=1; tile<ntiles; ++tile) {
+
+        for (int i=0; i<nverts; ++i) {
+            sh->verts.push_back(sh->verts[i*3+0] + dx*tile);
+            sh->verts.push_back(sh->verts[i*3+1]);
+            sh->verts.push_back(sh->verts[i*3+2]);
+        }
+
+        for (int i=0; i<nfaces; ++i)
+            sh->nvertsPerFace.push_back(sh->nvertsPerFace[i]);
+
+        for (int i=0; i<nfaceverts; ++i)
+            sh->faceverts.push_back(sh->faceverts[i] + nverts*tile);
+
+        for (int i=0; i<ntags; ++i) {
+            shape::tag const * t = sh->tags[i];
+            if (t->name!="crease" and t->name!="corner")
+                continue;
+
+            shape::tag * copy = new shape::tag(*t);
+            for (int j=0; j<(int)copy->intargs.size(); ++j)
+                copy->intargs[j] += nverts*tile;
+            sh->tags.push_back(copy);
+        }
+    }
+
+    // the uvs and normals are not tiled
+    sh->faceuvs.clear();
+    sh->facenormals.clear();
+}
+
+// Creates the Hbr mesh of a (tiled) shape, returning its coarse vertices
+static OsdHbrMesh * createHbrMesh( shaperec const & rec, std::vector<float> & verts ) {
+
+    shape * sh = shape::parseShape( rec.data.c_str() );
+
+    tileShape( sh, g_tiles );
+
+    OsdHbrMesh * mesh = createMesh<OpenSubdiv::OsdVertex>(rec.scheme);
+
+    createVertices<OpenSubdiv::OsdVertex>(sh, mesh, verts);
+
+    createTopology<OpenSubdiv::OsdVertex>(sh, mesh, rec.scheme);
+
+    copyVertexPositions<OpenSubdiv::OsdVertex>(sh, mesh, verts);
+
+    delete sh;
+
+    return mesh;
+}
+
+//------------------------------------------------------------------------------
+// Times g_repeats refinements of the vertex buffer, after g_warmups untimed
+// ones (ex. to start the thread pools and warm the caches up). Asynchronous
+// controllers are synchronized within each timed refinement. The kernels of the
+// timed refinements of the controller profiled (see usage) are printed to stderr.
+template <class CONTROLLER>
+static void benchRefine( CONTROLLER * controller,
+                         OpenSubdiv::OsdCpuComputeContext * context,
+                         OpenSubdiv::OsdCpuVertexBuffer * vb,
+                         Result * result ) {
+
+    for (int i=0; i<g_warmups; ++i) {
+        controller->Refine( context, vb );
+        controller->Synchronize();
+    }
+
+    Stopwatch s;
+
+    double minTime = DBL_MAX,
+           totalTime = 0.0;
+
+    OpenSubdiv::FarKernelProfiler profiler;
+    bool profile = g_profile and not strcmp(g_profile, result->controller);
+    if (profile)
+        OpenSubdiv::FarKernelInstrumentation::Install(&profiler);
+
+    for (int i=0; i<g_repeats; ++i) {
+        s.Start();
+        controller->Refine( context, vb );
+        controller->Synchronize();
+        s.Stop();
+
+        minTime = std::min(minTime, s.GetElapsed());
+        totalTime += s.GetElapsed();
+    }
+
+    if (profile) {
+        OpenSubdiv::FarKernelInstrumentation::Install(0);
+        fprintf(stderr, "%s level %d (%s) :\n", result->shape, result->level,
+                result->controller);
+        profiler.Print(stderr);
+    }
+
+    result->minRefineTime = minTime;
+    result->avgRefineTime = totalTime / g_repeats;
+}
+
+// Refines the shape to the level with every controller
+static void benchShape( shaperec const & rec, int level, bool * first ) {
+
+    std::vector<float> coarseverts;
+
+    // a new Hbr mesh, so that the factory times the Hbr refinement of every level
+    OsdHbrMesh * hmesh = createHbrMesh( rec, coarseverts );
+
+    Stopwatch s;
+    s.Start();
+
+    OpenSubdiv::FarMeshFactory<OpenSubdiv::OsdVertex> meshFactory(hmesh, level);
+    OsdFarMesh * farmesh = meshFactory.Create();
+
+    s.Stop();
+
+    Result result;
+    result.shape = rec.name.c_str();
+    result.scheme = rec.scheme;
+    result.level = level;
+    result.numCoarseVertices = (int)coarseverts.size()/3;
+    result.numVertices = farmesh->GetNumVertices();
+    result.tableMemory = farmesh->GetSubdivisionTables()->GetMemoryUsed();
+    result.factoryTime = s.GetElapsed();
+
+    OpenSubdiv::OsdCpuComputeContext * context =
+        OpenSubdiv::OsdCpuComputeContext::Create(farmesh);
+
+    OpenSubdiv::OsdCpuVertexBuffer * vb =
+        OpenSubdiv::OsdCpuVertexBuffer::Create(3, farmesh->GetNumVertices());
+
+    vb->UpdateData( & coarseverts[0], result.numCoarseVertices );
+
+    static OpenSubdiv::OsdCpuComputeController cpuController;
+    result.controller = "cpu";
+    benchRefine(&cpuController, context, vb, &result);
+    printResult(result, *first);
+    *first = false;
+
+    static OpenSubdiv::OsdCpuComputeController cpuAsyncController(/*asynchronous*/ true);
+    result.controller = "cpu async";
+    benchRefine(&cpuAsyncController, context, vb, &result);
+    printResult(result, *first);
+
+    static OpenSubdiv::OsdTaskComputeController taskController;
+    result.controller = "task";
+    benchRefine(&taskController, context, vb, &result);
+    printResult(result, *first);
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+    static OpenSubdiv::OsdOmpComputeController ompController;
+    result.controller = "omp";
+    benchRefine(&ompController, context, vb, &result);
+    printResult(result, *first);
+
+    static OpenSubdiv::OsdOmpComputeController ompAsyncController(-1, 1024, /*asynchronous*/ true);
+    result.controller = "omp async";
+    benchRefine(&ompAsyncController, context, vb, &result);
+    printResult(result, *first);
+#endif
+
+    delete vb;
+    delete context;
+    delete farmesh;
+    delete hmesh;
+}
+
+//------------------------------------------------------------------------------
+static void usage( char const * program ) {
+
+    fprintf(stderr,
+        "Usage : %s [options]\n"
+        "  -l <level>    refines the shapes to levels 1 to <level> (default %d)\n"
+        "  -r <count>    number of timed refinements (default %d)\n"
+        "  -w <count>    number of untimed refinements beforehand (default %d)\n"
+        "  -t <count>    tiles <count> copies of each shape (default %d)\n"
+        "  -s <name>     only benchmarks the shapes whose name contains <name>\n"
+        "  -f csv|json   output format (default csv)\n"
+        "  -o <file>     writes the results to <file> (default stdout)\n"
+        "  -p <ctrl>     prints the kernels of the controller <ctrl> (ex. \"cpu\")\n"
+        "                to stderr (the kernels are timed within the refinements)\n",
+        program, g_maxlevel, g_repeats, g_warmups, g_tiles);
+    exit(1);
+}
+
+int main(int argc, char ** argv) {
+
+    char const * outputFile = 0;
+
+    for (int i=1; i<argc; ++i) {
+        if (i+1==argc)
+            usage(argv[0]);
+
+        if (not strcmp(argv[i], "-l"))
+            g_maxlevel = atoi(argv[++i]);
+        else if (not strcmp(argv[i], "-r"))
+            g_repeats = atoi(argv[++i]);
+        else if (not strcmp(argv[i], "-w"))
+            g_warmups = atoi(argv[++i]);
+        else if (not strcmp(argv[i], "-t"))
+            g_tiles = atoi(argv[++i]);
+        else if (not strcmp(argv[i], "-s"))
+            g_shapeFilter = argv[++i];
+        else if (not strcmp(argv[i], "-f"))
+            g_json = not strcmp(argv[++i], "json");
+        else if (not strcmp(argv[i], "-o"))
+            outputFile = argv[++i];
+        else if (not strcmp(argv[i], "-p"))
+            g_profile = argv[++i];
+        else
+            usage(argv[0]);
+    }
+
+    if (g_maxlevel<1 or g_repeats<1 or g_warmups<0 or g_tiles<1)
+        usage(argv[0]);
+
+    if (outputFile and not (g_output = fopen(outputFile, "w"))) {
+        fprintf(stderr, "Cannot open %s\n", outputFile);
+        return 1;
+    }
+
+    initShapes();
+
+    printHeader();
+
+    bool first = true;
+    for (int i=0; i<(int)g_shapes.size(); ++i) {
+
+        if (g_shapeFilter and not strstr(g_shapes[i].name.c_str(), g_shapeFilter))
+            continue;
+
+        for (int level=1; level<=g_maxlevel; ++level)
+            benchShape(g_shapes[i], level, &first);
+
+        fflush(g_output);
+    }
+
+    printFooter();
+
+    if (g_output!=stdout)
+        fclose(g_output);
+
+    return 0;
+}
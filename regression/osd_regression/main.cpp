@@ -63,18 +63,36 @@
     #include <GL/glut.h>
 #endif
 
+#if defined(_WIN32)
+    #define NOMINMAX
+    #include <windows.h>
+#endif
+
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <cassert>
+#include <algorithm>
+#include <new>
 
 #include "../common/mutex.h"
 
 #include <far/meshFactory.h>
+#include <far/kernelInstrumentation.h>
+#include <far/meshSerializer.h>
 
 #include <osd/vertex.h>
 #include <osd/cpuVertexBuffer.h>
 #include <osd/cpuDispatcher.h>
 #include <osd/cpuComputeController.h>
 #include <osd/cpuComputeContext.h>
+#include <osd/cpuKernel.h>
+#include <osd/evalContext.h>
+#include <osd/taskComputeController.h>
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+    #include <osd/ompComputeController.h>
+#endif
 
 #ifdef OPENSUBDIV_HAS_CUDA
     #include <osd/cudaDispatcher.h>
@@ -99,6 +117,86 @@
 //
 #define PRECISION 1e-6
 
+// Limit surface samples are compared to the centroid of the faces of the
+// uniformly refined mesh, which only converges towards the limit surface.
+// Gregory patches also only approximate the limit around extraordinary
+// features (such as sharp corners) at the last level of isolation.
+#define LIMIT_PRECISION 1e-2
+
+// Limit derivatives are compared to central differences of limit positions,
+// relative to the magnitude of the derivative.
+#define DERIVATIVE_PRECISION 1e-2
+
+//------------------------------------------------------------------------------
+// Counts the heap allocations made through operator new (see checkAllocations).
+// The task pool, asynchronous workers and OpenMP threads allocate concurrently,
+// so the counter is updated atomically.
+static volatile long g_numAllocations = 0;
+
+static void countAllocation() {
+#if defined(_WIN32)
+    InterlockedIncrement(&g_numAllocations);
+#else
+    __sync_fetch_and_add(&g_numAllocations, 1);
+#endif
+}
+
+static long getNumAllocations() {
+#if defined(_WIN32)
+    return InterlockedCompareExchange(&g_numAllocations, 0, 0);
+#else
+    return __sync_fetch_and_add(&g_numAllocations, 0);
+#endif
+}
+
+// The replacement functions are not inlined : GCC would otherwise pair the
+// free() of an inlined operator delete with the operator new of the caller
+// (-Wmismatched-new-delete).
+#if defined(_MSC_VER)
+    #define ALLOCATION_FUNCTION __declspec(noinline)
+#elif defined(__GNUC__)
+    #define ALLOCATION_FUNCTION __attribute__((noinline))
+#else
+    #define ALLOCATION_FUNCTION
+#endif
+
+ALLOCATION_FUNCTION void * operator new(size_t size) {
+    countAllocation();
+    void * ptr = malloc(size ? size : 1);
+    if (not ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+ALLOCATION_FUNCTION void * operator new[](size_t size) {
+    return operator new(size);
+}
+
+ALLOCATION_FUNCTION void * operator new(size_t size, std::nothrow_t const &) throw() {
+    countAllocation();
+    return malloc(size ? size : 1);
+}
+
+ALLOCATION_FUNCTION void * operator new[](size_t size, std::nothrow_t const &) throw() {
+    return operator new(size, std::nothrow);
+}
+
+ALLOCATION_FUNCTION void operator delete(void * ptr) throw() {
+    free(ptr);
+}
+
+ALLOCATION_FUNCTION void operator delete[](void * ptr) throw() {
+    free(ptr);
+}
+
+ALLOCATION_FUNCTION void operator delete(void * ptr, std::nothrow_t const &) throw() {
+    free(ptr);
+}
+
+ALLOCATION_FUNCTION void operator delete[](void * ptr, std::nothrow_t const &) throw() {
+    free(ptr);
+}
+
 //------------------------------------------------------------------------------
 // Vertex class implementation
 struct xyzVV {
@@ -287,6 +385,1139 @@ int checkVertexBuffer( xyzmesh * hmesh,
     return count;
 }
 
+//------------------------------------------------------------------------------
+static int g_numOsdErrors = 0;
+
+static void countOsdErrors( OpenSubdiv::OsdErrorType, const char * ) {
+    ++g_numOsdErrors;
+}
+
+//------------------------------------------------------------------------------
+// Returns the distance between 2 points
+static float distance( float const * a, float const * b ) {
+    float delta[3] = { a[0]-b[0], a[1]-b[1], a[2]-b[2] };
+    return sqrtf( delta[0]*delta[0]+delta[1]*delta[1]+delta[2]*delta[2] );
+}
+
+//------------------------------------------------------------------------------
+// Evaluates the limit surface of an adaptive mesh at the center of each face of
+// the uniformly refined mesh and compares it to the centroid of the face. The
+// limit derivatives are compared to central differences of limit positions.
+// The coarse positions are also refined as varying data : the varying data
+// evaluated on a quad face must interpolate its corners bilinearly.
+int checkLimitSurface( char const * shape,
+                       OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> const * farmesh,
+                       OpenSubdiv::OsdCpuVertexBuffer * vb, int levels ) {
+
+    std::vector<float> coarseverts;
+
+    OsdHbrMesh * hmesh = simpleHbr<OpenSubdiv::OsdVertex>(shape, kCatmark, coarseverts);
+
+    // the ptex index of non-quad faces is negated, which is ambiguous for face 0
+    bool firstFaceIsQuad = hmesh->GetFace(0)->GetNumVertices()==4;
+
+    OpenSubdiv::FarMeshFactory<OpenSubdiv::OsdVertex> meshFactory(hmesh, levels, /*adaptive*/ true);
+
+    OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> * adaptiveMesh = meshFactory.Create(/*ptex*/ true);
+
+    OpenSubdiv::OsdCpuComputeController controller;
+
+    OpenSubdiv::OsdCpuComputeContext * context =
+        OpenSubdiv::OsdCpuComputeContext::Create(adaptiveMesh);
+
+    OpenSubdiv::OsdCpuVertexBuffer * adaptiveVb =
+        OpenSubdiv::OsdCpuVertexBuffer::Create(3, adaptiveMesh->GetNumVertices()),
+                                   * adaptiveVaryingVb =
+        OpenSubdiv::OsdCpuVertexBuffer::Create(3, adaptiveMesh->GetNumVertices());
+
+    adaptiveVb->UpdateData( & coarseverts[0], (int)coarseverts.size()/3 );
+    adaptiveVaryingVb->UpdateData( & coarseverts[0], (int)coarseverts.size()/3 );
+
+    controller.Refine( context, adaptiveVb, adaptiveVaryingVb );
+
+    OpenSubdiv::OsdEvalContext * evalContext = OpenSubdiv::OsdEvalContext::Create(adaptiveMesh);
+    assert(evalContext);
+
+    std::vector<int> const & faceverts = farmesh->GetFaceVertices(levels);
+    std::vector<int> const & ptexcoords = farmesh->GetPtexCoordinates(levels);
+
+    int nfaces = (int)faceverts.size()/4;
+
+    std::vector<OpenSubdiv::OsdEvalCoords> coords(nfaces);
+    for (int i=0; i<nfaces; ++i) {
+        int face = ptexcoords[2*i],
+            depth = levels;
+        if (face<0 or (face==0 and not firstFaceIsQuad)) {
+            face = -face;
+            depth = levels-1;
+        }
+        float u = (float)(ptexcoords[2*i+1] >> 16),
+              v = (float)(ptexcoords[2*i+1] & 0xffff),
+              scale = 1.0f / (1<<depth);
+        coords[i] = OpenSubdiv::OsdEvalCoords(face, (u+0.5f)*scale, (v+0.5f)*scale);
+    }
+
+    std::vector<float> limit(nfaces*3), du(nfaces*3), dv(nfaces*3), varying(nfaces*3);
+    int nsamples = evalContext->EvalLimitSamples( adaptiveVb, adaptiveVaryingVb,
+                                                  nfaces, &coords[0], &limit[0],
+                                                  &du[0], &dv[0], &varying[0] );
+
+    int count = nfaces - nsamples;
+
+    // limit positions on each side of the samples along u and v : the offset
+    // keeps the samples within their sub-face, hence within a single patch
+    float h = 0.1f / (1<<levels);
+
+    std::vector<float> offsetLimit[4];
+    for (int k=0; k<4; ++k) {
+        std::vector<OpenSubdiv::OsdEvalCoords> offsetCoords(coords);
+        for (int i=0; i<nfaces; ++i) {
+            float offset = (k&1) ? -h : h;
+            if (k<2)
+                offsetCoords[i].u += offset;
+            else
+                offsetCoords[i].v += offset;
+        }
+        offsetLimit[k].resize(nfaces*3);
+        count += nfaces - evalContext->EvalLimitSamples( adaptiveVb,
+                                                         (OpenSubdiv::OsdCpuVertexBuffer *)0,
+                                                         nfaces, &offsetCoords[0],
+                                                         &offsetLimit[k][0] );
+    }
+
+    float const * verts = vb->BindCpuBuffer();
+
+    float maxDist = 0.0f;
+    for (int i=0; i<nfaces; ++i) {
+
+        float delta[3] = { -limit[3*i], -limit[3*i+1], -limit[3*i+2] };
+        for (int j=0; j<4; ++j) {
+            float const * fv = verts + faceverts[4*i+j]*3;
+            delta[0] += 0.25f*fv[0];
+            delta[1] += 0.25f*fv[1];
+            delta[2] += 0.25f*fv[2];
+        }
+
+        float dist = sqrtf( delta[0]*delta[0]+delta[1]*delta[1]+delta[2]*delta[2]);
+        if ( dist > LIMIT_PRECISION ) {
+            printf("// Limit sample %d (face %d u=%f v=%f) fails : dist=%.10f\n",
+                i, coords[i].face, coords[i].u, coords[i].v, dist);
+            count++;
+        }
+        if (dist > maxDist)
+            maxDist = dist;
+    }
+    printf("    limit surface : %d samples, max distance %.10f\n", nsamples, maxDist);
+
+    float maxError = 0.0f;
+    for (int i=0; i<nfaces; ++i) {
+        float const * deriv[2] = { &du[3*i], &dv[3*i] };
+        for (int k=0; k<2; ++k) {
+            float diff[3];
+            for (int j=0; j<3; ++j)
+                diff[j] = (offsetLimit[2*k][3*i+j] - offsetLimit[2*k+1][3*i+j]) / (2.0f*h);
+
+            float zero[3] = { 0.0f, 0.0f, 0.0f },
+                  error = distance(diff, deriv[k]) / (1.0f + distance(deriv[k], zero));
+            if ( error > DERIVATIVE_PRECISION ) {
+                printf("// Limit derivative %s of sample %d (face %d u=%f v=%f) fails : error=%.10f\n",
+                    k ? "dv" : "du", i, coords[i].face, coords[i].u, coords[i].v, error);
+                count++;
+            }
+            if (error > maxError)
+                maxError = error;
+        }
+    }
+    printf("    limit derivatives : max relative error %.10f\n", maxError);
+
+    // varying data : the corners of the coarse quad faces are the coarse
+    // vertices in ptex order, which are refined (and evaluated) bilinearly
+    std::vector<OsdHbrFace *> ptexFaces(evalContext->GetNumPtexFaces(), (OsdHbrFace *)0);
+    for (int i=0; i<hmesh->GetNumFaces(); ++i) {
+        OsdHbrFace * f = hmesh->GetFace(i);
+        if (f->GetDepth()==0 and f->GetNumVertices()==4 and f->GetPtexIndex()<(int)ptexFaces.size())
+            ptexFaces[f->GetPtexIndex()] = f;
+    }
+
+    float maxVaryingDist = 0.0f;
+    for (int i=0; i<nfaces; ++i) {
+        OsdHbrFace * f = ptexFaces[coords[i].face];
+        if (not f)
+            continue;
+
+        float u = coords[i].u,
+              v = coords[i].v,
+              weights[4] = { (1.0f-u)*(1.0f-v), u*(1.0f-v), u*v, (1.0f-u)*v },
+              expected[3] = { 0.0f, 0.0f, 0.0f };
+        for (int j=0; j<4; ++j) {
+            float const * corner = &coarseverts[3*f->GetVertex(j)->GetID()];
+            for (int k=0; k<3; ++k)
+                expected[k] += weights[j]*corner[k];
+        }
+
+        float dist = distance(expected, &varying[3*i]);
+        if ( dist > PRECISION ) {
+            printf("// Varying sample %d (face %d u=%f v=%f) fails : dist=%.10f\n",
+                i, coords[i].face, coords[i].u, coords[i].v, dist);
+            count++;
+        }
+        if (dist > maxVaryingDist)
+            maxVaryingDist = dist;
+    }
+    printf("    varying : max distance %.10f\n", maxVaryingDist);
+
+    // the same primvars interleaved in a single buffer (vertex elements at
+    // offset 1, varying elements at offset 4) must evaluate identically
+    {
+        int stride = 8,
+            nverts = adaptiveMesh->GetNumVertices();
+        std::vector<float> interleaved(nverts*stride, -1.0f);
+        float const * vertexData = adaptiveVb->BindCpuBuffer(),
+                    * varyingData = adaptiveVaryingVb->BindCpuBuffer();
+        for (int i=0; i<nverts; ++i)
+            for (int j=0; j<3; ++j) {
+                interleaved[i*stride+1+j] = vertexData[i*3+j];
+                interleaved[i*stride+4+j] = varyingData[i*3+j];
+            }
+
+        OpenSubdiv::OsdVertexDescriptor vdesc(
+            OpenSubdiv::OsdVertexBufferDescriptor(1, 3, stride),
+            OpenSubdiv::OsdVertexBufferDescriptor(4, 3, stride));
+
+        std::vector<float> ilimit(nfaces*3), idu(nfaces*3), idv(nfaces*3), ivarying(nfaces*3);
+        int isamples = evalContext->EvalLimitSamples( vdesc, &interleaved[1], &interleaved[4],
+                                                      nfaces, &coords[0], &ilimit[0],
+                                                      &idu[0], &idv[0], &ivarying[0] );
+        if (isamples!=nsamples or ilimit!=limit or idu!=du or idv!=dv or ivarying!=varying) {
+            printf("// Interleaved limit samples differ\n");
+            count++;
+        }
+
+        // double precision data is rejected
+        OpenSubdiv::OsdVertexDescriptor ddesc(3, 0, 1, OpenSubdiv::OSD_PRECISION_DOUBLE);
+        g_numOsdErrors = 0;
+        OpenSubdiv::OsdSetErrorCallback( countOsdErrors );
+        int dsamples = evalContext->EvalLimitSamples( ddesc, &interleaved[0], 0,
+                                                      nfaces, &coords[0], &ilimit[0] );
+        OpenSubdiv::OsdSetErrorCallback( 0 );
+        if (dsamples!=0 or g_numOsdErrors!=1) {
+            printf("// Double precision limit samples were evaluated\n");
+            count++;
+        }
+    }
+
+    delete evalContext;
+    delete adaptiveVaryingVb;
+    delete adaptiveVb;
+    delete context;
+    delete adaptiveMesh;
+    delete hmesh;
+
+    return count;
+}
+
+//------------------------------------------------------------------------------
+struct TaskRefineData {
+    OpenSubdiv::OsdTaskComputeController * controller;
+    OpenSubdiv::OsdCpuComputeContext ** contexts;
+    OpenSubdiv::OsdCpuVertexBuffer ** buffers;
+};
+
+static void refineTask( void * data, int start, int end ) {
+
+    TaskRefineData * d = static_cast<TaskRefineData *>(data);
+    for (int i=start; i<end; ++i)
+        d->controller->Refine( d->contexts[i], d->buffers[i] );
+}
+
+// Refines the mesh with the task controller, both directly and from inside
+// tasks of the same pool (nested parallelism), and checks that the results are
+// identical to the single threaded CPU controller.
+int checkTaskController( OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> * farmesh,
+                         std::vector<float> const & coarseverts,
+                         OpenSubdiv::OsdCpuVertexBuffer * cpuVb ) {
+
+    // small grain to split even the coarse levels into several tasks
+    static OpenSubdiv::OsdTaskThreadPool *pool =
+        new OpenSubdiv::OsdTaskThreadPool(4);
+    static OpenSubdiv::OsdTaskComputeController *controller =
+        new OpenSubdiv::OsdTaskComputeController(pool, /*grainSize*/ 8);
+
+    int const nbuffers = 4,
+              nverts = farmesh->GetNumVertices();
+
+    OpenSubdiv::OsdCpuComputeContext * contexts[nbuffers];
+    OpenSubdiv::OsdCpuVertexBuffer * buffers[nbuffers];
+
+    for (int i=0; i<nbuffers; ++i) {
+        contexts[i] = OpenSubdiv::OsdCpuComputeContext::Create(farmesh);
+        buffers[i] = OpenSubdiv::OsdCpuVertexBuffer::Create(3, nverts);
+        buffers[i]->UpdateData( & coarseverts[0], (int)coarseverts.size()/3 );
+    }
+
+    controller->Refine( contexts[0], buffers[0] );
+
+    TaskRefineData data = { controller, contexts+1, buffers+1 };
+    pool->ParallelFor(0, nbuffers-1, 1, refineTask, &data);
+
+    int count=0;
+    float const * ref = cpuVb->BindCpuBuffer();
+    for (int i=0; i<nbuffers; ++i) {
+        float const * verts = buffers[i]->BindCpuBuffer();
+        for (int j=0; j<nverts*3; ++j)
+            if (verts[j]!=ref[j]) {
+                ++count;
+            }
+        delete buffers[i];
+        delete contexts[i];
+    }
+
+    if (count)
+        printf("    task controller : %d values differ from the cpu controller\n", count);
+
+    return count;
+}
+
+// Refines the mesh again with every kernel batch writing its vertices with
+// non-temporal stores and checks that the results are unchanged.
+int checkNonTemporalStores( OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> * farmesh,
+                            OpenSubdiv::OsdCpuComputeController * controller,
+                            OpenSubdiv::OsdCpuComputeContext * context,
+                            std::vector<float> const & coarseverts,
+                            OpenSubdiv::OsdCpuVertexBuffer * cpuVb ) {
+
+    int nverts = farmesh->GetNumVertices();
+
+    OpenSubdiv::OsdCpuVertexBuffer * vb = OpenSubdiv::OsdCpuVertexBuffer::Create(3, nverts);
+    vb->UpdateData( & coarseverts[0], (int)coarseverts.size()/3 );
+
+    size_t threshold = OpenSubdiv::OsdCpuGetNonTemporalStoreThreshold();
+    OpenSubdiv::OsdCpuSetNonTemporalStoreThreshold(0);
+    controller->Refine( context, vb );
+    OpenSubdiv::OsdCpuSetNonTemporalStoreThreshold(threshold);
+
+    int count=0;
+    float const * ref = cpuVb->BindCpuBuffer(),
+                * verts = vb->BindCpuBuffer();
+    for (int j=0; j<nverts*3; ++j)
+        if (verts[j]!=ref[j]) {
+            ++count;
+        }
+    delete vb;
+
+    if (count)
+        printf("    non-temporal stores : %d values differ from the cpu controller\n", count);
+
+    return count;
+}
+
+// Counts the kernels launched and the vertices they compute
+struct KernelCounter : public OpenSubdiv::FarKernelInstrumentation {
+
+    KernelCounter() : launches(0), pending(0), vertices(0), errors(0) { }
+
+    virtual void BeginKernel(OpenSubdiv::FarKernelLaunch const & launch) {
+        ++launches;
+        ++pending;
+        vertices += launch.end-launch.start;
+        // the CPU kernels compute the vertex-vertices in a single pass
+        if (launch.kernel>OpenSubdiv::FarKernelLaunch::k_VertexVertices and
+            launch.kernel!=OpenSubdiv::FarKernelLaunch::k_VertexEdits)
+            ++errors;
+        if (launch.bytes<(launch.end-launch.start)*3*sizeof(float))
+            ++errors;
+    }
+
+    virtual void EndKernel(OpenSubdiv::FarKernelLaunch const & launch) {
+        --pending;
+    }
+
+    int launches, pending, vertices, errors;
+};
+
+// Refines the mesh with the kernels instrumented and checks that the kernels
+// reported compute all the refined vertices, as the cpu controller.
+template <class CONTROLLER>
+int checkInstrumentation( char const * msg, CONTROLLER * controller,
+                          OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> * farmesh,
+                          std::vector<float> const & coarseverts,
+                          OpenSubdiv::OsdCpuVertexBuffer * cpuVb ) {
+
+    int nverts = farmesh->GetNumVertices();
+
+    OpenSubdiv::OsdCpuComputeContext * context =
+        OpenSubdiv::OsdCpuComputeContext::Create(farmesh);
+
+    OpenSubdiv::OsdCpuVertexBuffer * vb = OpenSubdiv::OsdCpuVertexBuffer::Create(3, nverts);
+    vb->UpdateData( & coarseverts[0], (int)coarseverts.size()/3 );
+
+    KernelCounter counter;
+    OpenSubdiv::FarKernelInstrumentation::Install(&counter);
+    controller->Refine( context, vb );
+    controller->Synchronize();
+    OpenSubdiv::FarKernelInstrumentation::Install(0);
+
+    int count = counter.errors;
+    if (counter.launches!=(int)context->GetSchedule().size() or counter.pending!=0 or
+        counter.vertices!=nverts-farmesh->GetSubdivisionTables()->GetFirstVertexOffset(1))
+        ++count;
+
+    float const * ref = cpuVb->BindCpuBuffer(),
+                * verts = vb->BindCpuBuffer();
+    for (int j=0; j<nverts*3; ++j)
+        if (verts[j]!=ref[j]) {
+            ++count;
+        }
+    delete vb;
+    delete context;
+
+    if (count)
+        printf("    %s instrumentation : %d errors\n", msg, count);
+
+    return count;
+}
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+// Places a new context and buffer with FirstTouch, then refines the buffer
+// from the copy of the tables and checks that it matches the cpu controller.
+template <class CONTROLLER>
+int checkFirstTouch( char const * msg, CONTROLLER * controller,
+                     OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> * farmesh,
+                     std::vector<float> const & coarseverts,
+                     OpenSubdiv::OsdCpuVertexBuffer * cpuVb ) {
+
+    int nverts = farmesh->GetNumVertices();
+
+    OpenSubdiv::OsdCpuComputeContext * context =
+        OpenSubdiv::OsdCpuComputeContext::Create(farmesh);
+
+    OpenSubdiv::OsdCpuVertexBuffer * vb = OpenSubdiv::OsdCpuVertexBuffer::Create(3, nverts);
+
+    int count=0;
+
+    void const * tablePtr = context->GetTablePtr(OpenSubdiv::Table::V_ITa, 0);
+
+    controller->FirstTouch( context, vb );
+    controller->Synchronize();
+
+    if (not context->HasTableCopy() or
+        context->GetTablePtr(OpenSubdiv::Table::V_ITa, 0)==tablePtr)
+        ++count;
+
+    vb->UpdateData( & coarseverts[0], (int)coarseverts.size()/3 );
+
+    controller->Refine( context, vb );
+    controller->Synchronize();
+
+    float const * ref = cpuVb->BindCpuBuffer(),
+                * verts = vb->BindCpuBuffer();
+    for (int j=0; j<nverts*3; ++j)
+        if (verts[j]!=ref[j]) {
+            ++count;
+        }
+    delete vb;
+    delete context;
+
+    if (count)
+        printf("    %s first touch : %d values differ from the cpu controller\n", msg, count);
+
+    return count;
+}
+#endif
+
+// Moves two coarse vertices one after the other, refining each time only the
+// vertices that depend on the vertex moved, and checks that the results match
+// a full refine of the modified mesh.
+int checkDirtyRefine( OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> * farmesh,
+                      OpenSubdiv::OsdCpuComputeController * controller,
+                      OpenSubdiv::OsdCpuComputeContext * context,
+                      std::vector<float> const & coarseverts,
+                      OpenSubdiv::OsdCpuVertexBuffer * cpuVb ) {
+
+    int nverts = farmesh->GetNumVertices(),
+        ncoarse = (int)coarseverts.size()/3;
+
+    int dirty[2] = { 0, ncoarse/2 };
+
+    // start from the results of the unmodified mesh
+    std::vector<float> verts( cpuVb->BindCpuBuffer(), cpuVb->BindCpuBuffer()+nverts*3 );
+
+    OpenSubdiv::OsdCpuVertexBuffer * vb = OpenSubdiv::OsdCpuVertexBuffer::Create(3, nverts);
+    vb->UpdateData( & verts[0], nverts );
+
+    for (int i=0; i<2; ++i) {
+        verts[dirty[i]*3+0] += 0.1f;
+        verts[dirty[i]*3+1] += 0.2f;
+        verts[dirty[i]*3+2] -= 0.3f;
+
+        vb->UpdateData( & verts[0], ncoarse );
+        controller->Refine( context, &dirty[i], 1, vb );
+    }
+
+    OpenSubdiv::OsdCpuVertexBuffer * refVb = OpenSubdiv::OsdCpuVertexBuffer::Create(3, nverts);
+    refVb->UpdateData( & verts[0], ncoarse );
+    controller->Refine( context, refVb );
+
+    int count=0;
+    float const * ref = refVb->BindCpuBuffer(),
+                * result = vb->BindCpuBuffer();
+    for (int j=0; j<nverts*3; ++j)
+        if (result[j]!=ref[j]) {
+            ++count;
+        }
+    delete vb;
+    delete refVb;
+
+    if (count)
+        printf("    dirty refine : %d values differ from a full refine\n", count);
+
+    return count;
+}
+
+// Refines copies of the mesh as a single batch and checks that the results
+// are identical to the single threaded CPU controller.
+template <class CONTROLLER>
+int checkBatchRefine( char const * msg, CONTROLLER * controller,
+                      OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> * farmesh,
+                      std::vector<float> const & coarseverts,
+                      OpenSubdiv::OsdCpuVertexBuffer * cpuVb ) {
+
+    int const nbuffers = 8,
+              nverts = farmesh->GetNumVertices();
+
+    OpenSubdiv::OsdCpuComputeContext * contexts[nbuffers];
+    OpenSubdiv::OsdCpuVertexBuffer * buffers[nbuffers];
+
+    // clear the refined vertices, so that meshes skipped by the batch fail
+    std::vector<float> verts(nverts*3, 0.0f);
+    std::copy(coarseverts.begin(), coarseverts.end(), verts.begin());
+
+    for (int i=0; i<nbuffers; ++i) {
+        contexts[i] = OpenSubdiv::OsdCpuComputeContext::Create(farmesh);
+        buffers[i] = OpenSubdiv::OsdCpuVertexBuffer::Create(3, nverts);
+        buffers[i]->UpdateData( & verts[0], nverts );
+    }
+
+    controller->RefineBatch( contexts, buffers, nbuffers );
+
+    int count=0;
+    float const * ref = cpuVb->BindCpuBuffer();
+    for (int i=0; i<nbuffers; ++i) {
+        float const * verts = buffers[i]->BindCpuBuffer();
+        for (int j=0; j<nverts*3; ++j)
+            if (verts[j]!=ref[j]) {
+                ++count;
+            }
+        delete buffers[i];
+        delete contexts[i];
+    }
+
+    if (count)
+        printf("    %s batch : %d values differ from the cpu controller\n", msg, count);
+
+    return count;
+}
+
+// Refines the vertices depending on a coarse vertex, with the controllers
+// which support it
+static void refineDirtyVertex( OpenSubdiv::OsdCpuComputeController * controller,
+                               OpenSubdiv::OsdCpuComputeContext * context,
+                               OpenSubdiv::OsdCpuVertexBuffer * vb ) {
+    int dirty = 0;
+    controller->Refine( context, &dirty, 1, vb );
+}
+
+template <class CONTROLLER>
+static void refineDirtyVertex( CONTROLLER *, OpenSubdiv::OsdCpuComputeContext *,
+                               OpenSubdiv::OsdCpuVertexBuffer * ) {
+}
+
+// Refines the mesh with each flavor of Refine once the context and buffers
+// are created, and checks that none of them allocates memory.
+template <class CONTROLLER>
+int checkAllocations( char const * msg, CONTROLLER * controller,
+                      OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> * farmesh,
+                      std::vector<float> const & coarseverts ) {
+
+    int nverts = farmesh->GetNumVertices(),
+        ncoarse = (int)coarseverts.size()/3;
+
+    OpenSubdiv::OsdCpuComputeContext * context =
+        OpenSubdiv::OsdCpuComputeContext::Create(farmesh);
+
+    OpenSubdiv::OsdCpuVertexBuffer * vb = OpenSubdiv::OsdCpuVertexBuffer::Create(3, nverts),
+                                   * vb6 = OpenSubdiv::OsdCpuVertexBuffer::Create(6, nverts);
+    OpenSubdiv::OsdCpuDoubleVertexBuffer * dvb = OpenSubdiv::OsdCpuDoubleVertexBuffer::Create(3, nverts);
+
+    vb->UpdateData( & coarseverts[0], ncoarse );
+
+    OpenSubdiv::OsdVertexBufferDescriptor desc(3, 3, 6);
+
+    // warm up (ex. thread pools started by the first refine)
+    controller->Refine( context, vb );
+
+    long numAllocations = getNumAllocations();
+
+    controller->Refine( context, vb );
+    controller->Refine( context, vb, vb );
+    controller->Refine( context, desc, vb6 );
+    controller->RefineSamples( context, 2, vb6 );
+    controller->Refine( context, dvb );
+    controller->RefineBatch( &context, &vb, 1 );
+    refineDirtyVertex( controller, context, vb );
+
+    context->SetDoubleAccumulation(true);
+    controller->Refine( context, vb );
+    context->SetDoubleAccumulation(false);
+
+    controller->Synchronize();
+
+    int count = (int)(getNumAllocations() - numAllocations);
+
+    delete dvb;
+    delete vb6;
+    delete vb;
+    delete context;
+
+    if (count)
+        printf("    %s : %d allocations while refining\n", msg, count);
+
+    return count;
+}
+
+// Refines copies of the mesh with an asynchronous controller : each context
+// is refined twice in a row with two buffers (double buffering), then the
+// results are compared to the single threaded CPU controller.
+template <class CONTROLLER>
+int checkAsyncRefine( char const * msg, CONTROLLER * controller,
+                      OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> * farmesh,
+                      std::vector<float> const & coarseverts,
+                      OpenSubdiv::OsdCpuVertexBuffer * cpuVb ) {
+
+    int const ncontexts = 4,
+              nbuffers = ncontexts*2,
+              nverts = farmesh->GetNumVertices();
+
+    OpenSubdiv::OsdCpuComputeContext * contexts[ncontexts];
+    OpenSubdiv::OsdCpuVertexBuffer * buffers[nbuffers];
+
+    // clear the refined vertices, so that skipped refinements fail
+    std::vector<float> verts(nverts*3, 0.0f);
+    std::copy(coarseverts.begin(), coarseverts.end(), verts.begin());
+
+    for (int i=0; i<ncontexts; ++i)
+        contexts[i] = OpenSubdiv::OsdCpuComputeContext::Create(farmesh);
+    for (int i=0; i<nbuffers; ++i) {
+        buffers[i] = OpenSubdiv::OsdCpuVertexBuffer::Create(3, nverts);
+        buffers[i]->UpdateData( & verts[0], nverts );
+    }
+
+    for (int i=0; i<ncontexts; ++i)
+        controller->Refine( contexts[i], buffers[i] );
+
+    // waits for the first refinement of each context
+    controller->RefineBatch( contexts, buffers+ncontexts, ncontexts );
+
+    controller->Synchronize( contexts[0] );
+    controller->Synchronize();
+
+    int count=0;
+    float const * ref = cpuVb->BindCpuBuffer();
+    for (int i=0; i<nbuffers; ++i) {
+        float const * verts = buffers[i]->BindCpuBuffer();
+        for (int j=0; j<nverts*3; ++j)
+            if (verts[j]!=ref[j]) {
+                ++count;
+            }
+        delete buffers[i];
+    }
+
+    // the last refinements of the contexts are left pending on purpose :
+    // destroying a context waits for its refinement
+    for (int i=0; i<ncontexts; ++i) {
+        buffers[i] = OpenSubdiv::OsdCpuVertexBuffer::Create(3, nverts);
+        buffers[i]->UpdateData( & verts[0], nverts );
+        controller->Refine( contexts[i], buffers[i] );
+        delete contexts[i];
+        delete buffers[i];
+    }
+
+    if (count)
+        printf("    %s async : %d values differ from the cpu controller\n", msg, count);
+
+    return count;
+}
+
+// Refines several interleaved samples of the vertices in a single pass and
+// checks that each sample matches a separate refine of its coarse vertices.
+int checkMultiSample( OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> * farmesh,
+                      OpenSubdiv::OsdCpuComputeController * controller,
+                      OpenSubdiv::OsdCpuComputeContext * context,
+                      std::vector<float> const & coarseverts ) {
+
+    int const nsamples = 3;
+
+    int nverts = farmesh->GetNumVertices(),
+        ncoarse = (int)coarseverts.size()/3;
+
+    // sample 's' is the coarse mesh translated by 's'
+    std::vector<float> samples(ncoarse*3*nsamples);
+    for (int i=0; i<ncoarse; ++i)
+        for (int j=0; j<nsamples; ++j)
+            for (int k=0; k<3; ++k)
+                samples[(i*nsamples+j)*3+k] = coarseverts[i*3+k] + (float)j;
+
+    OpenSubdiv::OsdCpuVertexBuffer * vb = OpenSubdiv::OsdCpuVertexBuffer::Create(3*nsamples, nverts);
+    vb->UpdateData( & samples[0], ncoarse );
+
+    controller->RefineSamples( context, nsamples, vb );
+
+    int count=0;
+    float const * result = vb->BindCpuBuffer();
+    for (int j=0; j<nsamples; ++j) {
+
+        std::vector<float> sample(ncoarse*3);
+        for (int i=0; i<ncoarse*3; ++i)
+            sample[i] = coarseverts[i] + (float)j;
+
+        OpenSubdiv::OsdCpuVertexBuffer * refVb = OpenSubdiv::OsdCpuVertexBuffer::Create(3, nverts);
+        refVb->UpdateData( & sample[0], ncoarse );
+        controller->Refine( context, refVb );
+
+        float const * ref = refVb->BindCpuBuffer();
+        for (int i=0; i<nverts; ++i)
+            for (int k=0; k<3; ++k)
+                if (result[(i*nsamples+j)*3+k]!=ref[i*3+k]) {
+                    ++count;
+                }
+        delete refVb;
+    }
+    delete vb;
+
+    // a width which can not be split in samples must not be refined
+    std::vector<float> ragged(nverts*(3*nsamples+1), -1.0f);
+    vb = OpenSubdiv::OsdCpuVertexBuffer::Create(3*nsamples+1, nverts);
+    vb->UpdateData( & ragged[0], nverts );
+
+    g_numOsdErrors = 0;
+    OpenSubdiv::OsdSetErrorCallback( countOsdErrors );
+    controller->RefineSamples( context, nsamples, vb );
+    controller->Synchronize( context );
+    OpenSubdiv::OsdSetErrorCallback( 0 );
+
+    if (g_numOsdErrors!=1 or
+        memcmp(vb->BindCpuBuffer(), & ragged[0], ragged.size()*sizeof(float))) {
+        printf("    multi-sample : ragged sample width was refined\n");
+        ++count;
+    }
+    delete vb;
+
+    if (count)
+        printf("    multi-sample : %d values differ from separate refines\n", count);
+
+    return count;
+}
+
+// Refines the positions held at two offsets of an interleaved buffer, one
+// after the other, and checks that both match the cpu controller while the
+// other elements of the vertices are left untouched.
+int checkInterleavedRefine( OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> * farmesh,
+                            OpenSubdiv::OsdCpuComputeController * controller,
+                            OpenSubdiv::OsdCpuComputeContext * context,
+                            std::vector<float> const & coarseverts,
+                            OpenSubdiv::OsdCpuVertexBuffer * cpuVb ) {
+
+    int const stride = 8;
+
+    int nverts = farmesh->GetNumVertices(),
+        ncoarse = (int)coarseverts.size()/3;
+
+    // vertex layout : position | 2 padding elements | position
+    std::vector<float> verts(nverts*stride, -1.0f);
+    for (int i=0; i<ncoarse; ++i)
+        for (int k=0; k<3; ++k)
+            verts[i*stride+k] = verts[i*stride+5+k] = coarseverts[i*3+k];
+
+    OpenSubdiv::OsdCpuVertexBuffer * vb = OpenSubdiv::OsdCpuVertexBuffer::Create(stride, nverts);
+    vb->UpdateData( & verts[0], nverts );
+
+    controller->Refine( context, OpenSubdiv::OsdVertexBufferDescriptor(0, 3, stride), vb );
+    controller->Refine( context, OpenSubdiv::OsdVertexBufferDescriptor(5, 3, stride), vb );
+
+    int count=0;
+    float const * ref = cpuVb->BindCpuBuffer(),
+                * result = vb->BindCpuBuffer();
+    for (int i=0; i<nverts; ++i) {
+        for (int k=0; k<3; ++k)
+            if (result[i*stride+k]!=ref[i*3+k] or result[i*stride+5+k]!=ref[i*3+k]) {
+                ++count;
+            }
+        if (result[i*stride+3]!=-1.0f or result[i*stride+4]!=-1.0f)
+            ++count;
+    }
+    delete vb;
+
+    if (count)
+        printf("    interleaved : %d values differ from the cpu controller\n", count);
+
+    return count;
+}
+
+// Refines the mesh in an aligned buffer padded to the SIMD width and in a
+// buffer wrapping client memory, and checks that both match the cpu controller
+// while the padding elements stay cleared.
+int checkBufferAllocation( OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> * farmesh,
+                           OpenSubdiv::OsdCpuComputeController * controller,
+                           OpenSubdiv::OsdCpuComputeContext * context,
+                           std::vector<float> const & coarseverts,
+                           OpenSubdiv::OsdCpuVertexBuffer * cpuVb ) {
+
+    typedef OpenSubdiv::OsdCpuVertexBuffer VertexBuffer;
+
+    int nverts = farmesh->GetNumVertices(),
+        ncoarse = (int)coarseverts.size()/3;
+
+    int count=0;
+    float const * ref = cpuVb->BindCpuBuffer();
+
+    if ((size_t)ref % VertexBuffer::k_Alignment)
+        ++count;
+
+    // padded vertices (xyz | 0) on huge pages
+    VertexBuffer * paddedVb = VertexBuffer::Create(3, nverts,
+        VertexBuffer::k_PadVertices | VertexBuffer::k_HugePages);
+
+    int stride = paddedVb->GetNumElements();
+    if (stride!=4 or (size_t)paddedVb->BindCpuBuffer() % VertexBuffer::k_HugePageSize)
+        ++count;
+
+    // the coarse vertices are not padded : the padding elements are cleared
+    std::fill(paddedVb->BindCpuBuffer(), paddedVb->BindCpuBuffer()+nverts*stride, -1.0f);
+    paddedVb->UpdateData( & coarseverts[0], ncoarse );
+
+    controller->Refine( context, paddedVb );
+
+    float const * padded = paddedVb->BindCpuBuffer();
+    for (int i=0; i<nverts; ++i) {
+        for (int k=0; k<3; ++k)
+            if (padded[i*stride+k]!=ref[i*3+k])
+                ++count;
+        if (padded[i*stride+3]!=0.0f)
+            ++count;
+    }
+    delete paddedVb;
+
+    // coarse vertices written directly in client memory, refined in place
+    std::vector<float> verts(nverts*3, 0.0f);
+    std::copy(coarseverts.begin(), coarseverts.end(), verts.begin());
+
+    VertexBuffer * wrappedVb = VertexBuffer::Wrap(&verts[0], 3, nverts);
+    if (wrappedVb->IsOwner() or wrappedVb->BindCpuBuffer()!=&verts[0])
+        ++count;
+
+    wrappedVb->UpdateData( wrappedVb->BindCpuBuffer(), ncoarse );
+
+    controller->Refine( context, wrappedVb );
+    delete wrappedVb;
+
+    for (int j=0; j<nverts*3; ++j)
+        if (verts[j]!=ref[j]) {
+            ++count;
+        }
+
+    if (count)
+        printf("    buffer allocation : %d values differ from the cpu controller\n", count);
+
+    return count;
+}
+
+// Refines a buffer of T holding the coarse vertices and copies the refined
+// vertices to 'result', streaming them if 'nonTemporal'
+template <class VERTEX_BUFFER, class T>
+void refinePrecision( OpenSubdiv::OsdCpuComputeController * controller,
+                      OpenSubdiv::OsdCpuComputeContext * context,
+                      std::vector<float> const & coarseverts,
+                      int nverts, bool nonTemporal, std::vector<T> & result ) {
+
+    int ncoarse = (int)coarseverts.size()/3;
+
+    // zero-filled : the refined vertices must not be left over by a
+    // previous buffer
+    std::vector<T> verts(nverts*3, T(0));
+    for (int i=0; i<ncoarse*3; ++i)
+        verts[i] = (T)coarseverts[i];
+
+    VERTEX_BUFFER * vb = VERTEX_BUFFER::Create(3, nverts);
+    vb->UpdateData( & verts[0], nverts );
+
+    size_t threshold = OpenSubdiv::OsdCpuGetNonTemporalStoreThreshold();
+    if (nonTemporal)
+        OpenSubdiv::OsdCpuSetNonTemporalStoreThreshold(0);
+    controller->Refine( context, vb );
+    OpenSubdiv::OsdCpuSetNonTemporalStoreThreshold(threshold);
+
+    T const * data = vb->BindCpuBuffer();
+    result.assign(data, data+nverts*3);
+    delete vb;
+}
+
+// Refines the mesh with the kernels of each instruction set supported by the
+// processor and checks that the vertices are bitwise identical to the ones of
+// the default kernels, in float, mixed and double precision.
+int checkInstructionSets( OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> * farmesh,
+                          OpenSubdiv::OsdCpuComputeController * controller,
+                          OpenSubdiv::OsdCpuComputeContext * context,
+                          std::vector<float> const & coarseverts ) {
+
+    static const OpenSubdiv::OsdCpuInstructionSet isas[] = {
+        OpenSubdiv::OSD_CPU_ISA_DEFAULT,
+        OpenSubdiv::OSD_CPU_ISA_AVX2,
+        OpenSubdiv::OSD_CPU_ISA_AVX512 };
+
+    int nverts = farmesh->GetNumVertices();
+
+    OpenSubdiv::OsdCpuInstructionSet selected = OpenSubdiv::OsdCpuGetInstructionSet();
+
+    int count=0;
+    std::vector<float> ref, refStreamed, refMixed;
+    std::vector<double> refDouble;
+    for (int i=0; i<(int)(sizeof(isas)/sizeof(isas[0])); ++i) {
+
+        if (not OpenSubdiv::OsdCpuSetInstructionSet(isas[i]))
+            continue;
+
+        std::vector<float> verts, streamed, mixed;
+        std::vector<double> dbl;
+        refinePrecision<OpenSubdiv::OsdCpuVertexBuffer>(
+            controller, context, coarseverts, nverts, false, verts);
+        refinePrecision<OpenSubdiv::OsdCpuVertexBuffer>(
+            controller, context, coarseverts, nverts, true, streamed);
+        refinePrecision<OpenSubdiv::OsdCpuDoubleVertexBuffer>(
+            controller, context, coarseverts, nverts, false, dbl);
+        context->SetDoubleAccumulation(true);
+        refinePrecision<OpenSubdiv::OsdCpuVertexBuffer>(
+            controller, context, coarseverts, nverts, false, mixed);
+        context->SetDoubleAccumulation(false);
+
+        if (isas[i]==OpenSubdiv::OSD_CPU_ISA_DEFAULT) {
+            ref.swap(verts);
+            refStreamed.swap(streamed);
+            refMixed.swap(mixed);
+            refDouble.swap(dbl);
+            continue;
+        }
+
+        int differ=0;
+        for (int j=0; j<nverts*3; ++j)
+            if (verts[j]!=ref[j] or streamed[j]!=refStreamed[j] or
+                mixed[j]!=refMixed[j] or dbl[j]!=refDouble[j]) {
+                ++differ;
+            }
+
+        if (differ)
+            printf("    instruction set %d : %d values differ from the default kernels\n",
+                   isas[i], differ);
+        count += differ;
+    }
+
+    OpenSubdiv::OsdCpuSetInstructionSet(selected);
+
+    return count;
+}
+
+// Refines the mesh in double precision and float buffers with double
+// accumulations : checks that both match the float refine and that the
+// mixed precision vertices are at least as close to the double precision
+// ones as the float vertices.
+int checkDoublePrecision( OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> * farmesh,
+                          OpenSubdiv::OsdCpuComputeController * controller,
+                          OpenSubdiv::OsdCpuComputeContext * context,
+                          std::vector<float> const & coarseverts,
+                          OpenSubdiv::OsdCpuVertexBuffer * cpuVb ) {
+
+    int nverts = farmesh->GetNumVertices();
+
+    std::vector<double> dbl, dblStreamed;
+    refinePrecision<OpenSubdiv::OsdCpuDoubleVertexBuffer>(
+        controller, context, coarseverts, nverts, false, dbl);
+    refinePrecision<OpenSubdiv::OsdCpuDoubleVertexBuffer>(
+        controller, context, coarseverts, nverts, true, dblStreamed);
+
+    std::vector<float> mixed, mixedStreamed;
+    context->SetDoubleAccumulation(true);
+    refinePrecision<OpenSubdiv::OsdCpuVertexBuffer>(
+        controller, context, coarseverts, nverts, false, mixed);
+    refinePrecision<OpenSubdiv::OsdCpuVertexBuffer>(
+        controller, context, coarseverts, nverts, true, mixedStreamed);
+    context->SetDoubleAccumulation(false);
+
+    int count=0;
+    double floatError=0.0, mixedError=0.0;
+    float const * ref = cpuVb->BindCpuBuffer();
+    for (int j=0; j<nverts*3; ++j) {
+        if (fabs(dbl[j]-ref[j]) > PRECISION or
+            fabs(mixed[j]-ref[j]) > PRECISION or
+            dblStreamed[j]!=dbl[j] or mixedStreamed[j]!=mixed[j]) {
+            ++count;
+        }
+        floatError = std::max(floatError, fabs(ref[j]-dbl[j]));
+        mixedError = std::max(mixedError, fabs(mixed[j]-dbl[j]));
+    }
+
+    if (floatError > 0.0 and mixedError >= floatError)
+        ++count;
+
+    if (count)
+        printf("    double precision : %d values differ (float error %g,"
+               " mixed error %g)\n", count, floatError, mixedError);
+
+    return count;
+}
+
+// Creates a mesh with 2 face-varying items : the uvs of the shape (with
+// seams) and the x coordinate of the vertices (seamless)
+static OsdHbrMesh * createFVarMesh( char const * shapestr, Scheme scheme,
+    OsdHbrMesh::InterpolateBoundaryMethod fvarInterpolation ) {
+
+    static OpenSubdiv::HbrBilinearSubdivision<OpenSubdiv::OsdVertex> _bilinear;
+    static OpenSubdiv::HbrCatmarkSubdivision<OpenSubdiv::OsdVertex>  _catmark;
+
+    static int const fvarIndices[] = { 0, 2 },
+                     fvarWidths[] = { 2, 1 };
+
+    shape * sh = shape::parseShape( shapestr );
+
+    OsdHbrMesh * mesh = new OsdHbrMesh( scheme==kBilinear ?
+        (OpenSubdiv::HbrSubdivision<OpenSubdiv::OsdVertex> *)&_bilinear :
+        (OpenSubdiv::HbrSubdivision<OpenSubdiv::OsdVertex> *)&_catmark,
+        2, fvarIndices, fvarWidths, 3 );
+
+    std::vector<float> verts;
+    createVertices<OpenSubdiv::OsdVertex>(sh, mesh, verts);
+    createTopology<OpenSubdiv::OsdVertex>(sh, mesh, scheme);
+    mesh->SetFVarInterpolateBoundaryMethod( fvarInterpolation );
+
+    for (int i=0, idx=0; i<sh->getNfaces(); ++i) {
+        OsdHbrFace * f = mesh->GetFace(i);
+        for (int j=0; j<f->GetNumVertices(); ++j, ++idx) {
+            int uv = sh->faceuvs.empty() ? sh->faceverts[idx] : sh->faceuvs[idx];
+            float data[3] = { sh->uvs[uv*2], sh->uvs[uv*2+1],
+                              sh->verts[sh->faceverts[idx]*3] };
+
+            // new data on uv seams
+            OsdHbrVertex * v = f->GetVertex(j);
+            if (not v->GetFVarData(f).IsInitialized())
+                v->GetFVarData(f).SetAllData(3, data);
+            else if (not v->GetFVarData(f).CompareAll(3, data))
+                v->NewFVarData(f).SetAllData(3, data);
+        }
+    }
+    delete sh;
+    return mesh;
+}
+
+// Refines the face-varying data of the coarse faces with the face-varying
+// tables and checks the refined corners against the data interpolated by
+// Hbr, for each face-varying boundary interpolation method. The coarse data
+// is then scaled and refined again, without rebuilding the tables. The same
+// is done with the tables of a serialized copy of the mesh.
+template <class CONTROLLER>
+int checkFVarRefine( char const * msg, CONTROLLER * controller,
+                     char const * shape, Scheme scheme, int levels ) {
+
+    static OsdHbrMesh::InterpolateBoundaryMethod const methods[] = {
+        OsdHbrMesh::k_InterpolateBoundaryNone,
+        OsdHbrMesh::k_InterpolateBoundaryEdgeOnly,
+        OsdHbrMesh::k_InterpolateBoundaryEdgeAndCorner,
+        OsdHbrMesh::k_InterpolateBoundaryAlwaysSharp };
+
+    int count=0;
+    for (int m=0; m<4; ++m) {
+
+        OsdHbrMesh * hmesh = createFVarMesh(shape, scheme, methods[m]);
+
+        OpenSubdiv::FarMeshFactory<OpenSubdiv::OsdVertex> meshFactory(hmesh, levels);
+        OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> * farmesh =
+            meshFactory.Create(/*ptex*/ false, /*fvar*/ true);
+
+        std::vector<char> data;
+        OpenSubdiv::FarMeshSerializer<OpenSubdiv::OsdVertex>::Write(farmesh, data);
+        OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> * serialized =
+            OpenSubdiv::FarMeshSerializer<OpenSubdiv::OsdVertex>::Read(&data[0], data.size());
+
+        if (not farmesh->GetFVarTables() or not serialized or
+            not serialized->GetFVarTables()) {
+            printf("    fvar %s : no face-varying tables\n", msg);
+            delete serialized;
+            delete farmesh;
+            delete hmesh;
+            return 1;
+        }
+
+        for (int copy=0; copy<2; ++copy) {
+
+            OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> * mesh = copy ? serialized : farmesh;
+            OpenSubdiv::FarFVarTables const * tables = mesh->GetFVarTables();
+
+            int width = tables->GetTotalFVarWidth(),
+                ncorners = tables->GetNumCorners();
+
+            // zero-filled : the refined corners must not be left over by a
+            // previous buffer
+            std::vector<float> corners(ncorners*width, 0.0f);
+            for (int i=0, corner=0; i<hmesh->GetNumCoarseFaces(); ++i) {
+                OsdHbrFace * f = hmesh->GetFace(i);
+                for (int j=0; j<f->GetNumVertices(); ++j, ++corner) {
+                    float const * data = f->GetVertex(j)->GetFVarData(f).GetData(0);
+                    std::copy(data, data+width, &corners[corner*width]);
+                }
+            }
+
+            OpenSubdiv::OsdCpuComputeContext * context =
+                OpenSubdiv::OsdCpuComputeContext::Create(mesh);
+            OpenSubdiv::OsdCpuVertexBuffer * vb =
+                OpenSubdiv::OsdCpuVertexBuffer::Create(width, ncorners);
+
+            for (int pass=0; pass<2; ++pass) {
+
+                // the second pass doubles the coarse data (exact in floats)
+                float scale = pass ? 2.0f : 1.0f;
+                if (pass)
+                    for (int i=0; i<tables->GetFirstCorner(1)*width; ++i)
+                        corners[i] *= scale;
+
+                vb->UpdateData( & corners[0], ncorners );
+                controller->RefineFVar( context, vb );
+
+                float const * result = vb->BindCpuBuffer();
+                for (int l=1; l<=levels; ++l) {
+                    std::vector<float> const & ref = farmesh->GetFVarData(l);
+                    float const * data = result + tables->GetFirstCorner(l)*width;
+                    if ((int)ref.size()!=tables->GetNumCorners(l)*width) {
+                        ++count;
+                        continue;
+                    }
+                    for (int i=0; i<(int)ref.size(); ++i)
+                        if (fabs(data[i]-scale*ref[i]) > PRECISION)
+                            ++count;
+                }
+            }
+
+            delete vb;
+            delete context;
+        }
+
+        delete serialized;
+        delete farmesh;
+        delete hmesh;
+    }
+
+    if (count)
+        printf("    fvar %s : %d values differ from Hbr\n", msg, count);
+
+    return count;
+}
+
 //------------------------------------------------------------------------------
 static void refine( xyzmesh * mesh, int maxlevel ) {
 
@@ -320,7 +1551,7 @@ int checkMesh( char const * msg, char const * shape, int levels, Scheme scheme=k
     OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> *farmesh;
     OpenSubdiv::FarMeshFactory<OpenSubdiv::OsdVertex> meshFactory(hmesh, levels);
 
-    farmesh = meshFactory.Create();
+    farmesh = meshFactory.Create(/*ptex*/ true);
 
     static OpenSubdiv::OsdCpuComputeController *controller =
         new OpenSubdiv::OsdCpuComputeController();
@@ -336,6 +1567,66 @@ int checkMesh( char const * msg, char const * shape, int levels, Scheme scheme=k
         controller->Refine( context, vb );
 
         checkVertexBuffer(refmesh, vb, remap);
+
+        result += checkTaskController(farmesh, coarseverts, vb);
+
+        result += checkNonTemporalStores(farmesh, controller, context, coarseverts, vb);
+
+        result += checkDirtyRefine(farmesh, controller, context, coarseverts, vb);
+
+        result += checkMultiSample(farmesh, controller, context, coarseverts);
+
+        result += checkDoublePrecision(farmesh, controller, context, coarseverts, vb);
+
+        result += checkInstructionSets(farmesh, controller, context, coarseverts);
+
+        result += checkInterleavedRefine(farmesh, controller, context, coarseverts, vb);
+
+        result += checkBufferAllocation(farmesh, controller, context, coarseverts, vb);
+
+        result += checkBatchRefine("cpu", controller, farmesh, coarseverts, vb);
+
+        result += checkAllocations("cpu", controller, farmesh, coarseverts);
+
+        result += checkInstrumentation("cpu", controller, farmesh, coarseverts, vb);
+
+        static OpenSubdiv::OsdCpuComputeController *asyncController =
+            new OpenSubdiv::OsdCpuComputeController(/*asynchronous*/ true);
+        result += checkAsyncRefine("cpu", asyncController, farmesh, coarseverts, vb);
+
+        result += checkAllocations("cpu async", asyncController, farmesh, coarseverts);
+
+        if (scheme!=kLoop)
+            result += checkFVarRefine("cpu", controller, shape, scheme, levels);
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+        // meshes refined by a single thread each
+        static OpenSubdiv::OsdOmpComputeController *ompController =
+            new OpenSubdiv::OsdOmpComputeController(4);
+        result += checkBatchRefine("omp", ompController, farmesh, coarseverts, vb);
+
+        // meshes split across the threads
+        static OpenSubdiv::OsdOmpComputeController *ompSplitController =
+            new OpenSubdiv::OsdOmpComputeController(4, /*batchGrainSize*/ 1);
+        result += checkBatchRefine("omp split", ompSplitController, farmesh, coarseverts, vb);
+
+        result += checkAllocations("omp", ompController, farmesh, coarseverts);
+
+        result += checkInstrumentation("omp", ompController, farmesh, coarseverts, vb);
+
+        static OpenSubdiv::OsdOmpComputeController *ompAsyncController =
+            new OpenSubdiv::OsdOmpComputeController(4, 1024, /*asynchronous*/ true);
+        result += checkAsyncRefine("omp", ompAsyncController, farmesh, coarseverts, vb);
+
+        result += checkFirstTouch("omp", ompController, farmesh, coarseverts, vb);
+        result += checkFirstTouch("omp async", ompAsyncController, farmesh, coarseverts, vb);
+
+        if (scheme!=kLoop)
+            result += checkFVarRefine("omp", ompController, shape, scheme, levels);
+#endif
+
+        if (scheme==kCatmark and not hmesh->HasVertexEdits())
+            result += checkLimitSurface(shape, farmesh, vb, levels);
     }
 
     delete hmesh;